@@ -7,14 +7,19 @@ extern "C" {
 
 struct iotex_st_config;
 
-/* URL */
+/* URL, can be pointed at a local mock server at build time */
+#ifndef IOTEX_EMB_BASE_URL
 #define IOTEX_EMB_BASE_URL "https://pharos.iotex.io/v%d/"
+#endif
 #define IOTEX_EMB_MAX_URL_LEN 256
 #define IOTEX_EMB_MAX_ACB_LEN 1024
 
 /* Response */
 #define IOTEX_EBM_MAX_RES_LEN (32 * 1024)
 
+/* Request, number of connections kept open to the server */
+#define IOTEX_EMB_REQ_POOL_SIZE 2
+
 void print_config();
 struct iotex_st_config get_config();
 
@@ -552,6 +552,10 @@ void point_multiply(const ecdsa_curve *curve, const bignum256 *k,
 
 #if USE_PRECOMPUTED_CP
 
+// window size, number of windows and the bit the top window reaches
+#define CP_W USE_PRECOMPUTED_CP_WINDOW
+#define CP_TOP_BIT (CP_W * CP_ROWS)
+
 // res = k * G
 // k must be a normalized number with 0 <= k < curve->order
 void scalar_multiply(const ecdsa_curve *curve, const bignum256 *k,
@@ -567,7 +571,7 @@ void scalar_multiply(const ecdsa_curve *curve, const bignum256 *k,
 
     // is_even = 0xffffffff if k is even, 0 otherwise.
 
-    // add 2^256.
+    // add 2^CP_TOP_BIT.
     // make number odd: subtract curve->order if even
     uint32_t tmp = 1;
     uint32_t is_non_zero = 0;
@@ -579,8 +583,9 @@ void scalar_multiply(const ecdsa_curve *curve, const bignum256 *k,
         tmp >>= 30;
     }
 
+    // the low limbs added 2^240, the top limb adds the rest of 2^CP_TOP_BIT
     is_non_zero |= k->val[j];
-    a.val[j] = tmp + 0xffff + k->val[j] - (curve->order.val[j] & is_even);
+    a.val[j] = tmp + ((1u << (CP_TOP_BIT - 240)) - 1) + k->val[j] - (curve->order.val[j] & is_even);
     assert((a.val[0] & 1) != 0);
 
     // special case 0*G:  just return zero. We don't care about constant time.
@@ -589,46 +594,47 @@ void scalar_multiply(const ecdsa_curve *curve, const bignum256 *k,
         return;
     }
 
-    // Now a = k + 2^256 (mod curve->order) and a is odd.
+    // Now a = k + 2^CP_TOP_BIT (mod curve->order) and a is odd.
+    // With W = CP_W and N = CP_ROWS:
     //
     // The idea is to bring the new a into the form.
-    // sum_{i=0..64} a[i] 16^i,  where |a[i]| < 16 and a[i] is odd.
+    // sum_{i=0..N} a[i] (2^W)^i,  where |a[i]| < 2^W and a[i] is odd.
     // a[0] is odd, since a is odd.  If a[i] would be even, we can
-    // add 1 to it and subtract 16 from a[i-1].  Afterwards,
-    // a[64] = 1, which is the 2^256 that we added before.
+    // add 1 to it and subtract 2^W from a[i-1].  Afterwards,
+    // a[N] = 1, which is the 2^CP_TOP_BIT that we added before.
     //
-    // Since k = a - 2^256 (mod curve->order), we can compute
-    //   k*G = sum_{i=0..63} a[i] 16^i * G
+    // Since k = a - 2^CP_TOP_BIT (mod curve->order), we can compute
+    //   k*G = sum_{i=0..N-1} a[i] (2^W)^i * G
     //
     // We have a big table curve->cp that stores all possible
-    // values of |a[i]| 16^i * G.
-    // curve->cp[i][j] = (2*j+1) * 16^i * G
+    // values of |a[i]| (2^W)^i * G.
+    // curve->cp[i][j] = (2*j+1) * (2^W)^i * G
 
-    // now compute  res = sum_{i=0..63} a[i] * 16^i * G step by step.
-    // initial res = |a[0]| * G.  Note that a[0] = a & 0xf if (a&0x10) != 0
-    // and - (16 - (a & 0xf)) otherwise.   We can compute this as
-    //   ((a ^ (((a >> 4) & 1) - 1)) & 0xf) >> 1
+    // now compute  res = sum_{i=0..N-1} a[i] * (2^W)^i * G step by step.
+    // initial res = |a[0]| * G.  Note that a[0] = a & (2^W-1) if (a&2^W) != 0
+    // and - (2^W - (a & (2^W-1))) otherwise.   We can compute this as
+    //   ((a ^ (((a >> W) & 1) - 1)) & (2^W-1)) >> 1
     // since a is odd.
-    lowbits = a.val[0] & ((1 << 5) - 1);
-    lowbits ^= (lowbits >> 4) - 1;
-    lowbits &= 15;
+    lowbits = a.val[0] & ((1 << (CP_W + 1)) - 1);
+    lowbits ^= (lowbits >> CP_W) - 1;
+    lowbits &= (1 << CP_W) - 1;
     curve_to_jacobian(&curve->cp[0][lowbits >> 1], &jres, prime);
 
-    for (i = 1; i < 64; i++) {
-        // invariant res = sign(a[i-1]) sum_{j=0..i-1} (a[j] * 16^j * G)
+    for (i = 1; i < CP_ROWS; i++) {
+        // invariant res = sign(a[i-1]) sum_{j=0..i-1} (a[j] * (2^W)^j * G)
 
-        // shift a by 4 places.
+        // shift a by W places.
         for (j = 0; j < 8; j++) {
-            a.val[j] = (a.val[j] >> 4) | ((a.val[j + 1] & 0xf) << 26);
+            a.val[j] = (a.val[j] >> CP_W) | ((a.val[j + 1] & ((1 << CP_W) - 1)) << (30 - CP_W));
         }
 
-        a.val[j] >>= 4;
-        // a = old(a)>>(4*i)
+        a.val[j] >>= CP_W;
+        // a = old(a)>>(W*i)
         // a is even iff sign(a[i-1]) = -1
 
-        lowbits = a.val[0] & ((1 << 5) - 1);
-        lowbits ^= (lowbits >> 4) - 1;
-        lowbits &= 15;
+        lowbits = a.val[0] & ((1 << (CP_W + 1)) - 1);
+        lowbits ^= (lowbits >> CP_W) - 1;
+        lowbits &= (1 << CP_W) - 1;
         // negate last result to make signs of this round and the
         // last round equal.
         conditional_negate((lowbits & 1) - 1, &jres.y, prime);
@@ -637,7 +643,7 @@ void scalar_multiply(const ecdsa_curve *curve, const bignum256 *k,
         point_jacobian_add(&curve->cp[i][lowbits >> 1], &jres, curve);
     }
 
-    conditional_negate(((a.val[0] >> 4) & 1) - 1, &jres.y, prime);
+    conditional_negate(((a.val[0] >> CP_W) & 1) - 1, &jres.y, prime);
     jacobian_to_curve(&jres, res, prime);
     memzero(&a, sizeof(a));
     memzero(&jres, sizeof(jres));
@@ -28,6 +28,12 @@
 #include "bignum.h"
 #include "options.h"
 
+#if USE_PRECOMPUTED_CP
+// cp[i][j] = (2*j+1) * 2^(i*USE_PRECOMPUTED_CP_WINDOW) * G, rows cover all 256 bits
+#define CP_ROWS ((256 + USE_PRECOMPUTED_CP_WINDOW - 1) / USE_PRECOMPUTED_CP_WINDOW)
+#define CP_COLS (1 << (USE_PRECOMPUTED_CP_WINDOW - 1))
+#endif
+
 // curve point x and y
 typedef struct {
     bignum256 x, y;
@@ -42,7 +48,7 @@ typedef struct {
     bignum256 b;           // coefficient 'b' of the elliptic curve
 
 #if USE_PRECOMPUTED_CP
-    const curve_point cp[64][8];
+    const curve_point cp[CP_ROWS][CP_COLS];
 #endif
 
 } ecdsa_curve;
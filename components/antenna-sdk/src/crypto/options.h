@@ -28,6 +28,13 @@
 #define USE_PRECOMPUTED_CP 1
 #endif
 
+// window size in bits of the precomputed Curve Points, 4, 5 or 6.
+// a larger window needs fewer point additions per signature but a larger
+// table (in flash): 4 = 64 additions / 36 KB, 5 = 52 / 59 KB, 6 = 43 / 97 KB
+#ifndef USE_PRECOMPUTED_CP_WINDOW
+#define USE_PRECOMPUTED_CP_WINDOW 4
+#endif
+
 // use fast inverse method
 #ifndef USE_INVERSE_FAST
 #define USE_INVERSE_FAST 1
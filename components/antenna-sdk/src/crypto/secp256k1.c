@@ -64,7 +64,15 @@ const ecdsa_curve secp256k1 = {
     ,
     /* cp */
     {
+#if USE_PRECOMPUTED_CP_WINDOW == 4
 #include "secp256k1.table"
+#elif USE_PRECOMPUTED_CP_WINDOW == 5
+#include "secp256k1_w5.table"
+#elif USE_PRECOMPUTED_CP_WINDOW == 6
+#include "secp256k1_w6.table"
+#else
+#error "no secp256k1 table for USE_PRECOMPUTED_CP_WINDOW, generate one with tools/mktable.c"
+#endif
     }
 #endif
 };
@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2013-2014 Tomas Dzetkulic
+ * Copyright (c) 2013-2014 Pavol Rusnak
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Generates the precomputed curve point table included by secp256k1.c for a
+ * given window size, cp[i][j] = (2*j+1) * 2^(i*window) * G. Built on the host
+ * without a table:
+ *
+ *   cc -O2 -I.. -DUSE_PRECOMPUTED_CP=0 -o mktable mktable.c ../bignum.c \
+ *      ../ecdsa.c ../secp256k1.c ../memzero.c ../rand.c ../hmac_drbg.c \
+ *      ../rfc6979.c ../sha2.c ../sha3.c
+ *   ./mktable 5 > ../secp256k1_w5.table
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bignum.h"
+#include "ecdsa.h"
+#include "secp256k1.h"
+
+static void print_point(const curve_point *p, int last) {
+    int k;
+
+    printf("\t\t{{{");
+
+    for (k = 0; k < 8; k++) {
+        printf("0x%08x, ", p->x.val[k]);
+    }
+
+    printf("0x%04x}},\n\t\t {{", p->x.val[8]);
+
+    for (k = 0; k < 8; k++) {
+        printf("0x%08x, ", p->y.val[k]);
+    }
+
+    printf("0x%04x}}}%s\n", p->y.val[8], last ? "" : ",");
+}
+
+int main(int argc, char **argv) {
+    const ecdsa_curve *curve = &secp256k1;
+    int window = argc > 1 ? atoi(argv[1]) : 4;
+    int rows, cols, i, j, k;
+    curve_point ng, pow2ig, p;
+
+    if (window < 2 || window > 8) {
+        fprintf(stderr, "usage: %s [window 2..8]\n", argv[0]);
+        return 1;
+    }
+
+    rows = (256 + window - 1) / window;
+    cols = 1 << (window - 1);
+
+    // ng = 2^(i*window) * G for the current row
+    point_copy(&curve->G, &ng);
+
+    for (i = 0; i < rows; i++) {
+        printf("\t{\n");
+        point_copy(&ng, &p);
+
+        // 2 * ng, the step between odd multiples
+        point_copy(&ng, &pow2ig);
+        point_double(curve, &pow2ig);
+
+        for (j = 0; j < cols; j++) {
+            printf("\t\t/* %2d*%d^%d*G: */\n", 2 * j + 1, 1 << window, i);
+            print_point(&p, j == cols - 1);
+            point_add(curve, &pow2ig, &p);
+        }
+
+        printf("\t},\n");
+
+        for (k = 0; k < window; k++) {
+            point_double(curve, &ng);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,138 @@
+/**
+ * Copyright (c) 2013-2014 Tomas Dzetkulic
+ * Copyright (c) 2013-2014 Pavol Rusnak
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES
+ * OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Host benchmark for the secp256k1 code. Checks the fixed-base k*G against
+ * the generic point multiplication, then times signing, public key
+ * derivation and a variable-base multiplication (the cost that dominates a
+ * signature verification). Build once per table size to compare:
+ *
+ *   cc -O2 -I.. -DUSE_PRECOMPUTED_CP_WINDOW=5 -o test_speed test_speed.c \
+ *      ../bignum.c ../ecdsa.c ../secp256k1.c ../memzero.c ../rand.c \
+ *      ../hmac_drbg.c ../rfc6979.c ../sha2.c ../sha3.c
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "bignum.h"
+#include "ecdsa.h"
+#include "rand.h"
+#include "secp256k1.h"
+
+#define CHECK_ROUNDS 500
+#define SPEED_ROUNDS 250
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void random_scalar(bignum256 *k) {
+    uint8_t buf[32];
+
+    do {
+        random_buffer(buf, sizeof(buf));
+        bn_read_be(buf, k);
+    } while (bn_is_zero(k) || !bn_is_less(k, &secp256k1.order));
+}
+
+static int check_scalar_multiply(void) {
+    int i;
+    bignum256 k;
+    curve_point a, b;
+
+    for (i = 0; i < CHECK_ROUNDS; i++) {
+        random_scalar(&k);
+        scalar_multiply(&secp256k1, &k, &a);
+        point_multiply(&secp256k1, &k, &secp256k1.G, &b);
+
+        if (!point_is_equal(&a, &b)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static void report(const char *name, double start) {
+    double elapsed = now() - start;
+
+    printf("%-24s %8.1f ops/s  %8.1f us/op\n", name, SPEED_ROUNDS / elapsed, elapsed * 1e6 / SPEED_ROUNDS);
+}
+
+int main(void) {
+    int i;
+    double start;
+    uint8_t priv_key[32], digest[32], sig[64], pub_key[65];
+    bignum256 k;
+    curve_point p;
+
+    printf("window %d, table %u bytes\n", USE_PRECOMPUTED_CP_WINDOW, (unsigned)sizeof(secp256k1.cp));
+
+    if (check_scalar_multiply()) {
+        printf("scalar_multiply does not match point_multiply\n");
+        return 1;
+    }
+
+    random_buffer(priv_key, sizeof(priv_key));
+    random_buffer(digest, sizeof(digest));
+
+    start = now();
+
+    for (i = 0; i < SPEED_ROUNDS; i++) {
+        digest[0] = i;
+
+        if (ecdsa_sign_digest(&secp256k1, priv_key, digest, sig, NULL, NULL)) {
+            printf("ecdsa_sign_digest failed\n");
+            return 1;
+        }
+    }
+
+    report("ecdsa_sign_digest", start);
+
+    start = now();
+
+    for (i = 0; i < SPEED_ROUNDS; i++) {
+        priv_key[0] = i;
+        ecdsa_get_public_key65(&secp256k1, priv_key, pub_key);
+    }
+
+    report("ecdsa_get_public_key65", start);
+
+    random_scalar(&k);
+    point_copy(&secp256k1.G, &p);
+    point_double(&secp256k1, &p);
+    start = now();
+
+    for (i = 0; i < SPEED_ROUNDS; i++) {
+        k.val[0] = (k.val[0] + 1) & 0x3fffffff;
+        point_multiply(&secp256k1, &k, &p, &p);
+    }
+
+    report("point_multiply", start);
+    return 0;
+}
@@ -16,6 +16,7 @@ int iotex_emb_init(const iotex_st_config *config) {
 }
 
 void iotex_emb_exit() {
+    req_exit();
     clear_config();
 }
 
@@ -145,7 +145,7 @@ typedef struct iotex_st_execution {
 int iotex_emb_init(const iotex_st_config *config);
 
 /*
- * @brief: clear api configure
+ * @brief: clear api configure, close connections kept open to the server
  */
 void iotex_emb_exit();
 
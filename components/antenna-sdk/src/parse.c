@@ -9,6 +9,18 @@
 
 
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+/* Tokens allocated for a new json stream, doubled whenever jsmn runs out */
+#define JSON_STREAM_INIT_TOKENS 64
+
+
+struct json_stream {
+    jsmn_parser parser;
+    jsmntok_t *token;
+    size_t token_size;
+    int tok_total;
+};
+
 static int json_parse_array(const char *json, jsmntok_t *tok, int tok_count, json_parse_rule *rule, int array_size);
 
 
@@ -272,6 +284,48 @@ static int json_parse_array(const char *json, jsmntok_t *tok, int tok_count, jso
 }
 
 
+/*
+ * @brief: follow the rules to parse tokenized json
+ * #response: https response json string
+ * #token: tokens of #response
+ * #tok_total: #token count
+ * #rules: response json hierarchy, ends with NULL
+ * $return: successed return 0, failed return -1
+ */
+static int json_parse_tokens(const char *response, jsmntok_t *token, int tok_total, json_parse_rule *rules) {
+
+    int processed_tok;
+
+    if (tok_total < 1) {
+        fprintf(stderr, "Json parse failed!\n");
+        return -1;
+    }
+
+    /* Json object */
+    if (token[0].type == JSMN_OBJECT) {
+
+        if ((processed_tok = json_parse_object(response, token, tok_total - 1, rules)) != tok_total - 1) {
+            fprintf(stderr, "Json parse failed, total token: %d, processed token: %d\n", tok_total - 1, processed_tok);
+            return -1;
+        }
+    }
+    /* Json array */
+    else if (token[0].type == JSMN_ARRAY) {
+
+        if ((processed_tok = json_parse_array(response, token + 1, tok_total - 1, rules, token[0].size)) != tok_total - 1) {
+            fprintf(stderr, "Json parse failed, total token: %d, processed token: %d\n", tok_total - 1, processed_tok);
+            return -1;
+        }
+    }
+    else {
+        fprintf(stdout, "Unknown type: %d\n", token[0].type);
+        return -1;
+    }
+
+    return 0;
+}
+
+
 /*
  * @brief: parse response json string
  * #response: https response json string
@@ -285,8 +339,8 @@ int json_parse_response(const char *response, json_parse_rule *rules) {
     assert(response != NULL);
     assert(rules != NULL);
 
+    int ret;
     int tok_total;
-    int processed_tok;
     jsmn_parser parser;
     jsmntok_t *token = NULL;
     size_t token_size = 0;
@@ -308,36 +362,106 @@ int json_parse_response(const char *response, json_parse_rule *rules) {
         return -1;
     }
 
-    if (tok_total < 1) {
-        fprintf(stderr, "Json parse failed!\n");
-        free(token);
-        return -1;
-    }
+    ret = json_parse_tokens(response, token, tok_total, rules);
+    free(token);
+    return ret;
+}
 
-    /* Json object */
-    if (token[0].type == JSMN_OBJECT) {
 
-        if ((processed_tok = json_parse_object(response, token, tok_total - 1, rules)) != tok_total - 1) {
-            fprintf(stderr, "Json parse failed, total token: %d, processed token: %d\n", tok_total - 1, processed_tok);
-            free(token);
-            return -1;
-        }
-    }
-    /* Json array */
-    else if (token[0].type == JSMN_ARRAY) {
+/*
+ * @brief: tokenize #json up to #len, growing the token array as needed
+ * $return: successed return 0, failed return -1
+ */
+static int json_stream_tokenize(json_stream *stream, const char *json, size_t len) {
 
-        if ((processed_tok = json_parse_array(response, token + 1, tok_total - 1, rules, token[0].size)) != tok_total - 1) {
-            fprintf(stderr, "Json parse failed, total token: %d, processed token: %d\n", tok_total - 1, processed_tok);
-            free(token);
+    int ret;
+    jsmntok_t *token = NULL;
+
+    while ((ret = jsmn_parse(&stream->parser, json, len, stream->token, stream->token_size)) == JSMN_ERROR_NOMEM) {
+
+        /* jsmn stops before the token it has no room for, so it can carry on */
+        if (!(token = realloc(stream->token, sizeof(jsmntok_t) * stream->token_size * 2))) {
             return -1;
         }
+
+        stream->token = token;
+        stream->token_size *= 2;
     }
-    else {
-        fprintf(stdout, "Unknown type: %d\n", token[0].type);
-        free(token);
+
+    if (ret < 0 && ret != JSMN_ERROR_PART) {
+        fprintf(stderr, "Json parse response failed: %d\n", ret);
         return -1;
     }
 
-    free(token);
+    stream->tok_total = ret;
     return 0;
 }
+
+json_stream *json_stream_new(void) {
+
+    json_stream *stream = NULL;
+
+    if (!(stream = calloc(1, sizeof(json_stream)))) {
+        return NULL;
+    }
+
+    if (!(stream->token = calloc(sizeof(jsmntok_t), JSON_STREAM_INIT_TOKENS))) {
+        free(stream);
+        return NULL;
+    }
+
+    jsmn_init(&stream->parser);
+    stream->token_size = JSON_STREAM_INIT_TOKENS;
+    return stream;
+}
+
+void json_stream_free(json_stream *stream) {
+
+    if (!stream) {
+        return;
+    }
+
+    free(stream->token);
+    free(stream);
+}
+
+/*
+ * @brief: tokenize the part of a response received so far
+ * #stream: json stream
+ * #json: response received so far, must start at the same address every call
+ * #len: #json length
+ * $return: successed return 0, failed(invalid json) return -1
+ */
+int json_stream_feed(json_stream *stream, const char *json, size_t len) {
+
+    assert(stream != NULL);
+    assert(json != NULL);
+
+    /* A number or literal at the end may continue in the next chunk, but jsmn
+     * would take it as complete, so stop at the last delimiter */
+    while (len > 0 && !strchr("{}[]\":, \t\r\n", json[len - 1])) {
+        len--;
+    }
+
+    return json_stream_tokenize(stream, json, len);
+}
+
+/*
+ * @brief: tokenize the rest of a complete response and parse it
+ * #stream: json stream fed with #response
+ * #response: complete response json string
+ * #rules: response json hierarchy, ends with NULL
+ * $return: successed return 0, failed return -1
+ */
+int json_stream_parse(json_stream *stream, const char *response, json_parse_rule *rules) {
+
+    assert(stream != NULL);
+    assert(response != NULL);
+    assert(rules != NULL);
+
+    if (json_stream_tokenize(stream, response, strlen(response)) != 0) {
+        return -1;
+    }
+
+    return json_parse_tokens(response, stream->token, stream->tok_total, rules);
+}
@@ -62,6 +62,19 @@ typedef struct json_parse_rule {
  */
 int json_parse_response(const char *response, json_parse_rule *rules);
 
+
+/*
+ * parse response while it is being received
+ * feed the response after each received chunk, then parse once it's complete,
+ * the response is tokenized as it arrives instead of all at once at the end
+ */
+typedef struct json_stream json_stream;
+
+json_stream *json_stream_new(void);
+void json_stream_free(json_stream *stream);
+int json_stream_feed(json_stream *stream, const char *json, size_t len);
+int json_stream_parse(json_stream *stream, const char *response, json_parse_rule *rules);
+
 #ifdef	__cplusplus
 }
 #endif
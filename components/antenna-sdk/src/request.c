@@ -5,6 +5,7 @@
 #include <stdarg.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
 #include <curl/curl.h>
 
 
@@ -24,9 +25,29 @@ typedef struct {
 typedef struct {
     char *data;
     size_t len;
+    size_t max_size;
+    req_stream_callback callback;
+    void *arg;
 } iotex_st_response_data;
 
 
+typedef struct {
+    CURL *curl;
+    uint32_t busy;
+} iotex_st_request_handle;
+
+
+/*
+ * Easy handles are kept between requests, each one holds its connection to the
+ * server open for the next request. The handles share DNS results and TLS
+ * sessions, so a handle that has to reconnect resumes the TLS session instead of
+ * doing a full handshake.
+ */
+static pthread_mutex_t __g_req_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t __g_req_share_locks[CURL_LOCK_DATA_LAST];
+static CURLSH *__g_req_share = NULL;
+static iotex_st_request_handle __g_req_pool[IOTEX_EMB_REQ_POOL_SIZE];
+
 static const iotex_st_request_conf __g_req_configs[] = {
     {
         REQ_GET_ACCOUNT,
@@ -85,53 +106,162 @@ static const iotex_st_request_conf __g_req_configs[] = {
 };
 
 /*
- * @brief: free iotex_st_response_data
+ * @brief: curl share lock callbacks, one mutex per kind of shared data
  */
-static void _free_response_data(iotex_st_response_data *res) {
+static void _curl_share_lock(CURL *curl, curl_lock_data data, curl_lock_access access, void *userptr) {
 
-    if (!res || !res->data) {
-        return;
+    pthread_mutex_lock(&__g_req_share_locks[data]);
+}
+
+static void _curl_share_unlock(CURL *curl, curl_lock_data data, void *userptr) {
+
+    pthread_mutex_unlock(&__g_req_share_locks[data]);
+}
+
+
+/*
+ * @brief: create curl share object, must hold __g_req_pool_lock
+ * $return: successed return 0, failed return -1
+ */
+static int _req_share_init(void) {
+
+    int i;
+
+    if (__g_req_share) {
+        return 0;
+    }
+
+    if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK) {
+        __WARN_MSG__("curl_global_init");
+        return -1;
+    }
+
+    if (!(__g_req_share = curl_share_init())) {
+        __WARN_MSG__("curl_share_init");
+        curl_global_cleanup();
+        return -1;
     }
 
-    free(res->data);
-    res->len = 0;
-    res->data = NULL;
+    for (i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&__g_req_share_locks[i], NULL);
+    }
+
+    curl_share_setopt(__g_req_share, CURLSHOPT_LOCKFUNC, _curl_share_lock);
+    curl_share_setopt(__g_req_share, CURLSHOPT_UNLOCKFUNC, _curl_share_unlock);
+    curl_share_setopt(__g_req_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(__g_req_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    return 0;
 }
 
 
 /*
- * @brief: curl receive data callback, copy received data to iotex_st_response_data
+ * @brief: take an idle handle from the pool, create one if the pool is empty
+ * #pooled: set 1 if the handle belongs to the pool, 0 if it's a temporary one
+ * $return: successed return curl handle, failed return NULL
  */
-static size_t _curl_write_callback(char *ptr, size_t size, size_t nmemb, void *userdata) {
+static CURL *_req_acquire_handle(uint32_t *pooled) {
 
-    char *new_ptr = NULL;
-    size_t new_len = size * nmemb;
-    iotex_st_response_data *res = userdata;
+    int i;
+    CURL *curl = NULL;
+    iotex_st_request_handle *slot = NULL;
+
+    pthread_mutex_lock(&__g_req_pool_lock);
+
+    if (_req_share_init() != 0) {
+        pthread_mutex_unlock(&__g_req_pool_lock);
+        return NULL;
+    }
 
-    /* First time */
-    if (res->data == NULL) {
+    /* Prefer a handle that already has a connection */
+    for (i = 0; i < IOTEX_EMB_REQ_POOL_SIZE; i++) {
 
-        res->data = 0;
+        if (__g_req_pool[i].busy) {
+            continue;
+        }
 
-        if (!(res->data = malloc(new_len)))  {
-            __ERROR_MSG__("malloc");
-            return 0;
+        if (__g_req_pool[i].curl) {
+            slot = __g_req_pool + i;
+            break;
         }
+
+        if (!slot) {
+            slot = __g_req_pool + i;
+        }
+    }
+
+    if (slot && !slot->curl) {
+        slot->curl = curl_easy_init();
+    }
+
+    if (slot && slot->curl) {
+        slot->busy = 1;
+        curl = slot->curl;
+        *pooled = 1;
     }
     else {
+        /* All handles are in use by other threads, use a temporary one */
+        curl = curl_easy_init();
+        *pooled = 0;
+    }
+
+    if (curl) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, __g_req_share);
+    }
+
+    pthread_mutex_unlock(&__g_req_pool_lock);
+    return curl;
+}
+
+
+/*
+ * @brief: give a handle back to the pool, the connection stays open
+ */
+static void _req_release_handle(CURL *curl, uint32_t pooled) {
+
+    int i;
 
-        if (!(new_ptr = realloc(res->data, res->len + new_len))) {
-            __ERROR_MSG__("realloc");
-            _free_response_data(res);
-            return 0;
+    if (!pooled) {
+        curl_easy_cleanup(curl);
+        return;
+    }
+
+    pthread_mutex_lock(&__g_req_pool_lock);
+
+    for (i = 0; i < IOTEX_EMB_REQ_POOL_SIZE; i++) {
+        if (__g_req_pool[i].curl == curl) {
+            __g_req_pool[i].busy = 0;
+            break;
         }
+    }
+
+    pthread_mutex_unlock(&__g_req_pool_lock);
+}
+
+
+/*
+ * @brief: curl receive data callback, append received data to iotex_st_response_data
+ */
+static size_t _curl_write_callback(char *ptr, size_t size, size_t nmemb, void *userdata) {
 
-        res->data = new_ptr;
+    size_t new_len = size * nmemb;
+    iotex_st_response_data *res = userdata;
+
+    /* Keep one byte for the terminating NUL */
+    if (res->len + new_len + 1 > res->max_size) {
+        __WARN_MSG__("response buffer too short!");
+        return 0;
     }
 
     /* Append new data to response data */
     memcpy(res->data + res->len, ptr, new_len);
     res->len += new_len;
+    res->data[res->len] = 0;
+
+    /* Let the caller consume the response while it is still arriving */
+    if (res->callback && res->callback(res->data, res->len, res->arg) != 0) {
+        return 0;
+    }
+
     return new_len;
 }
 
@@ -215,34 +345,46 @@ char *req_compose_url(char *url, size_t url_max_size, iotex_em_request req, ...)
  * #response: store request response data
  * #response_max_size: #response buffer max len
  * #is_post: set this indicate it's a post request
+ * #callback: called after each received chunk, NULL if not needed
+ * #arg: #callback argument
  * $return: successed return 0, failed return negative error code
  *
  * TODO:
  * 1. add meaningful error code
- * 2. add zero copy version ? (don't forget release response)
- * 3. add two-way authentication support
+ * 2. add two-way authentication support
  */
-static int req_basic_request(const char *request, char *response, size_t response_max_size, uint32_t is_post) {
+static int req_basic_request(const char *request, char *response, size_t response_max_size, uint32_t is_post,
+                             req_stream_callback callback, void *arg) {
 
     assert(request != NULL);
     assert(response != NULL);
 
     CURL *curl;
     CURLcode ret;
-    iotex_st_response_data res = {};
+    uint32_t pooled = 0;
     iotex_st_config config = get_config();
+    iotex_st_response_data res = {response, 0, response_max_size, callback, arg};
 
-    if (!(curl = curl_easy_init())) {
+    if (response_max_size == 0) {
+        return -1;
+    }
+
+    if (!(curl = _req_acquire_handle(&pooled))) {
         __WARN_MSG__("curl_easy_init");
         return -1;
     }
 
+    /* The handle may come from a previous request, set every option it uses */
     if (is_post) {
         curl_easy_setopt(curl, CURLOPT_POST, 1L);
         curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, 0L);
     }
+    else {
+        curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+    }
 
     curl_easy_setopt(curl, CURLOPT_URL, request);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
 
     /* Set the file with the certs vaildating the server */
     curl_easy_setopt(curl, CURLOPT_CAINFO, config.cert_file);
@@ -258,33 +400,68 @@ static int req_basic_request(const char *request, char *response, size_t respons
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, &res);
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, _curl_write_callback);
 
-    if ((ret = curl_easy_perform(curl)) != CURLE_OK) {
-        __WARN_MSG__(curl_easy_strerror(ret));
-        curl_easy_cleanup(curl);
-        return -1;
-    }
+    response[0] = 0;
+    ret = curl_easy_perform(curl);
 
-    if (res.len + 1 > response_max_size) {
-        _free_response_data(&res);
-        curl_easy_cleanup(curl);
+    /* Don't leave a pointer to this stack frame in a pooled handle */
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, NULL);
+    _req_release_handle(curl, pooled);
+
+    if (ret != CURLE_OK) {
+        __WARN_MSG__(curl_easy_strerror(ret));
         return -1;
     }
 
-    /* Copy data to response */
-    memcpy(response, res.data, res.len);
-    response[res.len] = 0;
-
-    _free_response_data(&res);
-    curl_easy_cleanup(curl);
     return 0;
 }
 
 int req_get_request(const char *request, char *response, size_t response_max_size) {
 
-    return req_basic_request(request, response, response_max_size, 0);
+    return req_basic_request(request, response, response_max_size, 0, NULL, NULL);
 }
 
 int req_post_request(const char *request, char *response, size_t response_max_size) {
 
-    return req_basic_request(request, response, response_max_size, 1);
+    return req_basic_request(request, response, response_max_size, 1, NULL, NULL);
+}
+
+int req_get_request_stream(const char *request, char *response, size_t response_max_size,
+                           req_stream_callback callback, void *arg) {
+
+    return req_basic_request(request, response, response_max_size, 0, callback, arg);
+}
+
+/*
+ * @brief: close pooled connections and release curl, the pool is created again on next request
+ */
+void req_exit(void) {
+
+    int i;
+
+    pthread_mutex_lock(&__g_req_pool_lock);
+
+    for (i = 0; i < IOTEX_EMB_REQ_POOL_SIZE; i++) {
+
+        /* A handle still in use is released by its request */
+        if (__g_req_pool[i].curl && !__g_req_pool[i].busy) {
+            curl_easy_cleanup(__g_req_pool[i].curl);
+            __g_req_pool[i].curl = NULL;
+        }
+    }
+
+    if (__g_req_share) {
+
+        /* Fails while a handle still uses it, it's kept for the next exit then */
+        if (curl_share_cleanup(__g_req_share) == CURLSHE_OK) {
+
+            for (i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+                pthread_mutex_destroy(&__g_req_share_locks[i]);
+            }
+
+            __g_req_share = NULL;
+            curl_global_cleanup();
+        }
+    }
+
+    pthread_mutex_unlock(&__g_req_pool_lock);
 }
@@ -6,6 +6,7 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <stddef.h>
 
 typedef enum {
 
@@ -26,9 +27,19 @@ typedef enum {
 } iotex_em_request;
 
 
+/*
+ * Called each time a chunk of the response arrives, #response holds the #len bytes
+ * received so far (NUL terminated). Return non-zero to abort the request.
+ */
+typedef int (*req_stream_callback)(const char *response, size_t len, void *arg);
+
+
 char *req_compose_url(char *url, size_t url_max_size, iotex_em_request req, ...);
 int req_get_request(const char *request, char *response, size_t response_max_size);
 int req_post_request(const char *request, char *response, size_t response_max_size);
+int req_get_request_stream(const char *request, char *response, size_t response_max_size,
+                           req_stream_callback callback, void *arg);
+void req_exit(void);
 
 #ifdef __cplusplus
 }
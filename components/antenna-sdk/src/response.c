@@ -15,6 +15,15 @@
 #define SET_ERROR_DESC(error, desc) do {if (desc && error) *desc = strndup(error, strlen(error));} while (0)
 
 
+/*
+ * @brief: req_stream_callback, tokenize response json while it's being received
+ */
+static int res_stream_feed(const char *response, size_t len, void *arg) {
+
+    return json_stream_feed((json_stream *)arg, response, len);
+}
+
+
 /*
  * @brief: send request to http server and get response data then follow the rule parse json string to struct data
  * #request: http request should include base url and post data
@@ -23,16 +32,23 @@
  */
 int res_get_data(const char *request, json_parse_rule *rules) {
     char *response = NULL;
+    json_stream *stream = NULL;
 
     if ((response = malloc(IOTEX_EBM_MAX_RES_LEN)) == NULL) {
         return -IOTEX_E_MEM;
     }
 
+    if ((stream = json_stream_new()) == NULL) {
+        free(response);
+        return -IOTEX_E_MEM;
+    }
+
 #ifdef _DEBUG_HTTP_
     __INFO_MSG__(request);
 #endif
 
-    if (req_get_request(request, response, IOTEX_EBM_MAX_RES_LEN) != 0) {
+    if (req_get_request_stream(request, response, IOTEX_EBM_MAX_RES_LEN, res_stream_feed, stream) != 0) {
+        json_stream_free(stream);
         free(response);
         return -IOTEX_E_REQUEST;
     }
@@ -41,11 +57,13 @@ int res_get_data(const char *request, json_parse_rule *rules) {
     __INFO_MSG__(response);
 #endif
 
-    if (json_parse_response(response, rules) != 0) {
+    if (json_stream_parse(stream, response, rules) != 0) {
+        json_stream_free(stream);
         free(response);
         return -IOTEX_E_PARSE;
     }
 
+    json_stream_free(stream);
     free(response);
     return 0;
 }
@@ -1,6 +1,12 @@
 #include <stdbool.h>
+#include <string.h>
 #include "mbedtls/config.h"
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
 #include "cryptoauthlib.h"
 #include "mbedtls/atca_mbedtls_wrap.h"
 #include "esp_log.h"
@@ -18,6 +24,31 @@
 
 static const char *TAG = "atecc608";
 
+#define ATECC608_QUEUE_LEN 8
+#define ATECC608_BATCH_MAX 4
+
+typedef enum {
+    ATECC608_OP_SIGN,
+    ATECC608_OP_GET_PUBKEY,
+} Atecc608_Op_t;
+
+typedef struct {
+    Atecc608_Op_t op;
+    uint16_t key_id;
+    uint8_t digest[ATECC608_DIGEST_SIZE];
+    Atecc608_Callback_t callback;
+    void *arg;
+} Atecc608_Request_t;
+
+typedef struct {
+    SemaphoreHandle_t done;
+    uint8_t *signature;
+    ATCA_STATUS status;
+} Atecc608_SyncSign_t;
+
+static QueueHandle_t request_queue = NULL;
+static TaskHandle_t request_task = NULL;
+
 static mbedtls_entropy_context entropy;
 static mbedtls_ctr_drbg_context ctr_drbg;
 
@@ -57,9 +88,7 @@ ATCA_STATUS Atecc608_GetSerialString(char * sn) {
     int ret;
     uint8_t serial[ATCA_SERIAL_NUM_SIZE];
     
-    i2c_take_port(ATECC608_I2C_PORT, portMAX_DELAY);    
     ret = atcab_read_serial_number(serial);
-    i2c_free_port(ATECC608_I2C_PORT);
     
     if (ret != ATCA_SUCCESS) {
         ESP_LOGI(TAG, "*FAILED* atcab_read_serial_number returned %02x", ret);
@@ -110,9 +139,184 @@ ATCA_STATUS Atecc608_Init() {
             }
             ESP_LOGI(TAG, "ok: %02x %02x", buf[2], buf[3]);
         }
+
+        if (Atecc608_StartTask() != ATCA_SUCCESS) {
+            ESP_LOGE(TAG, "*FAILED* could not start the secure element task");
+            return ATCA_ALLOC_FAILURE;
+        }
    
 
     }
 
     return ret;
 }
+
+/*
+ * Runs the queued requests in one go. The chip is held for the whole batch (so
+ * nothing else can load a message between our nonce and sign) and the RNG seed
+ * is updated once instead of for every signature. The I2C bus is only held for
+ * the transfers, the HAL lets go of it while the chip computes.
+ */
+static void Atecc608_RunBatch(Atecc608_Request_t *batch, ATCA_STATUS *status, uint8_t (*out)[ATCA_SIG_SIZE], int count) {
+    bool seeded = false;
+    uint8_t nonce_target = NONCE_MODE_TARGET_TEMPKEY;
+    uint8_t sign_source = SIGN_MODE_SOURCE_TEMPKEY;
+
+    if (atcab_get_device_type() == ATECC608A) {
+        nonce_target = NONCE_MODE_TARGET_MSGDIGBUF;
+        sign_source = SIGN_MODE_SOURCE_MSGDIGBUF;
+    }
+
+    (void)atcab_wakeup();
+
+    for (int i = 0; i < count; i++) {
+        switch (batch[i].op) {
+            case ATECC608_OP_SIGN:
+                status[i] = ATCA_SUCCESS;
+                if (!seeded) {
+                    status[i] = atcab_random(NULL);
+                    seeded = status[i] == ATCA_SUCCESS;
+                }
+                if (status[i] == ATCA_SUCCESS) {
+                    status[i] = atcab_nonce_load(nonce_target, batch[i].digest, ATECC608_DIGEST_SIZE);
+                }
+                if (status[i] == ATCA_SUCCESS) {
+                    status[i] = atcab_sign_base(SIGN_MODE_EXTERNAL | sign_source, batch[i].key_id, out[i]);
+                }
+                break;
+            case ATECC608_OP_GET_PUBKEY:
+                status[i] = atcab_get_pubkey(batch[i].key_id, out[i]);
+                break;
+            default:
+                status[i] = ATCA_BAD_PARAM;
+                break;
+        }
+    }
+
+    (void)atcab_idle();
+}
+
+static void Atecc608_Task(void *arg) {
+    Atecc608_Request_t batch[ATECC608_BATCH_MAX];
+    ATCA_STATUS status[ATECC608_BATCH_MAX];
+    uint8_t out[ATECC608_BATCH_MAX][ATCA_SIG_SIZE];
+    int count;
+
+    for (;;) {
+        xQueueReceive(request_queue, &batch[0], portMAX_DELAY);
+        count = 1;
+        while (count < ATECC608_BATCH_MAX && xQueueReceive(request_queue, &batch[count], 0) == pdTRUE) {
+            count++;
+        }
+
+        Atecc608_RunBatch(batch, status, out, count);
+
+        // callbacks run after the chip is released, they may queue more requests
+        for (int i = 0; i < count; i++) {
+            if (status[i] != ATCA_SUCCESS) {
+                ESP_LOGW(TAG, "request %d on slot %d failed: %02x", batch[i].op, batch[i].key_id, status[i]);
+            }
+            batch[i].callback(status[i], status[i] == ATCA_SUCCESS ? out[i] : NULL, batch[i].arg);
+        }
+        memset(out, 0, sizeof(out));
+    }
+}
+
+ATCA_STATUS Atecc608_StartTask(void) {
+    if (request_queue != NULL) {
+        return ATCA_SUCCESS;
+    }
+
+    request_queue = xQueueCreate(ATECC608_QUEUE_LEN, sizeof(Atecc608_Request_t));
+    if (request_queue == NULL) {
+        return ATCA_ALLOC_FAILURE;
+    }
+
+    if (xTaskCreatePinnedToCore(Atecc608_Task, "Atecc608Task", 4 * 1024, NULL, 1, &request_task, 0) != pdPASS) {
+        vQueueDelete(request_queue);
+        request_queue = NULL;
+        return ATCA_ALLOC_FAILURE;
+    }
+
+    return ATCA_SUCCESS;
+}
+
+static ATCA_STATUS Atecc608_Queue(Atecc608_Request_t *request, TickType_t timeout) {
+    if (request->callback == NULL) {
+        return ATCA_BAD_PARAM;
+    }
+
+    if (request_queue == NULL) {
+        return ATCA_FUNC_FAIL;
+    }
+
+    if (xQueueSend(request_queue, request, timeout) != pdTRUE) {
+        return ATCA_TIMEOUT;
+    }
+
+    return ATCA_SUCCESS;
+}
+
+ATCA_STATUS Atecc608_SignAsync(uint16_t key_id, const uint8_t *digest, Atecc608_Callback_t callback, void *arg, TickType_t timeout) {
+    Atecc608_Request_t request = {
+        .op = ATECC608_OP_SIGN,
+        .key_id = key_id,
+        .callback = callback,
+        .arg = arg,
+    };
+
+    if (digest == NULL) {
+        return ATCA_BAD_PARAM;
+    }
+    memcpy(request.digest, digest, sizeof(request.digest));
+
+    return Atecc608_Queue(&request, timeout);
+}
+
+ATCA_STATUS Atecc608_GetPubkeyAsync(uint16_t key_id, Atecc608_Callback_t callback, void *arg, TickType_t timeout) {
+    Atecc608_Request_t request = {
+        .op = ATECC608_OP_GET_PUBKEY,
+        .key_id = key_id,
+        .callback = callback,
+        .arg = arg,
+    };
+
+    return Atecc608_Queue(&request, timeout);
+}
+
+static void Atecc608_SyncSignDone(ATCA_STATUS status, const uint8_t *data, void *arg) {
+    Atecc608_SyncSign_t *sync = (Atecc608_SyncSign_t *)arg;
+
+    sync->status = status;
+    if (data != NULL) {
+        memcpy(sync->signature, data, ATCA_SIG_SIZE);
+    }
+    xSemaphoreGive(sync->done);
+}
+
+ATCA_STATUS Atecc608_Sign(uint16_t key_id, const uint8_t *digest, uint8_t *signature) {
+    ATCA_STATUS ret;
+    Atecc608_SyncSign_t sync = {
+        .signature = signature,
+        .status = ATCA_GEN_FAIL,
+    };
+
+    // would wait for itself
+    if (signature == NULL || xTaskGetCurrentTaskHandle() == request_task) {
+        return ATCA_BAD_PARAM;
+    }
+
+    sync.done = xSemaphoreCreateBinary();
+    if (sync.done == NULL) {
+        return ATCA_ALLOC_FAILURE;
+    }
+
+    ret = Atecc608_SignAsync(key_id, digest, Atecc608_SyncSignDone, &sync, portMAX_DELAY);
+    if (ret == ATCA_SUCCESS) {
+        xSemaphoreTake(sync.done, portMAX_DELAY);
+        ret = sync.status;
+    }
+
+    vSemaphoreDelete(sync.done);
+    return ret;
+}
@@ -6,12 +6,33 @@
 #pragma once
 
 #include "stdio.h"
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "cryptoauthlib.h"
 
 /** @brief I2C port the ATECC608 uses to communicate with the ESP32-D0WD main MCU */
 /* @[declare_atecc608_i2c_port] */
 #define ATECC608_I2C_PORT I2C_NUM_1
 /* @[declare_atecc608_i2c_port] */
 
+/** @brief Size of the digest signed by Atecc608_SignAsync() and Atecc608_Sign(). */
+/* @[declare_atecc608_digest_size] */
+#define ATECC608_DIGEST_SIZE 32
+/* @[declare_atecc608_digest_size] */
+
+/**
+ * @brief Completion callback of a queued secure element request.
+ *
+ * Called from the secure element task. data is the 64 byte signature (R and S)
+ * or public key (X and Y), valid only during the call, and NULL when status is
+ * not ATCA_SUCCESS. The callback may queue more requests but must not wait for
+ * them, e.g. by calling Atecc608_Sign().
+ */
+/* @[declare_atecc608_callback_t] */
+typedef void (*Atecc608_Callback_t)(ATCA_STATUS status, const uint8_t *data, void *arg);
+/* @[declare_atecc608_callback_t] */
+
 /**
  * @brief Initializes the ATECC608 Trust&GO on the I2C bus.
  * 
@@ -53,4 +74,81 @@ ATCA_STATUS Atecc608_Init();
  */
 /* @[declare_atecc608_getserialstring] */
 ATCA_STATUS Atecc608_GetSerialString(char * sn);
-/* @[declare_atecc608_getserialstring] */
\ No newline at end of file
+/* @[declare_atecc608_getserialstring] */
+
+/**
+ * @brief Queues a signature of a digest with the private key in a slot.
+ *
+ * Requests are run by a secure element task that Atecc608_Init() starts.
+ * Requests queued while the chip is busy are run back to back as one batch,
+ * which updates the RNG seed once instead of for every signature. The shared
+ * I2C bus is released while the chip computes, so the PMU, touch and IMU
+ * can use it during a signature.
+ *
+ * **Example:**
+ *
+ * Sign a SHA-256 digest with the key in slot 0.
+ * @code{c}
+ *  static void signed_cb(ATCA_STATUS status, const uint8_t *signature, void *arg) {
+ *      if (status == ATCA_SUCCESS) {
+ *          // use the 64 byte signature
+ *      }
+ *  }
+ *
+ *  Atecc608_SignAsync(0, digest, signed_cb, NULL, portMAX_DELAY);
+ * @endcode
+ *
+ * @param[in] key_id Slot of the private key.
+ * @param[in] digest The ATECC608_DIGEST_SIZE byte digest, copied into the request.
+ * @param[in] callback Called with the signature when done.
+ * @param[in] arg Passed to the callback.
+ * @param[in] timeout Ticks to wait for room in the queue.
+ *
+ * @return ATCA_SUCCESS when queued, ATCA_TIMEOUT when the queue stayed full.
+ */
+/* @[declare_atecc608_signasync] */
+ATCA_STATUS Atecc608_SignAsync(uint16_t key_id, const uint8_t *digest, Atecc608_Callback_t callback, void *arg, TickType_t timeout);
+/* @[declare_atecc608_signasync] */
+
+/**
+ * @brief Queues a read of the public key of the private key in a slot.
+ *
+ * Same as Atecc608_SignAsync(), the callback gets the 64 byte public key.
+ *
+ * @param[in] key_id Slot of the private key.
+ * @param[in] callback Called with the public key when done.
+ * @param[in] arg Passed to the callback.
+ * @param[in] timeout Ticks to wait for room in the queue.
+ *
+ * @return ATCA_SUCCESS when queued, ATCA_TIMEOUT when the queue stayed full.
+ */
+/* @[declare_atecc608_getpubkeyasync] */
+ATCA_STATUS Atecc608_GetPubkeyAsync(uint16_t key_id, Atecc608_Callback_t callback, void *arg, TickType_t timeout);
+/* @[declare_atecc608_getpubkeyasync] */
+
+/**
+ * @brief Signs a digest through the secure element task and waits for it.
+ *
+ * Blocks the calling task only, the I2C bus stays usable while the chip
+ * computes. Must not be called from an Atecc608_Callback_t.
+ *
+ * @param[in] key_id Slot of the private key.
+ * @param[in] digest The ATECC608_DIGEST_SIZE byte digest.
+ * @param[out] signature The 64 byte signature.
+ *
+ * @return Status of the sign operation, 0 is success.
+ */
+/* @[declare_atecc608_sign] */
+ATCA_STATUS Atecc608_Sign(uint16_t key_id, const uint8_t *digest, uint8_t *signature);
+/* @[declare_atecc608_sign] */
+
+/**
+ * @brief Starts the secure element task.
+ *
+ * @note Atecc608_Init() calls this function, calling it again does nothing.
+ *
+ * @return ATCA_SUCCESS, or ATCA_ALLOC_FAILURE.
+ */
+/* @[declare_atecc608_starttask] */
+ATCA_STATUS Atecc608_StartTask(void);
+/* @[declare_atecc608_starttask] */
@@ -8,6 +8,7 @@ static I2CDevice_t axp192_device;
 
 void Axp192_I2CInit() {
     axp192_device = i2c_malloc_device(I2C_NUM_1, 21, 22, 400000, AXP192_ADDR);
+    i2c_device_set_priority(axp192_device, I2C_PRIORITY_LOW);
 }
 
 bool Axp192_WriteBytes(uint8_t reg_addr, uint8_t *data, uint16_t length) {
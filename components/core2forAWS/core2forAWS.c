@@ -31,7 +31,7 @@ static const char *TAG = "Core2forAWS";
 
 void Core2ForAWS_Init(void) {    
 #if CONFIG_SOFTWARE_ILI9342C_SUPPORT || CONFIG_SOFTWARE_SDCARD_SUPPORT
-    spi_mutex = xSemaphoreCreateMutex();
+    spi_bus_init();
     spi_bus_config_t bus_cfg = {
         .mosi_io_num = 23,
         .miso_io_num = 38,
@@ -227,6 +227,7 @@ void Core2ForAWS_Sk6812_Init(void) {
     px.pixels = (uint8_t *)malloc((px.nbits / 8) * px.pixel_count);
     neopixel_init(GPIO_NUM_25, RMT_CHANNEL_0);
     np_clear(&px);
+    sk6812_fx_start(&px, RMT_CHANNEL_0);
 }
 
 void Core2ForAWS_Sk6812_SetColor(uint16_t pos, uint32_t color) {
@@ -256,6 +257,27 @@ void Core2ForAWS_Sk6812_Show(void) {
 void Core2ForAWS_Sk6812_Clear(void) {
     np_clear(&px);
 }
+
+bool Core2ForAWS_Sk6812_Fade(uint32_t left_color, uint32_t right_color, uint16_t duration_ms) {
+    sk6812_fx_t fx = {
+        .type = SK6812_FX_FADE,
+        .left = left_color,
+        .right = right_color,
+        .duration_ms = duration_ms,
+    };
+    return sk6812_fx_post(&fx);
+}
+
+bool Core2ForAWS_Sk6812_Pulse(uint32_t left_color, uint32_t right_color, uint16_t period_ms, uint8_t count) {
+    sk6812_fx_t fx = {
+        .type = SK6812_FX_PULSE,
+        .left = left_color,
+        .right = right_color,
+        .duration_ms = period_ms,
+        .count = count,
+    };
+    return sk6812_fx_post(&fx);
+}
 #endif
 /* ----------------------------------------------- End -----------------------------------------------*/
 /* ===================================================================================================*/
@@ -266,12 +288,13 @@ void Core2ForAWS_Sk6812_Clear(void) {
 
 #define DISPLAY_BRIGHTNESS_MIN_VOLT 2200
 #define DISPLAY_BRIGHTNESS_MAX_VOLT 3300
-#define LV_TICK_PERIOD_MS 1
 
 SemaphoreHandle_t xGuiSemaphore;
 
+static TaskHandle_t gui_task_handle;
+
 static void guiTask(void *pvParameter);
-static void lv_tick_task(void *arg);
+static void gui_invalidate_cb(lv_disp_drv_t *drv);
 
 #if CONFIG_SOFTWARE_FT6336U_SUPPORT
 static bool ft6336u_read(lv_indev_drv_t * drv, lv_indev_data_t * data);
@@ -293,9 +316,19 @@ void Core2ForAWS_Display_Init(void) {
 
     static lv_disp_buf_t disp_buf;
 
+    /* Both bands in internal RAM the SPI DMA reads directly: LVGL renders one
+     * while the other is being sent. SPIRAM still works, through a bounce
+     * buffer the SPI driver allocates and fills for every flush. */
     uint32_t size_in_px = DISP_BUF_SIZE;
-    lv_color_t *buf1 = heap_caps_malloc(DISP_BUF_SIZE * sizeof(lv_color_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT); //Assuming max size of lv_color_t = 16bit, DISP_BUF_SIZE calculated from max horizontal display size 480
-    lv_color_t *buf2 = heap_caps_malloc(DISP_BUF_SIZE * sizeof(lv_color_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT); //Assuming max size of lv_color_t = 16bit, DISP_BUF_SIZE calculated from max horizontal display size 480
+    lv_color_t *buf1 = heap_caps_malloc(DISP_BUF_SIZE * sizeof(lv_color_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    lv_color_t *buf2 = heap_caps_malloc(DISP_BUF_SIZE * sizeof(lv_color_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (buf1 == NULL || buf2 == NULL) {
+        ESP_LOGW(TAG, "No internal DMA memory for the display buffers, using SPIRAM");
+        heap_caps_free(buf1);
+        heap_caps_free(buf2);
+        buf1 = heap_caps_malloc(DISP_BUF_SIZE * sizeof(lv_color_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        buf2 = heap_caps_malloc(DISP_BUF_SIZE * sizeof(lv_color_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
     
     /* Initialize the working buffer depending on the selected display */
     lv_disp_buf_init(&disp_buf, buf1, buf2, size_in_px);
@@ -303,6 +336,7 @@ void Core2ForAWS_Display_Init(void) {
     lv_disp_drv_t disp_drv;
     lv_disp_drv_init(&disp_drv);
     disp_drv.flush_cb = disp_driver_flush;
+    disp_drv.invalidate_cb = gui_invalidate_cb;
 
     disp_drv.buffer = &disp_buf;
     lv_disp_drv_register(&disp_drv);
@@ -316,18 +350,11 @@ void Core2ForAWS_Display_Init(void) {
     lv_indev_drv_register(&indev_drv);
 #endif
 
-    /* Create and start a periodic timer interrupt to call lv_tick_inc */
-    const esp_timer_create_args_t periodic_timer_args = {
-        .callback = &lv_tick_task,
-        .name = "periodic_gui"
-    };
-    esp_timer_handle_t periodic_timer;
-    ESP_ERROR_CHECK(esp_timer_create(&periodic_timer_args, &periodic_timer));
-    ESP_ERROR_CHECK(esp_timer_start_periodic(periodic_timer, LV_TICK_PERIOD_MS * 1000));
+    /* LVGL reads its tick from esp_timer_get_time (LV_TICK_CUSTOM), no tick timer needed */
 
     xSemaphoreGive(xGuiSemaphore);
 
-    xTaskCreatePinnedToCore(guiTask, "gui", 4096*2, NULL, 2, NULL, 1);
+    xTaskCreatePinnedToCore(guiTask, "gui", 4096*2, NULL, 2, &gui_task_handle, 1);
 }
 
 void Core2ForAWS_Display_SetBrightness(uint8_t brightness) {
@@ -344,7 +371,18 @@ void Core2ForAWS_LED_Enable(uint8_t enable) {
 }
 
 #if CONFIG_SOFTWARE_FT6336U_SUPPORT
+/* Reads the touch events queued by the FT6336U interrupt, no I2C access here.
+ * Returning true makes LVGL call it again in the same cycle until the queue is empty. */
 static bool ft6336u_read(lv_indev_drv_t * drv, lv_indev_data_t * data) {
+    FT6336U_Event_t event;
+    if (FT6336U_ReadEvent(&event)) {
+        data->point.x = event.x;
+        data->point.y = event.y;
+        data->state = event.type == FT6336U_EVENT_RELEASE ? LV_INDEV_STATE_REL : LV_INDEV_STATE_PR;
+        return FT6336U_EventPending();
+    }
+
+    /* Nothing new: repeat the current state, it's also right after a queue overflow */
     bool valid = true;
     uint16_t x = 0;
     uint16_t y = 0;
@@ -356,31 +394,46 @@ static bool ft6336u_read(lv_indev_drv_t * drv, lv_indev_data_t * data) {
 }
 #endif
 
-static void lv_tick_task(void *arg) {
-    (void) arg;
-    lv_tick_inc(LV_TICK_PERIOD_MS);
+/* Runs under xGuiSemaphore in whichever task invalidated something */
+static void gui_invalidate_cb(lv_disp_drv_t *drv) {
+    (void) drv;
+    if (gui_task_handle != NULL) {
+        xTaskNotifyGive(gui_task_handle);
+    }
 }
 
 /**
- * @brief The FreeRTOS task that periodically calls lv_task_handler
+ * @brief The FreeRTOS task that calls lv_task_handler when there is work
  * 
- * A FreeRTOS task function that calls [lv_task_handler](https://docs.lvgl.io/7.11/porting/task-handler.html)
- * after a tick (depends on task prioritization), which executes 
- * LVGL tasks to then pass to the display controller. Learn more 
+ * A FreeRTOS task function that calls [lv_task_handler](https://docs.lvgl.io/7.11/porting/task-handler.html),
+ * which executes LVGL tasks to then pass to the display controller. Learn more 
  * about LVGL Tasks[https://docs.lvgl.io/7.11/overview/task.html].
+ *
+ * Between calls it sleeps until the next LVGL task is due, or until something
+ * invalidates the screen. The display refresh task only runs while there is
+ * something to redraw, at most every LV_DISP_DEF_REFR_PERIOD, so a screen
+ * that does not change costs no CPU.
  */
 static void guiTask(void *pvParameter) {
     
     (void) pvParameter;
 
+    uint32_t time_till_next = 0;
 
     while (1) {
-        /* Delay 1 tick (assumes FreeRTOS tick is 10ms */
-        vTaskDelay(pdMS_TO_TICKS(10));
+        /* At least one tick, even if an LVGL task is already due */
+        TickType_t sleep = portMAX_DELAY;
+        if (time_till_next != LV_NO_TASK_READY) {
+            sleep = pdMS_TO_TICKS(time_till_next);
+            if (sleep == 0) {
+                sleep = 1;
+            }
+        }
+        ulTaskNotifyTake(pdTRUE, sleep);
 
         /* Try to take the semaphore, call lvgl related function on success */
         if (pdTRUE == xSemaphoreTake(xGuiSemaphore, portMAX_DELAY)) {
-            lv_task_handler();
+            time_till_next = lv_task_handler();
             xSemaphoreGive(xGuiSemaphore);
        }
     }
@@ -50,6 +50,7 @@ extern SemaphoreHandle_t xGuiSemaphore;
 
 #if CONFIG_SOFTWARE_SK6812_SUPPORT
 #include "sk6812.h"
+#include "sk6812_fx.h"
 /**
  * @brief LEDs on left side of the LED bar. For use with Core2ForAWS_Sk6812_SetSideColor().
  */
@@ -100,6 +101,10 @@ extern SemaphoreHandle_t xGuiSemaphore;
 #include "sdmmc_cmd.h"
 #endif
 
+#if CONFIG_SOFTWARE_ILI9342C_SUPPORT || CONFIG_SOFTWARE_SDCARD_SUPPORT
+#include "spi_bus.h"
+#endif
+
 #if CONFIG_SOFTWARE_EXPPORTS_SUPPORT
 #include "driver/gpio.h"
 #include "driver/uart.h"
@@ -581,6 +586,67 @@ void Core2ForAWS_Sk6812_Show(void);
 /* @[declare_core2foraws_sk6812_clear] */
 void Core2ForAWS_Sk6812_Clear(void);
 /* @[declare_core2foraws_sk6812_clear] */
+
+/**
+ * @brief Fades the LED bars from their current colors to new ones
+ * in the background.
+ *
+ * Only posts the effect to the LED task and returns, it never waits
+ * for the LEDs. The effect replaces any running one.
+ *
+ * **Example:**
+ *
+ * Fade the left LED bar to green and the right one to off in 150ms.
+ * @code{c}
+ *  Core2ForAWS_Sk6812_Fade(0x00ff00, 0x000000, 150);
+ * @endcode
+ *
+ * @param[in] left_color Color of the left LED bar.
+ * Accepts hexadecimal (web colors).
+ *
+ * @param[in] right_color Color of the right LED bar.
+ * Accepts hexadecimal (web colors).
+ *
+ * @param[in] duration_ms Fade time, 0 sets the colors on the next frame.
+ *
+ * @return true if the effect was posted, false if the LED task's
+ * queue is full.
+ */
+/* @[declare_core2foraws_sk6812_fade] */
+bool Core2ForAWS_Sk6812_Fade(uint32_t left_color, uint32_t right_color, uint16_t duration_ms);
+/* @[declare_core2foraws_sk6812_fade] */
+
+/**
+ * @brief Pulses the LED bars in the background: the colors
+ * breathe in and out, then the LEDs turn off.
+ *
+ * Only posts the effect to the LED task and returns, it never waits
+ * for the LEDs. The effect replaces any running one.
+ *
+ * **Example:**
+ *
+ * Pulse both LED bars white 3 times, each over half a second.
+ * @code{c}
+ *  Core2ForAWS_Sk6812_Pulse(0xffffff, 0xffffff, 500, 3);
+ * @endcode
+ *
+ * @param[in] left_color Peak color of the left LED bar.
+ * Accepts hexadecimal (web colors).
+ *
+ * @param[in] right_color Peak color of the right LED bar.
+ * Accepts hexadecimal (web colors).
+ *
+ * @param[in] period_ms Time of one pulse.
+ *
+ * @param[in] count Number of pulses, 0 keeps pulsing until the
+ * next effect.
+ *
+ * @return true if the effect was posted, false if the LED task's
+ * queue is full.
+ */
+/* @[declare_core2foraws_sk6812_pulse] */
+bool Core2ForAWS_Sk6812_Pulse(uint32_t left_color, uint32_t right_color, uint16_t period_ms, uint8_t count);
+/* @[declare_core2foraws_sk6812_pulse] */
 #endif
 
 #if CONFIG_SOFTWARE_SDCARD_SUPPORT
@@ -590,11 +656,13 @@ void Core2ForAWS_Sk6812_Clear(void);
  *
  * @note The SD Card must be mounted before use. The SD card
  * and the screen uses the same SPI bus. In order to avoid
- * conflicts with the screen, you must take the spi_mutex
- * semaphore, then call spi_poll() before accessing the SD card.
- * Once done, give/free the semaphore so the display can take it.
- * The display task will then continue to update the display
- * controller on the SPI bus.
+ * conflicts with the screen, you must acquire the bus with
+ * spi_bus_acquire(SPI_BUS_CLIENT_SDCARD, ...), then call spi_poll()
+ * before accessing the SD card. Once done, release it with
+ * spi_bus_release() so the display can take it. Keep each hold
+ * short (one chunk of a larger write): the bus goes to whichever
+ * client's deadline is closest, and the display only refreshes
+ * between SD holds.
  *
  * Reading/writing to an inserted SD card can use the standard C
  * functions fopen or fprintf to work with Espressif's virtual
@@ -611,7 +679,7 @@ void Core2ForAWS_Sk6812_Clear(void);
  *  sdmmc_card_t* card;
  *  esp_err_t err;
  *
- *  xSemaphoreTake(spi_mutex, portMAX_DELAY);
+ *  spi_bus_acquire(SPI_BUS_CLIENT_SDCARD, SPI_BUS_SDCARD_DEADLINE_MS);
  *
  *  spi_poll();
  *
@@ -621,7 +689,7 @@ void Core2ForAWS_Sk6812_Clear(void);
  *  fprintf(f, "Hello %s!\n", card->cid.name);
  *  fclose(f);
  *
- *  xSemaphoreGive(spi_mutex);
+ *  spi_bus_release(SPI_BUS_CLIENT_SDCARD);
  * @endcode
  *
  * @param[in] mount_path The path where partition should be registered.
@@ -638,11 +706,13 @@ esp_err_t Core2ForAWS_SDcard_Mount(const char *mount_path, sdmmc_card_t **out_ca
  *
  * @note The SD Card must be mounted before use. The SD card
  * and the screen uses the same SPI bus. In order to avoid
- * conflicts with the screen, you must take the spi_mutex
- * semaphore, then call spi_poll() before accessing the SD card.
- * Once done, give/free the semaphore so the display can take it.
- * The display task will then continue to update the display
- * controller on the SPI bus.
+ * conflicts with the screen, you must acquire the bus with
+ * spi_bus_acquire(SPI_BUS_CLIENT_SDCARD, ...), then call spi_poll()
+ * before accessing the SD card. Once done, release it with
+ * spi_bus_release() so the display can take it. Keep each hold
+ * short (one chunk of a larger write): the bus goes to whichever
+ * client's deadline is closest, and the display only refreshes
+ * between SD holds.
  *
  * To learn more about using the SD card, visit Espressif's virtual
  * [file system component](https://docs.espressif.com/projects/esp-idf/en/release-v4.2/esp32/api-reference/storage/vfs.html)
@@ -658,7 +728,7 @@ esp_err_t Core2ForAWS_SDcard_Mount(const char *mount_path, sdmmc_card_t **out_ca
  *  sdmmc_card_t* card;
  *  esp_err_t err;
  *
- *  xSemaphoreTake(spi_mutex, portMAX_DELAY);
+ *  spi_bus_acquire(SPI_BUS_CLIENT_SDCARD, SPI_BUS_SDCARD_DEADLINE_MS);
  *
  *  spi_poll();
  *
@@ -669,7 +739,7 @@ esp_err_t Core2ForAWS_SDcard_Mount(const char *mount_path, sdmmc_card_t **out_ca
  *  fclose(f);
  *
  *  err = Core2ForAWS_Sdcard_Unmount(MOUNT_POINT, &card);
- *  xSemaphoreGive(spi_mutex);
+ *  spi_bus_release(SPI_BUS_CLIENT_SDCARD);
  * @endcode
  *
  * @param[in] mount_path The path where partition should be registered.
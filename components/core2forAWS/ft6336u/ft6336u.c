@@ -1,8 +1,10 @@
 #include "stdio.h"
 #include "stdbool.h"
 #include "driver/gpio.h"
+#include "esp_timer.h"
 
 #include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "freertos/semphr.h"
 
 #include "ft6336u.h"
@@ -11,26 +13,49 @@
 #define FT6336U_I2C_ADDR 0x38
 #define FT6336U_INTR_PIN 39
 
+#define FT6336U_REG_TD_STATUS 0x02
+#define FT6336U_REG_G_MODE 0xa4
+#define FT6336U_G_MODE_TRIGGER 0x01
+
+/* A pressed panel keeps reporting. If a press has no report for this long,
+ * read once more in case the pulse of the release was missed. */
+#define FT6336U_RELEASE_TIMEOUT_MS 100
+
+/* Power of 2 */
+#define FT6336U_EVENT_QUEUE_LEN 32
+#define FT6336U_EVENT_QUEUE_MASK (FT6336U_EVENT_QUEUE_LEN - 1)
+
 static uint16_t _x, _y;
 static bool _pressed;
 static I2CDevice_t ft6336u_i2c;
 static xTaskHandle ft6336_task_handle;
 static SemaphoreHandle_t thread_mutex;
 
+/* Single producer (FT6336Task), single consumer ring. The indexes run freely,
+ * each side writes only its own and publishes it with release ordering. */
+static FT6336U_Event_t event_queue[FT6336U_EVENT_QUEUE_LEN];
+static uint32_t event_head;
+static uint32_t event_tail;
+
+static volatile uint32_t intr_time_us;
+
 static void IRAM_ATTR FT6336U_ISRHandler(void* arg);
 static void FT6336U_UpdateTask(void *arg);
+static void FT6336U_PushEvent(const FT6336U_Event_t* event);
 
 void FT6336U_Init() {
     ft6336u_i2c = i2c_malloc_device(I2C_NUM_1, 21, 22, 400000, FT6336U_I2C_ADDR);
-    i2c_write_byte(ft6336u_i2c, 0xa4, 0x00);
-    
+    i2c_device_set_priority(ft6336u_i2c, I2C_PRIORITY_HIGH);
+    i2c_write_byte(ft6336u_i2c, FT6336U_REG_G_MODE, FT6336U_G_MODE_TRIGGER);
+
     thread_mutex = xSemaphoreCreateMutex();
 
     gpio_config_t io_conf;
-    io_conf.intr_type = GPIO_INTR_ANYEDGE;
+    io_conf.intr_type = GPIO_INTR_NEGEDGE;
     io_conf.pin_bit_mask = (1ULL << FT6336U_INTR_PIN);
     io_conf.mode = GPIO_MODE_INPUT;
     io_conf.pull_up_en = 1;
+    io_conf.pull_down_en = 0;
     gpio_config(&io_conf);
     xTaskCreatePinnedToCore(FT6336U_UpdateTask, "FT6336Task", 2 * 1024, NULL, 1, &ft6336_task_handle, 0);
     gpio_install_isr_service(0);
@@ -39,28 +64,90 @@ void FT6336U_Init() {
 
 static void IRAM_ATTR FT6336U_ISRHandler(void* arg) {
     xTaskHandle task_handle = *(xTaskHandle *)arg;
-    xTaskResumeFromISR(task_handle);
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    intr_time_us = (uint32_t)esp_timer_get_time();
+    vTaskNotifyGiveFromISR(task_handle, &higher_priority_task_woken);
+    if (higher_priority_task_woken) {
+        portYIELD_FROM_ISR();
+    }
 }
 
 static void FT6336U_UpdateTask(void *arg) {
     uint8_t buff[5] = {0x00, 0x00, 0x00, 0x00, 0x00};
-    bool press_stash;
+    bool press_stash = false;
+    uint16_t x = 0, y = 0;
+
     for (;;) {
-        i2c_read_bytes(ft6336u_i2c, 0x02, buff, 5);
-        
+        /* The notification counts the pulses; one read gets the newest report for all of them */
+        TickType_t timeout = press_stash ? pdMS_TO_TICKS(FT6336U_RELEASE_TIMEOUT_MS) : portMAX_DELAY;
+        bool notified = ulTaskNotifyTake(pdTRUE, timeout) != 0;
+        uint32_t time_us = notified ? intr_time_us : (uint32_t)esp_timer_get_time();
+
+        if (i2c_read_bytes(ft6336u_i2c, FT6336U_REG_TD_STATUS, buff, 5) != ESP_OK) {
+            continue;
+        }
+
+        bool pressed = (buff[0] & 0x0f) ? true : false;
+        if (pressed) {
+            x = ((buff[1] & 0x0f) << 8) | buff[2];
+            y = ((buff[3] & 0x0f) << 8) | buff[4];
+        }
+
+        /* Skip the timeout read of a press still held and the releases repeated by the panel */
+        if ((notified || pressed != press_stash) && (pressed || press_stash)) {
+            FT6336U_Event_t event = {
+                .type = pressed ? (press_stash ? FT6336U_EVENT_MOVE : FT6336U_EVENT_PRESS) : FT6336U_EVENT_RELEASE,
+                .x = x,
+                .y = y,
+                .time_us = time_us,
+            };
+            FT6336U_PushEvent(&event);
+        }
+        press_stash = pressed;
+
+        /* After the event, so the state is never ahead of the queue */
         xSemaphoreTake(thread_mutex, portMAX_DELAY);
-        _pressed = buff[0] ? true : false;
-        _x = ((buff[1] & 0x0f) << 8) | buff[2];
-        _y = ((buff[3] & 0x0f) << 8) | buff[4];
-        press_stash = _pressed;
+        _pressed = pressed;
+        _x = x;
+        _y = y;
         xSemaphoreGive(thread_mutex);
+    }
+}
 
-        if (press_stash == false) {
-            vTaskSuspend(NULL);
-        } else {
-            vTaskDelay(pdMS_TO_TICKS(20));
-        }
+static void FT6336U_PushEvent(const FT6336U_Event_t* event) {
+    uint32_t head = __atomic_load_n(&event_head, __ATOMIC_ACQUIRE);
+    if (event_tail - head >= FT6336U_EVENT_QUEUE_LEN) {
+        return;
+    }
+
+    event_queue[event_tail & FT6336U_EVENT_QUEUE_MASK] = *event;
+    __atomic_store_n(&event_tail, event_tail + 1, __ATOMIC_RELEASE);
+}
+
+bool FT6336U_ReadEvent(FT6336U_Event_t* event) {
+    uint32_t head = event_head;
+    uint32_t tail = __atomic_load_n(&event_tail, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        return false;
+    }
+
+    *event = event_queue[head & FT6336U_EVENT_QUEUE_MASK];
+    head++;
+
+    /* Only the latest of consecutive moves matters, the press and release positions are kept */
+    while (head != tail && event->type == FT6336U_EVENT_MOVE &&
+           event_queue[head & FT6336U_EVENT_QUEUE_MASK].type == FT6336U_EVENT_MOVE) {
+        *event = event_queue[head & FT6336U_EVENT_QUEUE_MASK];
+        head++;
     }
+
+    __atomic_store_n(&event_head, head, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool FT6336U_EventPending() {
+    return __atomic_load_n(&event_tail, __ATOMIC_ACQUIRE) != event_head;
 }
 
 void FT6336U_GetTouch(uint16_t* x, uint16_t* y, bool* press_down) {
@@ -5,6 +5,29 @@
 
 #pragma once
 
+/**
+ * @brief Kinds of touch events.
+ */
+/* @[declare_ft6336_eventtype] */
+typedef enum {
+    FT6336U_EVENT_PRESS,    /**< @brief The screen was touched. */
+    FT6336U_EVENT_MOVE,     /**< @brief The touch point moved, or is still pressed. */
+    FT6336U_EVENT_RELEASE   /**< @brief The touch was lifted, at the last pressed position. */
+} FT6336U_EventType_t;
+/* @[declare_ft6336_eventtype] */
+
+/**
+ * @brief A touch report of the FT6336U.
+ */
+/* @[declare_ft6336_event] */
+typedef struct {
+    FT6336U_EventType_t type;
+    uint16_t x;
+    uint16_t y;
+    uint32_t time_us;       /**< @brief Low 32 bits of esp_timer_get_time() at the interrupt. */
+} FT6336U_Event_t;
+/* @[declare_ft6336_event] */
+
 /**
  * @brief Initializes the FT6336U over I2C.
  * 
@@ -13,14 +36,12 @@
  * @note It creates a FreeRTOS task with the task name `FT6336Task` and installs
  * an ISR on the interrupt pin FT6336U_INTR_PIN.
  *
- * The most recent button press state is stored within the library and can
- * be queried using the functions provided by this library.
- *
- * The FreeRTOS task remains suspended and only resumes when the screen is
- * pressed (which is informed by the FT6336U using the interrupt on the
- * FT6336U_INTR_PIN). If multiple press events are stashed by the hardware, the
- * FreeRTOS task keeps retrieving them one by one at an interval of 20 ticks.
- * Once all the events are retrieved, the task suspends itself.
+ * The FT6336U is set to pulse the interrupt pin once per new touch report.
+ * The FreeRTOS task sleeps until the ISR notifies it and reads exactly one
+ * report per pulse, so there is no I2C traffic while the screen is not
+ * touched. Every report is queued as a timestamped event for
+ * FT6336U_ReadEvent() and also stored as the most recent touch state, which
+ * can be queried using the other functions provided by this library.
  */
 /* @[declare_ft6336_init] */
 void FT6336U_Init();
@@ -76,3 +97,31 @@ uint16_t FT6336U_GetPressPosX();
 /* @[declare_ft6336_getpressposy] */
 uint16_t FT6336U_GetPressPosY();
 /* @[declare_ft6336_getpressposy] */
+
+/**
+ * @brief Takes the oldest touch event from the event queue.
+ *
+ * The queue has a single producer, the `FT6336Task`, and must have a single
+ * consumer, the LVGL input device of Core2ForAWS_Display_Init(). It needs no
+ * lock on either side.
+ *
+ * Moves waiting behind a move are merged into the latest one, so a consumer
+ * that falls behind catches up in one read. Presses and releases are never
+ * merged. If the queue overflows, the newest events are dropped; the current
+ * state is still available from FT6336U_GetTouch().
+ *
+ * @param[out] event The oldest event.
+ * @return true if an event was read, false if the queue is empty.
+ */
+/* @[declare_ft6336_readevent] */
+bool FT6336U_ReadEvent(FT6336U_Event_t* event);
+/* @[declare_ft6336_readevent] */
+
+/**
+ * @brief Checks if there are touch events in the event queue.
+ *
+ * @return true if FT6336U_ReadEvent() would read an event.
+ */
+/* @[declare_ft6336_eventpending] */
+bool FT6336U_EventPending();
+/* @[declare_ft6336_eventpending] */
@@ -1,9 +1,13 @@
+#include <string.h>
+
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
 
 #include "driver/i2c.h"
 #include "esp_log.h"
 #include "esp_err.h"
+#include "esp_timer.h"
 
 #include "i2c_device.h"
 
@@ -30,6 +34,9 @@
 #define I2C_TIMEOUT_MS (100) // 1000ms
 #define MAX_DEVICE_NUMBER 24
 
+// above the application tasks, a transfer is short and its caller is blocked on it
+#define I2C_SCHED_TASK_PRIORITY 9
+
 typedef struct _i2c_port_obj_t {
     i2c_port_t port;
     gpio_num_t scl;
@@ -40,14 +47,55 @@ typedef struct _i2c_port_obj_t {
 typedef struct _i2c_device_t {
     i2c_port_obj_t* i2c_port;
     uint8_t addr;
+    i2c_priority_t priority;
+    i2c_device_stats_t stats;
+    uint64_t logged_busy_us;    // busy_us at the last i2c_log_stats()
 } i2c_device_t;
 
+// a batch queued by i2c_transfer(), lives on the caller's stack until done is given
+typedef struct _i2c_request_t {
+    i2c_device_t* device;
+    i2c_op_t* ops;
+    uint8_t count;
+    int64_t queued_us;
+    int64_t deadline_us;
+    esp_err_t err;
+    SemaphoreHandle_t done;
+    struct _i2c_request_t* next;
+} i2c_request_t;
+
+typedef struct _i2c_sched_t {
+    TaskHandle_t task;
+    i2c_request_t* pending;         // in queueing order
+    uint8_t burst[I2C_BURST_MAX];   // merged reads land here, used with the port held
+    int64_t logged_at_us;
+} i2c_sched_t;
+
+// the outermost i2c_apply_bus() of the task holding the port, for the bus time
+typedef struct _i2c_hold_t {
+    i2c_device_t* device;
+    uint32_t depth;
+    int64_t since_us;
+} i2c_hold_t;
+
+static const uint32_t priority_deadline_ms[I2C_PRIORITY_MAX] = {
+    I2C_HIGH_DEADLINE_MS, I2C_NORMAL_DEADLINE_MS, I2C_LOW_DEADLINE_MS
+};
+
 static SemaphoreHandle_t i2c_mutex[I2C_NUM_MAX];
 static i2c_port_obj_t *i2c_port_used[2] = { NULL, NULL };
 
+// guards the queues, the device list and the counters
+static portMUX_TYPE sched_lock = portMUX_INITIALIZER_UNLOCKED;
+static i2c_sched_t i2c_sched[I2C_NUM_MAX];
+static i2c_hold_t i2c_hold[I2C_NUM_MAX];
+static i2c_device_t* i2c_devices[MAX_DEVICE_NUMBER];
+
+static void i2c_sched_task(void *arg);
+
 I2CDevice_t i2c_malloc_device(i2c_port_t i2c_num, gpio_num_t sda, gpio_num_t scl, uint32_t freq, uint8_t device_addr) {
-    if (i2c_num > I2C_NUM_MAX) {
-        i2c_num = I2C_NUM_MAX;
+    if (i2c_num >= I2C_NUM_MAX) {
+        i2c_num = I2C_NUM_MAX - 1;
     }
 
     if (i2c_mutex[0] == NULL) {
@@ -58,6 +106,12 @@ I2CDevice_t i2c_malloc_device(i2c_port_t i2c_num, gpio_num_t sda, gpio_num_t scl
         i2c_mutex[1] = xSemaphoreCreateRecursiveMutex(); 
     }
 
+    if (i2c_sched[i2c_num].task == NULL) {
+        i2c_sched[i2c_num].logged_at_us = esp_timer_get_time();
+        xTaskCreatePinnedToCore(i2c_sched_task, "I2CSched", 3 * 1024, &i2c_sched[i2c_num],
+                                I2C_SCHED_TASK_PRIORITY, &i2c_sched[i2c_num].task, 0);
+    }
+
     i2c_port_obj_t* new_device_port = (i2c_port_obj_t *)malloc(sizeof(i2c_port_obj_t));
     if (new_device_port == NULL) {
         return NULL;
@@ -73,8 +127,20 @@ I2CDevice_t i2c_malloc_device(i2c_port_t i2c_num, gpio_num_t sda, gpio_num_t scl
         return NULL;
     }
 
+    memset(device, 0, sizeof(i2c_device_t));
     device->i2c_port = new_device_port;
     device->addr = device_addr;
+    device->priority = I2C_PRIORITY_NORMAL;
+
+    // not listed when full, it works but is left out of i2c_log_stats()
+    portENTER_CRITICAL(&sched_lock);
+    for (int i = 0; i < MAX_DEVICE_NUMBER; i++) {
+        if (i2c_devices[i] == NULL) {
+            i2c_devices[i] = device;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&sched_lock);
     log_i("New device malloc, scl: %d, sda: %d, freq: %d HZ",
         device->i2c_port->scl, device->i2c_port->sda, device->i2c_port->freq);
 
@@ -85,10 +151,25 @@ void i2c_free_device(I2CDevice_t i2c_device) {
     if (i2c_device == NULL) {
         return ;
     }
+    portENTER_CRITICAL(&sched_lock);
+    for (int i = 0; i < MAX_DEVICE_NUMBER; i++) {
+        if (i2c_devices[i] == i2c_device) {
+            i2c_devices[i] = NULL;
+        }
+    }
+    portEXIT_CRITICAL(&sched_lock);
+
     free(((i2c_device_t *)i2c_device)->i2c_port);
     free(i2c_device);
 }
 
+void i2c_device_set_priority(I2CDevice_t i2c_device, i2c_priority_t priority) {
+    if (i2c_device == NULL || priority >= I2C_PRIORITY_MAX) {
+        return ;
+    }
+    ((i2c_device_t *)i2c_device)->priority = priority;
+}
+
 BaseType_t i2c_take_port(i2c_port_t i2c_num, uint32_t timeout) {
     if (i2c_mutex[i2c_num] == NULL) {
         return pdFAIL;
@@ -105,6 +186,31 @@ BaseType_t i2c_free_port(i2c_port_t i2c_num) {
     return xSemaphoreGiveRecursive(i2c_mutex[i2c_num]);
 }
 
+// port held
+static void i2c_hold_begin(i2c_device_t* device) {
+    i2c_hold_t* hold = &i2c_hold[device->i2c_port->port];
+    if (hold->depth++ == 0) {
+        hold->device = device;
+        hold->since_us = esp_timer_get_time();
+    }
+}
+
+// port held, charges the hold to the device that started it
+static void i2c_hold_end(i2c_device_t* device) {
+    i2c_hold_t* hold = &i2c_hold[device->i2c_port->port];
+    if (hold->depth == 0 || --hold->depth > 0) {
+        return ;
+    }
+
+    uint32_t held = (uint32_t)(esp_timer_get_time() - hold->since_us);
+    portENTER_CRITICAL(&sched_lock);
+    hold->device->stats.busy_us += held;
+    if (held > hold->device->stats.max_hold_us) {
+        hold->device->stats.max_hold_us = held;
+    }
+    portEXIT_CRITICAL(&sched_lock);
+}
+
 esp_err_t i2c_apply_bus(I2CDevice_t i2c_device) {
     if (i2c_device == NULL) {
         return ESP_FAIL;
@@ -112,6 +218,7 @@ esp_err_t i2c_apply_bus(I2CDevice_t i2c_device) {
 
     i2c_device_t* device = (i2c_device_t *)i2c_device;
     xSemaphoreTakeRecursive(i2c_mutex[device->i2c_port->port], portMAX_DELAY);
+    i2c_hold_begin(device);
     i2c_port_obj_t* used_port = i2c_port_used[device->i2c_port->port];
     
     if (used_port == device->i2c_port) {
@@ -157,16 +264,13 @@ void i2c_free_bus(I2CDevice_t i2c_device) {
         return ;
     }
     i2c_device_t* device = (i2c_device_t *)i2c_device;
+    i2c_hold_end(device);
     xSemaphoreGiveRecursive(i2c_mutex[device->i2c_port->port]);
 }
 
-esp_err_t i2c_read_bytes(I2CDevice_t i2c_device, uint8_t reg_addr, uint8_t *data, uint16_t length) {
-    if (i2c_device == NULL || (length > 0 && data == NULL)) {
-        return ESP_FAIL;
-    }
-
-    i2c_device_t* device = (i2c_device_t *)i2c_device;
+// The i2c_exec_* functions run one access on the bus the caller already holds
 
+static esp_err_t i2c_exec_read(i2c_device_t* device, uint8_t reg_addr, uint8_t *data, uint16_t length) {
     i2c_cmd_handle_t write_cmd = i2c_cmd_link_create();
     i2c_master_start(write_cmd);
     i2c_master_write_byte(write_cmd, (device->addr << 1) | I2C_MASTER_WRITE, 1);
@@ -184,14 +288,11 @@ esp_err_t i2c_read_bytes(I2CDevice_t i2c_device, uint8_t reg_addr, uint8_t *data
     }
     i2c_master_stop(read_cmd);
 
-
-    i2c_apply_bus(i2c_device);
     esp_err_t err = ESP_FAIL;
     err = i2c_master_cmd_begin(device->i2c_port->port, write_cmd, pdMS_TO_TICKS(I2C_TIMEOUT_MS));
     if (err == ESP_OK && length > 0) {
         err = i2c_master_cmd_begin(device->i2c_port->port, read_cmd, pdMS_TO_TICKS(I2C_TIMEOUT_MS));
     }
-    i2c_free_bus(i2c_device);
 
     i2c_cmd_link_delete(write_cmd);
     i2c_cmd_link_delete(read_cmd);
@@ -206,13 +307,7 @@ esp_err_t i2c_read_bytes(I2CDevice_t i2c_device, uint8_t reg_addr, uint8_t *data
     return err;
 }
 
-esp_err_t i2c_read_bytes_no_stop(I2CDevice_t i2c_device, uint8_t reg_addr, uint8_t *data, uint16_t length) {
-    if (i2c_device == NULL || (length > 0 && data == NULL)) {
-        return ESP_FAIL;
-    }
-
-    i2c_device_t* device = (i2c_device_t *)i2c_device;
-
+static esp_err_t i2c_exec_read_no_stop(i2c_device_t* device, uint8_t reg_addr, uint8_t *data, uint16_t length) {
     i2c_cmd_handle_t write_cmd = i2c_cmd_link_create();
     i2c_master_start(write_cmd);
     i2c_master_write_byte(write_cmd, (device->addr << 1) | I2C_MASTER_WRITE, 1);
@@ -227,11 +322,8 @@ esp_err_t i2c_read_bytes_no_stop(I2CDevice_t i2c_device, uint8_t reg_addr, uint8
     }
     i2c_master_stop(write_cmd);
 
-
-    i2c_apply_bus(i2c_device);
     esp_err_t err = ESP_FAIL;
     err = i2c_master_cmd_begin(device->i2c_port->port, write_cmd, pdMS_TO_TICKS(I2C_TIMEOUT_MS));
-    i2c_free_bus(i2c_device);
 
     i2c_cmd_link_delete(write_cmd);
 
@@ -245,6 +337,201 @@ esp_err_t i2c_read_bytes_no_stop(I2CDevice_t i2c_device, uint8_t reg_addr, uint8
     return err;
 }
 
+static esp_err_t i2c_exec_write(i2c_device_t* device, uint8_t reg_addr, uint8_t *data, uint16_t length) {
+    i2c_cmd_handle_t write_cmd = i2c_cmd_link_create();
+    i2c_master_start(write_cmd);
+    i2c_master_write_byte(write_cmd, (device->addr << 1) | I2C_MASTER_WRITE, 1);
+    i2c_master_write_byte(write_cmd, reg_addr, 1);
+    if (length > 0) {
+        i2c_master_write(write_cmd, data, length, 1);
+    }
+    i2c_master_stop(write_cmd);
+
+    esp_err_t err = ESP_FAIL;
+    err = i2c_master_cmd_begin(device->i2c_port->port, write_cmd, pdMS_TO_TICKS(I2C_TIMEOUT_MS));
+
+    i2c_cmd_link_delete(write_cmd);
+
+    if (err != ESP_OK) {
+        log_e("I2C Write Error, addr: 0x%02x, reg: 0x%02x, length: %d, Code: 0x%x", device->addr, reg_addr, length, err);
+    } else {
+        log_i("I2C Write Success, addr: 0x%02x, reg: 0x%02x, length: %d", device->addr, reg_addr, length);
+        log_reg(data, length);
+    }
+
+    return err;
+}
+
+static esp_err_t i2c_exec_probe(i2c_device_t* device) {
+    i2c_cmd_handle_t write_cmd = i2c_cmd_link_create();
+    i2c_master_start(write_cmd);
+    i2c_master_write_byte(write_cmd, (device->addr << 1) | I2C_MASTER_WRITE, 1);
+    i2c_master_stop(write_cmd);
+
+    esp_err_t err = ESP_FAIL;
+    err = i2c_master_cmd_begin(device->i2c_port->port, write_cmd, pdMS_TO_TICKS(I2C_TIMEOUT_MS));
+
+    i2c_cmd_link_delete(write_cmd);
+    return err;
+}
+
+static esp_err_t i2c_exec_op(i2c_device_t* device, i2c_op_type_t type, uint8_t reg_addr, uint8_t *data, uint16_t length) {
+    switch (type) {
+        case I2C_OP_READ:
+            return i2c_exec_read(device, reg_addr, data, length);
+        case I2C_OP_READ_NO_STOP:
+            return i2c_exec_read_no_stop(device, reg_addr, data, length);
+        case I2C_OP_WRITE:
+            return i2c_exec_write(device, reg_addr, data, length);
+        case I2C_OP_PROBE:
+            return i2c_exec_probe(device);
+        default:
+            return ESP_ERR_INVALID_ARG;
+    }
+}
+
+// How many ops from the first one on go out as one read burst
+static uint8_t i2c_burst_count(const i2c_op_t *ops, uint8_t count) {
+    if ((ops[0].type != I2C_OP_READ && ops[0].type != I2C_OP_READ_NO_STOP) || ops[0].length == 0) {
+        return 1;
+    }
+
+    uint8_t n = 1;
+    uint16_t end = ops[0].reg + ops[0].length;
+    while (n < count && ops[n].type == ops[0].type && ops[n].reg == end && ops[n].length > 0 &&
+           end + ops[n].length - ops[0].reg <= I2C_BURST_MAX) {
+        end += ops[n].length;
+        n++;
+    }
+    return n;
+}
+
+static esp_err_t i2c_run_batch(i2c_device_t* device, i2c_op_t *ops, uint8_t count, int64_t queued_us) {
+    uint8_t *burst = i2c_sched[device->i2c_port->port].burst;
+    esp_err_t err = ESP_OK;
+    uint32_t merged = 0;
+
+    i2c_apply_bus(device);
+    uint32_t wait = (uint32_t)(esp_timer_get_time() - queued_us);
+
+    for (uint8_t i = 0; i < count && err == ESP_OK; ) {
+        uint8_t n = i2c_burst_count(&ops[i], count - i);
+        if (n == 1) {
+            err = i2c_exec_op(device, ops[i].type, ops[i].reg, ops[i].data, ops[i].length);
+        } else {
+            const i2c_op_t *last = &ops[i + n - 1];
+            err = i2c_exec_op(device, ops[i].type, ops[i].reg, burst, last->reg + last->length - ops[i].reg);
+            for (uint8_t k = i; err == ESP_OK && k < i + n; k++) {
+                memcpy(ops[k].data, &burst[ops[k].reg - ops[i].reg], ops[k].length);
+            }
+            merged += n - 1;
+        }
+        i += n;
+    }
+
+    i2c_free_bus(device);
+
+    portENTER_CRITICAL(&sched_lock);
+    device->stats.transfers++;
+    device->stats.ops += count;
+    device->stats.merged += merged;
+    device->stats.errors += err == ESP_OK ? 0 : 1;
+    device->stats.wait_us += wait;
+    if (wait > device->stats.max_wait_us) {
+        device->stats.max_wait_us = wait;
+    }
+    portEXIT_CRITICAL(&sched_lock);
+    return err;
+}
+
+// The earliest deadline, the first queued on a tie
+static i2c_request_t* i2c_sched_pop(i2c_sched_t* sched) {
+    portENTER_CRITICAL(&sched_lock);
+    i2c_request_t** next = NULL;
+    for (i2c_request_t** it = &sched->pending; *it != NULL; it = &(*it)->next) {
+        if (next == NULL || (*it)->deadline_us < (*next)->deadline_us) {
+            next = it;
+        }
+    }
+
+    i2c_request_t* request = NULL;
+    if (next != NULL) {
+        request = *next;
+        *next = request->next;
+    }
+    portEXIT_CRITICAL(&sched_lock);
+    return request;
+}
+
+static void i2c_sched_task(void *arg) {
+    i2c_sched_t* sched = (i2c_sched_t *)arg;
+    i2c_request_t* request;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while ((request = i2c_sched_pop(sched)) != NULL) {
+            request->err = i2c_run_batch(request->device, request->ops, request->count, request->queued_us);
+            xSemaphoreGive(request->done);
+        }
+    }
+}
+
+esp_err_t i2c_transfer(I2CDevice_t i2c_device, i2c_op_t *ops, uint8_t count) {
+    if (i2c_device == NULL || (count > 0 && ops == NULL)) {
+        return ESP_FAIL;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (ops[i].type != I2C_OP_PROBE && ops[i].length > 0 && ops[i].data == NULL) {
+            return ESP_FAIL;
+        }
+    }
+
+    i2c_device_t* device = (i2c_device_t *)i2c_device;
+    i2c_port_t port = device->i2c_port->port;
+    i2c_sched_t* sched = &i2c_sched[port];
+
+    // the scheduler would wait for the port this task holds
+    if (sched->task == NULL || xSemaphoreGetMutexHolder(i2c_mutex[port]) == xTaskGetCurrentTaskHandle()) {
+        return i2c_run_batch(device, ops, count, esp_timer_get_time());
+    }
+
+    StaticSemaphore_t done_buffer;
+    i2c_request_t request = {
+        .device = device,
+        .ops = ops,
+        .count = count,
+        .queued_us = esp_timer_get_time(),
+        .err = ESP_FAIL,
+        .done = xSemaphoreCreateBinaryStatic(&done_buffer),
+        .next = NULL,
+    };
+    request.deadline_us = request.queued_us + (int64_t)priority_deadline_ms[device->priority] * 1000;
+
+    portENTER_CRITICAL(&sched_lock);
+    i2c_request_t** tail = &sched->pending;
+    while (*tail != NULL) {
+        tail = &(*tail)->next;
+    }
+    *tail = &request;
+    portEXIT_CRITICAL(&sched_lock);
+
+    xTaskNotifyGive(sched->task);
+    xSemaphoreTake(request.done, portMAX_DELAY);
+    vSemaphoreDelete(request.done);
+    return request.err;
+}
+
+esp_err_t i2c_read_bytes(I2CDevice_t i2c_device, uint8_t reg_addr, uint8_t *data, uint16_t length) {
+    i2c_op_t op = { .type = I2C_OP_READ, .reg = reg_addr, .data = data, .length = length };
+    return i2c_transfer(i2c_device, &op, 1);
+}
+
+esp_err_t i2c_read_bytes_no_stop(I2CDevice_t i2c_device, uint8_t reg_addr, uint8_t *data, uint16_t length) {
+    i2c_op_t op = { .type = I2C_OP_READ_NO_STOP, .reg = reg_addr, .data = data, .length = length };
+    return i2c_transfer(i2c_device, &op, 1);
+}
+
 esp_err_t i2c_read_byte(I2CDevice_t i2c_device, uint8_t reg_addr, uint8_t* data) {
     return i2c_read_bytes(i2c_device, reg_addr, data, 1);
 }
@@ -284,37 +571,8 @@ esp_err_t i2c_read_bits(I2CDevice_t i2c_device, uint8_t reg_addr, uint8_t *data,
 }
 
 esp_err_t i2c_write_bytes(I2CDevice_t i2c_device, uint8_t reg_addr, uint8_t *data, uint16_t length) {
-    if (i2c_device == NULL || (length > 0 && data == NULL)) {
-        return ESP_FAIL;
-    }
-
-    i2c_device_t* device = (i2c_device_t *)i2c_device;
-
-    i2c_cmd_handle_t write_cmd = i2c_cmd_link_create();
-    i2c_master_start(write_cmd);
-    i2c_master_write_byte(write_cmd, (device->addr << 1) | I2C_MASTER_WRITE, 1);
-    i2c_master_write_byte(write_cmd, reg_addr, 1);
-    if (length > 0) {
-        i2c_master_write(write_cmd, data, length, 1);
-    }
-    i2c_master_stop(write_cmd);
-
-    esp_err_t err = ESP_FAIL;
-
-    i2c_apply_bus(i2c_device);
-    err = i2c_master_cmd_begin(device->i2c_port->port, write_cmd, pdMS_TO_TICKS(I2C_TIMEOUT_MS));
-    i2c_free_bus(i2c_device);
-
-    i2c_cmd_link_delete(write_cmd);
-
-    if (err != ESP_OK) {
-        log_e("I2C Write Error, addr: 0x%02x, reg: 0x%02x, length: %d, Code: 0x%x", device->addr, reg_addr, length, err);
-    } else {
-        log_i("I2C Write Success, addr: 0x%02x, reg: 0x%02x, length: %d", device->addr, reg_addr, length);
-        log_reg(data, length);
-    }
-
-    return err;
+    i2c_op_t op = { .type = I2C_OP_WRITE, .reg = reg_addr, .data = data, .length = length };
+    return i2c_transfer(i2c_device, &op, 1);
 }
 
 esp_err_t i2c_write_byte(I2CDevice_t i2c_device, uint8_t reg_addr, uint8_t data) {
@@ -373,23 +631,78 @@ esp_err_t i2c_device_change_freq(I2CDevice_t i2c_device, uint32_t freq) {
 }
 
 esp_err_t i2c_device_valid(I2CDevice_t i2c_device) {
-    if (i2c_device == NULL ) {
-        return ESP_FAIL;
+    i2c_op_t op = { .type = I2C_OP_PROBE };
+    return i2c_transfer(i2c_device, &op, 1);
+}
+
+void i2c_device_get_stats(I2CDevice_t i2c_device, i2c_device_stats_t *stats) {
+    if (i2c_device == NULL || stats == NULL) {
+        return ;
     }
 
-    i2c_device_t* device = (i2c_device_t *)i2c_device;
+    portENTER_CRITICAL(&sched_lock);
+    *stats = ((i2c_device_t *)i2c_device)->stats;
+    portEXIT_CRITICAL(&sched_lock);
+}
 
-    i2c_cmd_handle_t write_cmd = i2c_cmd_link_create();
-    i2c_master_start(write_cmd);
-    i2c_master_write_byte(write_cmd, (device->addr << 1) | I2C_MASTER_WRITE, 1);
-    i2c_master_stop(write_cmd);
+void i2c_reset_stats(i2c_port_t i2c_num) {
+    if (i2c_num >= I2C_NUM_MAX) {
+        return ;
+    }
 
-    esp_err_t err = ESP_FAIL;
+    portENTER_CRITICAL(&sched_lock);
+    for (int i = 0; i < MAX_DEVICE_NUMBER; i++) {
+        if (i2c_devices[i] != NULL && i2c_devices[i]->i2c_port->port == i2c_num) {
+            memset(&i2c_devices[i]->stats, 0, sizeof(i2c_device_stats_t));
+            i2c_devices[i]->logged_busy_us = 0;
+        }
+    }
+    i2c_sched[i2c_num].logged_at_us = esp_timer_get_time();
+    portEXIT_CRITICAL(&sched_lock);
+}
 
-    i2c_apply_bus(i2c_device);
-    err = i2c_master_cmd_begin(device->i2c_port->port, write_cmd, pdMS_TO_TICKS(I2C_TIMEOUT_MS));
-    i2c_free_bus(i2c_device);
+void i2c_log_stats(i2c_port_t i2c_num) {
+    if (i2c_num >= I2C_NUM_MAX) {
+        return ;
+    }
 
-    i2c_cmd_link_delete(write_cmd);
-    return err;
-}
\ No newline at end of file
+    int64_t now = esp_timer_get_time();
+    int64_t elapsed;
+
+    portENTER_CRITICAL(&sched_lock);
+    elapsed = now - i2c_sched[i2c_num].logged_at_us;
+    i2c_sched[i2c_num].logged_at_us = now;
+    portEXIT_CRITICAL(&sched_lock);
+
+    if (elapsed <= 0) {
+        return ;
+    }
+
+    // one device at a time, the log can't go out inside the critical section
+    for (int i = 0; i < MAX_DEVICE_NUMBER; i++) {
+        i2c_device_stats_t stats = { 0 };
+        uint64_t busy = 0;
+        uint8_t addr = 0;
+        bool listed = false;
+
+        portENTER_CRITICAL(&sched_lock);
+        i2c_device_t* device = i2c_devices[i];
+        if (device != NULL && device->i2c_port->port == i2c_num) {
+            listed = true;
+            addr = device->addr;
+            stats = device->stats;
+            busy = stats.busy_us - device->logged_busy_us;
+            device->logged_busy_us = stats.busy_us;
+        }
+        portEXIT_CRITICAL(&sched_lock);
+
+        if (!listed) {
+            continue;
+        }
+
+        ESP_LOGI(TAG, "0x%02x: %u.%u%% busy, %u transfers, %u ops, %u merged, %u errors, hold max %u us, wait avg %u us max %u us",
+            addr, (unsigned)(busy * 100 / elapsed), (unsigned)(busy * 1000 / elapsed % 10),
+            stats.transfers, stats.ops, stats.merged, stats.errors, stats.max_hold_us,
+            stats.transfers ? (unsigned)(stats.wait_us / stats.transfers) : 0, stats.max_wait_us);
+    }
+}
@@ -19,6 +19,53 @@ extern "C" {
 
 typedef void * I2CDevice_t;
 
+/*
+    Every port has a scheduler task that owns the bus. The read and write
+    functions below queue their transfer to it and block until it's done.
+    When the bus frees up, the queued batch with the earliest deadline runs
+    next. The deadline is the device's priority added to the queueing time,
+    so touch and IMU reads go ahead of PMU polling, but nothing starves.
+*/
+typedef enum {
+    I2C_PRIORITY_HIGH = 0,  // latency sensitive: touch, IMU
+    I2C_PRIORITY_NORMAL,    // default
+    I2C_PRIORITY_LOW,       // slow polling: PMU, secure element
+    I2C_PRIORITY_MAX,
+} i2c_priority_t;
+
+/* How long a batch may wait for the bus before it goes ahead of newer ones */
+#define I2C_HIGH_DEADLINE_MS 2
+#define I2C_NORMAL_DEADLINE_MS 10
+#define I2C_LOW_DEADLINE_MS 50
+
+/* The longest burst adjacent reads are merged into */
+#define I2C_BURST_MAX 32
+
+typedef enum {
+    I2C_OP_READ = 0,        // write reg, stop, read length bytes
+    I2C_OP_READ_NO_STOP,    // write reg, repeated start, read length bytes
+    I2C_OP_WRITE,           // write reg then length bytes
+    I2C_OP_PROBE,           // address only, reg and data unused
+} i2c_op_type_t;
+
+typedef struct {
+    i2c_op_type_t type;
+    uint8_t reg;
+    uint8_t *data;
+    uint16_t length;
+} i2c_op_t;
+
+typedef struct {
+    uint32_t transfers;     // batches run
+    uint32_t ops;           // register accesses in them
+    uint32_t merged;        // reads folded into the burst of the previous one
+    uint32_t errors;
+    uint64_t busy_us;       // total time the device held the bus, direct i2c_apply_bus() users included
+    uint32_t max_hold_us;   // longest single hold
+    uint64_t wait_us;       // total time batches were queued
+    uint32_t max_wait_us;   // longest single queueing time
+} i2c_device_stats_t;
+
 I2CDevice_t i2c_malloc_device(i2c_port_t i2c_num, gpio_num_t sda, gpio_num_t scl, uint32_t freq, uint8_t device_addr);
 
 void i2c_free_device(I2CDevice_t i2c_device);
@@ -65,6 +112,27 @@ esp_err_t i2c_write_bits(I2CDevice_t i2c_device, uint8_t reg_addr, uint8_t data,
 
 esp_err_t i2c_device_valid(I2CDevice_t i2c_device);
 
+void i2c_device_set_priority(I2CDevice_t i2c_device, i2c_priority_t priority);
+
+/*
+    Runs the ops in order in one hold of the bus, returns the first error
+    and skips the rest of the batch after it.
+    Consecutive reads of the same type where one ends at the register the
+    next starts at go out as one burst, so only batch adjacent reads for
+    devices that auto-increment the register address.
+    From a task that holds the port (i2c_take_port() or i2c_apply_bus())
+    the batch runs in the caller instead of being queued.
+*/
+esp_err_t i2c_transfer(I2CDevice_t i2c_device, i2c_op_t *ops, uint8_t count);
+
+/* Counters since boot, or since the last i2c_reset_stats() */
+void i2c_device_get_stats(I2CDevice_t i2c_device, i2c_device_stats_t *stats);
+
+void i2c_reset_stats(i2c_port_t i2c_num);
+
+/* Logs the share of time each device on the port held the bus since the last call */
+void i2c_log_stats(i2c_port_t i2c_num);
+
 BaseType_t i2c_take_port(i2c_port_t i2c_num, uint32_t timeout);
 
 BaseType_t i2c_free_port(i2c_port_t i2c_num);
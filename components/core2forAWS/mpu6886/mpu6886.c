@@ -1,17 +1,30 @@
 #include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "driver/gpio.h"
 #include "i2c_device.h"
 #include "mpu6886.h"
 
+#define MPU6886_INTERNAL_RATE_HZ 1000
+
 static I2CDevice_t mpu6886_device;
 static gyro_scale_t gyro_scale = MPU6886_GFS_2000DPS;
 static acc_scale_t acc_scale = MPU6886_AFS_8G;
 static float acc_res, gyro_res;
 
+static int fifo_int_pin = MPU6886_FIFO_NO_INT_PIN;
+static SemaphoreHandle_t fifo_wm_semaphore;
+static uint16_t fifo_watermark;
+static uint32_t fifo_period_us;
+static uint64_t fifo_sample_count;
+static uint8_t fifo_buff[MPU6886_FIFO_MAX_FRAMES * MPU6886_FIFO_FRAME_SIZE];
+
 static void MPU6886_I2CInit() {
     mpu6886_device = i2c_malloc_device(I2C_NUM_1, 21, 22, 400000, MPU6886_ADDRESS);
+    i2c_device_set_priority(mpu6886_device, I2C_PRIORITY_HIGH);
 }
 
-static void MPU6886_I2CReadBytes(uint8_t start_Addr, uint8_t number_Bytes, uint8_t *read_Buffer) {
+static void MPU6886_I2CReadBytes(uint8_t start_Addr, uint16_t number_Bytes, uint8_t *read_Buffer) {
     i2c_read_bytes(mpu6886_device, start_Addr, read_Buffer, number_Bytes);
 }
 
@@ -187,3 +200,182 @@ void MPU6886_GetTempData(float *t) {
     MPU6886_GetTempAdc(&temp);
     *t = (float)temp / 326.8 + 25.0;
 }
+
+static void IRAM_ATTR MPU6886_FifoISRHandler(void *arg) {
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    xSemaphoreGiveFromISR(fifo_wm_semaphore, &higher_priority_task_woken);
+    if (higher_priority_task_woken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+int MPU6886_FifoInit(uint16_t sample_rate_hz, uint16_t watermark_frames, int int_pin) {
+    unsigned char regdata;
+
+    if (mpu6886_device == NULL) {
+        return -1;
+    }
+    if (sample_rate_hz < 4 || sample_rate_hz > MPU6886_INTERNAL_RATE_HZ) {
+        return -1;
+    }
+    if (watermark_frames == 0 || watermark_frames > MPU6886_FIFO_MAX_FRAMES) {
+        return -1;
+    }
+
+    // Stop interrupts and FIFO writes while reconfiguring
+    regdata = 0x00;
+    MPU6886_I2CWriteBytes(MPU6886_INT_ENABLE, 1, &regdata);
+    MPU6886_I2CWriteBytes(MPU6886_FIFO_EN, 1, &regdata);
+    MPU6886_I2CWriteBytes(MPU6886_USER_CTRL, 1, &regdata);
+    vTaskDelay(1);
+
+    // ODR = 1 kHz / (1 + SMPLRT_DIV), valid while the DLPF is enabled
+    regdata = (MPU6886_INTERNAL_RATE_HZ / sample_rate_hz) - 1;
+    MPU6886_I2CWriteBytes(MPU6886_SMPLRT_DIV, 1, &regdata);
+    fifo_period_us = 1000UL * (1 + regdata);
+    vTaskDelay(1);
+
+    // FIFO_MODE: stop writing when full so the contents stay frame-aligned,
+    // DLPF_CFG = 1 keeps the 1 kHz internal rate
+    regdata = (0x01 << 6) | 0x01;
+    MPU6886_I2CWriteBytes(MPU6886_CONFIG, 1, &regdata);
+    vTaskDelay(1);
+
+    // Watermark is expressed in bytes, 10 bits split across two registers
+    uint16_t watermark_bytes = watermark_frames * MPU6886_FIFO_FRAME_SIZE;
+    regdata = (watermark_bytes >> 8) & 0x03;
+    MPU6886_I2CWriteBytes(MPU6886_FIFO_WM_TH1, 1, &regdata);
+    regdata = watermark_bytes & 0xff;
+    MPU6886_I2CWriteBytes(MPU6886_FIFO_WM_TH2, 1, &regdata);
+    fifo_watermark = watermark_frames;
+    vTaskDelay(1);
+
+    if (int_pin != MPU6886_FIFO_NO_INT_PIN) {
+        if (fifo_wm_semaphore == NULL) {
+            fifo_wm_semaphore = xSemaphoreCreateBinary();
+        }
+
+        gpio_config_t io_conf;
+        io_conf.intr_type = GPIO_INTR_POSEDGE;
+        io_conf.pin_bit_mask = (1ULL << int_pin);
+        io_conf.mode = GPIO_MODE_INPUT;
+        io_conf.pull_up_en = 0;
+        io_conf.pull_down_en = 0;
+        gpio_config(&io_conf);
+        gpio_install_isr_service(0);
+        gpio_isr_handler_add(int_pin, MPU6886_FifoISRHandler, NULL);
+    }
+    fifo_int_pin = int_pin;
+
+    // Accelerometer and gyroscope to the FIFO, then reset and enable it
+    regdata = (0x01 << 4) | (0x01 << 3);
+    MPU6886_I2CWriteBytes(MPU6886_FIFO_EN, 1, &regdata);
+    MPU6886_FifoReset();
+
+    // Watermark raises INT as soon as FIFO_WM_TH is set, also wake up on overflow
+    regdata = (0x01 << 4);
+    MPU6886_I2CWriteBytes(MPU6886_INT_ENABLE, 1, &regdata);
+    return 0;
+}
+
+void MPU6886_FifoDeinit(void) {
+    unsigned char regdata = 0x00;
+    MPU6886_I2CWriteBytes(MPU6886_FIFO_EN, 1, &regdata);
+    MPU6886_I2CWriteBytes(MPU6886_USER_CTRL, 1, &regdata);
+    MPU6886_I2CWriteBytes(MPU6886_FIFO_WM_TH1, 1, &regdata);
+    MPU6886_I2CWriteBytes(MPU6886_FIFO_WM_TH2, 1, &regdata);
+
+    regdata = 0x01;
+    MPU6886_I2CWriteBytes(MPU6886_CONFIG, 1, &regdata);
+    MPU6886_I2CWriteBytes(MPU6886_INT_ENABLE, 1, &regdata);
+
+    // Back to the output rate MPU6886_Init() sets up
+    regdata = 0x05;
+    MPU6886_I2CWriteBytes(MPU6886_SMPLRT_DIV, 1, &regdata);
+
+    if (fifo_int_pin != MPU6886_FIFO_NO_INT_PIN) {
+        gpio_isr_handler_remove(fifo_int_pin);
+        fifo_int_pin = MPU6886_FIFO_NO_INT_PIN;
+    }
+    fifo_watermark = 0;
+}
+
+void MPU6886_FifoReset(void) {
+    unsigned char regdata;
+    regdata = (0x01 << 2);
+    MPU6886_I2CWriteBytes(MPU6886_USER_CTRL, 1, &regdata);
+    vTaskDelay(1);
+    regdata = (0x01 << 6);
+    MPU6886_I2CWriteBytes(MPU6886_USER_CTRL, 1, &regdata);
+    fifo_sample_count = 0;
+    if (fifo_wm_semaphore != NULL) {
+        xSemaphoreTake(fifo_wm_semaphore, 0);
+    }
+}
+
+uint16_t MPU6886_FifoCount(void) {
+    uint8_t buf[2];
+    MPU6886_I2CReadBytes(MPU6886_FIFO_COUNTH, 2, buf);
+    uint16_t count_bytes = ((uint16_t)(buf[0] & 0x1f) << 8) | buf[1];
+    return count_bytes / MPU6886_FIFO_FRAME_SIZE;
+}
+
+bool MPU6886_FifoWait(TickType_t timeout) {
+    if (fifo_int_pin == MPU6886_FIFO_NO_INT_PIN) {
+        vTaskDelay(pdMS_TO_TICKS((fifo_watermark * fifo_period_us) / 1000));
+        return true;
+    }
+    return xSemaphoreTake(fifo_wm_semaphore, timeout) == pdTRUE;
+}
+
+int MPU6886_FifoRead(mpu6886_fifo_frame_t *frames, uint16_t max_frames) {
+    uint8_t status[2] = { 0 };
+    uint8_t count_buf[2] = { 0 };
+
+    // Reading the status registers also clears the latched INT line.
+    // One batch with the count, a single trip through the I2C scheduler.
+    i2c_op_t ops[2] = {
+        { .type = I2C_OP_READ, .reg = MPU6886_FIFO_WM_INT_STATUS, .data = status, .length = 2 },
+        { .type = I2C_OP_READ, .reg = MPU6886_FIFO_COUNTH, .data = count_buf, .length = 2 },
+    };
+    if (i2c_transfer(mpu6886_device, ops, 2) != ESP_OK) {
+        return -1;
+    }
+    if (status[1] & (0x01 << 4)) {
+        MPU6886_FifoReset();
+        return -1;
+    }
+
+    uint16_t count = (((uint16_t)(count_buf[0] & 0x1f) << 8) | count_buf[1]) / MPU6886_FIFO_FRAME_SIZE;
+    if (count > max_frames) {
+        count = max_frames;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    MPU6886_I2CReadBytes(MPU6886_FIFO_R_W, count * MPU6886_FIFO_FRAME_SIZE, fifo_buff);
+
+    uint8_t *buf = fifo_buff;
+    for (uint16_t i = 0; i < count; i++) {
+        frames[i].ax = ((int16_t)buf[0] << 8) | buf[1];
+        frames[i].ay = ((int16_t)buf[2] << 8) | buf[3];
+        frames[i].az = ((int16_t)buf[4] << 8) | buf[5];
+        frames[i].temp = ((int16_t)buf[6] << 8) | buf[7];
+        frames[i].gx = ((int16_t)buf[8] << 8) | buf[9];
+        frames[i].gy = ((int16_t)buf[10] << 8) | buf[11];
+        frames[i].gz = ((int16_t)buf[12] << 8) | buf[13];
+        buf += MPU6886_FIFO_FRAME_SIZE;
+    }
+
+    fifo_sample_count += count;
+    return count;
+}
+
+uint32_t MPU6886_FifoGetPeriodUs(void) {
+    return fifo_period_us;
+}
+
+uint64_t MPU6886_FifoGetSampleCount(void) {
+    return fifo_sample_count;
+}
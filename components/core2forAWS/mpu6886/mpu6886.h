@@ -6,6 +6,8 @@
 #pragma once
 
 #include "stdint.h"
+#include "stdbool.h"
+#include "freertos/FreeRTOS.h"
 
 #define MPU6886_ADDRESS           0x68 
 #define MPU6886_WHOAMI            0x75
@@ -38,6 +40,36 @@
 #define MPU6886_ACCEL_CONFIG      0x1C
 #define MPU6886_ACCEL_CONFIG2     0x1D
 #define MPU6886_FIFO_EN           0x23
+#define MPU6886_FIFO_WM_INT_STATUS 0x39
+#define MPU6886_INT_STATUS        0x3A
+#define MPU6886_FIFO_WM_TH1       0x60
+#define MPU6886_FIFO_WM_TH2       0x61
+#define MPU6886_FIFO_COUNTH       0x72
+#define MPU6886_FIFO_COUNTL       0x73
+#define MPU6886_FIFO_R_W          0x74
+
+/**
+ * @brief Size of the MPU6886 on-chip FIFO in bytes.
+ */
+#define MPU6886_FIFO_SIZE         1024
+
+/**
+ * @brief Size of one FIFO frame in bytes. With the accelerometer and
+ * gyroscope both routed to the FIFO, the MPU6886 writes accel X/Y/Z,
+ * temperature and gyro X/Y/Z (big-endian) for every sample.
+ */
+#define MPU6886_FIFO_FRAME_SIZE   14
+
+/**
+ * @brief Maximum number of whole frames the FIFO can hold.
+ */
+#define MPU6886_FIFO_MAX_FRAMES   (MPU6886_FIFO_SIZE / MPU6886_FIFO_FRAME_SIZE)
+
+/**
+ * @brief Pass as the interrupt pin to MPU6886_FifoInit() when the
+ * MPU6886 INT line is not wired to the ESP32.
+ */
+#define MPU6886_FIFO_NO_INT_PIN   (-1)
 
 /**
  * @brief List of possible accelerometer scalars in Gs.
@@ -63,6 +95,21 @@ typedef enum {
 } gyro_scale_t;
 /* @[declare_mpu6886_gyro_scale_t] */
 
+/**
+ * @brief A single raw sample frame read out of the MPU6886 FIFO.
+ */
+/* @[declare_mpu6886_fifo_frame_t] */
+typedef struct {
+    int16_t ax;   /**< @brief Raw accelerometer ADC value in the X direction. */
+    int16_t ay;   /**< @brief Raw accelerometer ADC value in the Y direction. */
+    int16_t az;   /**< @brief Raw accelerometer ADC value in the Z direction. */
+    int16_t temp; /**< @brief Raw temperature ADC value. */
+    int16_t gx;   /**< @brief Raw gyroscope ADC value in the X direction. */
+    int16_t gy;   /**< @brief Raw gyroscope ADC value in the Y direction. */
+    int16_t gz;   /**< @brief Raw gyroscope ADC value in the Z direction. */
+} mpu6886_fifo_frame_t;
+/* @[declare_mpu6886_fifo_frame_t] */
+
 /**
  * @brief Initializes the MPU6886 over I2C.
  * 
@@ -210,3 +257,110 @@ void MPU6886_GetGyroData(float *roll, float *yaw, float *pitch);
 /* @[declare_mpu6886_gettempdata] */
 void MPU6886_GetTempData(float *t);
 /* @[declare_mpu6886_gettempdata] */
+
+/**
+ * @brief Switches the MPU6886 into FIFO mode.
+ *
+ * The sensor samples on its own clock at `sample_rate_hz` and stores
+ * frames in its 1 KB FIFO. Instead of one I2C transaction per sample,
+ * the host waits for the watermark with MPU6886_FifoWait() and drains
+ * many frames at once with MPU6886_FifoRead().
+ *
+ * **Example:**
+ *
+ * Sample at 500 Hz and wake up every 25 frames (50 ms).
+ * @code{c}
+ *  mpu6886_fifo_frame_t frames[25];
+ *  MPU6886_FifoInit(500, 25, MPU6886_FIFO_NO_INT_PIN);
+ *  while (1) {
+ *      MPU6886_FifoWait(portMAX_DELAY);
+ *      int count = MPU6886_FifoRead(frames, 25);
+ *  }
+ * @endcode
+ *
+ * @param[in] sample_rate_hz Output data rate, 4 to 1000 Hz. The rate is
+ * derived from the 1 kHz internal clock, so it is rounded to 1000/(1+n).
+ * @param[in] watermark_frames Number of frames that triggers the
+ * watermark, 1 to MPU6886_FIFO_MAX_FRAMES.
+ * @param[in] int_pin ESP32 GPIO connected to the MPU6886 INT line, or
+ * MPU6886_FIFO_NO_INT_PIN to fall back to sleeping for one watermark period.
+ *
+ * @return 0 if successful, -1 otherwise.
+ */
+/* @[declare_mpu6886_fifoinit] */
+int MPU6886_FifoInit(uint16_t sample_rate_hz, uint16_t watermark_frames, int int_pin);
+/* @[declare_mpu6886_fifoinit] */
+
+/**
+ * @brief Stops FIFO sampling and releases the interrupt pin.
+ */
+/* @[declare_mpu6886_fifodeinit] */
+void MPU6886_FifoDeinit(void);
+/* @[declare_mpu6886_fifodeinit] */
+
+/**
+ * @brief Discards the FIFO contents and restarts the sample counter.
+ */
+/* @[declare_mpu6886_fiforeset] */
+void MPU6886_FifoReset(void);
+/* @[declare_mpu6886_fiforeset] */
+
+/**
+ * @brief Retrieves the number of whole frames waiting in the FIFO.
+ *
+ * @return The number of frames available to MPU6886_FifoRead().
+ */
+/* @[declare_mpu6886_fifocount] */
+uint16_t MPU6886_FifoCount(void);
+/* @[declare_mpu6886_fifocount] */
+
+/**
+ * @brief Blocks until the FIFO reaches the watermark.
+ *
+ * @param[in] timeout Maximum number of ticks to wait for the interrupt.
+ * Ignored when no interrupt pin was configured.
+ *
+ * @return true if the watermark interrupt fired (or the poll period
+ * elapsed), false on timeout.
+ */
+/* @[declare_mpu6886_fifowait] */
+bool MPU6886_FifoWait(TickType_t timeout);
+/* @[declare_mpu6886_fifowait] */
+
+/**
+ * @brief Drains up to `max_frames` frames from the FIFO in a single
+ * burst I2C read.
+ *
+ * If the FIFO overflowed, its contents are no longer frame-aligned, so
+ * it is reset and -1 is returned; the sample counter restarts and the
+ * caller should re-anchor its timestamps.
+ *
+ * @param[out] frames Destination for the raw frames.
+ * @param[in] max_frames Capacity of `frames`.
+ *
+ * @return Number of frames read, or -1 if the FIFO overflowed or its
+ * status could not be read.
+ */
+/* @[declare_mpu6886_fiforead] */
+int MPU6886_FifoRead(mpu6886_fifo_frame_t *frames, uint16_t max_frames);
+/* @[declare_mpu6886_fiforead] */
+
+/**
+ * @brief Retrieves the exact FIFO sample period after rounding the
+ * requested rate to the internal 1 kHz clock.
+ *
+ * @return The time between two FIFO frames in microseconds.
+ */
+/* @[declare_mpu6886_fifogetperiodus] */
+uint32_t MPU6886_FifoGetPeriodUs(void);
+/* @[declare_mpu6886_fifogetperiodus] */
+
+/**
+ * @brief Retrieves the number of frames produced since the last
+ * FIFO reset, used to reconstruct per-sample timestamps.
+ *
+ * @return Total frames drained from the FIFO since the last reset.
+ */
+/* @[declare_mpu6886_fifogetsamplecount] */
+uint64_t MPU6886_FifoGetSampleCount(void);
+/* @[declare_mpu6886_fifogetsamplecount] */
@@ -39,14 +39,12 @@
 #include "soc/dport_access.h"
 #include "soc/dport_reg.h"
 
+// RMT clock is 80 MHz / clk_div 2
+#define NP_NS_PER_TICK	25
+
 static SemaphoreHandle_t neopixel_sem = NULL;
-static uint16_t neopixel_buf_len = 0;
-static uint8_t *neopixel_buffer = NULL;
-static uint32_t neopixel_t0h_ticks = 0;
-static uint32_t neopixel_t1h_ticks = 0;
-static uint32_t neopixel_t0l_ticks = 0;
-static uint32_t neopixel_t1l_ticks = 0;
-static uint32_t neopixel_reset_ticks = 0;
+static uint16_t neopixel_item_num = 0;
+static rmt_item32_t *neopixel_items = NULL;
 
 // Get color value of RGB component
 //---------------------------------------------------
@@ -118,50 +116,28 @@ uint32_t np_get_pixel_color(pixel_settings_t *px, uint16_t idx, uint8_t *white)
 	return color;
 }
 
-static void IRAM_ATTR np_rmt_adapter(const void *src, rmt_item32_t *dest, size_t src_size,
-        size_t wanted_num, size_t *translated_size, size_t *item_num) {
-    if (src == NULL || dest == NULL) {
-        *translated_size = 0;
-        *item_num = 0;
-        return;
-    }
-    const rmt_item32_t bit0 = {{{ neopixel_t0h_ticks, 1, neopixel_t0l_ticks, 0 }}}; //Logical 0
-    const rmt_item32_t bit1 = {{{ neopixel_t1h_ticks, 1, neopixel_t1l_ticks, 0 }}}; //Logical 1
-    size_t size = 0;
-    size_t num = 0;
-    uint8_t *psrc = (uint8_t *)src;
-    rmt_item32_t *pdest = dest;
-	uint8_t transmit_end = 0;	
-
-	if ((wanted_num >> 3) >= src_size) {
-		src_size -= 1;
-		transmit_end = 1;
-	}
-
-    while (size < src_size && num < wanted_num) {
-        for (int i = 0; i < 8; i++) {
-            // MSB first
-            if (*psrc & (1 << (7 - i))) {
-                pdest->val =  bit1.val;
-            } else {
-                pdest->val =  bit0.val;
-            }
-            num++;
-            pdest++;
-        }
-        size++;
-        psrc++;
-    }
-
-	if (transmit_end) {
-		const rmt_item32_t reset = {{{ neopixel_reset_ticks >> 1, 0, neopixel_reset_ticks >> 1, 0 }}};
-		pdest->val = reset.val;
-		size += 1;
-		num += 1;
+// Encode the pixel bytes to RMT items, MSB first and corrected by brightness,
+// followed by the reset pulse. items must hold pixel_count * nbits + 1 entries.
+//==========================================================================
+size_t np_encode(const pixel_settings_t *px, rmt_item32_t *items)
+{
+	const rmt_item32_t bit0 = {{{ px->timings.t0h / NP_NS_PER_TICK, 1, px->timings.t0l / NP_NS_PER_TICK, 0 }}}; //Logical 0
+	const rmt_item32_t bit1 = {{{ px->timings.t1h / NP_NS_PER_TICK, 1, px->timings.t1l / NP_NS_PER_TICK, 0 }}}; //Logical 1
+	const rmt_item32_t reset = {{{ px->timings.reset / NP_NS_PER_TICK / 2, 0, px->timings.reset / NP_NS_PER_TICK / 2, 0 }}};
+	uint16_t len = px->pixel_count * (px->nbits / 8);
+	rmt_item32_t *pdest = items;
+
+	for (uint16_t i = 0; i < len; i++) {
+		uint8_t clr = (uint16_t)px->pixels[i] * px->brightness / 255;
+		for (int bit = 7; bit >= 0; bit--) {
+			pdest->val = (clr & (1 << bit)) ? bit1.val : bit0.val;
+			pdest++;
+		}
 	}
+	pdest->val = reset.val;
+	pdest++;
 
-	*translated_size = size;
-    *item_num = num;
+	return pdest - items;
 }
 
 // Initialize Neopixel RMT interface on specific GPIO
@@ -199,11 +175,6 @@ int neopixel_init(int gpioNum, rmt_channel_t channel) {
 		goto failed;
 	}
 
-    res = rmt_translator_init(channel, np_rmt_adapter);
-	if (res != ESP_OK) {
-		goto failed;
-	}
-
 failed:
 	xSemaphoreGive(neopixel_sem);
 	return res;
@@ -218,39 +189,30 @@ void neopixel_deinit(rmt_channel_t channel) {
 }
 
 // Start the transfer of Neopixel color bytes from buffer
+// Returns once the items are queued, the previous transfer is waited for first
 //=======================================================
 void np_show(pixel_settings_t *px, rmt_channel_t channel)
 {
-	float ratio = 40000000.0 / 1e9; 
-	uint16_t blen = px->pixel_count * (px->nbits / 8) + 1;
+	uint16_t item_num = px->pixel_count * px->nbits + 1;
 
 	xSemaphoreTake(neopixel_sem, portMAX_DELAY);
-	neopixel_t0h_ticks = (uint32_t)(ratio * px->timings.t0h);
-    neopixel_t0l_ticks = (uint32_t)(ratio * px->timings.t0l);
-    neopixel_t1h_ticks = (uint32_t)(ratio * px->timings.t1h);
-    neopixel_t1l_ticks = (uint32_t)(ratio * px->timings.t1l);
-	neopixel_reset_ticks = (uint32_t)(ratio * px->timings.reset);
-
-	// Allocate neopixel buffer if needed
-	if (neopixel_buffer == NULL) {
-		neopixel_buffer = (uint8_t *)malloc(blen);
-		if (neopixel_buffer == NULL) return;
-		neopixel_buf_len = blen;
-	}
-	// Resize neopixel buffer if needed
-	if (neopixel_buf_len < blen) {
-		// larger buffer needed
-		free(neopixel_buffer);
-		neopixel_buffer = (uint8_t *)malloc(blen);
-		if (neopixel_buffer == NULL) return;
+	// the RMT interrupt still reads the previous frame from the buffer
+	rmt_wait_tx_done(channel, portMAX_DELAY);
+
+	// Resize the item buffer if needed
+	if (neopixel_item_num < item_num) {
+		free(neopixel_items);
+		neopixel_items = (rmt_item32_t *)malloc(item_num * sizeof(rmt_item32_t));
+		if (neopixel_items == NULL) {
+			neopixel_item_num = 0;
+			xSemaphoreGive(neopixel_sem);
+			return;
+		}
+		neopixel_item_num = item_num;
 	}
 
-	memcpy(neopixel_buffer, px->pixels, blen);
-	for (uint16_t i = 0; i < blen; i++) {
-		float b = px->brightness / 255.0;
-		neopixel_buffer[i] = b * neopixel_buffer[i]; 
-	}
-	rmt_write_sample(channel, neopixel_buffer, blen, true);
+	np_encode(px, neopixel_items);
+	rmt_write_items(channel, neopixel_items, item_num, false);
 	xSemaphoreGive(neopixel_sem);
 }
 
@@ -373,73 +335,109 @@ uint32_t hsb_to_rgb(float _hue, float _sat, float _brightness)
 	return (uint32_t)((uint8_t)(red * 255.0) << 16) | ((uint8_t)(green * 255.0) << 8) | ((uint8_t)(blue * 255.0));
 }
 
-// Convert HSB color to 24-bit color representation
+// Convert 24-bit color to HSB representation
+// hue: 0 ~ 359
+// sat: 0 ~ 1000
+// bri: 0 ~ 1000
+//===================================================================
+void rgb_to_hsb_int(uint32_t color, int *hue, int *sat, int *bri)
+{
+	int red = (color >> 16) & 0xFF;
+	int green = (color >> 8) & 0xFF;
+	int blue = color & 0xFF;
+	int max = red > green ? (red > blue ? red : blue) : (green > blue ? green : blue);
+	int min = red < green ? (red < blue ? red : blue) : (green < blue ? green : blue);
+	int delta = max - min;
+	int h = 0;
+
+	if (delta != 0) {
+		if (red == max)
+			h = 60 * (green - blue) / delta;
+		else if (green == max)
+			h = 120 + 60 * (blue - red) / delta;
+		else
+			h = 240 + 60 * (red - green) / delta;
+
+		if (h < 0) h += 360;
+	}
+
+	*hue = h;
+	*sat = max ? delta * 1000 / max : 0;
+	*bri = max * 1000 / 255;
+}
+
+// Convert HSB color to 24-bit color representation, integer only
 // _hue: 0 ~ 359
-// _sat: 0 ~ 255
-// _bri: 0 ~ 255
+// _sat: 0 ~ 1000
+// _bri: 0 ~ 1000
 //=======================================================
 uint32_t hsb_to_rgb_int(int hue, int sat, int brightness)
 {
-	float _hue = (float)hue;
-	float _sat = (float)((float)sat / 1000.0);
-	float _brightness = (float)((float)brightness / 1000.0);
-	float red = 0.0;
-	float green = 0.0;
-	float blue = 0.0;
-
-	if (_sat == 0.0) {
-		red = _brightness;
-		green = _brightness;
-		blue = _brightness;
+	// the channels are kept x1000 until the end
+	int red = 0;
+	int green = 0;
+	int blue = 0;
+
+	if (sat < 0) sat = 0;
+	if (sat > 1000) sat = 1000;
+	if (brightness < 0) brightness = 0;
+	if (brightness > 1000) brightness = 1000;
+
+	int v = brightness * 255;
+
+	if (sat == 0) {
+		red = v;
+		green = v;
+		blue = v;
 	}
 	else {
-		if (_hue >= 360.0) _hue = fmod(_hue, 360);
+		if (hue >= 360) hue %= 360;
 
-		int slice = (int)(_hue / 60.0);
-		float hue_frac = (_hue / 60.0) - slice;
+		int slice = hue / 60;
+		int hue_frac = (hue % 60) * 1000 / 60;
 
-		float aa = _brightness * (1.0 - _sat);
-		float bb = _brightness * (1.0 - _sat * hue_frac);
-		float cc = _brightness * (1.0 - _sat * (1.0 - hue_frac));
+		int aa = v * (1000 - sat) / 1000;
+		int bb = v * (1000 - sat * hue_frac / 1000) / 1000;
+		int cc = v * (1000 - sat * (1000 - hue_frac) / 1000) / 1000;
 
 		switch(slice) {
 			case 0:
-				red = _brightness;
+				red = v;
 				green = cc;
 				blue = aa;
 				break;
 			case 1:
 				red = bb;
-				green = _brightness;
+				green = v;
 				blue = aa;
 				break;
 			case 2:
 				red = aa;
-				green = _brightness;
+				green = v;
 				blue = cc;
 				break;
 			case 3:
 				red = aa;
 				green = bb;
-				blue = _brightness;
+				blue = v;
 				break;
 			case 4:
 				red = cc;
 				green = aa;
-				blue = _brightness;
+				blue = v;
 				break;
 			case 5:
-				red = _brightness;
+				red = v;
 				green = aa;
 				blue = bb;
 				break;
 			default:
-				red = 0.0;
-				green = 0.0;
-				blue = 0.0;
+				red = 0;
+				green = 0;
+				blue = 0;
 				break;
 		}
 	}
 
-	return (uint32_t)((uint8_t)(red * 255.0) << 16) | ((uint8_t)(green * 255.0) << 8) | ((uint8_t)(blue * 255.0));
+	return (uint32_t)((red / 1000) << 16) | ((green / 1000) << 8) | (blue / 1000);
 }
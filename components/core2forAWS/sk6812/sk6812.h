@@ -49,6 +49,7 @@ typedef struct pixel_settings {
 void np_set_pixel_color(pixel_settings_t *px, uint16_t idx, uint32_t color);
 void np_set_pixel_color_hsb(pixel_settings_t *px, uint16_t idx, float hue, float saturation, float brightness);
 uint32_t np_get_pixel_color(pixel_settings_t *px, uint16_t idx, uint8_t *white);
+size_t np_encode(const pixel_settings_t *px, rmt_item32_t *items);
 void np_show(pixel_settings_t *px, rmt_channel_t channel);
 void np_clear(pixel_settings_t *px);
 
@@ -57,4 +58,5 @@ void neopixel_deinit(rmt_channel_t channel);
 
 void rgb_to_hsb( uint32_t color, float *hue, float *sat, float *bri );
 uint32_t hsb_to_rgb(float hue, float saturation, float brightness);
+void rgb_to_hsb_int(uint32_t color, int *hue, int *sat, int *bri);
 uint32_t hsb_to_rgb_int(int hue, int sat, int brightness);
@@ -0,0 +1,171 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "sk6812_fx.h"
+
+#define TAG "SK6812-FX"
+
+typedef struct {
+    uint32_t left;
+    uint32_t right;
+} sk6812_fx_frame_t;
+
+static const pixel_settings_t *settings;    // brightness is read from here on every frame
+static pixel_settings_t frame_px;           // same settings with the engine's own pixels
+static rmt_channel_t fx_channel;
+static QueueHandle_t fx_queue;
+
+// one buffer may still be sent by the RMT interrupt while the next frame is encoded to the other
+static rmt_item32_t *items[2];
+static uint16_t item_num;
+static uint8_t next_items;
+
+static sk6812_fx_frame_t shown;
+
+// the running effect
+static bool running;
+static sk6812_fx_t fx;
+static sk6812_fx_frame_t from;
+static int hue[2], sat[2], bri[2];          // pulse colors, left then right
+static int64_t started_us;
+
+static uint32_t lerp_color(uint32_t a, uint32_t b, int level) {
+    uint32_t color = 0;
+    for (int shift = 0; shift < 24; shift += 8) {
+        int ca = (a >> shift) & 0xff;
+        int cb = (b >> shift) & 0xff;
+        color |= (uint32_t)(ca + (cb - ca) * level / 1000) << shift;
+    }
+    return color;
+}
+
+static void fx_begin(const sk6812_fx_t *next) {
+    fx = *next;
+    from = shown;
+    rgb_to_hsb_int(fx.left, &hue[0], &sat[0], &bri[0]);
+    rgb_to_hsb_int(fx.right, &hue[1], &sat[1], &bri[1]);
+    started_us = esp_timer_get_time();
+    running = true;
+}
+
+// Returns true when the effect is over
+static bool fx_render(uint32_t elapsed_ms, sk6812_fx_frame_t *frame) {
+    if (fx.type == SK6812_FX_FADE) {
+        int level = (fx.duration_ms == 0 || elapsed_ms >= fx.duration_ms) ? 1000 : elapsed_ms * 1000 / fx.duration_ms;
+        frame->left = lerp_color(from.left, fx.left, level);
+        frame->right = lerp_color(from.right, fx.right, level);
+        return level == 1000;
+    }
+
+    if (fx.duration_ms == 0) {
+        frame->left = fx.left;
+        frame->right = fx.right;
+        return true;
+    }
+
+    if (fx.count != 0 && elapsed_ms >= (uint32_t)fx.count * fx.duration_ms) {
+        frame->left = 0;
+        frame->right = 0;
+        return true;
+    }
+
+    // triangle from 0 up to 1000 and back over a period
+    uint32_t phase = elapsed_ms % fx.duration_ms;
+    int level = phase * 2 < fx.duration_ms ? phase * 2000 / fx.duration_ms : (fx.duration_ms - phase) * 2000 / fx.duration_ms;
+    frame->left = hsb_to_rgb_int(hue[0], sat[0], bri[0] * level / 1000);
+    frame->right = hsb_to_rgb_int(hue[1], sat[1], bri[1] * level / 1000);
+    return false;
+}
+
+static void fx_show(const sk6812_fx_frame_t *frame) {
+    uint16_t half = frame_px.pixel_count / 2;
+
+    // the right bar is the first half of the strip, as in Core2ForAWS_Sk6812_SetSideColor()
+    for (uint16_t i = 0; i < frame_px.pixel_count; i++) {
+        np_set_pixel_color(&frame_px, i, (i < half ? frame->right : frame->left) << 8);
+    }
+    frame_px.brightness = settings->brightness;
+
+    np_encode(&frame_px, items[next_items]);
+    // waits only for a previous frame still going out, never for this one
+    rmt_write_items(fx_channel, items[next_items], item_num, false);
+    next_items ^= 1;
+    shown = *frame;
+}
+
+static void sk6812_fx_task(void *arg) {
+    sk6812_fx_t next;
+    sk6812_fx_frame_t frame;
+
+    for (;;) {
+        TickType_t wait = running ? pdMS_TO_TICKS(SK6812_FX_FRAME_MS) : portMAX_DELAY;
+        if (xQueueReceive(fx_queue, &next, wait) == pdTRUE) {
+            // only the latest one is shown
+            while (xQueueReceive(fx_queue, &next, 0) == pdTRUE) {
+            }
+            fx_begin(&next);
+        }
+
+        if (!running) {
+            continue;
+        }
+
+        uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - started_us) / 1000);
+        running = !fx_render(elapsed_ms, &frame);
+        if (frame.left != shown.left || frame.right != shown.right) {
+            fx_show(&frame);
+        }
+    }
+}
+
+esp_err_t sk6812_fx_start(const pixel_settings_t *px, rmt_channel_t channel) {
+    if (fx_queue != NULL) {
+        return ESP_OK;
+    }
+
+    settings = px;
+    fx_channel = channel;
+    frame_px = *px;
+    item_num = px->pixel_count * px->nbits + 1;
+
+    frame_px.pixels = (uint8_t *)calloc(px->pixel_count, px->nbits / 8);
+    items[0] = (rmt_item32_t *)malloc(item_num * sizeof(rmt_item32_t));
+    items[1] = (rmt_item32_t *)malloc(item_num * sizeof(rmt_item32_t));
+    fx_queue = xQueueCreate(SK6812_FX_QUEUE_LEN, sizeof(sk6812_fx_t));
+    if (frame_px.pixels == NULL || items[0] == NULL || items[1] == NULL || fx_queue == NULL) {
+        goto failed;
+    }
+
+    if (xTaskCreatePinnedToCore(sk6812_fx_task, "Sk6812Fx", 2 * 1024, NULL, 1, NULL, 0) != pdPASS) {
+        goto failed;
+    }
+    return ESP_OK;
+
+failed:
+    ESP_LOGE(TAG, "Failed to start the LED effects");
+    free(frame_px.pixels);
+    free(items[0]);
+    free(items[1]);
+    items[0] = NULL;
+    items[1] = NULL;
+    if (fx_queue != NULL) {
+        vQueueDelete(fx_queue);
+        fx_queue = NULL;
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+bool sk6812_fx_post(const sk6812_fx_t *fx) {
+    if (fx_queue == NULL || fx == NULL) {
+        return false;
+    }
+    return xQueueSend(fx_queue, fx, 0) == pdTRUE;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "sk6812.h"
+
+/*
+ * Background effects for the two SK6812 LED bars.
+ *
+ * A task renders the frames of the current effect, encodes them to RMT
+ * items in one of two buffers and queues them while the other one may
+ * still be going out, so a caller only posts a message and never waits
+ * for the LEDs. A new effect replaces the running one from the colors
+ * shown at that moment.
+ */
+typedef enum {
+    SK6812_FX_FADE = 0,     // from the shown colors to the new ones over duration_ms
+    SK6812_FX_PULSE,        // the new colors breathe in and out every duration_ms, off after the last pulse
+} sk6812_fx_type_t;
+
+typedef struct {
+    sk6812_fx_type_t type;
+    uint32_t left;          // 0xRRGGBB
+    uint32_t right;         // 0xRRGGBB
+    uint16_t duration_ms;   // fade time or pulse period, 0 fades at once
+    uint8_t count;          // pulses, 0 repeats until the next effect
+} sk6812_fx_t;
+
+#define SK6812_FX_FRAME_MS 20
+#define SK6812_FX_QUEUE_LEN 4
+
+/* px gives the LED count, color order, timings and brightness, its pixel buffer isn't used */
+esp_err_t sk6812_fx_start(const pixel_settings_t *px, rmt_channel_t channel);
+
+/* Never blocks, false if the task isn't started or its queue is full */
+bool sk6812_fx_post(const sk6812_fx_t *fx);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,7 +1,11 @@
+#include <string.h>
 #include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "speaker.h"
 #include "driver/i2s.h"
 #include "esp_idf_version.h"
+#include "esp_timer.h"
+#include "axp192.h"
 
 #define I2S_BCK_PIN 12
 #define I2S_LRCK_PIN 0
@@ -9,11 +13,41 @@
 #define I2S_DATA_IN_PIN 34
 #define SPEAKER_I2S_NUMBER I2S_NUM_0
 
+#define SPEAKER_DMA_BUF_COUNT 2
+#define SPEAKER_DMA_BUF_LEN 128
+/* One block fills all the DMA buffers */
+#define SPEAKER_BLOCK_SAMPLES (SPEAKER_DMA_BUF_COUNT * SPEAKER_DMA_BUF_LEN)
+
+/* Power of 2 */
+#define SPEAKER_STREAM_MASK (SPEAKER_STREAM_SAMPLES - 1)
+
+typedef struct {
+    const int16_t* pcm;     /* NULL when the voice is free */
+    uint32_t samples;
+    uint32_t pos;
+    uint16_t gain;
+} speaker_voice_t;
+
+static portMUX_TYPE voice_lock = portMUX_INITIALIZER_UNLOCKED;
+static speaker_voice_t voices[SPEAKER_VOICES];
+
+/* Single producer (Speaker_WriteBuff), single consumer (Speaker_PlaySlice) ring.
+ * The indexes run freely, each side writes only its own. */
+static int16_t stream[SPEAKER_STREAM_SAMPLES];
+static uint32_t stream_head;
+static uint32_t stream_tail;
+
+/* Set by the task that owns I2S_NUM_0 and plays the slices */
+static bool scheduled;
+
+static int32_t mix_acc[SPEAKER_BLOCK_SAMPLES];
+static int16_t mix_block[SPEAKER_BLOCK_SAMPLES];
+
 void Speaker_Init() {
     esp_err_t err = ESP_OK;
     i2s_config_t i2s_config = {
         .mode = (i2s_mode_t)(I2S_MODE_MASTER),
-        .sample_rate = 44100,
+        .sample_rate = SPEAKER_SAMPLE_RATE,
         .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT, // is fixed at 12bit, stereo, MSB
         .channel_format = I2S_CHANNEL_FMT_ONLY_RIGHT,
 #if ESP_IDF_VERSION > ESP_IDF_VERSION_VAL(4, 1, 0)
@@ -22,8 +56,8 @@ void Speaker_Init() {
         .communication_format = I2S_COMM_FORMAT_I2S,
 #endif
         .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-        .dma_buf_count = 2,
-        .dma_buf_len = 128,
+        .dma_buf_count = SPEAKER_DMA_BUF_COUNT,
+        .dma_buf_len = SPEAKER_DMA_BUF_LEN,
     };
 
     i2s_config.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX);
@@ -37,12 +71,151 @@ void Speaker_Init() {
     tx_pin_config.data_out_num = I2S_DATA_PIN;
     tx_pin_config.data_in_num = I2S_DATA_IN_PIN;
     err += i2s_set_pin(SPEAKER_I2S_NUMBER, &tx_pin_config);
-    err += i2s_set_clk(SPEAKER_I2S_NUMBER, 44100, I2S_BITS_PER_SAMPLE_16BIT, I2S_CHANNEL_MONO);
+    err += i2s_set_clk(SPEAKER_I2S_NUMBER, SPEAKER_SAMPLE_RATE, I2S_BITS_PER_SAMPLE_16BIT, I2S_CHANNEL_MONO);
+}
+
+void Speaker_SetScheduled(bool state) {
+    __atomic_store_n(&scheduled, state, __ATOMIC_RELEASE);
+}
+
+uint32_t Speaker_WriteBuff(uint8_t* buff, uint32_t len, uint32_t timeout) {
+    if (!__atomic_load_n(&scheduled, __ATOMIC_ACQUIRE)) {
+        /* No scheduler, the caller owns the driver installed by Speaker_Init() */
+        size_t bytes_written = 0;
+        i2s_write(SPEAKER_I2S_NUMBER, buff, len, &bytes_written, portMAX_DELAY);
+        return bytes_written;
+    }
+
+    const int16_t* samples = (const int16_t *)buff;
+    uint32_t count = len / 2;
+    uint32_t queued = 0;
+    TickType_t start = xTaskGetTickCount();
+
+    for (;;) {
+        uint32_t head = __atomic_load_n(&stream_head, __ATOMIC_ACQUIRE);
+        uint32_t tail = stream_tail;
+        while (queued < count && tail - head < SPEAKER_STREAM_SAMPLES) {
+            stream[tail & SPEAKER_STREAM_MASK] = samples[queued];
+            tail++;
+            queued++;
+        }
+        __atomic_store_n(&stream_tail, tail, __ATOMIC_RELEASE);
+
+        if (queued == count || xTaskGetTickCount() - start >= timeout) {
+            break;
+        }
+        /* Room comes back only while a slice plays */
+        vTaskDelay(1);
+    }
+    return queued * 2;
 }
 
-void Speaker_WriteBuff(uint8_t* buff, uint32_t len, uint32_t timeout) {
+int Speaker_Play(const int16_t* pcm, uint32_t samples, uint16_t gain) {
+    int voice = -1;
+    if (pcm == NULL || samples == 0) {
+        return -1;
+    }
+
+    portENTER_CRITICAL(&voice_lock);
+    for (int i = 0; i < SPEAKER_VOICES; i++) {
+        if (voices[i].pcm == NULL) {
+            voices[i].pcm = pcm;
+            voices[i].samples = samples;
+            voices[i].pos = 0;
+            voices[i].gain = gain;
+            voice = i;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&voice_lock);
+    return voice;
+}
+
+bool Speaker_Pending() {
+    bool pending = __atomic_load_n(&stream_tail, __ATOMIC_ACQUIRE) != stream_head;
+
+    portENTER_CRITICAL(&voice_lock);
+    for (int i = 0; i < SPEAKER_VOICES && !pending; i++) {
+        pending = voices[i].pcm != NULL;
+    }
+    portEXIT_CRITICAL(&voice_lock);
+    return pending;
+}
+
+/* Mixes the next block into mix_block, false when there was nothing to play */
+static bool Speaker_MixBlock() {
+    bool active = false;
+    memset(mix_acc, 0, sizeof(mix_acc));
+
+    for (int i = 0; i < SPEAKER_VOICES; i++) {
+        portENTER_CRITICAL(&voice_lock);
+        speaker_voice_t voice = voices[i];
+        portEXIT_CRITICAL(&voice_lock);
+        if (voice.pcm == NULL) {
+            continue;
+        }
+
+        /* Speaker_Play only takes free voices, this one stays ours until it's freed below */
+        uint32_t n = voice.samples - voice.pos;
+        if (n > SPEAKER_BLOCK_SAMPLES) {
+            n = SPEAKER_BLOCK_SAMPLES;
+        }
+        const int16_t* src = &voice.pcm[voice.pos];
+        for (uint32_t k = 0; k < n; k++) {
+            mix_acc[k] += ((int32_t)src[k] * voice.gain) >> 8;
+        }
+        active = true;
+
+        portENTER_CRITICAL(&voice_lock);
+        voices[i].pos += n;
+        if (voices[i].pos >= voices[i].samples) {
+            voices[i].pcm = NULL;
+        }
+        portEXIT_CRITICAL(&voice_lock);
+    }
+
+    uint32_t head = stream_head;
+    uint32_t tail = __atomic_load_n(&stream_tail, __ATOMIC_ACQUIRE);
+    for (uint32_t k = 0; k < SPEAKER_BLOCK_SAMPLES && head != tail; k++) {
+        mix_acc[k] += stream[head & SPEAKER_STREAM_MASK];
+        head++;
+        active = true;
+    }
+    __atomic_store_n(&stream_head, head, __ATOMIC_RELEASE);
+
+    for (uint32_t k = 0; k < SPEAKER_BLOCK_SAMPLES; k++) {
+        int32_t v = mix_acc[k];
+        mix_block[k] = v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v);
+    }
+    return active;
+}
+
+uint32_t Speaker_PlaySlice(uint32_t max_ms) {
+    if (!Speaker_Pending()) {
+        return 0;
+    }
+
+    int64_t start = esp_timer_get_time();
+    uint32_t max_samples = max_ms * (SPEAKER_SAMPLE_RATE / 1000);
+    uint32_t played = 0;
     size_t bytes_written = 0;
-    i2s_write(SPEAKER_I2S_NUMBER, buff, len, &bytes_written, portMAX_DELAY);
+
+    Speaker_Init();
+    Axp192_SetGPIO2Level(1);
+    while (played < max_samples && Speaker_MixBlock()) {
+        /* Paced by the DMA, returns once a buffer is free */
+        i2s_write(SPEAKER_I2S_NUMBER, mix_block, sizeof(mix_block), &bytes_written, portMAX_DELAY);
+        played += SPEAKER_BLOCK_SAMPLES;
+    }
+
+    /* Push the last block out of the DMA buffers before the driver goes */
+    memset(mix_block, 0, sizeof(mix_block));
+    i2s_write(SPEAKER_I2S_NUMBER, mix_block, sizeof(mix_block), &bytes_written, portMAX_DELAY);
+    /* The amplifier stays off while the microphone has the shared pins */
+    Axp192_SetGPIO2Level(0);
+    Speaker_Deinit();
+
+    return (uint32_t)((esp_timer_get_time() - start) / 1000);
 }
 
 void Speaker_Deinit() {
@@ -5,6 +5,35 @@
 
 #pragma once
 #include "stdint.h"
+#include "stdbool.h"
+
+/**
+ * @brief Output sample rate, 16 bit mono.
+ */
+/* @[declare_speaker_sample_rate] */
+#define SPEAKER_SAMPLE_RATE 44100
+/* @[declare_speaker_sample_rate] */
+
+/**
+ * @brief Number of sounds @ref Speaker_Play() can mix at once.
+ */
+/* @[declare_speaker_voices] */
+#define SPEAKER_VOICES 4
+/* @[declare_speaker_voices] */
+
+/**
+ * @brief Gain of a sound played at its recorded level, gains are in 1/256 steps.
+ */
+/* @[declare_speaker_gain_unity] */
+#define SPEAKER_GAIN_UNITY 256
+/* @[declare_speaker_gain_unity] */
+
+/**
+ * @brief Samples buffered for @ref Speaker_WriteBuff(), about 93ms.
+ */
+/* @[declare_speaker_stream_samples] */
+#define SPEAKER_STREAM_SAMPLES 4096
+/* @[declare_speaker_stream_samples] */
 
 /**
  * @brief Initializes the speaker over I2S.
@@ -42,14 +71,90 @@ void Speaker_Init();
  *  Speaker_Deinit();
  * @endcode
  * 
- * @param[out] buff The sound buffer to play.
- * @param[in] len Length of the buffer.
- * @param[in] timeout UNUSED.
+ * Without a scheduler this writes to the driver installed by
+ * @ref Speaker_Init() and blocks until all of the buffer is written.
+ * Once a task schedules the playback with @ref Speaker_SetScheduled(),
+ * the buffer is copied to the stream buffer instead and mixed with the
+ * sounds started by @ref Speaker_Play(). It goes out in the next
+ * @ref Speaker_PlaySlice(). Only one task may write the stream.
+ * 
+ * @param[in] buff 16 bit mono samples at @ref SPEAKER_SAMPLE_RATE.
+ * @param[in] len Length of the buffer in bytes.
+ * @param[in] timeout Ticks to wait for room in the stream buffer, 0 never blocks.
+ * Unused without a scheduler.
+ * 
+ * @return The number of bytes written or queued.
  */
 /* @[declare_speaker_writebuff] */
-void Speaker_WriteBuff(uint8_t* buff, uint32_t len, uint32_t timeout);
+uint32_t Speaker_WriteBuff(uint8_t* buff, uint32_t len, uint32_t timeout);
 /* @[declare_speaker_writebuff] */
 
+/**
+ * @brief Hands the playback to a scheduler, or takes it back.
+ * 
+ * The task that owns I2S_NUM_0 for the microphone sets this before it
+ * starts capturing and then plays the pending audio with
+ * @ref Speaker_PlaySlice() between its reads. From then on
+ * @ref Speaker_WriteBuff() queues instead of writing to the driver, and
+ * @ref Speaker_Init() must not be called by anyone else.
+ * 
+ * @param[in] state true while a task schedules the playback.
+ */
+/* @[declare_speaker_setscheduled] */
+void Speaker_SetScheduled(bool state);
+/* @[declare_speaker_setscheduled] */
+
+/**
+ * @brief Starts a short sound, mixed with the others playing. Never blocks.
+ * 
+ * The samples are not copied, they must stay valid until the sound is over.
+ * The sound goes out in the next @ref Speaker_PlaySlice().
+ * 
+ * **Example:**
+ * 
+ * Play a beep at half its level.
+ * @code{c}
+ *  static int16_t beep[882]; // 20ms, filled once at start up
+ *  Speaker_Play(beep, 882, SPEAKER_GAIN_UNITY / 2);
+ * @endcode
+ * 
+ * @param[in] pcm 16 bit mono samples at @ref SPEAKER_SAMPLE_RATE.
+ * @param[in] samples Number of samples.
+ * @param[in] gain Level of the sound, @ref SPEAKER_GAIN_UNITY plays it as is.
+ * 
+ * @return The voice playing the sound, or -1 if all @ref SPEAKER_VOICES are busy.
+ */
+/* @[declare_speaker_play] */
+int Speaker_Play(const int16_t* pcm, uint32_t samples, uint16_t gain);
+/* @[declare_speaker_play] */
+
+/**
+ * @brief Whether a sound or streamed samples wait to be played.
+ */
+/* @[declare_speaker_pending] */
+bool Speaker_Pending();
+/* @[declare_speaker_pending] */
+
+/**
+ * @brief Plays the pending audio for up to max_ms.
+ * 
+ * The speaker and the microphone share I2S_NUM_0, so the task that
+ * captures from the microphone schedules the playback: it uninstalls
+ * its driver, calls this function when @ref Speaker_Pending() and
+ * installs its driver again. This initializes the speaker, powers the
+ * amplifier, mixes the voices and the stream into the DMA buffers, lets
+ * the last buffers play out, then powers the amplifier down and
+ * de-initializes the speaker. There is no need to call
+ * @ref Core2ForAWS_Speaker_Enable().
+ * 
+ * @param[in] max_ms The longest time of audio to play, the rest waits for the next slice.
+ * 
+ * @return The time I2S_NUM_0 was used in ms, 0 if nothing was pending.
+ */
+/* @[declare_speaker_playslice] */
+uint32_t Speaker_PlaySlice(uint32_t max_ms);
+/* @[declare_speaker_playslice] */
+
 /**
  * @brief De-initializes the speaker.
  */
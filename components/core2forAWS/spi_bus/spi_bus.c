@@ -0,0 +1,173 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "spi_bus.h"
+
+#define TAG "SPI-BUS"
+
+#define SPI_BUS_NO_OWNER -1
+
+typedef struct {
+    SemaphoreHandle_t grant;    // given by whoever hands the bus over
+    bool waiting;
+    int64_t deadline_us;
+    int64_t since_us;           // request time while waiting, grant time while owning
+    spi_bus_stats_t stats;
+    uint64_t logged_busy_us;    // busy_us at the last spi_bus_log_stats()
+} spi_bus_slot_t;
+
+static const char *client_name[SPI_BUS_CLIENT_MAX] = { "display", "sdcard" };
+
+static portMUX_TYPE bus_lock = portMUX_INITIALIZER_UNLOCKED;
+static spi_bus_slot_t slots[SPI_BUS_CLIENT_MAX];
+static int owner = SPI_BUS_NO_OWNER;
+static int64_t logged_at_us;
+
+void spi_bus_init(void) {
+    for (int i = 0; i < SPI_BUS_CLIENT_MAX; i++) {
+        if (slots[i].grant == NULL) {
+            slots[i].grant = xSemaphoreCreateBinary();
+            assert(slots[i].grant != NULL);
+        }
+    }
+    logged_at_us = esp_timer_get_time();
+}
+
+/* bus_lock held */
+static void IRAM_ATTR grant_locked(int client, int64_t now) {
+    spi_bus_slot_t *slot = &slots[client];
+    uint32_t wait = (uint32_t)(now - slot->since_us);
+
+    owner = client;
+    slot->waiting = false;
+    slot->since_us = now;
+    slot->stats.grants++;
+    slot->stats.wait_us += wait;
+    if (wait > slot->stats.max_wait_us) {
+        slot->stats.max_wait_us = wait;
+    }
+}
+
+/* bus_lock held, returns the client that got the bus next or SPI_BUS_NO_OWNER */
+static int IRAM_ATTR release_locked(int client, int64_t now) {
+    spi_bus_slot_t *slot = &slots[client];
+    uint32_t hold = (uint32_t)(now - slot->since_us);
+    int next = SPI_BUS_NO_OWNER;
+
+    assert(owner == client);
+
+    slot->stats.busy_us += hold;
+    if (hold > slot->stats.max_hold_us) {
+        slot->stats.max_hold_us = hold;
+    }
+    owner = SPI_BUS_NO_OWNER;
+
+    // earliest deadline first, the lower id on a tie
+    for (int i = 0; i < SPI_BUS_CLIENT_MAX; i++) {
+        if (slots[i].waiting && (next == SPI_BUS_NO_OWNER || slots[i].deadline_us < slots[next].deadline_us)) {
+            next = i;
+        }
+    }
+    if (next != SPI_BUS_NO_OWNER) {
+        grant_locked(next, now);
+    }
+    return next;
+}
+
+void spi_bus_acquire(spi_bus_client_t client, uint32_t deadline_ms) {
+    spi_bus_slot_t *slot = &slots[client];
+    int64_t now = esp_timer_get_time();
+    bool granted = false;
+
+    portENTER_CRITICAL(&bus_lock);
+    // one task per client at a time, a client never waits behind itself
+    assert(owner != client && !slot->waiting);
+    slot->since_us = now;
+    if (owner == SPI_BUS_NO_OWNER) {
+        grant_locked(client, now);
+        granted = true;
+    } else {
+        slot->deadline_us = now + (int64_t)deadline_ms * 1000;
+        slot->waiting = true;
+    }
+    portEXIT_CRITICAL(&bus_lock);
+
+    if (!granted) {
+        xSemaphoreTake(slot->grant, portMAX_DELAY);
+    }
+}
+
+void spi_bus_release(spi_bus_client_t client) {
+    int next;
+
+    portENTER_CRITICAL(&bus_lock);
+    next = release_locked(client, esp_timer_get_time());
+    portEXIT_CRITICAL(&bus_lock);
+
+    if (next != SPI_BUS_NO_OWNER) {
+        xSemaphoreGive(slots[next].grant);
+    }
+}
+
+void IRAM_ATTR spi_bus_release_from_isr(spi_bus_client_t client, BaseType_t *higher_priority_task_woken) {
+    int next;
+
+    portENTER_CRITICAL_ISR(&bus_lock);
+    next = release_locked(client, esp_timer_get_time());
+    portEXIT_CRITICAL_ISR(&bus_lock);
+
+    if (next != SPI_BUS_NO_OWNER) {
+        xSemaphoreGiveFromISR(slots[next].grant, higher_priority_task_woken);
+    }
+}
+
+void spi_bus_get_stats(spi_bus_client_t client, spi_bus_stats_t *stats) {
+    portENTER_CRITICAL(&bus_lock);
+    *stats = slots[client].stats;
+    portEXIT_CRITICAL(&bus_lock);
+}
+
+void spi_bus_reset_stats(void) {
+    portENTER_CRITICAL(&bus_lock);
+    for (int i = 0; i < SPI_BUS_CLIENT_MAX; i++) {
+        memset(&slots[i].stats, 0, sizeof(slots[i].stats));
+        slots[i].logged_busy_us = 0;
+    }
+    logged_at_us = esp_timer_get_time();
+    portEXIT_CRITICAL(&bus_lock);
+}
+
+void spi_bus_log_stats(void) {
+    spi_bus_stats_t stats[SPI_BUS_CLIENT_MAX];
+    uint64_t busy[SPI_BUS_CLIENT_MAX];
+    int64_t now = esp_timer_get_time();
+    int64_t elapsed;
+
+    portENTER_CRITICAL(&bus_lock);
+    for (int i = 0; i < SPI_BUS_CLIENT_MAX; i++) {
+        stats[i] = slots[i].stats;
+        busy[i] = stats[i].busy_us - slots[i].logged_busy_us;
+        slots[i].logged_busy_us = stats[i].busy_us;
+    }
+    elapsed = now - logged_at_us;
+    logged_at_us = now;
+    portEXIT_CRITICAL(&bus_lock);
+
+    if (elapsed <= 0) {
+        return;
+    }
+
+    for (int i = 0; i < SPI_BUS_CLIENT_MAX; i++) {
+        ESP_LOGI(TAG, "%s: %u.%u%% busy, %u grants, hold max %u us, wait avg %u us max %u us",
+            client_name[i], (unsigned)(busy[i] * 100 / elapsed), (unsigned)(busy[i] * 1000 / elapsed % 10),
+            stats[i].grants, stats[i].max_hold_us,
+            stats[i].grants ? (unsigned)(stats[i].wait_us / stats[i].grants) : 0, stats[i].max_wait_us);
+    }
+}
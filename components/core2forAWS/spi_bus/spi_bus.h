@@ -0,0 +1,58 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+/*
+ * Arbitration of the SPI bus shared by the display and the SD card.
+ *
+ * Every client holds the bus for one bounded piece of work (a display band,
+ * one multi-block SD write) and hands it back. When the bus frees up it goes
+ * to the waiter with the earliest deadline, a tie to the lower client id, so
+ * a long SD transfer costs the display at most one chunk and a busy display
+ * cannot starve the card past its deadline.
+ */
+typedef enum {
+    SPI_BUS_CLIENT_DISPLAY = 0,
+    SPI_BUS_CLIENT_SDCARD,
+    SPI_BUS_CLIENT_MAX,
+} spi_bus_client_t;
+
+/* How long a client may wait for the bus before it goes ahead of newer requests */
+#define SPI_BUS_DISPLAY_DEADLINE_MS 10
+#define SPI_BUS_SDCARD_DEADLINE_MS 50
+
+typedef struct {
+    uint32_t grants;        // times the client got the bus
+    uint64_t busy_us;       // total time it held the bus
+    uint32_t max_hold_us;   // longest single hold
+    uint64_t wait_us;       // total time spent waiting for the bus
+    uint32_t max_wait_us;   // longest single wait
+} spi_bus_stats_t;
+
+void spi_bus_init(void);
+
+/* Blocks until the client owns the bus, deadline_ms after the call at the latest if others keep to theirs */
+void spi_bus_acquire(spi_bus_client_t client, uint32_t deadline_ms);
+
+void spi_bus_release(spi_bus_client_t client);
+
+/* For transfers that complete in the SPI post-transaction interrupt */
+void spi_bus_release_from_isr(spi_bus_client_t client, BaseType_t *higher_priority_task_woken);
+
+/* Counters since boot, or since the last spi_bus_reset_stats() */
+void spi_bus_get_stats(spi_bus_client_t client, spi_bus_stats_t *stats);
+
+void spi_bus_reset_stats(void);
+
+/* Logs the share of time each client held the bus since the last call */
+void spi_bus_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
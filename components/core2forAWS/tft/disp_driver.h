@@ -20,7 +20,11 @@ extern "C" {
 /*********************
  *      DEFINES
  *********************/
-#define DISP_BUF_SIZE  (LV_HOR_RES_MAX * 64)
+/* Lines per draw buffer. Both buffers live in DMA-capable internal RAM (the
+ * SPI DMA cannot read SPIRAM, the driver would copy every flush into a bounce
+ * buffer), so they are bands rather than a large part of the frame. */
+#define DISP_BUF_LINES 20
+#define DISP_BUF_SIZE  (LV_HOR_RES_MAX * DISP_BUF_LINES)
 
 /**********************
  *      TYPEDEFS
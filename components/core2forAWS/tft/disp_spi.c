@@ -17,14 +17,15 @@
 
 #include "disp_spi.h"
 #include "disp_driver.h"
-
-SemaphoreHandle_t spi_mutex;
+#include "spi_bus.h"
 
 static void IRAM_ATTR spi_ready (spi_transaction_t *trans);
+static void IRAM_ATTR spi_pre (spi_transaction_t *trans);
 
 static spi_host_device_t spi_host;
 static spi_device_handle_t spi;
 static volatile uint8_t spi_pending_trans = 0;
+static transaction_cb_t chained_pre_cb;
 static transaction_cb_t chained_post_cb;
 
 static uint8_t tft_used_spi_dma = 0;
@@ -48,7 +49,9 @@ void spi_poll() {
 
 void disp_spi_add_device_config(spi_host_device_t host, spi_device_interface_config_t *devcfg) {
     spi_host=host;
+    chained_pre_cb=devcfg->pre_cb;
     chained_post_cb=devcfg->post_cb;
+    devcfg->pre_cb=spi_pre;
     devcfg->post_cb=spi_ready;
     esp_err_t ret=spi_bus_add_device(host, devcfg, &spi);
     assert(ret==ESP_OK);
@@ -65,7 +68,7 @@ void disp_spi_add_device(spi_host_device_t host) {
         .mode = 0,
         .spics_io_num=CONFIG_LV_DISP_SPI_CS,              // CS pin
         .input_delay_ns=0,
-        .queue_size=1,
+        .queue_size=DISP_SPI_CHAIN_MAX,
         .pre_cb=NULL,
         .post_cb=NULL,
         .flags = SPI_DEVICE_NO_DUMMY,
@@ -119,7 +122,7 @@ void disp_spi_transaction(const uint8_t *data, size_t length,
     /* Save flags for pre/post transaction processing */
     t.base.user = (void *) flags;
 
-    xSemaphoreTake(spi_mutex, portMAX_DELAY);
+    spi_bus_acquire(SPI_BUS_CLIENT_DISPLAY, SPI_BUS_DISPLAY_DEADLINE_MS);
     spi_device_acquire_bus(spi, portMAX_DELAY);
     gpio_set_level(CONFIG_LV_DISP_SPI_CS, 0);
 
@@ -128,12 +131,12 @@ void disp_spi_transaction(const uint8_t *data, size_t length,
         spi_device_polling_transmit(spi, (spi_transaction_t *) &t);
         gpio_set_level(CONFIG_LV_DISP_SPI_CS, 1);
         spi_device_release_bus(spi);
-        xSemaphoreGive(spi_mutex);
+        spi_bus_release(SPI_BUS_CLIENT_DISPLAY);
     } else if (flags & DISP_SPI_SEND_SYNCHRONOUS) {
         spi_device_transmit(spi, (spi_transaction_t *) &t);
         gpio_set_level(CONFIG_LV_DISP_SPI_CS, 1);
         spi_device_release_bus(spi);
-        xSemaphoreGive(spi_mutex);
+        spi_bus_release(SPI_BUS_CLIENT_DISPLAY);
     } else {
         static spi_transaction_ext_t queuedt;
         memcpy(&queuedt, &t, sizeof t);
@@ -144,6 +147,42 @@ void disp_spi_transaction(const uint8_t *data, size_t length,
     }
 }
 
+void disp_spi_queue_chain(const disp_spi_chain_t *chain, size_t count) {
+    /* one chain in flight at a time, LVGL only flushes again once the last one signalled */
+    static spi_transaction_ext_t queuedt[DISP_SPI_CHAIN_MAX];
+
+    assert(count > 0 && count <= DISP_SPI_CHAIN_MAX);
+    assert(chain[count - 1].flags & DISP_SPI_SIGNAL_FLUSH);
+
+    /* Collect the results of the previous chain, done by now */
+    disp_wait_for_pending_transactions();
+
+    for (size_t i = 0; i < count; i++) {
+        spi_transaction_ext_t *t = &queuedt[i];
+
+        memset(t, 0, sizeof *t);
+        t->base.length = chain[i].length * 8;
+        if (chain[i].length <= 4) {
+            t->base.flags = SPI_TRANS_USE_TXDATA;
+            memcpy(t->base.tx_data, chain[i].data, chain[i].length);
+        } else {
+            t->base.tx_buffer = chain[i].data;
+        }
+        t->base.user = (void *) chain[i].flags;
+    }
+
+    spi_bus_acquire(SPI_BUS_CLIENT_DISPLAY, SPI_BUS_DISPLAY_DEADLINE_MS);
+    spi_device_acquire_bus(spi, portMAX_DELAY);
+    gpio_set_level(CONFIG_LV_DISP_SPI_CS, 0);
+
+    for (size_t i = 0; i < count; i++) {
+        spi_pending_trans++;
+        if (spi_device_queue_trans(spi, (spi_transaction_t *) &queuedt[i], portMAX_DELAY) != ESP_OK) {
+            spi_pending_trans--;
+        }
+    }
+}
+
 void disp_wait_for_pending_transactions(void) {
     spi_transaction_t *presult;
 
@@ -154,9 +193,23 @@ void disp_wait_for_pending_transactions(void) {
     }
 }
 
+static void IRAM_ATTR spi_pre(spi_transaction_t *trans) {
+    disp_spi_send_flag_t flags = (disp_spi_send_flag_t) trans->user;
+
+    if (flags & DISP_SPI_DC_COMMAND) {
+        gpio_set_level(ILI9341_DC, 0);
+    } else if (flags & DISP_SPI_DC_DATA) {
+        gpio_set_level(ILI9341_DC, 1);
+    }
+
+    if (chained_pre_cb) {
+        chained_pre_cb(trans);
+    }
+}
+
 static void IRAM_ATTR spi_ready(spi_transaction_t *trans) {
     disp_spi_send_flag_t flags = (disp_spi_send_flag_t) trans->user;
-    int higher_priority_task_awoken = pdFALSE;
+    BaseType_t higher_priority_task_awoken = pdFALSE;
 
     if (flags & DISP_SPI_SIGNAL_FLUSH) {
         lv_disp_t * disp = NULL;
@@ -173,7 +226,7 @@ static void IRAM_ATTR spi_ready(spi_transaction_t *trans) {
         tft_used_spi_dma = 1;
         gpio_set_level(CONFIG_LV_DISP_SPI_CS, 1);
         spi_device_release_bus(spi);
-        xSemaphoreGiveFromISR(spi_mutex, &higher_priority_task_awoken);
+        spi_bus_release_from_isr(SPI_BUS_CLIENT_DISPLAY, &higher_priority_task_awoken);
     }
 
     if (higher_priority_task_awoken) portYIELD_FROM_ISR();
@@ -29,8 +29,20 @@ typedef enum _disp_spi_send_flag_t {
     DISP_SPI_MODE_DIO           = 0x00000400, /* Reserved */
     DISP_SPI_MODE_QIO           = 0x00000800, /* Reserved */
     DISP_SPI_MODE_DIOQIO_ADDR   = 0x00001000, /* Reserved */
+    DISP_SPI_DC_COMMAND         = 0x00002000, /* D/C low from the pre-transfer callback */
+    DISP_SPI_DC_DATA            = 0x00004000, /* D/C high from the pre-transfer callback */
 } disp_spi_send_flag_t;
 
+/* Longest chain disp_spi_queue_chain() takes, also the depth of the device queue */
+#define DISP_SPI_CHAIN_MAX 6
+
+/* One transfer of a queued chain, the buffer must stay valid until the chain is done */
+typedef struct _disp_spi_chain_t {
+    const uint8_t *data;
+    size_t length;
+    disp_spi_send_flag_t flags;
+} disp_spi_chain_t;
+
 typedef struct _disp_spi_read_data {
     uint8_t _dummy_byte;
     union {
@@ -40,22 +52,20 @@ typedef struct _disp_spi_read_data {
     } __attribute__((packed));
 } disp_spi_read_data __attribute__((aligned(4)));
 
-/**
- * @brief Semaphore for the shared SPI bus.
- * 
- * This semaphore helps protect the usage of the SPI bus. The implementation of the 
- * ILI9342C library uses this mutex to write to the display controller.
- */
-/* @[declare_spi_mutex] */
-extern SemaphoreHandle_t spi_mutex;
-/* @[declare_spi_mutex] */
-
 void disp_spi_add_device(spi_host_device_t host);
 void disp_spi_add_device_config(spi_host_device_t host, spi_device_interface_config_t *devcfg);
 void disp_spi_transaction(const uint8_t *data, size_t length,
     disp_spi_send_flag_t flags, disp_spi_read_data *out, uint64_t addr);
 void disp_wait_for_pending_transactions(void);
 
+/*
+ * Queues up to DISP_SPI_CHAIN_MAX transfers back to back under one bus
+ * acquisition and returns without waiting for them. The last one must carry
+ * DISP_SPI_SIGNAL_FLUSH: the bus is handed back to the spi_bus arbiter from
+ * its post-transfer interrupt, the same as for disp_spi_send_colors().
+ */
+void disp_spi_queue_chain(const disp_spi_chain_t *chain, size_t count);
+
 static inline void disp_spi_send_data(uint8_t *data, size_t length) {
     disp_spi_transaction(data, length, DISP_SPI_SEND_POLLING, NULL, 0);
 }
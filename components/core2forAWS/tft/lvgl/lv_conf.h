@@ -101,6 +101,11 @@
  * Can be changed in the display driver (`lv_disp_drv_t`).*/
 #define LV_DISP_DEF_REFR_PERIOD CONFIG_LV_DISP_DEF_REFR_PERIOD   /*[ms]*/
 
+/* Join invalid areas if it costs at most this many extra pixels.
+ * Each area is an object tree walk and a flush of its own, eight
+ * lines of pixels are cheaper to redraw than that.*/
+#define LV_INV_JOIN_EXTRA_PX    (LV_HOR_RES_MAX * 8)
+
 /* Dot Per Inch: used to initialize default sizes.
  * E.g. a button with width = LV_DPI / 2 -> half inch wide
  * (Not so important, you can adjust it to modify default sizes and spaces)*/
@@ -128,10 +133,10 @@ typedef int16_t lv_coord_t;
  * The graphical objects and other related data are stored here. */
 
 /* 1: use custom malloc/free, 0: use the built-in `lv_mem_alloc` and `lv_mem_free` */
-#define LV_MEM_CUSTOM      1
+#define LV_MEM_CUSTOM      0
 #if LV_MEM_CUSTOM == 0
 /* Size of the memory used by `lv_mem_alloc` in bytes (>= 2kB)*/
-#  define LV_MEM_SIZE    ( CONFIG_LV_MEM_SIZE * 1024U)
+#  define LV_MEM_SIZE    ( CONFIG_LV_MEM_SIZE_BYTES * 1024U)
 
 /* Complier prefix for a big array declaration */
 #  define LV_MEM_ATTR
@@ -142,6 +147,10 @@ typedef int16_t lv_coord_t;
 
 /* Automatically defrag. on free. Defrag. means joining the adjacent free cells. */
 #  define LV_MEM_AUTO_DEFRAG  1
+
+/* 1: Manage the memory with a two-level segregated fit allocator.
+ * Allocation and free take constant time and the free blocks are always joined. */
+#  define LV_MEM_TLSF         1
 #else       /*LV_MEM_CUSTOM*/
 #  define LV_MEM_CUSTOM_INCLUDE "freertos/FreeRTOS.h"   /*Header for the dynamic memory function*/
 #  define LV_MEM_CUSTOM_ALLOC   pvPortMalloc       /*Wrapper to malloc*/
@@ -266,6 +275,14 @@ typedef void * lv_group_user_data_t;
     #define LV_USE_GPU_STM32_DMA2D  0
 #endif
 
+/* 1: Blend the RGB565 colors of the ILI9342C two pixels at a time in software
+ * Gives the same pixels as the plain loops of lv_draw_blend.c */
+#if LV_COLOR_DEPTH == 16 && LV_COLOR_SCREEN_TRANSP == 0
+    #define LV_USE_GPU_SW_BLEND     1
+#else
+    #define LV_USE_GPU_SW_BLEND     0
+#endif
+
 /* 1: Enable file system (might be required for images */
 #if defined CONFIG_LV_FEATURE_USE_FILESYSTEM
     #define LV_USE_FILESYSTEM       1
@@ -544,6 +561,14 @@ typedef void * lv_indev_drv_user_data_t;            /*Type of user data in the i
     #define LV_FONT_FMT_TXT_LARGE   0
 #endif
 
+/* LRU cache of glyph ids and decompressed glyph bitmaps, in bytes (0: no cache).
+ * It lives in the PSRAM (internal RAM if there is none) so it doesn't take from the
+ * DMA capable draw buffers. */
+#define LV_FONT_GLYPH_CACHE_SIZE    (48 * 1024U)
+#define LV_FONT_GLYPH_CACHE_INCLUDE "esp_heap_caps.h"
+#define LV_FONT_GLYPH_CACHE_ALLOC(size) heap_caps_malloc_prefer(size, 2, MALLOC_CAP_SPIRAM, MALLOC_CAP_DEFAULT)
+#define LV_FONT_GLYPH_CACHE_FREE    heap_caps_free
+
 /* Set the pixel order of the display.
  * Important only if "subpx fonts" are used.
  * With "normal" font it doesn't matter.
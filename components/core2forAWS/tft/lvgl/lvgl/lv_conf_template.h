@@ -94,6 +94,10 @@ typedef int16_t lv_coord_t;
 
 /* Automatically defrag. on free. Defrag. means joining the adjacent free cells. */
 #  define LV_MEM_AUTO_DEFRAG  1
+
+/* 1: Manage the memory with a two-level segregated fit allocator.
+ * Allocation and free take constant time and the free blocks are always joined. */
+#  define LV_MEM_TLSF         0
 #else       /*LV_MEM_CUSTOM*/
 #  define LV_MEM_CUSTOM_INCLUDE <stdlib.h>   /*Header for the dynamic memory function*/
 #  define LV_MEM_CUSTOM_ALLOC   malloc       /*Wrapper to malloc*/
@@ -210,6 +214,10 @@ e.g. "stm32f769xx.h" or "stm32f429xx.h" */
 /*1: Use VG-Lite for CPU offload on NXP RTxxx platforms */
 #define LV_USE_GPU_NXP_VG_LITE   0
 
+/*1: Blend 16 bit colors two pixels at a time in software (lv_gpu_sw_blend.c).
+ *   Requires LV_COLOR_DEPTH 16 without LV_COLOR_SCREEN_TRANSP */
+#define LV_USE_GPU_SW_BLEND     0
+
 /* 1: Enable file system (might be required for images */
 #define LV_USE_FILESYSTEM       1
 #if LV_USE_FILESYSTEM
@@ -432,6 +440,17 @@ typedef void * lv_indev_drv_user_data_t;            /*Type of user data in the i
  */
 #define LV_USE_FONT_COMPRESSED 1
 
+/* Size of an LRU cache of glyphs in bytes (0: no cache).
+ * Keeps the glyph ids of the letters and the decompressed bitmaps of compressed fonts,
+ * so a glyph is looked up and decompressed only once. */
+#define LV_FONT_GLYPH_CACHE_SIZE 0
+#if LV_FONT_GLYPH_CACHE_SIZE
+/* Allocator of the glyph cache, e.g. to keep it in external RAM.
+ * Set LV_FONT_GLYPH_CACHE_INCLUDE to the header of the functions if needed. */
+#  define LV_FONT_GLYPH_CACHE_ALLOC lv_mem_alloc
+#  define LV_FONT_GLYPH_CACHE_FREE  lv_mem_free
+#endif
+
 /* Enable subpixel rendering */
 #define LV_USE_FONT_SUBPX 1
 #if LV_USE_FONT_SUBPX
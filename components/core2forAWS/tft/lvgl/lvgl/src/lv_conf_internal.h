@@ -231,6 +231,16 @@
 #    define  LV_MEM_AUTO_DEFRAG  1
 #  endif
 #endif
+
+/* 1: Manage the memory with a two-level segregated fit allocator.
+ * Allocation and free take constant time and the free blocks are always joined. */
+#ifndef LV_MEM_TLSF
+#  ifdef CONFIG_LV_MEM_TLSF
+#    define LV_MEM_TLSF CONFIG_LV_MEM_TLSF
+#  else
+#    define  LV_MEM_TLSF         0
+#  endif
+#endif
 #else       /*LV_MEM_CUSTOM*/
 #ifndef LV_MEM_CUSTOM_INCLUDE
 #  ifdef CONFIG_LV_MEM_CUSTOM_INCLUDE
@@ -531,6 +541,16 @@ e.g. "stm32f769xx.h" or "stm32f429xx.h" */
 #  endif
 #endif
 
+/*1: Blend 16 bit colors two pixels at a time in software (lv_gpu_sw_blend.c).
+ *   Requires LV_COLOR_DEPTH 16 without LV_COLOR_SCREEN_TRANSP */
+#ifndef LV_USE_GPU_SW_BLEND
+#  ifdef CONFIG_LV_USE_GPU_SW_BLEND
+#    define LV_USE_GPU_SW_BLEND CONFIG_LV_USE_GPU_SW_BLEND
+#  else
+#    define  LV_USE_GPU_SW_BLEND     0
+#  endif
+#endif
+
 /* 1: Enable file system (might be required for images */
 #ifndef LV_USE_FILESYSTEM
 #  ifdef CONFIG_LV_USE_FILESYSTEM
@@ -1115,6 +1135,35 @@ e.g. "stm32f769xx.h" or "stm32f429xx.h" */
 #  endif
 #endif
 
+/* Size of an LRU cache of glyphs in bytes (0: no cache).
+ * Keeps the glyph ids of the letters and the decompressed bitmaps of compressed fonts,
+ * so a glyph is looked up and decompressed only once. */
+#ifndef LV_FONT_GLYPH_CACHE_SIZE
+#  ifdef CONFIG_LV_FONT_GLYPH_CACHE_SIZE
+#    define LV_FONT_GLYPH_CACHE_SIZE CONFIG_LV_FONT_GLYPH_CACHE_SIZE
+#  else
+#    define  LV_FONT_GLYPH_CACHE_SIZE 0
+#  endif
+#endif
+#if LV_FONT_GLYPH_CACHE_SIZE
+/* Allocator of the glyph cache, e.g. to keep it in external RAM.
+ * Set LV_FONT_GLYPH_CACHE_INCLUDE to the header of the functions if needed. */
+#ifndef LV_FONT_GLYPH_CACHE_ALLOC
+#  ifdef CONFIG_LV_FONT_GLYPH_CACHE_ALLOC
+#    define LV_FONT_GLYPH_CACHE_ALLOC CONFIG_LV_FONT_GLYPH_CACHE_ALLOC
+#  else
+#    define  LV_FONT_GLYPH_CACHE_ALLOC lv_mem_alloc
+#  endif
+#endif
+#ifndef LV_FONT_GLYPH_CACHE_FREE
+#  ifdef CONFIG_LV_FONT_GLYPH_CACHE_FREE
+#    define LV_FONT_GLYPH_CACHE_FREE CONFIG_LV_FONT_GLYPH_CACHE_FREE
+#  else
+#    define  LV_FONT_GLYPH_CACHE_FREE lv_mem_free
+#  endif
+#endif
+#endif  /*LV_FONT_GLYPH_CACHE_SIZE*/
+
 /* Enable subpixel rendering */
 #ifndef LV_USE_FONT_SUBPX
 #  ifdef CONFIG_LV_USE_FONT_SUBPX
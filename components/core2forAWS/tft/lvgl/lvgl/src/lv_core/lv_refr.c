@@ -37,6 +37,7 @@
  *  STATIC PROTOTYPES
  **********************/
 static void lv_refr_join_area(void);
+static bool lv_refr_join_worth(const lv_area_t * a1, const lv_area_t * a2, lv_area_t * joined);
 static void lv_refr_areas(void);
 static void lv_refr_area(const lv_area_t * area_p);
 static void lv_refr_area_part(const lv_area_t * area_p);
@@ -135,6 +136,9 @@ void _lv_inv_area(lv_disp_t * disp, const lv_area_t * area_p)
             if(_lv_area_is_in(&com_area, &disp->inv_areas[i], 0) != false) return;
         }
 
+        /*Tell the driver the display became dirty*/
+        if(disp->inv_p == 0 && disp->driver.invalidate_cb) disp->driver.invalidate_cb(&disp->driver);
+
         /*Save the area*/
         if(disp->inv_p < LV_INV_BUF_SIZE) {
             lv_area_copy(&disp->inv_areas[disp->inv_p], &com_area);
@@ -340,33 +344,52 @@ static void lv_refr_join_area(void)
     uint32_t join_from;
     uint32_t join_in;
     lv_area_t joined_area;
-    for(join_in = 0; join_in < disp_refr->inv_p; join_in++) {
-        if(disp_refr->inv_area_joined[join_in] != 0) continue;
-
-        /*Check all areas to join them in 'join_in'*/
-        for(join_from = 0; join_from < disp_refr->inv_p; join_from++) {
-            /*Handle only unjoined areas and ignore itself*/
-            if(disp_refr->inv_area_joined[join_from] != 0 || join_in == join_from) {
-                continue;
-            }
-
-            /*Check if the areas are on each other*/
-            if(_lv_area_is_on(&disp_refr->inv_areas[join_in], &disp_refr->inv_areas[join_from]) == false) {
-                continue;
-            }
+    bool joined;
+
+    /*A grown area can be worth joining with one checked before, so repeat until nothing changes*/
+    do {
+        joined = false;
+        for(join_in = 0; join_in < disp_refr->inv_p; join_in++) {
+            if(disp_refr->inv_area_joined[join_in] != 0) continue;
+
+            /*Check all areas to join them in 'join_in'*/
+            for(join_from = 0; join_from < disp_refr->inv_p; join_from++) {
+                /*Handle only unjoined areas and ignore itself*/
+                if(disp_refr->inv_area_joined[join_from] != 0 || join_in == join_from) {
+                    continue;
+                }
 
-            _lv_area_join(&joined_area, &disp_refr->inv_areas[join_in], &disp_refr->inv_areas[join_from]);
+                if(lv_refr_join_worth(&disp_refr->inv_areas[join_in], &disp_refr->inv_areas[join_from],
+                                      &joined_area) == false) {
+                    continue;
+                }
 
-            /*Join two area only if the joined area size is smaller*/
-            if(lv_area_get_size(&joined_area) < (lv_area_get_size(&disp_refr->inv_areas[join_in]) +
-                                                 lv_area_get_size(&disp_refr->inv_areas[join_from]))) {
                 lv_area_copy(&disp_refr->inv_areas[join_in], &joined_area);
 
                 /*Mark 'join_form' is joined into 'join_in'*/
                 disp_refr->inv_area_joined[join_from] = 1;
+                joined = true;
             }
         }
-    }
+    } while(joined);
+}
+
+/**
+ * Decide whether two invalid areas should be redrawn as one
+ * @param a1 pointer to an area
+ * @param a2 pointer to an other area
+ * @param joined store the joined area here
+ * @return true: redraw `joined` instead of the two areas
+ */
+static bool lv_refr_join_worth(const lv_area_t * a1, const lv_area_t * a2, lv_area_t * joined)
+{
+    /*Without extra pixels allowed only areas on each other can be joined*/
+    if(LV_INV_JOIN_EXTRA_PX == 0 && _lv_area_is_on(a1, a2) == false) return false;
+
+    _lv_area_join(joined, a1, a2);
+
+    /*Join two area only if the joined area is not (much) larger*/
+    return lv_area_get_size(joined) < lv_area_get_size(a1) + lv_area_get_size(a2) + LV_INV_JOIN_EXTRA_PX;
 }
 
 /**
@@ -20,6 +20,10 @@
     #include "../lv_gpu/lv_gpu_stm32_dma2d.h"
 #endif
 
+#if LV_USE_GPU_SW_BLEND
+    #include "../lv_gpu/lv_gpu_sw_blend.h"
+#endif
+
 /*********************
  *      DEFINES
  *********************/
@@ -405,6 +409,11 @@ LV_ATTRIBUTE_FAST_MEM static void fill_normal(const lv_area_t * disp_area, lv_co
                 return;
             }
 #endif
+
+#if LV_USE_GPU_SW_BLEND
+            lv_gpu_sw_blend_fill(disp_buf_first, disp_w, color, opa, draw_area_w, draw_area_h);
+            return;
+#endif
             lv_color_t last_dest_color = LV_COLOR_BLACK;
             lv_color_t last_res_color = lv_color_mix(color, last_dest_color, opa);
 
@@ -444,6 +453,11 @@ LV_ATTRIBUTE_FAST_MEM static void fill_normal(const lv_area_t * disp_area, lv_co
         }
 #endif
 
+#if LV_USE_GPU_SW_BLEND
+        lv_gpu_sw_blend_fill_mask(disp_buf_first, disp_w, color, mask, opa, draw_area_w, draw_area_h);
+        return;
+#endif
+
         /*Buffer the result color to avoid recalculating the same color*/
         lv_color_t last_dest_color;
         lv_color_t last_res_color;
@@ -840,6 +854,11 @@ LV_ATTRIBUTE_FAST_MEM static void map_normal(const lv_area_t * disp_area, lv_col
             }
 #endif
 
+#if LV_USE_GPU_SW_BLEND
+            lv_gpu_sw_blend_map(disp_buf_first, disp_w, map_buf_first, opa, map_w, draw_area_w, draw_area_h);
+            return;
+#endif
+
             /*Software rendering*/
 
             for(y = 0; y < draw_area_h; y++) {
@@ -862,6 +881,11 @@ LV_ATTRIBUTE_FAST_MEM static void map_normal(const lv_area_t * disp_area, lv_col
     }
     /*Masked*/
     else {
+#if LV_USE_GPU_SW_BLEND
+        lv_gpu_sw_blend_map_mask(disp_buf_first, disp_w, map_buf_first, map_w, mask, opa, draw_area_w, draw_area_h);
+        return;
+#endif
+
         /*Only the mask matters*/
         if(opa > LV_OPA_MAX) {
             /*Go to the first pixel of the row */
@@ -1,5 +1,6 @@
 CSRCS += lv_font.c
 CSRCS += lv_font_fmt_txt.c
+CSRCS += lv_font_glyph_cache.c
 CSRCS += lv_font_loader.c
 
 CSRCS += lv_font_dejavu_16_persian_hebrew.c
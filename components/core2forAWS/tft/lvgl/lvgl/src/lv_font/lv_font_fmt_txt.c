@@ -8,6 +8,7 @@
  *********************/
 #include "lv_font.h"
 #include "lv_font_fmt_txt.h"
+#include "lv_font_glyph_cache.h"
 #include "../lv_misc/lv_debug.h"
 #include "../lv_misc/lv_types.h"
 #include "../lv_misc/lv_gc.h"
@@ -37,6 +38,10 @@ static int32_t unicode_list_compare(const void * ref, const void * element);
 static int32_t kern_pair_8_compare(const void * ref, const void * element);
 static int32_t kern_pair_16_compare(const void * ref, const void * element);
 
+#if LV_FONT_GLYPH_CACHE_SIZE
+    static lv_font_glyph_cache_entry_t * get_cache_entry(const lv_font_t * font, uint32_t letter);
+#endif
+
 #if LV_USE_FONT_COMPRESSED
     static void decompress(const uint8_t * in, uint8_t * out, lv_coord_t w, lv_coord_t h, uint8_t bpp, bool prefilter);
     static inline void decompress_line(uint8_t * out, lv_coord_t w);
@@ -81,12 +86,21 @@ const uint8_t * lv_font_get_bitmap_fmt_txt(const lv_font_t * font, uint32_t unic
     if(unicode_letter == '\t') unicode_letter = ' ';
 
     lv_font_fmt_txt_dsc_t * fdsc = (lv_font_fmt_txt_dsc_t *) font->dsc;
+#if LV_FONT_GLYPH_CACHE_SIZE
+    lv_font_glyph_cache_entry_t * entry = get_cache_entry(font, unicode_letter);
+    if(entry && entry->bitmap) return entry->bitmap;
+    uint32_t gid = entry ? entry->gid : get_glyph_dsc_id(font, unicode_letter);
+#else
     uint32_t gid = get_glyph_dsc_id(font, unicode_letter);
+#endif
     if(!gid) return NULL;
 
     const lv_font_fmt_txt_glyph_dsc_t * gdsc = &fdsc->glyph_dsc[gid];
 
     if(fdsc->bitmap_format == LV_FONT_FMT_TXT_PLAIN) {
+#if LV_FONT_GLYPH_CACHE_SIZE
+        if(entry) entry->bitmap = &fdsc->glyph_bitmap[gdsc->bitmap_index];
+#endif
         return &fdsc->glyph_bitmap[gdsc->bitmap_index];
     }
     /*Handle compressed bitmap*/
@@ -112,6 +126,20 @@ const uint8_t * lv_font_get_bitmap_fmt_txt(const lv_font_t * font, uint32_t unic
                 break;
         }
 
+        bool prefilter = fdsc->bitmap_format == LV_FONT_FMT_TXT_COMPRESSED ? true : false;
+
+#if LV_FONT_GLYPH_CACHE_SIZE
+        /*Decompress into the cache to do it only once*/
+        if(entry) {
+            uint8_t * cached = _lv_font_glyph_cache_alloc_bitmap(entry, buf_size);
+            if(cached) {
+                decompress(&fdsc->glyph_bitmap[gdsc->bitmap_index], cached, gdsc->box_w, gdsc->box_h,
+                           (uint8_t)fdsc->bpp, prefilter);
+                return cached;
+            }
+        }
+#endif
+
         if(_lv_mem_get_size(LV_GC_ROOT(_lv_font_decompr_buf)) < buf_size) {
             uint8_t * tmp = lv_mem_realloc(LV_GC_ROOT(_lv_font_decompr_buf), buf_size);
             LV_ASSERT_MEM(tmp);
@@ -119,7 +147,6 @@ const uint8_t * lv_font_get_bitmap_fmt_txt(const lv_font_t * font, uint32_t unic
             LV_GC_ROOT(_lv_font_decompr_buf) = tmp;
         }
 
-        bool prefilter = fdsc->bitmap_format == LV_FONT_FMT_TXT_COMPRESSED ? true : false;
         decompress(&fdsc->glyph_bitmap[gdsc->bitmap_index], LV_GC_ROOT(_lv_font_decompr_buf), gdsc->box_w, gdsc->box_h,
                    (uint8_t)fdsc->bpp, prefilter);
         return LV_GC_ROOT(_lv_font_decompr_buf);
@@ -149,14 +176,34 @@ bool lv_font_get_glyph_dsc_fmt_txt(const lv_font_t * font, lv_font_glyph_dsc_t *
         is_tab = true;
     }
     lv_font_fmt_txt_dsc_t * fdsc = (lv_font_fmt_txt_dsc_t *) font->dsc;
+#if LV_FONT_GLYPH_CACHE_SIZE
+    lv_font_glyph_cache_entry_t * entry = get_cache_entry(font, unicode_letter);
+    uint32_t gid = entry ? entry->gid : get_glyph_dsc_id(font, unicode_letter);
+#else
     uint32_t gid = get_glyph_dsc_id(font, unicode_letter);
+#endif
     if(!gid) return false;
 
     int8_t kvalue = 0;
     if(fdsc->kern_dsc) {
-        uint32_t gid_next = get_glyph_dsc_id(font, unicode_letter_next);
-        if(gid_next) {
-            kvalue = get_kern_value(font, gid, gid_next);
+#if LV_FONT_GLYPH_CACHE_SIZE
+        /*The same pair comes again and again in a text which is redrawn*/
+        if(entry && unicode_letter_next && entry->kern_letter == unicode_letter_next) {
+            kvalue = entry->kern_value;
+        }
+        else
+#endif
+        {
+            uint32_t gid_next = get_glyph_dsc_id(font, unicode_letter_next);
+            if(gid_next) {
+                kvalue = get_kern_value(font, gid, gid_next);
+            }
+#if LV_FONT_GLYPH_CACHE_SIZE
+            if(entry) {
+                entry->kern_letter = unicode_letter_next;
+                entry->kern_value = kvalue;
+            }
+#endif
         }
     }
 
@@ -198,6 +245,21 @@ void _lv_font_clean_up_fmt_txt(void)
  *   STATIC FUNCTIONS
  **********************/
 
+#if LV_FONT_GLYPH_CACHE_SIZE
+/**
+ * Get the cache entry of a letter, add it if it's not cached yet
+ * @param font pointer to font
+ * @param letter an UNICODE letter code
+ * @return the entry or NULL if the cache is full or can't be allocated
+ */
+static lv_font_glyph_cache_entry_t * get_cache_entry(const lv_font_t * font, uint32_t letter)
+{
+    lv_font_glyph_cache_entry_t * entry = _lv_font_glyph_cache_get(font, letter);
+    if(entry == NULL) entry = _lv_font_glyph_cache_add(font, letter, get_glyph_dsc_id(font, letter));
+    return entry;
+}
+#endif
+
 static uint32_t get_glyph_dsc_id(const lv_font_t * font, uint32_t letter)
 {
     if(letter == '\0') return 0;
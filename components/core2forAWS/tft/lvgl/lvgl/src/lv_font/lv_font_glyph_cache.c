@@ -0,0 +1,292 @@
+/**
+ * @file lv_font_glyph_cache.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_font_glyph_cache.h"
+#include "../lv_misc/lv_gc.h"
+#include "../lv_misc/lv_mem.h"
+#include "../lv_misc/lv_log.h"
+
+#if LV_FONT_GLYPH_CACHE_SIZE
+
+#ifdef LV_FONT_GLYPH_CACHE_INCLUDE
+    #include LV_FONT_GLYPH_CACHE_INCLUDE
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+#define GLYPH_CACHE_BUCKETS     128     /*Power of 2*/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    lv_font_glyph_cache_entry_t * buckets[GLYPH_CACHE_BUCKETS];
+    lv_font_glyph_cache_entry_t * mru;  /*Most recently used entry*/
+    lv_font_glyph_cache_entry_t * lru;  /*Least recently used entry, dropped first*/
+    lv_font_glyph_cache_stats_t stats;
+} glyph_cache_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static glyph_cache_t * get_cache(void);
+static lv_font_glyph_cache_entry_t ** get_bucket(glyph_cache_t * cache, const lv_font_t * font, uint32_t letter);
+static void lru_unlink(glyph_cache_t * cache, lv_font_glyph_cache_entry_t * entry);
+static void lru_push(glyph_cache_t * cache, lv_font_glyph_cache_entry_t * entry);
+static bool make_room(glyph_cache_t * cache, uint32_t size);
+static void entry_drop(glyph_cache_t * cache, lv_font_glyph_cache_entry_t * entry);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+/**
+ * Find a letter of a font in the cache and make it the most recently used entry.
+ * @param font pointer to a font in LittlevGL's native format
+ * @param letter an UNICODE letter code
+ * @return the entry or NULL if the letter is not cached
+ */
+lv_font_glyph_cache_entry_t * _lv_font_glyph_cache_get(const lv_font_t * font, uint32_t letter)
+{
+    glyph_cache_t * cache = get_cache();
+    if(cache == NULL) return NULL;
+
+    lv_font_glyph_cache_entry_t * entry = *get_bucket(cache, font, letter);
+    while(entry) {
+        if(entry->letter == letter && entry->font == font) break;
+        entry = entry->hash_next;
+    }
+
+    if(entry == NULL) {
+        cache->stats.misses++;
+        return NULL;
+    }
+
+    cache->stats.hits++;
+    if(cache->mru != entry) {
+        lru_unlink(cache, entry);
+        lru_push(cache, entry);
+    }
+
+    return entry;
+}
+
+/**
+ * Add a letter of a font to the cache as the most recently used entry.
+ * The least recently used entries are dropped to make place for it.
+ * @param font pointer to a font in LittlevGL's native format
+ * @param letter an UNICODE letter code
+ * @param gid glyph id of the letter in the font
+ * @return the new entry or NULL if it doesn't fit
+ */
+lv_font_glyph_cache_entry_t * _lv_font_glyph_cache_add(const lv_font_t * font, uint32_t letter, uint32_t gid)
+{
+    glyph_cache_t * cache = get_cache();
+    if(cache == NULL) return NULL;
+
+    if(!make_room(cache, sizeof(lv_font_glyph_cache_entry_t))) return NULL;
+
+    lv_font_glyph_cache_entry_t * entry = LV_FONT_GLYPH_CACHE_ALLOC(sizeof(lv_font_glyph_cache_entry_t));
+    if(entry == NULL) return NULL;
+
+    _lv_memset_00(entry, sizeof(lv_font_glyph_cache_entry_t));
+    entry->font = font;
+    entry->letter = letter;
+    entry->gid = gid;
+
+    lv_font_glyph_cache_entry_t ** bucket = get_bucket(cache, font, letter);
+    entry->hash_next = *bucket;
+    *bucket = entry;
+    lru_push(cache, entry);
+
+    cache->stats.used += sizeof(lv_font_glyph_cache_entry_t);
+    cache->stats.entry_cnt++;
+
+    return entry;
+}
+
+/**
+ * Allocate the bitmap of an entry.
+ * The least recently used entries, except `entry`, are dropped to make place for it.
+ * @param entry the most recently used entry, without bitmap
+ * @param size bitmap size in bytes
+ * @return the bitmap to decompress into or NULL if it doesn't fit
+ */
+uint8_t * _lv_font_glyph_cache_alloc_bitmap(lv_font_glyph_cache_entry_t * entry, uint32_t size)
+{
+    glyph_cache_t * cache = LV_GC_ROOT(_lv_font_glyph_cache);
+    if(cache == NULL || entry->bitmap) return NULL;
+
+    /*`make_room` never drops the most recently used entry*/
+    if(cache->mru != entry) {
+        lru_unlink(cache, entry);
+        lru_push(cache, entry);
+    }
+
+    if(!make_room(cache, size)) return NULL;
+
+    uint8_t * bitmap = LV_FONT_GLYPH_CACHE_ALLOC(size);
+    if(bitmap == NULL) return NULL;
+
+    entry->bitmap = bitmap;
+    entry->bitmap_size = size;
+    cache->stats.used += size;
+    cache->stats.decompressed++;
+
+    return bitmap;
+}
+
+/**
+ * Invalidate a font in the cache.
+ * Needs to be called before a font is freed.
+ * @param font pointer to a font or NULL to drop every entry
+ */
+void lv_font_glyph_cache_invalidate_src(const lv_font_t * font)
+{
+    glyph_cache_t * cache = LV_GC_ROOT(_lv_font_glyph_cache);
+    if(cache == NULL) return;
+
+    lv_font_glyph_cache_entry_t * entry = cache->mru;
+    while(entry) {
+        lv_font_glyph_cache_entry_t * next = entry->next;
+        if(font == NULL || entry->font == font) entry_drop(cache, entry);
+        entry = next;
+    }
+}
+
+/**
+ * Get the counters of the cache.
+ * @param stats store the counters here
+ */
+void lv_font_glyph_cache_get_stats(lv_font_glyph_cache_stats_t * stats)
+{
+    glyph_cache_t * cache = LV_GC_ROOT(_lv_font_glyph_cache);
+    if(cache == NULL) {
+        _lv_memset_00(stats, sizeof(lv_font_glyph_cache_stats_t));
+        return;
+    }
+
+    *stats = cache->stats;
+}
+
+/**
+ * Clear the hit, miss, decompression and eviction counters.
+ */
+void lv_font_glyph_cache_reset_stats(void)
+{
+    glyph_cache_t * cache = LV_GC_ROOT(_lv_font_glyph_cache);
+    if(cache == NULL) return;
+
+    cache->stats.hits = 0;
+    cache->stats.misses = 0;
+    cache->stats.decompressed = 0;
+    cache->stats.evictions = 0;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * Get the cache, allocate it on the first use
+ * @return the cache or NULL if it couldn't be allocated
+ */
+static glyph_cache_t * get_cache(void)
+{
+    glyph_cache_t * cache = LV_GC_ROOT(_lv_font_glyph_cache);
+    if(cache) return cache;
+
+    cache = LV_FONT_GLYPH_CACHE_ALLOC(sizeof(glyph_cache_t));
+    if(cache == NULL) {
+        LV_LOG_WARN("lv_font_glyph_cache: couldn't allocate the cache");
+        return NULL;
+    }
+
+    _lv_memset_00(cache, sizeof(glyph_cache_t));
+    cache->stats.used = sizeof(glyph_cache_t);
+    LV_GC_ROOT(_lv_font_glyph_cache) = cache;
+
+    return cache;
+}
+
+static lv_font_glyph_cache_entry_t ** get_bucket(glyph_cache_t * cache, const lv_font_t * font, uint32_t letter)
+{
+    uint32_t h = (letter * 0x9E3779B1U) ^ (uint32_t)((lv_uintptr_t)font >> 3);
+    h ^= h >> 16;
+    return &cache->buckets[h & (GLYPH_CACHE_BUCKETS - 1)];
+}
+
+static void lru_unlink(glyph_cache_t * cache, lv_font_glyph_cache_entry_t * entry)
+{
+    if(entry->prev) entry->prev->next = entry->next;
+    else cache->mru = entry->next;
+
+    if(entry->next) entry->next->prev = entry->prev;
+    else cache->lru = entry->prev;
+
+    entry->prev = NULL;
+    entry->next = NULL;
+}
+
+static void lru_push(glyph_cache_t * cache, lv_font_glyph_cache_entry_t * entry)
+{
+    entry->prev = NULL;
+    entry->next = cache->mru;
+    if(cache->mru) cache->mru->prev = entry;
+    else cache->lru = entry;
+    cache->mru = entry;
+}
+
+/**
+ * Drop the least recently used entries until `size` more bytes fit in the budget.
+ * The most recently used entry is kept, it is the one the caller is working with.
+ * @param cache the cache
+ * @param size bytes to be allocated
+ * @return true: `size` bytes fit, false: not even after dropping everything else
+ */
+static bool make_room(glyph_cache_t * cache, uint32_t size)
+{
+    while(cache->stats.used + size > LV_FONT_GLYPH_CACHE_SIZE) {
+        lv_font_glyph_cache_entry_t * victim = cache->lru;
+        if(victim == NULL || victim == cache->mru) return false;
+
+        entry_drop(cache, victim);
+        cache->stats.evictions++;
+    }
+
+    return true;
+}
+
+static void entry_drop(glyph_cache_t * cache, lv_font_glyph_cache_entry_t * entry)
+{
+    lv_font_glyph_cache_entry_t ** p = get_bucket(cache, entry->font, entry->letter);
+    while(*p != entry) p = &(*p)->hash_next;
+    *p = entry->hash_next;
+
+    lru_unlink(cache, entry);
+
+    if(entry->bitmap_size) {
+        LV_FONT_GLYPH_CACHE_FREE((void *)entry->bitmap);
+        cache->stats.used -= entry->bitmap_size;
+    }
+
+    LV_FONT_GLYPH_CACHE_FREE(entry);
+    cache->stats.used -= sizeof(lv_font_glyph_cache_entry_t);
+    cache->stats.entry_cnt--;
+}
+
+#endif /*LV_FONT_GLYPH_CACHE_SIZE*/
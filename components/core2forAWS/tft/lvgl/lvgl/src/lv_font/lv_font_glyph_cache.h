@@ -0,0 +1,114 @@
+/**
+ * @file lv_font_glyph_cache.h
+ *
+ */
+
+#ifndef LV_FONT_GLYPH_CACHE_H
+#define LV_FONT_GLYPH_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_font.h"
+
+#if LV_FONT_GLYPH_CACHE_SIZE
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**
+ * A glyph of a font in LittlevGL's native format, found by its letter.
+ * Compressed fonts keep the decompressed bitmap here, so a glyph is decompressed only once.
+ */
+typedef struct _lv_font_glyph_cache_entry_t {
+    struct _lv_font_glyph_cache_entry_t * hash_next;    /**< Next entry in the same bucket*/
+    struct _lv_font_glyph_cache_entry_t * prev;         /**< More recently used entry*/
+    struct _lv_font_glyph_cache_entry_t * next;         /**< Less recently used entry*/
+    const lv_font_t * font;
+    uint32_t letter;
+    uint32_t gid;               /**< Glyph id in the font, 0: the font has no such letter*/
+    uint32_t kern_letter;       /**< Next letter of the last kerning lookup, 0: none*/
+    int8_t kern_value;          /**< Kerning value with `kern_letter`*/
+    const uint8_t * bitmap;     /**< Bitmap of the glyph or NULL if not loaded yet*/
+    uint32_t bitmap_size;       /**< Bytes allocated for `bitmap`, 0 if it points into the font*/
+} lv_font_glyph_cache_entry_t;
+
+/** Counters of the glyph cache, see `lv_font_glyph_cache_get_stats()`*/
+typedef struct {
+    uint32_t hits;              /**< Letters found in the cache*/
+    uint32_t misses;            /**< Letters looked up in the font*/
+    uint32_t decompressed;      /**< Bitmaps decompressed into the cache*/
+    uint32_t evictions;         /**< Entries dropped to stay in the budget*/
+    uint32_t entry_cnt;         /**< Entries in the cache now*/
+    uint32_t used;              /**< Bytes used now, at most `LV_FONT_GLYPH_CACHE_SIZE`*/
+} lv_font_glyph_cache_stats_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Find a letter of a font in the cache and make it the most recently used entry.
+ * @param font pointer to a font in LittlevGL's native format
+ * @param letter an UNICODE letter code
+ * @return the entry or NULL if the letter is not cached
+ */
+lv_font_glyph_cache_entry_t * _lv_font_glyph_cache_get(const lv_font_t * font, uint32_t letter);
+
+/**
+ * Add a letter of a font to the cache as the most recently used entry.
+ * The least recently used entries are dropped to make place for it.
+ * @param font pointer to a font in LittlevGL's native format
+ * @param letter an UNICODE letter code
+ * @param gid glyph id of the letter in the font
+ * @return the new entry or NULL if it doesn't fit
+ */
+lv_font_glyph_cache_entry_t * _lv_font_glyph_cache_add(const lv_font_t * font, uint32_t letter, uint32_t gid);
+
+/**
+ * Allocate the bitmap of an entry.
+ * The least recently used entries, except `entry`, are dropped to make place for it.
+ * @param entry the most recently used entry, without bitmap
+ * @param size bitmap size in bytes
+ * @return the bitmap to decompress into or NULL if it doesn't fit
+ */
+uint8_t * _lv_font_glyph_cache_alloc_bitmap(lv_font_glyph_cache_entry_t * entry, uint32_t size);
+
+/**
+ * Invalidate a font in the cache.
+ * Needs to be called before a font is freed.
+ * @param font pointer to a font or NULL to drop every entry
+ */
+void lv_font_glyph_cache_invalidate_src(const lv_font_t * font);
+
+/**
+ * Get the counters of the cache.
+ * @param stats store the counters here
+ */
+void lv_font_glyph_cache_get_stats(lv_font_glyph_cache_stats_t * stats);
+
+/**
+ * Clear the hit, miss, decompression and eviction counters.
+ */
+void lv_font_glyph_cache_reset_stats(void);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#endif /*LV_FONT_GLYPH_CACHE_SIZE*/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LV_FONT_GLYPH_CACHE_H*/
@@ -0,0 +1,389 @@
+/**
+ * @file lv_gpu_sw_blend.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_gpu_sw_blend.h"
+#include "../lv_misc/lv_math.h"
+
+#if LV_USE_GPU_SW_BLEND
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/*The channels of two RGB565 pixels are handled in the two 16 bit lanes of a word.
+ *The largest lane value is 63 * 255 + LV_COLOR_MIX_ROUND_OFS so nothing carries into the other lane.*/
+#define PAIR_R(w)           (((w) >> 11) & 0x001F001FU)
+#define PAIR_G(w)           (((w) >> 5) & 0x003F003FU)
+#define PAIR_B(w)           ((w) & 0x001F001FU)
+#define PAIR_RGB(r, g, b)   (((r) << 11) | ((g) << 5) | (b))
+#define PAIR_ROUND          ((uint32_t)LV_COLOR_MIX_ROUND_OFS * 0x00010001U)
+
+/*`LV_MATH_UDIV255` on both lanes: (x + 1 + (x >> 8)) >> 8 is exact for every x < 0xFFFF*/
+#define PAIR_DIV255(x)      ((((x) + 0x00010001U + (((x) >> 8) & 0x00FF00FFU)) >> 8) & 0x00FF00FFU)
+
+/*Bring the pixels of a word to RGB565 order and back*/
+#if LV_COLOR_16_SWAP
+    #define PAIR_SWAP(w)    ((((w) >> 8) & 0x00FF00FFU) | (((w) << 8) & 0xFF00FF00U))
+    #define PX_FULL(v)      ((uint16_t)(((v) >> 8) | ((v) << 8)))
+#else
+    #define PAIR_SWAP(w)    (w)
+    #define PX_FULL(v)      ((uint16_t)(v))
+#endif
+
+/*Red and blue of a pixel in the two lanes of a word*/
+#define PX_RB(c)            (((uint32_t)LV_COLOR_GET_R(c) << 16) | LV_COLOR_GET_B(c))
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+LV_ATTRIBUTE_FAST_MEM static inline uint32_t pair_load(const lv_color_t * px);
+LV_ATTRIBUTE_FAST_MEM static inline uint32_t pair_mix(uint32_t fg, uint32_t bg, uint32_t mix);
+LV_ATTRIBUTE_FAST_MEM static inline lv_color_t px_mix(uint32_t fg_rb, uint32_t fg_g, lv_color_t bg, uint32_t mix);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+/**
+ * Blend a color with opacity to an area of the buffer.
+ * Two pixels are mixed with one 32 bit operation; the result is the same as `lv_color_mix()` gives.
+ * @param buf a buffer which should be filled
+ * @param buf_w width of the buffer in pixels
+ * @param color fill color
+ * @param opa opacity of `color`
+ * @param fill_w width to fill in pixels (<= buf_w)
+ * @param fill_h height to fill in pixels
+ * @note `buf_w - fill_w` is offset to the next line after fill
+ */
+LV_ATTRIBUTE_FAST_MEM void lv_gpu_sw_blend_fill(lv_color_t * buf, lv_coord_t buf_w, lv_color_t color, lv_opa_t opa,
+                                                lv_coord_t fill_w, lv_coord_t fill_h)
+{
+    uint16_t color_premult[3];
+    lv_color_premult(color, opa, color_premult);
+    lv_opa_t opa_inv = 255 - opa;
+
+    /*The color part of the mix is the same for every pixel*/
+    uint32_t c32 = PAIR_SWAP((uint32_t)color.full | ((uint32_t)color.full << 16));
+    uint32_t fg_r = PAIR_R(c32) * opa + PAIR_ROUND;
+    uint32_t fg_g = PAIR_G(c32) * opa + PAIR_ROUND;
+    uint32_t fg_b = PAIR_B(c32) * opa + PAIR_ROUND;
+
+    /*Buffer the result to avoid recalculating it on plain backgrounds*/
+    lv_color_t last_dest_color = LV_COLOR_BLACK;
+    lv_color_t last_res_color = lv_color_mix_premult(color_premult, last_dest_color, opa_inv);
+    uint32_t last_dest32 = 0;
+    uint32_t last_res32 = (uint32_t)last_res_color.full | ((uint32_t)last_res_color.full << 16);
+
+    int32_t x;
+    int32_t y;
+    for(y = 0; y < fill_h; y++) {
+        x = 0;
+        if(((lv_uintptr_t)buf & 0x3) && fill_w > 0) {
+            if(last_dest_color.full != buf[0].full) {
+                last_dest_color = buf[0];
+                last_res_color = lv_color_mix_premult(color_premult, buf[0], opa_inv);
+            }
+            buf[0] = last_res_color;
+            x = 1;
+        }
+
+        uint32_t * buf32 = (uint32_t *)&buf[x];
+        for(; x < fill_w - 1; x += 2) {
+            if(*buf32 != last_dest32) {
+                last_dest32 = *buf32;
+                uint32_t bg = PAIR_SWAP(last_dest32);
+                uint32_t r = PAIR_DIV255(fg_r + PAIR_R(bg) * opa_inv);
+                uint32_t g = PAIR_DIV255(fg_g + PAIR_G(bg) * opa_inv);
+                uint32_t b = PAIR_DIV255(fg_b + PAIR_B(bg) * opa_inv);
+                last_res32 = PAIR_SWAP(PAIR_RGB(r, g, b));
+            }
+            *buf32 = last_res32;
+            buf32++;
+        }
+
+        if(x < fill_w) {
+            if(last_dest_color.full != buf[x].full) {
+                last_dest_color = buf[x];
+                last_res_color = lv_color_mix_premult(color_premult, buf[x], opa_inv);
+            }
+            buf[x] = last_res_color;
+        }
+
+        buf += buf_w;
+    }
+}
+
+/**
+ * Fill an area in the buffer with a color but take into account a mask which describes the opacity of each pixel
+ * @param buf a buffer which should be filled using a mask
+ * @param buf_w width of the buffer in pixels
+ * @param color fill color
+ * @param mask 0..255 values describing the opacity of the corresponding pixel. It's width is `fill_w`
+ * @param opa overall opacity. 255 in `mask` should mean this opacity.
+ * @param fill_w width to fill in pixels (<= buf_w)
+ * @param fill_h height to fill in pixels
+ * @note `buf_w - fill_w` is offset to the next line after fill
+ */
+LV_ATTRIBUTE_FAST_MEM void lv_gpu_sw_blend_fill_mask(lv_color_t * buf, lv_coord_t buf_w, lv_color_t color,
+                                                     const lv_opa_t * mask, lv_opa_t opa, lv_coord_t fill_w, lv_coord_t fill_h)
+{
+    uint32_t fg_rb = PX_RB(color);
+    uint32_t fg_g = LV_COLOR_GET_G(color);
+
+    int32_t x;
+    int32_t y;
+
+    /*Only the mask matters*/
+    if(opa > LV_OPA_MAX) {
+        for(y = 0; y < fill_h; y++) {
+            const lv_opa_t * mask_tmp_x = mask;
+            for(x = 0; x < fill_w && ((lv_uintptr_t)mask_tmp_x & 0x3); x++) {
+                if(*mask_tmp_x == LV_OPA_COVER) buf[x] = color;
+                else if(*mask_tmp_x) buf[x] = px_mix(fg_rb, fg_g, buf[x], *mask_tmp_x);
+                mask_tmp_x++;
+            }
+
+            for(; x <= fill_w - 4; x += 4) {
+                uint32_t mask32 = *((const uint32_t *)mask_tmp_x);
+                if(mask32 == 0xFFFFFFFF) {
+                    buf[x] = color;
+                    buf[x + 1] = color;
+                    buf[x + 2] = color;
+                    buf[x + 3] = color;
+                }
+                else if(mask32) {
+                    int32_t i;
+                    for(i = 0; i < 4; i++) {
+                        if(mask_tmp_x[i] == LV_OPA_COVER) buf[x + i] = color;
+                        else if(mask_tmp_x[i]) buf[x + i] = px_mix(fg_rb, fg_g, buf[x + i], mask_tmp_x[i]);
+                    }
+                }
+                mask_tmp_x += 4;
+            }
+
+            for(; x < fill_w; x++) {
+                if(*mask_tmp_x == LV_OPA_COVER) buf[x] = color;
+                else if(*mask_tmp_x) buf[x] = px_mix(fg_rb, fg_g, buf[x], *mask_tmp_x);
+                mask_tmp_x++;
+            }
+
+            buf += buf_w;
+            mask += fill_w;
+        }
+    }
+    /*Handle opa and mask values too*/
+    else {
+        /*Buffer the result color to avoid recalculating the same color*/
+        lv_color_t last_dest_color = buf[0];
+        lv_color_t last_res_color = buf[0];
+        lv_opa_t last_mask = LV_OPA_TRANSP;
+        lv_opa_t opa_tmp = LV_OPA_TRANSP;
+
+        for(y = 0; y < fill_h; y++) {
+            for(x = 0; x < fill_w; x++) {
+                if(mask[x]) {
+                    if(mask[x] != last_mask) {
+                        opa_tmp = mask[x] == LV_OPA_COVER ? opa : (uint32_t)((uint32_t)mask[x] * opa) >> 8;
+                    }
+                    if(mask[x] != last_mask || last_dest_color.full != buf[x].full) {
+                        last_res_color = px_mix(fg_rb, fg_g, buf[x], opa_tmp);
+                        last_mask = mask[x];
+                        last_dest_color = buf[x];
+                    }
+                    buf[x] = last_res_color;
+                }
+            }
+            buf += buf_w;
+            mask += fill_w;
+        }
+    }
+}
+
+/**
+ * Blend a map (e.g. RGB image with opacity) to a buffer.
+ * Two pixels are mixed with one 32 bit operation; the result is the same as `lv_color_mix()` gives.
+ * @param buf a buffer where `map` should be blended
+ * @param buf_w width of the buffer in pixels
+ * @param map an "image" to blend
+ * @param opa opacity of `map`
+ * @param map_w width of the map in pixels
+ * @param copy_w width of the area to blend in pixels (<= buf_w)
+ * @param copy_h height of the area to blend in pixels
+ * @note `map_w - copy_w` is offset to the next line after blend
+ */
+LV_ATTRIBUTE_FAST_MEM void lv_gpu_sw_blend_map(lv_color_t * buf, lv_coord_t buf_w, const lv_color_t * map, lv_opa_t opa,
+                                               lv_coord_t map_w, lv_coord_t copy_w, lv_coord_t copy_h)
+{
+    int32_t x;
+    int32_t y;
+    for(y = 0; y < copy_h; y++) {
+        x = 0;
+        if(((lv_uintptr_t)buf & 0x3) && copy_w > 0) {
+            buf[0] = lv_color_mix(map[0], buf[0], opa);
+            x = 1;
+        }
+
+        uint32_t * buf32 = (uint32_t *)&buf[x];
+        for(; x < copy_w - 1; x += 2) {
+            *buf32 = pair_mix(pair_load(&map[x]), *buf32, opa);
+            buf32++;
+        }
+
+        if(x < copy_w) {
+            buf[x] = lv_color_mix(map[x], buf[x], opa);
+        }
+
+        buf += buf_w;
+        map += map_w;
+    }
+}
+
+/**
+ * Blend a map to a buffer but take into account a mask which describes the opacity of each pixel
+ * @param buf a buffer where `map` should be blended
+ * @param buf_w width of the buffer in pixels
+ * @param map an "image" to blend
+ * @param map_w width of the map in pixels
+ * @param mask 0..255 values describing the opacity of the corresponding pixel. It's width is `copy_w`
+ * @param opa overall opacity. 255 in `mask` should mean this opacity.
+ * @param copy_w width of the area to blend in pixels (<= buf_w)
+ * @param copy_h height of the area to blend in pixels
+ */
+LV_ATTRIBUTE_FAST_MEM void lv_gpu_sw_blend_map_mask(lv_color_t * buf, lv_coord_t buf_w, const lv_color_t * map,
+                                                    lv_coord_t map_w, const lv_opa_t * mask, lv_opa_t opa,
+                                                    lv_coord_t copy_w, lv_coord_t copy_h)
+{
+    int32_t x;
+    int32_t y;
+
+    /*Only the mask matters*/
+    if(opa > LV_OPA_MAX) {
+        for(y = 0; y < copy_h; y++) {
+            const lv_opa_t * mask_tmp_x = mask;
+            for(x = 0; x < copy_w && ((lv_uintptr_t)mask_tmp_x & 0x3); x++) {
+                if(*mask_tmp_x == LV_OPA_COVER) buf[x] = map[x];
+                else if(*mask_tmp_x) buf[x] = px_mix(PX_RB(map[x]), LV_COLOR_GET_G(map[x]), buf[x], *mask_tmp_x);
+                mask_tmp_x++;
+            }
+
+            for(; x <= copy_w - 4; x += 4) {
+                uint32_t mask32 = *((const uint32_t *)mask_tmp_x);
+                if(mask32 == 0xFFFFFFFF) {
+                    buf[x] = map[x];
+                    buf[x + 1] = map[x + 1];
+                    buf[x + 2] = map[x + 2];
+                    buf[x + 3] = map[x + 3];
+                }
+                else if(mask32) {
+                    int32_t i;
+                    for(i = 0; i < 4; i++) {
+                        lv_opa_t m = mask_tmp_x[i];
+                        if(m == LV_OPA_COVER) buf[x + i] = map[x + i];
+                        else if(m) buf[x + i] = px_mix(PX_RB(map[x + i]), LV_COLOR_GET_G(map[x + i]), buf[x + i], m);
+                    }
+                }
+                mask_tmp_x += 4;
+            }
+
+            for(; x < copy_w; x++) {
+                if(*mask_tmp_x == LV_OPA_COVER) buf[x] = map[x];
+                else if(*mask_tmp_x) buf[x] = px_mix(PX_RB(map[x]), LV_COLOR_GET_G(map[x]), buf[x], *mask_tmp_x);
+                mask_tmp_x++;
+            }
+
+            buf += buf_w;
+            mask += copy_w;
+            map += map_w;
+        }
+    }
+    /*Handle opa and mask values too*/
+    else {
+        for(y = 0; y < copy_h; y++) {
+            for(x = 0; x < copy_w; x++) {
+                if(mask[x]) {
+                    lv_opa_t opa_tmp = mask[x] >= LV_OPA_MAX ? opa : ((opa * mask[x]) >> 8);
+                    buf[x] = px_mix(PX_RB(map[x]), LV_COLOR_GET_G(map[x]), buf[x], opa_tmp);
+                }
+            }
+            buf += buf_w;
+            mask += copy_w;
+            map += map_w;
+        }
+    }
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * Read two pixels into one word in the order they would be read from an aligned buffer
+ * @param px pointer to the first pixel, needs to be aligned only to 2 bytes
+ * @return the two pixels
+ */
+LV_ATTRIBUTE_FAST_MEM static inline uint32_t pair_load(const lv_color_t * px)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return ((uint32_t)px[0].full << 16) | px[1].full;
+#else
+    return px[0].full | ((uint32_t)px[1].full << 16);
+#endif
+}
+
+/**
+ * Mix two pixel pairs like `lv_color_mix()`
+ * @param fg two foreground pixels as they are in the buffer
+ * @param bg two background pixels as they are in the buffer
+ * @param mix ratio of the colors, 255: full `fg`
+ * @return the mixed pixels as they should be written to the buffer
+ */
+LV_ATTRIBUTE_FAST_MEM static inline uint32_t pair_mix(uint32_t fg, uint32_t bg, uint32_t mix)
+{
+    uint32_t mix_inv = 255 - mix;
+    fg = PAIR_SWAP(fg);
+    bg = PAIR_SWAP(bg);
+
+    uint32_t r = PAIR_DIV255(PAIR_R(fg) * mix + PAIR_R(bg) * mix_inv + PAIR_ROUND);
+    uint32_t g = PAIR_DIV255(PAIR_G(fg) * mix + PAIR_G(bg) * mix_inv + PAIR_ROUND);
+    uint32_t b = PAIR_DIV255(PAIR_B(fg) * mix + PAIR_B(bg) * mix_inv + PAIR_ROUND);
+
+    return PAIR_SWAP(PAIR_RGB(r, g, b));
+}
+
+/**
+ * Mix a color to a pixel like `lv_color_mix()` but with red and blue in the two lanes of one word
+ * @param fg_rb red and blue of the foreground color, see `PX_RB`
+ * @param fg_g green of the foreground color
+ * @param bg the background pixel
+ * @param mix ratio of the colors, 255: full foreground
+ * @return the mixed color
+ */
+LV_ATTRIBUTE_FAST_MEM static inline lv_color_t px_mix(uint32_t fg_rb, uint32_t fg_g, lv_color_t bg, uint32_t mix)
+{
+    uint32_t mix_inv = 255 - mix;
+    uint32_t rb = PAIR_DIV255(fg_rb * mix + PX_RB(bg) * mix_inv + PAIR_ROUND);
+    uint32_t g = LV_MATH_UDIV255(fg_g * mix + LV_COLOR_GET_G(bg) * mix_inv + LV_COLOR_MIX_ROUND_OFS);
+
+    lv_color_t ret;
+    ret.full = PX_FULL(((rb >> 16) << 11) | (g << 5) | (rb & 0xFF));
+    return ret;
+}
+
+#endif /*LV_USE_GPU_SW_BLEND*/
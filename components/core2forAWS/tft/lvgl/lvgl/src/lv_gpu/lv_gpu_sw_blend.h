@@ -0,0 +1,108 @@
+/**
+ * @file lv_gpu_sw_blend.h
+ *
+ */
+
+#ifndef LV_GPU_SW_BLEND_H
+#define LV_GPU_SW_BLEND_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../lv_misc/lv_area.h"
+#include "../lv_misc/lv_color.h"
+
+#if LV_USE_GPU_SW_BLEND
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#if LV_COLOR_DEPTH != 16
+    #error "LV_USE_GPU_SW_BLEND requires LV_COLOR_DEPTH == 16"
+#endif
+
+#if LV_COLOR_SCREEN_TRANSP
+    #error "Can't use LV_USE_GPU_SW_BLEND with LV_COLOR_SCREEN_TRANSP"
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Blend a color with opacity to an area of the buffer.
+ * Two pixels are mixed with one 32 bit operation; the result is the same as `lv_color_mix()` gives.
+ * @param buf a buffer which should be filled
+ * @param buf_w width of the buffer in pixels
+ * @param color fill color
+ * @param opa opacity of `color`
+ * @param fill_w width to fill in pixels (<= buf_w)
+ * @param fill_h height to fill in pixels
+ * @note `buf_w - fill_w` is offset to the next line after fill
+ */
+void lv_gpu_sw_blend_fill(lv_color_t * buf, lv_coord_t buf_w, lv_color_t color, lv_opa_t opa, lv_coord_t fill_w,
+                          lv_coord_t fill_h);
+
+/**
+ * Fill an area in the buffer with a color but take into account a mask which describes the opacity of each pixel
+ * @param buf a buffer which should be filled using a mask
+ * @param buf_w width of the buffer in pixels
+ * @param color fill color
+ * @param mask 0..255 values describing the opacity of the corresponding pixel. It's width is `fill_w`
+ * @param opa overall opacity. 255 in `mask` should mean this opacity.
+ * @param fill_w width to fill in pixels (<= buf_w)
+ * @param fill_h height to fill in pixels
+ * @note `buf_w - fill_w` is offset to the next line after fill
+ */
+void lv_gpu_sw_blend_fill_mask(lv_color_t * buf, lv_coord_t buf_w, lv_color_t color, const lv_opa_t * mask,
+                               lv_opa_t opa, lv_coord_t fill_w, lv_coord_t fill_h);
+
+/**
+ * Blend a map (e.g. RGB image with opacity) to a buffer.
+ * Two pixels are mixed with one 32 bit operation; the result is the same as `lv_color_mix()` gives.
+ * @param buf a buffer where `map` should be blended
+ * @param buf_w width of the buffer in pixels
+ * @param map an "image" to blend
+ * @param opa opacity of `map`
+ * @param map_w width of the map in pixels
+ * @param copy_w width of the area to blend in pixels (<= buf_w)
+ * @param copy_h height of the area to blend in pixels
+ * @note `map_w - copy_w` is offset to the next line after blend
+ */
+void lv_gpu_sw_blend_map(lv_color_t * buf, lv_coord_t buf_w, const lv_color_t * map, lv_opa_t opa,
+                         lv_coord_t map_w, lv_coord_t copy_w, lv_coord_t copy_h);
+
+/**
+ * Blend a map to a buffer but take into account a mask which describes the opacity of each pixel
+ * @param buf a buffer where `map` should be blended
+ * @param buf_w width of the buffer in pixels
+ * @param map an "image" to blend
+ * @param map_w width of the map in pixels
+ * @param mask 0..255 values describing the opacity of the corresponding pixel. It's width is `copy_w`
+ * @param opa overall opacity. 255 in `mask` should mean this opacity.
+ * @param copy_w width of the area to blend in pixels (<= buf_w)
+ * @param copy_h height of the area to blend in pixels
+ */
+void lv_gpu_sw_blend_map_mask(lv_color_t * buf, lv_coord_t buf_w, const lv_color_t * map, lv_coord_t map_w,
+                              const lv_opa_t * mask, lv_opa_t opa, lv_coord_t copy_w, lv_coord_t copy_h);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#endif /*LV_USE_GPU_SW_BLEND*/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LV_GPU_SW_BLEND_H*/
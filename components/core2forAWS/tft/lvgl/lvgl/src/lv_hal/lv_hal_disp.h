@@ -30,6 +30,13 @@ extern "C" {
 #define LV_INV_BUF_SIZE 32 /*Buffer size for invalid areas */
 #endif
 
+#ifndef LV_INV_JOIN_EXTRA_PX
+/*Join two invalid areas even if the joined area has up to this many more pixels than the two
+ *together. Redrawing a few extra pixels is often cheaper than a separate area (object tree walk
+ *and flush). 0: join only overlapping or touching areas which get smaller by joining*/
+#define LV_INV_JOIN_EXTRA_PX 0
+#endif
+
 #ifndef LV_ATTRIBUTE_FLUSH_READY
 #define LV_ATTRIBUTE_FLUSH_READY
 #endif
@@ -120,6 +127,10 @@ typedef struct _disp_drv_t {
      * User can execute very simple tasks here or yield the task */
     void (*wait_cb)(struct _disp_drv_t * disp_drv);
 
+    /** OPTIONAL: Called when an area gets invalidated on a display with nothing to redraw yet.
+     * E.g. wake up a task that calls `lv_task_handler` only when needed*/
+    void (*invalidate_cb)(struct _disp_drv_t * disp_drv);
+
     /** OPTIONAL: Called when lvgl needs any CPU cache that affects rendering to be cleaned */
     void (*clean_dcache_cb)(struct _disp_drv_t * disp_drv);
 
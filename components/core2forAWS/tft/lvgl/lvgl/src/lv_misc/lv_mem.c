@@ -8,6 +8,7 @@
  *      INCLUDES
  *********************/
 #include "lv_mem.h"
+#include "lv_tlsf.h"
 #include "lv_math.h"
 #include "lv_gc.h"
 #include "lv_debug.h"
@@ -29,6 +30,13 @@
     #define LV_MEM_FULL_DEFRAG_CNT 16
 #endif
 
+/*The built-in work memory is managed by `lv_tlsf` instead of the first fit entry list*/
+#if LV_MEM_CUSTOM == 0 && LV_MEM_TLSF
+    #define MEM_TLSF 1
+#else
+    #define MEM_TLSF 0
+#endif
+
 #ifdef LV_ARCH_64
     #define MEM_UNIT uint64_t
 #else
@@ -68,7 +76,7 @@ typedef struct {
 /**********************
  *  STATIC PROTOTYPES
  **********************/
-#if LV_MEM_CUSTOM == 0
+#if LV_MEM_CUSTOM == 0 && MEM_TLSF == 0
     static lv_mem_ent_t * ent_get_next(lv_mem_ent_t * act_e);
     static void * ent_alloc(lv_mem_ent_t * e, size_t size);
     static void ent_trunc(lv_mem_ent_t * e, size_t size);
@@ -83,7 +91,9 @@ typedef struct {
 
 static uint32_t zero_mem; /*Give the address of this variable if 0 byte should be allocated*/
 
-#if LV_MEM_CUSTOM == 0
+#if MEM_TLSF
+    static lv_tlsf_t tlsf;
+#elif LV_MEM_CUSTOM == 0
     static uint32_t mem_max_size; /*Tracks the maximum total size of memory ever used from the internal heap*/
 #endif
 
@@ -123,11 +133,15 @@ void _lv_mem_init(void)
     work_mem = (uint8_t *)LV_MEM_ADR;
 #endif
 
+#if MEM_TLSF
+    _lv_tlsf_init(&tlsf, work_mem, LV_MEM_SIZE);
+#else
     lv_mem_ent_t * full = (lv_mem_ent_t *)work_mem;
     full->header.s.used = 0;
     /*The total mem size reduced by the first header and the close patterns */
     full->header.s.d_size = LV_MEM_SIZE - sizeof(lv_mem_header_t);
 #endif
+#endif
 }
 
 /**
@@ -136,7 +150,9 @@ void _lv_mem_init(void)
  */
 void _lv_mem_deinit(void)
 {
-#if LV_MEM_CUSTOM == 0
+#if MEM_TLSF
+    _lv_tlsf_init(&tlsf, work_mem, LV_MEM_SIZE);
+#elif LV_MEM_CUSTOM == 0
     lv_mem_ent_t * full = (lv_mem_ent_t *)work_mem;
     full->header.s.used = 0;
     /*The total mem size reduced by the first header and the close patterns */
@@ -159,7 +175,11 @@ void * lv_mem_alloc(size_t size)
     size = (size + ALIGN_MASK) & (~ALIGN_MASK);
     void * alloc = NULL;
 
-#if LV_MEM_CUSTOM == 0
+#if MEM_TLSF
+    /*Find a large enough free block in O(1)*/
+    alloc = _lv_tlsf_alloc(&tlsf, size);
+
+#elif LV_MEM_CUSTOM == 0
     /*Use the built-in allocators*/
     lv_mem_ent_t * e = NULL;
 
@@ -199,7 +219,7 @@ void * lv_mem_alloc(size_t size)
         LV_LOG_WARN("Couldn't allocate memory");
     }
     else {
-#if LV_MEM_CUSTOM == 0
+#if LV_MEM_CUSTOM == 0 && MEM_TLSF == 0
         /* just a safety check, should always be true */
         if((uintptr_t) alloc > (uintptr_t) work_mem) {
             if((((uintptr_t) alloc - (uintptr_t) work_mem) + size) > mem_max_size) {
@@ -225,6 +245,10 @@ void lv_mem_free(const void * data)
     _lv_memset((void *)data, 0xbb, _lv_mem_get_size(data));
 #endif
 
+#if MEM_TLSF
+    /*The adjacent free blocks are joined right away*/
+    _lv_tlsf_free(&tlsf, data);
+#else
 #if LV_ENABLE_GC == 0
     /*e points to the header*/
     lv_mem_ent_t * e = (lv_mem_ent_t *)((uint8_t *)data - sizeof(lv_mem_header_t));
@@ -263,6 +287,7 @@ void lv_mem_free(const void * data)
     LV_MEM_CUSTOM_FREE((void *)data);
 #endif /*LV_ENABLE_GC*/
 #endif
+#endif /*MEM_TLSF*/
 }
 
 /**
@@ -280,6 +305,16 @@ void * lv_mem_realloc(void * data_p, size_t new_size)
     /*Round the size up to ALIGN_MASK*/
     new_size = (new_size + ALIGN_MASK) & (~ALIGN_MASK);
 
+#if MEM_TLSF
+    if(data_p == &zero_mem) data_p = NULL;
+
+    /*Shrink or grow in place if possible*/
+    if(data_p != NULL && new_size != 0) {
+        void * new_p = _lv_tlsf_realloc(&tlsf, data_p, new_size);
+        if(new_p == NULL) LV_LOG_WARN("Couldn't allocate memory");
+        return new_p;
+    }
+#else
     /*data_p could be previously freed pointer (in this case it is invalid)*/
     if(data_p != NULL) {
         lv_mem_ent_t * e = (lv_mem_ent_t *)((uint8_t *)data_p - sizeof(lv_mem_header_t));
@@ -287,11 +322,12 @@ void * lv_mem_realloc(void * data_p, size_t new_size)
             data_p = NULL;
         }
     }
+#endif
 
     uint32_t old_size = _lv_mem_get_size(data_p);
     if(old_size == new_size) return data_p; /*Also avoid reallocating the same memory*/
 
-#if LV_MEM_CUSTOM == 0
+#if LV_MEM_CUSTOM == 0 && MEM_TLSF == 0
     /* Truncate the memory if the new size is smaller. */
     if(new_size < old_size) {
         lv_mem_ent_t * e = (lv_mem_ent_t *)((uint8_t *)data_p - sizeof(lv_mem_header_t));
@@ -331,10 +367,11 @@ void * lv_mem_realloc(void * data_p, size_t new_size)
 
 /**
  * Join the adjacent free memory blocks
+ * @note With `LV_MEM_TLSF` the free blocks are always joined, there is nothing to do
  */
 void lv_mem_defrag(void)
 {
-#if LV_MEM_CUSTOM == 0
+#if LV_MEM_CUSTOM == 0 && MEM_TLSF == 0
     lv_mem_ent_t * e_free;
     lv_mem_ent_t * e_next;
     e_free = ent_get_next(NULL);
@@ -375,7 +412,9 @@ void lv_mem_defrag(void)
 
 lv_res_t lv_mem_test(void)
 {
-#if LV_MEM_CUSTOM == 0
+#if MEM_TLSF
+    return _lv_tlsf_check(&tlsf);
+#elif LV_MEM_CUSTOM == 0
     lv_mem_ent_t * e;
     e = ent_get_next(NULL);
     while(e) {
@@ -402,6 +441,10 @@ void lv_mem_monitor(lv_mem_monitor_t * mon_p)
     /*Init the data*/
     _lv_memset(mon_p, 0, sizeof(lv_mem_monitor_t));
 #if LV_MEM_CUSTOM == 0
+#if MEM_TLSF
+    /*The free blocks are counted on the fly*/
+    _lv_tlsf_monitor(&tlsf, mon_p);
+#else
     lv_mem_ent_t * e;
 
     e = ent_get_next(NULL);
@@ -420,8 +463,9 @@ void lv_mem_monitor(lv_mem_monitor_t * mon_p)
 
         e = ent_get_next(e);
     }
-    mon_p->total_size = LV_MEM_SIZE;
     mon_p->max_used = mem_max_size;
+#endif
+    mon_p->total_size = LV_MEM_SIZE;
     mon_p->used_pct = 100 - (100U * mon_p->free_size) / mon_p->total_size;
     if(mon_p->free_size > 0) {
         mon_p->frag_pct = mon_p->free_biggest_size * 100U / mon_p->free_size;
@@ -446,9 +490,13 @@ uint32_t _lv_mem_get_size(const void * data)
     if(data == NULL) return 0;
     if(data == &zero_mem) return 0;
 
+#if MEM_TLSF
+    return _lv_tlsf_get_size(data);
+#else
     lv_mem_ent_t * e = (lv_mem_ent_t *)((uint8_t *)data - sizeof(lv_mem_header_t));
 
     return e->header.s.d_size;
+#endif
 }
 
 #else /* LV_ENABLE_GC */
@@ -757,7 +805,7 @@ LV_ATTRIBUTE_FAST_MEM void _lv_memset_ff(void * dst, size_t len)
  *   STATIC FUNCTIONS
  **********************/
 
-#if LV_MEM_CUSTOM == 0
+#if LV_MEM_CUSTOM == 0 && MEM_TLSF == 0
 /**
  * Give the next entry after 'act_e'
  * @param act_e pointer to an entry
@@ -4,6 +4,7 @@ CSRCS += lv_fs.c
 CSRCS += lv_anim.c
 CSRCS += lv_mem.c
 CSRCS += lv_ll.c
+CSRCS += lv_tlsf.c
 CSRCS += lv_color.c
 CSRCS += lv_txt.c
 CSRCS += lv_txt_ap.c
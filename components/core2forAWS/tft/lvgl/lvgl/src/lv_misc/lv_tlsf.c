@@ -0,0 +1,584 @@
+/**
+ * @file lv_tlsf.c
+ * Two-level segregated fit (TLSF) allocator on a memory pool.
+ * Every block has a size word in front of its data. Free blocks are also linked
+ * into the list of their size class and are joined with their free neighbours
+ * on free, so there is nothing to defragment later.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_tlsf.h"
+#include "lv_log.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define BLOCK_FREE          ((size_t)1)     /*The block is free*/
+#define BLOCK_PREV_FREE     ((size_t)2)     /*The previous block in memory is free*/
+#define BLOCK_FLAGS         (BLOCK_FREE | BLOCK_PREV_FREE)
+
+#define ALIGN_SIZE          ((size_t)1 << LV_TLSF_ALIGN_LOG2)
+#define ALIGN_MASK          (ALIGN_SIZE - 1)
+
+/*Only the size word is in front of the data of a used block.
+ *`prev_phys` is stored in the last word of the previous block, it's used only if that block is free.*/
+#define BLOCK_OVERHEAD      sizeof(size_t)
+#define BLOCK_DATA_OFS      (offsetof(lv_tlsf_block_t, size) + sizeof(size_t))
+
+/*A free block keeps its list links and the next block's `prev_phys` in its data*/
+#define BLOCK_SIZE_MIN      (sizeof(lv_tlsf_block_t) - sizeof(lv_tlsf_block_t *))
+
+#define SMALL_BLOCK_SIZE    ((size_t)1 << LV_TLSF_FL_SHIFT)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct _lv_tlsf_block_t {
+    struct _lv_tlsf_block_t * prev_phys;    /*Previous block in memory, valid only if it's free*/
+    size_t size;                            /*Size of the data | `BLOCK_...` flags*/
+    struct _lv_tlsf_block_t * next_free;    /*Links in the free list, valid only if the block is free*/
+    struct _lv_tlsf_block_t * prev_free;
+} lv_tlsf_block_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static size_t block_size(const lv_tlsf_block_t * block);
+static void block_set_size(lv_tlsf_block_t * block, size_t size);
+static lv_tlsf_block_t * block_from_ptr(const void * data);
+static void * block_to_ptr(const lv_tlsf_block_t * block);
+static lv_tlsf_block_t * block_next(const lv_tlsf_block_t * block);
+static lv_tlsf_block_t * block_link_next(lv_tlsf_block_t * block);
+static void block_mark_free(lv_tlsf_block_t * block);
+static void block_mark_used(lv_tlsf_block_t * block);
+static bool block_can_split(const lv_tlsf_block_t * block, size_t size);
+static lv_tlsf_block_t * block_split(lv_tlsf_block_t * block, size_t size);
+static lv_tlsf_block_t * block_merge_prev(lv_tlsf_t * tlsf, lv_tlsf_block_t * block);
+static lv_tlsf_block_t * block_merge_next(lv_tlsf_t * tlsf, lv_tlsf_block_t * block);
+static void free_list_insert(lv_tlsf_t * tlsf, lv_tlsf_block_t * block);
+static void free_list_remove(lv_tlsf_t * tlsf, lv_tlsf_block_t * block);
+static lv_tlsf_block_t * free_list_search(lv_tlsf_t * tlsf, size_t size);
+static size_t adjust_size(size_t size);
+static void mapping_insert(size_t size, uint32_t * fl, uint32_t * sl);
+static void mapping_search(size_t size, uint32_t * fl, uint32_t * sl);
+static void update_max_used(lv_tlsf_t * tlsf);
+static uint32_t bit_first(uint32_t x);
+static uint32_t bit_last(uint32_t x);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+/**
+ * Initialize a TLSF pool
+ * @param tlsf pointer to the pool's descriptor
+ * @param mem the memory to manage, aligned to pointer size
+ * @param size size of `mem` in bytes, at most 2^LV_TLSF_FL_MAX
+ */
+void _lv_tlsf_init(lv_tlsf_t * tlsf, void * mem, uint32_t size)
+{
+    _lv_memset_00(tlsf, sizeof(lv_tlsf_t));
+
+    lv_uintptr_t start = ((lv_uintptr_t)mem + ALIGN_MASK) & ~(lv_uintptr_t)ALIGN_MASK;
+    size_t start_ofs = start - (lv_uintptr_t)mem;
+
+    /*The first block's header, a block and the size word of the closing block*/
+    if(size < start_ofs + 3 * BLOCK_OVERHEAD + BLOCK_SIZE_MIN) {
+        LV_LOG_WARN("lv_tlsf_init: the memory is too small");
+        return;
+    }
+
+    size_t pool_size = (size - start_ofs) & ~ALIGN_MASK;
+    if(pool_size > ((size_t)1 << LV_TLSF_FL_MAX)) pool_size = (size_t)1 << LV_TLSF_FL_MAX;
+
+    /*One free block covers the pool. It's closed by a used 0 size block, so it's never merged further.*/
+    lv_tlsf_block_t * first = (lv_tlsf_block_t *)start;
+    first->prev_phys = NULL;
+    first->size = pool_size - 3 * BLOCK_OVERHEAD;
+    block_mark_free(first);
+
+    lv_tlsf_block_t * last = block_next(first);
+    last->size = BLOCK_PREV_FREE;
+
+    tlsf->first = first;
+    tlsf->pool_size = (uint32_t)pool_size;
+    free_list_insert(tlsf, first);
+    update_max_used(tlsf);
+}
+
+/**
+ * Allocate from a TLSF pool
+ * @param tlsf pointer to an initialized pool
+ * @param size size of the memory to allocate in bytes
+ * @return pointer to the allocated memory or NULL if there is no large enough free block
+ */
+void * _lv_tlsf_alloc(lv_tlsf_t * tlsf, size_t size)
+{
+    if(size == 0 || size > tlsf->pool_size) return NULL;
+
+    size = adjust_size(size);
+    lv_tlsf_block_t * block = free_list_search(tlsf, size);
+    if(block == NULL) return NULL;
+
+    free_list_remove(tlsf, block);
+
+    /*Give back the end of the block if it's large enough for an other block*/
+    if(block_can_split(block, size)) {
+        lv_tlsf_block_t * rest = block_split(block, size);
+        free_list_insert(tlsf, rest);
+    }
+
+    block_mark_used(block);
+    tlsf->used_cnt++;
+    update_max_used(tlsf);
+
+    return block_to_ptr(block);
+}
+
+/**
+ * Free a memory allocated from a TLSF pool.
+ * It is joined with the adjacent free blocks.
+ * @param tlsf pointer to the pool
+ * @param data pointer to an allocated memory
+ */
+void _lv_tlsf_free(lv_tlsf_t * tlsf, const void * data)
+{
+    lv_tlsf_block_t * block = block_from_ptr(data);
+    if(block->size & BLOCK_FREE) {
+        LV_LOG_ERROR("lv_tlsf_free: the memory is already free");
+        return;
+    }
+
+    tlsf->used_cnt--;
+    block_mark_free(block);
+    block = block_merge_prev(tlsf, block);
+    block = block_merge_next(tlsf, block);
+    free_list_insert(tlsf, block);
+}
+
+/**
+ * Resize an allocated memory, in place if it's shrunk or the next block is free.
+ * The old content will be kept.
+ * @param tlsf pointer to the pool
+ * @param data pointer to an allocated memory
+ * @param new_size the desired new size in bytes, not 0
+ * @return pointer to the resized memory or NULL if there is no large enough free block.
+ *         `data` is not freed in this case.
+ */
+void * _lv_tlsf_realloc(lv_tlsf_t * tlsf, void * data, size_t new_size)
+{
+    if(new_size == 0 || new_size > tlsf->pool_size) return NULL;
+
+    lv_tlsf_block_t * block = block_from_ptr(data);
+    lv_tlsf_block_t * next = block_next(block);
+    size_t cur_size = block_size(block);
+    size_t size = adjust_size(new_size);
+
+    if(size > cur_size) {
+        /*Grow into the next block if it's free and large enough, else move*/
+        size_t joint_size = cur_size + block_size(next) + BLOCK_OVERHEAD;
+        if((next->size & BLOCK_FREE) == 0 || size > joint_size) {
+            void * new_p = _lv_tlsf_alloc(tlsf, size);
+            if(new_p == NULL) return NULL;
+
+            _lv_memcpy(new_p, data, cur_size);
+            _lv_tlsf_free(tlsf, data);
+            return new_p;
+        }
+
+        free_list_remove(tlsf, next);
+        block_set_size(block, joint_size);
+        block_mark_used(block);
+    }
+
+    /*Give back the unused end*/
+    if(block_can_split(block, size)) {
+        lv_tlsf_block_t * rest = block_split(block, size);
+        rest = block_merge_next(tlsf, rest);
+        free_list_insert(tlsf, rest);
+    }
+
+    update_max_used(tlsf);
+
+    return data;
+}
+
+/**
+ * Give the size of an allocated memory
+ * @param data pointer to an allocated memory
+ * @return usable size of the memory in bytes, at least the requested size
+ */
+uint32_t _lv_tlsf_get_size(const void * data)
+{
+    return (uint32_t)block_size(block_from_ptr(data));
+}
+
+/**
+ * Give information about the blocks of a pool.
+ * Only the counters of the blocks are filled, the other fields are not changed.
+ * @param tlsf pointer to the pool
+ * @param mon_p the counters will be stored here
+ */
+void _lv_tlsf_monitor(const lv_tlsf_t * tlsf, lv_mem_monitor_t * mon_p)
+{
+    mon_p->free_cnt = tlsf->free_cnt;
+    mon_p->free_size = tlsf->free_size;
+    mon_p->used_cnt = tlsf->used_cnt;
+    mon_p->max_used = tlsf->max_used;
+    mon_p->free_biggest_size = 0;
+
+    /*The biggest free block is in the last non-empty list*/
+    if(tlsf->fl_bitmap == 0) return;
+
+    uint32_t fl = bit_last(tlsf->fl_bitmap);
+    uint32_t sl = bit_last(tlsf->sl_bitmap[fl]);
+    const lv_tlsf_block_t * block;
+    for(block = tlsf->blocks[fl][sl]; block != NULL; block = block->next_free) {
+        if(block_size(block) > mon_p->free_biggest_size) mon_p->free_biggest_size = (uint32_t)block_size(block);
+    }
+}
+
+/**
+ * Check the integrity of a pool: block chain, free lists and counters
+ * @param tlsf pointer to the pool
+ * @return LV_RES_OK: the pool is consistent; LV_RES_INV: it is corrupted
+ */
+lv_res_t _lv_tlsf_check(const lv_tlsf_t * tlsf)
+{
+    if(tlsf->first == NULL) return LV_RES_OK;
+
+    const uint8_t * pool_end = (const uint8_t *)tlsf->first + tlsf->pool_size;
+    uint32_t free_cnt = 0;
+    uint32_t used_cnt = 0;
+    size_t free_size = 0;
+    bool prev_free = false;
+
+    /*Walk the blocks in memory up to the closing 0 size block*/
+    const lv_tlsf_block_t * block = tlsf->first;
+    while(block_size(block) != 0) {
+        size_t size = block_size(block);
+        bool is_free = (block->size & BLOCK_FREE) != 0;
+        if(((block->size & BLOCK_PREV_FREE) != 0) != prev_free) return LV_RES_INV;
+        if(size < BLOCK_SIZE_MIN || (size & ALIGN_MASK)) return LV_RES_INV;
+
+        const lv_tlsf_block_t * next = block_next(block);
+        if((const uint8_t *)next + BLOCK_DATA_OFS > pool_end) return LV_RES_INV;
+
+        if(is_free) {
+            /*Adjacent free blocks are always joined*/
+            if(prev_free || next->prev_phys != block) return LV_RES_INV;
+            free_cnt++;
+            free_size += size;
+        }
+        else {
+            used_cnt++;
+        }
+
+        prev_free = is_free;
+        block = next;
+    }
+
+    if((const uint8_t *)block + BLOCK_DATA_OFS != pool_end) return LV_RES_INV;
+    if((block->size & BLOCK_FREE) || ((block->size & BLOCK_PREV_FREE) != 0) != prev_free) return LV_RES_INV;
+
+    /*Every listed block is free, in the list of its size and the bitmaps show the non-empty lists*/
+    uint32_t listed_cnt = 0;
+    uint32_t fl;
+    uint32_t sl;
+    for(fl = 0; fl < LV_TLSF_FL_CNT; fl++) {
+        if(((tlsf->fl_bitmap >> fl) & 1U) != (tlsf->sl_bitmap[fl] != 0)) return LV_RES_INV;
+        for(sl = 0; sl < LV_TLSF_SL_CNT; sl++) {
+            const lv_tlsf_block_t * head = tlsf->blocks[fl][sl];
+            if(((tlsf->sl_bitmap[fl] >> sl) & 1U) != (head != NULL)) return LV_RES_INV;
+
+            const lv_tlsf_block_t * prev = NULL;
+            for(block = head; block != NULL; block = block->next_free) {
+                uint32_t block_fl;
+                uint32_t block_sl;
+                mapping_insert(block_size(block), &block_fl, &block_sl);
+                if((block->size & BLOCK_FREE) == 0 || block->prev_free != prev) return LV_RES_INV;
+                if(block_fl != fl || block_sl != sl) return LV_RES_INV;
+                if(++listed_cnt > free_cnt) return LV_RES_INV;
+                prev = block;
+            }
+        }
+    }
+
+    if(listed_cnt != free_cnt || free_cnt != tlsf->free_cnt || free_size != tlsf->free_size ||
+       used_cnt != tlsf->used_cnt) {
+        return LV_RES_INV;
+    }
+
+    return LV_RES_OK;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static size_t block_size(const lv_tlsf_block_t * block)
+{
+    return block->size & ~BLOCK_FLAGS;
+}
+
+static void block_set_size(lv_tlsf_block_t * block, size_t size)
+{
+    block->size = size | (block->size & BLOCK_FLAGS);
+}
+
+static lv_tlsf_block_t * block_from_ptr(const void * data)
+{
+    return (lv_tlsf_block_t *)((uint8_t *)data - BLOCK_DATA_OFS);
+}
+
+static void * block_to_ptr(const lv_tlsf_block_t * block)
+{
+    return (uint8_t *)block + BLOCK_DATA_OFS;
+}
+
+/**
+ * Get the next block in memory
+ * @param block pointer to a block, not the closing one
+ * @return the next block, its `prev_phys` is in the last word of `block`
+ */
+static lv_tlsf_block_t * block_next(const lv_tlsf_block_t * block)
+{
+    return (lv_tlsf_block_t *)((uint8_t *)block_to_ptr(block) + block_size(block) - BLOCK_OVERHEAD);
+}
+
+static lv_tlsf_block_t * block_link_next(lv_tlsf_block_t * block)
+{
+    lv_tlsf_block_t * next = block_next(block);
+    next->prev_phys = block;
+    return next;
+}
+
+static void block_mark_free(lv_tlsf_block_t * block)
+{
+    lv_tlsf_block_t * next = block_link_next(block);
+    next->size |= BLOCK_PREV_FREE;
+    block->size |= BLOCK_FREE;
+}
+
+static void block_mark_used(lv_tlsf_block_t * block)
+{
+    lv_tlsf_block_t * next = block_next(block);
+    next->size &= ~BLOCK_PREV_FREE;
+    block->size &= ~BLOCK_FREE;
+}
+
+static bool block_can_split(const lv_tlsf_block_t * block, size_t size)
+{
+    return block_size(block) >= sizeof(lv_tlsf_block_t) + size;
+}
+
+/**
+ * Cut a block to `size` and make a free block from the rest.
+ * The rest is not added to the free lists.
+ * @param block pointer to a block, it will be used
+ * @param size the new size of `block`
+ * @return the rest
+ */
+static lv_tlsf_block_t * block_split(lv_tlsf_block_t * block, size_t size)
+{
+    lv_tlsf_block_t * rest = (lv_tlsf_block_t *)((uint8_t *)block_to_ptr(block) + size - BLOCK_OVERHEAD);
+    rest->size = block_size(block) - (size + BLOCK_OVERHEAD);
+    block_set_size(block, size);
+    block_mark_free(rest);
+
+    return rest;
+}
+
+/**
+ * Join a free block with the previous block if that's free too
+ * @param tlsf pointer to the pool
+ * @param block pointer to a free block, not in the free lists
+ * @return the joint block
+ */
+static lv_tlsf_block_t * block_merge_prev(lv_tlsf_t * tlsf, lv_tlsf_block_t * block)
+{
+    if((block->size & BLOCK_PREV_FREE) == 0) return block;
+
+    lv_tlsf_block_t * prev = block->prev_phys;
+    free_list_remove(tlsf, prev);
+    block_set_size(prev, block_size(prev) + block_size(block) + BLOCK_OVERHEAD);
+    block_link_next(prev);
+
+    return prev;
+}
+
+/**
+ * Join a free block with the next block if that's free too
+ * @param tlsf pointer to the pool
+ * @param block pointer to a free block, not in the free lists
+ * @return the joint block
+ */
+static lv_tlsf_block_t * block_merge_next(lv_tlsf_t * tlsf, lv_tlsf_block_t * block)
+{
+    lv_tlsf_block_t * next = block_next(block);
+    if((next->size & BLOCK_FREE) == 0) return block;
+
+    free_list_remove(tlsf, next);
+    block_set_size(block, block_size(block) + block_size(next) + BLOCK_OVERHEAD);
+    block_link_next(block);
+
+    return block;
+}
+
+static void free_list_insert(lv_tlsf_t * tlsf, lv_tlsf_block_t * block)
+{
+    uint32_t fl;
+    uint32_t sl;
+    mapping_insert(block_size(block), &fl, &sl);
+
+    lv_tlsf_block_t * head = tlsf->blocks[fl][sl];
+    block->prev_free = NULL;
+    block->next_free = head;
+    if(head) head->prev_free = block;
+
+    tlsf->blocks[fl][sl] = block;
+    tlsf->fl_bitmap |= 1U << fl;
+    tlsf->sl_bitmap[fl] |= 1U << sl;
+
+    tlsf->free_cnt++;
+    tlsf->free_size += (uint32_t)block_size(block);
+}
+
+static void free_list_remove(lv_tlsf_t * tlsf, lv_tlsf_block_t * block)
+{
+    uint32_t fl;
+    uint32_t sl;
+    mapping_insert(block_size(block), &fl, &sl);
+
+    if(block->next_free) block->next_free->prev_free = block->prev_free;
+
+    if(block->prev_free) {
+        block->prev_free->next_free = block->next_free;
+    }
+    else {
+        tlsf->blocks[fl][sl] = block->next_free;
+        if(block->next_free == NULL) {
+            tlsf->sl_bitmap[fl] &= ~(1U << sl);
+            if(tlsf->sl_bitmap[fl] == 0) tlsf->fl_bitmap &= ~(1U << fl);
+        }
+    }
+
+    tlsf->free_cnt--;
+    tlsf->free_size -= (uint32_t)block_size(block);
+}
+
+/**
+ * Find a free block of at least `size` bytes with two bitmap lookups.
+ * The size is rounded up to the next list, so any block of the found list is large enough.
+ * @param tlsf pointer to the pool
+ * @param size an adjusted size
+ * @return a free block in the free lists or NULL if there is no large enough free block
+ */
+static lv_tlsf_block_t * free_list_search(lv_tlsf_t * tlsf, size_t size)
+{
+    uint32_t fl;
+    uint32_t sl;
+    mapping_search(size, &fl, &sl);
+    if(fl >= LV_TLSF_FL_CNT) return NULL;
+
+    /*A list of the same power of 2 range or a list of a larger range*/
+    uint32_t sl_map = tlsf->sl_bitmap[fl] & (~0U << sl);
+    if(sl_map == 0) {
+        uint32_t fl_map = tlsf->fl_bitmap & (~0U << (fl + 1));
+        if(fl_map == 0) return NULL;
+
+        fl = bit_first(fl_map);
+        sl_map = tlsf->sl_bitmap[fl];
+    }
+
+    sl = bit_first(sl_map);
+    return tlsf->blocks[fl][sl];
+}
+
+static size_t adjust_size(size_t size)
+{
+    size = (size + ALIGN_MASK) & ~ALIGN_MASK;
+    if(size < BLOCK_SIZE_MIN) size = BLOCK_SIZE_MIN;
+    return size;
+}
+
+/**
+ * Get the list of a size
+ * @param size a block size
+ * @param fl the first level index will be stored here: the power of 2 range of `size`
+ * @param sl the second level index will be stored here: the linear part of the range
+ */
+static void mapping_insert(size_t size, uint32_t * fl, uint32_t * sl)
+{
+    if(size < SMALL_BLOCK_SIZE) {
+        /*Small blocks are in linear lists of `ALIGN_SIZE` steps*/
+        *fl = 0;
+        *sl = (uint32_t)(size / (SMALL_BLOCK_SIZE / LV_TLSF_SL_CNT));
+    }
+    else {
+        uint32_t msb = bit_last((uint32_t)size);
+        *sl = (uint32_t)(size >> (msb - LV_TLSF_SL_LOG2)) ^ (1U << LV_TLSF_SL_LOG2);
+        *fl = msb - (LV_TLSF_FL_SHIFT - 1);
+    }
+}
+
+/**
+ * Get the first list whose every block is at least `size` bytes
+ */
+static void mapping_search(size_t size, uint32_t * fl, uint32_t * sl)
+{
+    if(size >= SMALL_BLOCK_SIZE) {
+        size += ((size_t)1 << (bit_last((uint32_t)size) - LV_TLSF_SL_LOG2)) - 1;
+    }
+
+    mapping_insert(size, fl, sl);
+}
+
+static void update_max_used(lv_tlsf_t * tlsf)
+{
+    uint32_t used = tlsf->pool_size - tlsf->free_size;
+    if(used > tlsf->max_used) tlsf->max_used = used;
+}
+
+/**
+ * Index of the lowest set bit
+ * @param x a value, not 0
+ */
+static uint32_t bit_first(uint32_t x)
+{
+#if defined(__GNUC__)
+    return (uint32_t)__builtin_ctz(x);
+#else
+    uint32_t i = 0;
+    while((x & 1U) == 0) {
+        x >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+/**
+ * Index of the highest set bit
+ * @param x a value, not 0
+ */
+static uint32_t bit_last(uint32_t x)
+{
+#if defined(__GNUC__)
+    return 31 - (uint32_t)__builtin_clz(x);
+#else
+    uint32_t i = 0;
+    while(x >>= 1) i++;
+    return i;
+#endif
+}
@@ -0,0 +1,131 @@
+/**
+ * @file lv_tlsf.h
+ * Two-level segregated fit (TLSF) allocator on a memory pool.
+ * Allocation and free are O(1): free blocks are kept in lists by size class
+ * and the first non-empty list is found with two bitmap lookups.
+ */
+
+#ifndef LV_TLSF_H
+#define LV_TLSF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_mem.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+/*Every power of 2 size range (first level) is split into 2^LV_TLSF_SL_LOG2 lists (second level)*/
+#define LV_TLSF_SL_LOG2     4
+#define LV_TLSF_SL_CNT      (1 << LV_TLSF_SL_LOG2)
+
+/*Blocks are smaller than 2^LV_TLSF_FL_MAX bytes, i.e. a pool is at most 16 MB*/
+#define LV_TLSF_FL_MAX      24
+
+#ifdef LV_ARCH_64
+    #define LV_TLSF_ALIGN_LOG2  3
+#else
+    #define LV_TLSF_ALIGN_LOG2  2
+#endif
+
+/*Blocks smaller than 2^LV_TLSF_FL_SHIFT are all in the first first-level list*/
+#define LV_TLSF_FL_SHIFT    (LV_TLSF_SL_LOG2 + LV_TLSF_ALIGN_LOG2)
+#define LV_TLSF_FL_CNT      (LV_TLSF_FL_MAX - LV_TLSF_FL_SHIFT + 1)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+struct _lv_tlsf_block_t;
+
+/** Description of a TLSF pool*/
+typedef struct {
+    uint32_t fl_bitmap;                 /**< Bit `fl` is set if `sl_bitmap[fl]` is not 0*/
+    uint32_t sl_bitmap[LV_TLSF_FL_CNT]; /**< Bit `sl` is set if `blocks[fl][sl]` is not empty*/
+    struct _lv_tlsf_block_t * blocks[LV_TLSF_FL_CNT][LV_TLSF_SL_CNT]; /**< Heads of the free lists*/
+    struct _lv_tlsf_block_t * first;    /**< First block of the pool*/
+    uint32_t pool_size;
+    uint32_t free_size;                 /**< Data bytes in free blocks*/
+    uint32_t free_cnt;
+    uint32_t used_cnt;
+    uint32_t max_used;                  /**< The most bytes ever used, headers included*/
+} lv_tlsf_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Initialize a TLSF pool
+ * @param tlsf pointer to the pool's descriptor
+ * @param mem the memory to manage, aligned to pointer size
+ * @param size size of `mem` in bytes, at most 2^LV_TLSF_FL_MAX
+ */
+void _lv_tlsf_init(lv_tlsf_t * tlsf, void * mem, uint32_t size);
+
+/**
+ * Allocate from a TLSF pool
+ * @param tlsf pointer to an initialized pool
+ * @param size size of the memory to allocate in bytes
+ * @return pointer to the allocated memory or NULL if there is no large enough free block
+ */
+void * _lv_tlsf_alloc(lv_tlsf_t * tlsf, size_t size);
+
+/**
+ * Free a memory allocated from a TLSF pool.
+ * It is joined with the adjacent free blocks.
+ * @param tlsf pointer to the pool
+ * @param data pointer to an allocated memory
+ */
+void _lv_tlsf_free(lv_tlsf_t * tlsf, const void * data);
+
+/**
+ * Resize an allocated memory, in place if it's shrunk or the next block is free.
+ * The old content will be kept.
+ * @param tlsf pointer to the pool
+ * @param data pointer to an allocated memory
+ * @param new_size the desired new size in bytes, not 0
+ * @return pointer to the resized memory or NULL if there is no large enough free block.
+ *         `data` is not freed in this case.
+ */
+void * _lv_tlsf_realloc(lv_tlsf_t * tlsf, void * data, size_t new_size);
+
+/**
+ * Give the size of an allocated memory
+ * @param data pointer to an allocated memory
+ * @return usable size of the memory in bytes, at least the requested size
+ */
+uint32_t _lv_tlsf_get_size(const void * data);
+
+/**
+ * Give information about the blocks of a pool.
+ * Only the counters of the blocks are filled, the other fields are not changed.
+ * @param tlsf pointer to the pool
+ * @param mon_p the counters will be stored here
+ */
+void _lv_tlsf_monitor(const lv_tlsf_t * tlsf, lv_mem_monitor_t * mon_p);
+
+/**
+ * Check the integrity of a pool: block chain, free lists and counters
+ * @param tlsf pointer to the pool
+ * @return LV_RES_OK: the pool is consistent; LV_RES_INV: it is corrupted
+ */
+lv_res_t _lv_tlsf_check(const lv_tlsf_t * tlsf);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LV_TLSF_H*/
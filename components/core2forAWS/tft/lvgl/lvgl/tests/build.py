@@ -207,6 +207,7 @@ all_obj_minimal_features = {
 all_obj_all_features = {
   "LV_DPI":100,
   "LV_MEM_SIZE":32*1024,
+  "LV_MEM_TLSF":1,
   "LV_HOR_RES_MAX":480,
   "LV_VER_RES_MAX":320,
   "LV_COLOR_DEPTH":32,
@@ -246,6 +247,7 @@ all_obj_all_features = {
   "LV_FONT_MONTSERRAT_28":1,
   "LV_FONT_MONTSERRAT_12_SUBPX":1,
   "LV_FONT_MONTSERRAT_28_COMPRESSED":1,
+  "LV_FONT_GLYPH_CACHE_SIZE":8*1024,
   "LV_FONT_UNSCII_8":1,
   "LV_USE_ARC":1,
   "LV_USE_BAR":1,
@@ -325,6 +327,7 @@ advanced_features = {
   "LV_FONT_MONTSERRAT_28":1,
   "LV_FONT_MONTSERRAT_12_SUBPX":1,
   "LV_FONT_MONTSERRAT_28_COMPRESSED":1,
+  "LV_FONT_GLYPH_CACHE_SIZE":64*1024,
   "LV_FONT_UNSCII_8":1,
   "LV_USE_BIDI": 1,
   "LV_USE_REVERSE_ARABIC_PERSIAN_CHARS":1,
@@ -369,7 +372,15 @@ advanced_features = {
   "LV_USE_WIN":1
 }
 
+rgb565_sw_blend = dict(all_obj_minimal_features)
+rgb565_sw_blend.update({
+  "LV_COLOR_DEPTH":16,
+  "LV_COLOR_16_SWAP":1,
+  "LV_USE_GPU_SW_BLEND":1,
+})
+
 build("Minimal monochrome", minimal_monochrome)
 build("All objects, minimal features", all_obj_minimal_features)
 build("All objects, all common features", all_obj_all_features)
 build("All objects, with advanced features", advanced_features)
+build("RGB565 swapped, software blend", rgb565_sw_blend)
@@ -13,6 +13,9 @@
 #include "lv_test_obj.h"
 #include "lv_test_style.h"
 #include "lv_test_font_loader.h"
+#include "lv_test_sw_blend.h"
+#include "lv_test_font_glyph_cache.h"
+#include "lv_test_tlsf.h"
 
 /*********************
  *      DEFINES
@@ -48,6 +51,9 @@ void lv_test_core(void)
     lv_test_obj();
     lv_test_style();
     lv_test_font_loader();
+    lv_test_sw_blend();
+    lv_test_font_glyph_cache();
+    lv_test_tlsf();
 }
 
 /**********************
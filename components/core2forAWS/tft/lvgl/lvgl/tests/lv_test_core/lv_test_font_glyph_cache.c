@@ -0,0 +1,204 @@
+/**
+ * @file lv_test_font_glyph_cache.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../../lvgl.h"
+#include "../lv_test_assert.h"
+#include "lv_test_font_glyph_cache.h"
+
+#if LV_BUILD_TEST
+#include <string.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TEST_GLYPH_CACHE (LV_FONT_GLYPH_CACHE_SIZE && LV_USE_FONT_COMPRESSED && \
+                          LV_FONT_MONTSERRAT_28 && LV_FONT_MONTSERRAT_28_COMPRESSED)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+#if TEST_GLYPH_CACHE
+static void same_as_plain(void);
+static void hit_and_evict(void);
+static void kerning(void);
+static void invalidate(void);
+static uint32_t glyph_size(const lv_font_t * font, uint32_t letter);
+#endif
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+#if TEST_GLYPH_CACHE
+static uint8_t glyph_copy[1024];
+#endif
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_test_font_glyph_cache(void)
+{
+    lv_test_print("");
+    lv_test_print("===============================");
+    lv_test_print("Start lv_font_glyph_cache tests");
+    lv_test_print("===============================");
+
+#if TEST_GLYPH_CACHE
+    same_as_plain();
+    hit_and_evict();
+    kerning();
+    invalidate();
+#else
+    lv_test_print("   SKIP: needs LV_FONT_GLYPH_CACHE_SIZE and both Montserrat 28 fonts");
+#endif
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+#if TEST_GLYPH_CACHE
+static void same_as_plain(void)
+{
+    lv_test_print("");
+    lv_test_print("Cached compressed glyphs are the same as the plain ones:");
+    lv_test_print("--------------------------------------------------------");
+
+    uint32_t letter;
+    uint32_t fails = 0;
+    uint32_t pass;
+
+    lv_font_glyph_cache_invalidate_src(NULL);
+
+    /*The second pass reads what the first one left in the cache*/
+    for(pass = 0; pass < 2; pass++) {
+        for(letter = 0x21; letter < 0x7F; letter++) {
+            uint32_t size = glyph_size(&lv_font_montserrat_28, letter);
+            const uint8_t * plain = lv_font_get_glyph_bitmap(&lv_font_montserrat_28, letter);
+            const uint8_t * compr = lv_font_get_glyph_bitmap(&lv_font_montserrat_28_compressed, letter);
+            if(size != glyph_size(&lv_font_montserrat_28_compressed, letter) || plain == NULL || compr == NULL ||
+               memcmp(plain, compr, size)) {
+                fails++;
+            }
+        }
+    }
+
+    lv_test_assert_int_eq(0, fails, "Different glyphs");
+
+    lv_font_glyph_cache_stats_t stats;
+    lv_font_glyph_cache_get_stats(&stats);
+    lv_test_assert_true(stats.used <= LV_FONT_GLYPH_CACHE_SIZE, "Cache within its budget");
+    lv_test_assert_true(stats.hits > 0, "Glyphs found in the cache");
+}
+
+static void hit_and_evict(void)
+{
+    lv_test_print("");
+    lv_test_print("Decompress a glyph once, again after it was evicted:");
+    lv_test_print("----------------------------------------------------");
+
+    const lv_font_t * font = &lv_font_montserrat_28_compressed;
+    lv_font_glyph_cache_stats_t stats;
+    uint32_t size = glyph_size(font, 'W');
+    uint32_t letter;
+
+    lv_font_glyph_cache_invalidate_src(NULL);
+    lv_font_glyph_cache_reset_stats();
+
+    const uint8_t * bitmap = lv_font_get_glyph_bitmap(font, 'W');
+    memcpy(glyph_copy, bitmap, size);
+    lv_font_glyph_cache_get_stats(&stats);
+    lv_test_assert_int_eq(1, stats.decompressed, "Decompressed on the first use");
+
+    lv_test_assert_ptr_eq(bitmap, lv_font_get_glyph_bitmap(font, 'W'), "The cached bitmap on the second use");
+    lv_font_glyph_cache_get_stats(&stats);
+    lv_test_assert_int_eq(1, stats.decompressed, "Not decompressed again");
+    lv_test_assert_int_eq(1, stats.hits, "Found in the cache");
+
+    /*Use every glyph of both fonts, more than a small cache can hold*/
+    for(letter = 0x21; letter < 0x7F; letter++) {
+        lv_font_get_glyph_bitmap(font, letter);
+        lv_font_get_glyph_bitmap(&lv_font_montserrat_28, letter);
+    }
+    lv_font_glyph_cache_get_stats(&stats);
+    lv_test_print("   %d entries, %d bytes, %d evictions", stats.entry_cnt, stats.used, stats.evictions);
+
+    lv_test_assert_true(stats.used <= LV_FONT_GLYPH_CACHE_SIZE, "Cache within its budget");
+    lv_test_assert_array_eq(glyph_copy, lv_font_get_glyph_bitmap(font, 'W'), size, "Same glyph after the others");
+}
+
+static void kerning(void)
+{
+    lv_test_print("");
+    lv_test_print("Kerning from the cache:");
+    lv_test_print("-----------------------");
+
+    const lv_font_t * font = &lv_font_montserrat_28_compressed;
+    lv_font_glyph_dsc_t dsc_av;
+    lv_font_glyph_dsc_t dsc_ab;
+    lv_font_glyph_dsc_t dsc;
+
+    lv_font_glyph_cache_invalidate_src(NULL);
+    lv_font_get_glyph_dsc(font, &dsc_av, 'A', 'V');
+    lv_font_get_glyph_dsc(font, &dsc_ab, 'A', 'B');
+    lv_test_assert_true(dsc_av.adv_w != dsc_ab.adv_w, "A-V is kerned");
+
+    lv_font_get_glyph_dsc(font, &dsc, 'A', 'V');
+    lv_test_assert_int_eq(dsc_av.adv_w, dsc.adv_w, "A-V after A-B");
+    lv_font_get_glyph_dsc(font, &dsc, 'A', 'V');
+    lv_test_assert_int_eq(dsc_av.adv_w, dsc.adv_w, "A-V again");
+    lv_font_get_glyph_dsc(font, &dsc, 'A', 'B');
+    lv_test_assert_int_eq(dsc_ab.adv_w, dsc.adv_w, "A-B again");
+}
+
+static void invalidate(void)
+{
+    lv_test_print("");
+    lv_test_print("Invalidate a font:");
+    lv_test_print("------------------");
+
+    lv_font_glyph_cache_stats_t stats;
+
+    lv_font_glyph_cache_invalidate_src(NULL);
+    lv_font_get_glyph_bitmap(&lv_font_montserrat_28, 'A');
+    lv_font_get_glyph_bitmap(&lv_font_montserrat_28_compressed, 'A');
+    lv_font_glyph_cache_get_stats(&stats);
+    lv_test_assert_int_eq(2, stats.entry_cnt, "One entry per font");
+
+    lv_font_glyph_cache_invalidate_src(&lv_font_montserrat_28_compressed);
+    lv_font_glyph_cache_get_stats(&stats);
+    lv_test_assert_int_eq(1, stats.entry_cnt, "The other font's entry is kept");
+
+    lv_font_glyph_cache_reset_stats();
+    lv_font_get_glyph_bitmap(&lv_font_montserrat_28_compressed, 'A');
+    lv_font_glyph_cache_get_stats(&stats);
+    lv_test_assert_int_eq(1, stats.misses, "Looked up again");
+    lv_test_assert_int_eq(1, stats.decompressed, "Decompressed again");
+
+    lv_font_glyph_cache_invalidate_src(NULL);
+    lv_font_glyph_cache_get_stats(&stats);
+    lv_test_assert_int_eq(0, stats.entry_cnt, "No entries after invalidating everything");
+}
+
+static uint32_t glyph_size(const lv_font_t * font, uint32_t letter)
+{
+    lv_font_glyph_dsc_t dsc;
+    if(!lv_font_get_glyph_dsc(font, &dsc, letter, 0)) return 0;
+    return (dsc.box_w * dsc.box_h * dsc.bpp + 7) >> 3;
+}
+#endif
+
+#endif
@@ -0,0 +1,38 @@
+/**
+ * @file lv_test_font_glyph_cache.h
+ *
+ */
+
+#ifndef LV_TEST_FONT_GLYPH_CACHE_H
+#define LV_TEST_FONT_GLYPH_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+void lv_test_font_glyph_cache(void);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LV_TEST_FONT_GLYPH_CACHE_H*/
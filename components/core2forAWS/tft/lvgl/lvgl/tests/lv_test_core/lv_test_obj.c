@@ -24,10 +24,13 @@
  *  STATIC PROTOTYPES
  **********************/
 static void create_delete_change_parent(void);
+static void invalidate_cb_on_dirty(void);
+static void count_invalidate_cb(lv_disp_drv_t * disp_drv);
 
 /**********************
  *  STATIC VARIABLES
  **********************/
+static uint32_t invalidate_cnt;
 
 /**********************
  *      MACROS
@@ -45,6 +48,7 @@ void lv_test_obj(void)
     lv_test_print("==================");
 
     create_delete_change_parent();
+    invalidate_cb_on_dirty();
 }
 
 /**********************
@@ -85,4 +89,41 @@ static void create_delete_change_parent(void)
     lv_obj_del(obj_parent);
     lv_test_assert_int_eq(0, lv_obj_count_children(lv_scr_act()), "Screen's children count after delete");
 }
+
+static void invalidate_cb_on_dirty(void)
+{
+    lv_test_print("");
+    lv_test_print("Notify the driver when the display gets dirty:");
+    lv_test_print("----------------------------------------------");
+
+    lv_disp_t * disp = lv_disp_get_default();
+    lv_refr_now(disp);
+
+    invalidate_cnt = 0;
+    disp->driver.invalidate_cb = count_invalidate_cb;
+
+    lv_test_print("Invalidate two objects");
+    lv_obj_t * obj1 = lv_obj_create(lv_scr_act(), NULL);
+    lv_obj_t * obj2 = lv_obj_create(lv_scr_act(), NULL);
+    lv_obj_set_pos(obj2, 20, 20);
+    lv_obj_invalidate(obj1);
+    lv_obj_invalidate(obj2);
+    lv_test_assert_int_eq(1, invalidate_cnt, "Called once until the next refresh");
+
+    lv_test_print("Refresh, then invalidate again");
+    lv_refr_now(disp);
+    lv_obj_invalidate(obj1);
+    lv_test_assert_int_eq(2, invalidate_cnt, "Called again after the refresh");
+
+    disp->driver.invalidate_cb = NULL;
+    lv_obj_del(obj1);
+    lv_obj_del(obj2);
+    lv_refr_now(disp);
+}
+
+static void count_invalidate_cb(lv_disp_drv_t * disp_drv)
+{
+    (void) disp_drv;
+    invalidate_cnt++;
+}
 #endif
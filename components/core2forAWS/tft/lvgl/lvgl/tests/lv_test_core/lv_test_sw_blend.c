@@ -0,0 +1,350 @@
+/**
+ * @file lv_test_sw_blend.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../../lvgl.h"
+#include "../lv_test_assert.h"
+#include "lv_test_sw_blend.h"
+
+#if LV_BUILD_TEST
+#include <string.h>
+#include <time.h>
+#include "../../src/lv_gpu/lv_gpu_sw_blend.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define BUF_W       67      /*Odd, so the rows start at both alignments*/
+#define BUF_H       9
+#define BENCH_W     320
+#define BENCH_H     20
+#define BENCH_RUNS  500
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+#if LV_USE_GPU_SW_BLEND
+static void same_as_color_mix(void);
+static void every_color_every_opa(void);
+static void bench(void);
+static void ref_fill(lv_color_t * buf, lv_coord_t buf_w, lv_color_t color, lv_opa_t opa, lv_coord_t w, lv_coord_t h);
+static void ref_fill_mask(lv_color_t * buf, lv_coord_t buf_w, lv_color_t color, const lv_opa_t * mask, lv_opa_t opa,
+                          lv_coord_t w, lv_coord_t h);
+static void ref_map(lv_color_t * buf, lv_coord_t buf_w, const lv_color_t * map, lv_opa_t opa, lv_coord_t map_w,
+                    lv_coord_t w, lv_coord_t h);
+static void ref_map_mask(lv_color_t * buf, lv_coord_t buf_w, const lv_color_t * map, lv_coord_t map_w,
+                         const lv_opa_t * mask, lv_opa_t opa, lv_coord_t w, lv_coord_t h);
+static void rand_fill(uint8_t * p, uint32_t size);
+static void rand_mask(lv_opa_t * mask, uint32_t size);
+static uint32_t rand_next(void);
+#endif
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+#if LV_USE_GPU_SW_BLEND
+static uint32_t rand_state = 0x12345678;
+static const lv_opa_t opa_list[] = {0, 1, 2, 64, 127, 128, 129, 200, LV_OPA_MAX - 1, LV_OPA_MAX, LV_OPA_MAX + 1, LV_OPA_COVER};
+
+static lv_color_t buf_act[BENCH_W * BENCH_H];
+static lv_color_t buf_ref[BENCH_W * BENCH_H];
+static lv_color_t map_buf[BENCH_W * BENCH_H];
+static lv_opa_t mask_buf[BENCH_W * BENCH_H + 4];
+
+static lv_color_t all_act[0x10000];
+static lv_color_t all_ref[0x10000];
+static lv_color_t all_map[0x10000];
+#endif
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_test_sw_blend(void)
+{
+    lv_test_print("");
+    lv_test_print("===========================");
+    lv_test_print("Start lv_gpu_sw_blend tests");
+    lv_test_print("===========================");
+
+#if LV_USE_GPU_SW_BLEND
+    same_as_color_mix();
+    every_color_every_opa();
+    bench();
+#else
+    lv_test_print("   SKIP: LV_USE_GPU_SW_BLEND is 0");
+#endif
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+#if LV_USE_GPU_SW_BLEND
+static void same_as_color_mix(void)
+{
+    lv_test_print("");
+    lv_test_print("Blend random areas like the plain loops of lv_draw_blend.c:");
+    lv_test_print("-----------------------------------------------------------");
+
+    uint32_t fill_fails = 0;
+    uint32_t fill_mask_fails = 0;
+    uint32_t map_fails = 0;
+    uint32_t map_mask_fails = 0;
+    uint32_t i;
+    lv_coord_t x;
+    lv_coord_t w;
+
+    /*Every start alignment and width of the destination, the map and the mask*/
+    for(i = 0; i < sizeof(opa_list); i++) {
+        lv_opa_t opa = opa_list[i];
+        for(x = 0; x < 4; x++) {
+            for(w = 1; w < BUF_W - x; w += 3) {
+                lv_color_t color;
+                color.full = (uint16_t)rand_next();
+                lv_coord_t h = (lv_coord_t)(1 + rand_next() % BUF_H);
+                lv_opa_t * mask = mask_buf + (rand_next() & 0x3);
+                const lv_color_t * map = map_buf + (rand_next() & 0x1);
+
+                rand_fill((uint8_t *)buf_act, sizeof(lv_color_t) * BUF_W * BUF_H);
+                rand_fill((uint8_t *)map_buf, sizeof(lv_color_t) * BUF_W * BUF_H);
+                rand_mask(mask, w * h);
+
+                memcpy(buf_ref, buf_act, sizeof(lv_color_t) * BUF_W * BUF_H);
+                lv_gpu_sw_blend_fill(buf_act + x, BUF_W, color, opa, w, h);
+                ref_fill(buf_ref + x, BUF_W, color, opa, w, h);
+                if(memcmp(buf_act, buf_ref, sizeof(lv_color_t) * BUF_W * BUF_H)) fill_fails++;
+
+                memcpy(buf_ref, buf_act, sizeof(lv_color_t) * BUF_W * BUF_H);
+                lv_gpu_sw_blend_fill_mask(buf_act + x, BUF_W, color, mask, opa, w, h);
+                ref_fill_mask(buf_ref + x, BUF_W, color, mask, opa, w, h);
+                if(memcmp(buf_act, buf_ref, sizeof(lv_color_t) * BUF_W * BUF_H)) fill_mask_fails++;
+
+                memcpy(buf_ref, buf_act, sizeof(lv_color_t) * BUF_W * BUF_H);
+                lv_gpu_sw_blend_map(buf_act + x, BUF_W, map, opa, BUF_W - 1, w, h);
+                ref_map(buf_ref + x, BUF_W, map, opa, BUF_W - 1, w, h);
+                if(memcmp(buf_act, buf_ref, sizeof(lv_color_t) * BUF_W * BUF_H)) map_fails++;
+
+                memcpy(buf_ref, buf_act, sizeof(lv_color_t) * BUF_W * BUF_H);
+                lv_gpu_sw_blend_map_mask(buf_act + x, BUF_W, map, BUF_W - 1, mask, opa, w, h);
+                ref_map_mask(buf_ref + x, BUF_W, map, BUF_W - 1, mask, opa, w, h);
+                if(memcmp(buf_act, buf_ref, sizeof(lv_color_t) * BUF_W * BUF_H)) map_mask_fails++;
+            }
+        }
+    }
+
+    lv_test_assert_int_eq(0, fill_fails, "Fill with opacity");
+    lv_test_assert_int_eq(0, fill_mask_fails, "Fill with mask");
+    lv_test_assert_int_eq(0, map_fails, "Map with opacity");
+    lv_test_assert_int_eq(0, map_mask_fails, "Map with mask");
+}
+
+static void every_color_every_opa(void)
+{
+    lv_test_print("");
+    lv_test_print("Blend to every 16 bit color with every opacity:");
+    lv_test_print("-----------------------------------------------");
+
+    uint32_t fill_fails = 0;
+    uint32_t map_fails = 0;
+    uint32_t i;
+    uint32_t opa;
+
+    for(i = 0; i < 0x10000; i++) {
+        all_map[i].full = (uint16_t)(0xFFFF - i);
+    }
+
+    for(opa = 0; opa <= LV_OPA_COVER; opa++) {
+        lv_color_t color;
+        color.full = (uint16_t)(opa * 0x0101 + 0x18E3);
+
+        for(i = 0; i < 0x10000; i++) all_act[i].full = (uint16_t)i;
+        memcpy(all_ref, all_act, sizeof(all_act));
+        lv_gpu_sw_blend_fill(all_act, 256, color, opa, 256, 256);
+        ref_fill(all_ref, 256, color, opa, 256, 256);
+        if(memcmp(all_act, all_ref, sizeof(all_act))) fill_fails++;
+
+        for(i = 0; i < 0x10000; i++) all_act[i].full = (uint16_t)i;
+        memcpy(all_ref, all_act, sizeof(all_act));
+        lv_gpu_sw_blend_map(all_act, 256, all_map, opa, 256, 256, 256);
+        ref_map(all_ref, 256, all_map, opa, 256, 256, 256);
+        if(memcmp(all_act, all_ref, sizeof(all_act))) map_fails++;
+    }
+
+    lv_test_assert_int_eq(0, fill_fails, "Fill, failing opacities");
+    lv_test_assert_int_eq(0, map_fails, "Map, failing opacities");
+}
+
+static void bench(void)
+{
+    lv_test_print("");
+    lv_test_print("Time of %d blends of a %dx%d band (plain loop -> lv_gpu_sw_blend):", BENCH_RUNS, BENCH_W, BENCH_H);
+    lv_test_print("-------------------------------------------------------------------");
+
+    lv_color_t color = LV_COLOR_MAKE(0x30, 0x90, 0xC0);
+    uint32_t size = BENCH_W * BENCH_H;
+    uint32_t i;
+    clock_t t_ref;
+    clock_t t_act;
+
+    /*Gradients, so the result buffering of the fills doesn't hide the work*/
+    for(i = 0; i < size; i++) {
+        buf_ref[i].full = (uint16_t)(i * 7);
+        map_buf[i].full = (uint16_t)(i * 13);
+    }
+    rand_mask(mask_buf, size);
+    memcpy(buf_act, buf_ref, sizeof(lv_color_t) * size);
+
+    t_ref = clock();
+    for(i = 0; i < BENCH_RUNS; i++) ref_fill(buf_ref, BENCH_W, color, LV_OPA_50, BENCH_W, BENCH_H);
+    t_ref = clock() - t_ref;
+    t_act = clock();
+    for(i = 0; i < BENCH_RUNS; i++) lv_gpu_sw_blend_fill(buf_act, BENCH_W, color, LV_OPA_50, BENCH_W, BENCH_H);
+    t_act = clock() - t_act;
+    lv_test_print("   fill:     %6ld us -> %6ld us", (long)(t_ref * 1000000 / CLOCKS_PER_SEC),
+                  (long)(t_act * 1000000 / CLOCKS_PER_SEC));
+
+    t_ref = clock();
+    for(i = 0; i < BENCH_RUNS; i++) ref_fill_mask(buf_ref, BENCH_W, color, mask_buf, LV_OPA_50, BENCH_W, BENCH_H);
+    t_ref = clock() - t_ref;
+    t_act = clock();
+    for(i = 0; i < BENCH_RUNS; i++) lv_gpu_sw_blend_fill_mask(buf_act, BENCH_W, color, mask_buf, LV_OPA_50, BENCH_W, BENCH_H);
+    t_act = clock() - t_act;
+    lv_test_print("   fill_mask: %6ld us -> %6ld us", (long)(t_ref * 1000000 / CLOCKS_PER_SEC),
+                  (long)(t_act * 1000000 / CLOCKS_PER_SEC));
+
+    t_ref = clock();
+    for(i = 0; i < BENCH_RUNS; i++) ref_map(buf_ref, BENCH_W, map_buf, LV_OPA_50, BENCH_W, BENCH_W, BENCH_H);
+    t_ref = clock() - t_ref;
+    t_act = clock();
+    for(i = 0; i < BENCH_RUNS; i++) lv_gpu_sw_blend_map(buf_act, BENCH_W, map_buf, LV_OPA_50, BENCH_W, BENCH_W, BENCH_H);
+    t_act = clock() - t_act;
+    lv_test_print("   map:      %6ld us -> %6ld us", (long)(t_ref * 1000000 / CLOCKS_PER_SEC),
+                  (long)(t_act * 1000000 / CLOCKS_PER_SEC));
+
+    t_ref = clock();
+    for(i = 0; i < BENCH_RUNS; i++) ref_map_mask(buf_ref, BENCH_W, map_buf, BENCH_W, mask_buf, LV_OPA_50, BENCH_W, BENCH_H);
+    t_ref = clock() - t_ref;
+    t_act = clock();
+    for(i = 0; i < BENCH_RUNS; i++) lv_gpu_sw_blend_map_mask(buf_act, BENCH_W, map_buf, BENCH_W, mask_buf, LV_OPA_50, BENCH_W,
+                                                                BENCH_H);
+    t_act = clock() - t_act;
+    lv_test_print("   map_mask: %6ld us -> %6ld us", (long)(t_ref * 1000000 / CLOCKS_PER_SEC),
+                  (long)(t_act * 1000000 / CLOCKS_PER_SEC));
+
+    lv_test_assert_array_eq((const uint8_t *)buf_ref, (const uint8_t *)buf_act, sizeof(lv_color_t) * size,
+                            "Same pixels after the benchmark");
+}
+
+/*The software rendering of `fill_normal()` in lv_draw_blend.c without LV_COLOR_SCREEN_TRANSP*/
+static void ref_fill(lv_color_t * buf, lv_coord_t buf_w, lv_color_t color, lv_opa_t opa, lv_coord_t w, lv_coord_t h)
+{
+    lv_coord_t x;
+    lv_coord_t y;
+    for(y = 0; y < h; y++) {
+        for(x = 0; x < w; x++) buf[x] = lv_color_mix(color, buf[x], opa);
+        buf += buf_w;
+    }
+}
+
+static void ref_fill_mask(lv_color_t * buf, lv_coord_t buf_w, lv_color_t color, const lv_opa_t * mask, lv_opa_t opa,
+                          lv_coord_t w, lv_coord_t h)
+{
+    lv_coord_t x;
+    lv_coord_t y;
+    for(y = 0; y < h; y++) {
+        for(x = 0; x < w; x++) {
+            if(mask[x] == 0) continue;
+            if(opa > LV_OPA_MAX) {
+                if(mask[x] == LV_OPA_COVER) buf[x] = color;
+                else buf[x] = lv_color_mix(color, buf[x], mask[x]);
+            }
+            else {
+                lv_opa_t opa_tmp = mask[x] == LV_OPA_COVER ? opa : (uint32_t)((uint32_t)mask[x] * opa) >> 8;
+                if(opa_tmp == LV_OPA_COVER) buf[x] = color;
+                else buf[x] = lv_color_mix(color, buf[x], opa_tmp);
+            }
+        }
+        buf += buf_w;
+        mask += w;
+    }
+}
+
+/*The software rendering of `map_normal()` in lv_draw_blend.c without LV_COLOR_SCREEN_TRANSP*/
+static void ref_map(lv_color_t * buf, lv_coord_t buf_w, const lv_color_t * map, lv_opa_t opa, lv_coord_t map_w,
+                    lv_coord_t w, lv_coord_t h)
+{
+    lv_coord_t x;
+    lv_coord_t y;
+    for(y = 0; y < h; y++) {
+        for(x = 0; x < w; x++) buf[x] = lv_color_mix(map[x], buf[x], opa);
+        buf += buf_w;
+        map += map_w;
+    }
+}
+
+static void ref_map_mask(lv_color_t * buf, lv_coord_t buf_w, const lv_color_t * map, lv_coord_t map_w,
+                         const lv_opa_t * mask, lv_opa_t opa, lv_coord_t w, lv_coord_t h)
+{
+    lv_coord_t x;
+    lv_coord_t y;
+    for(y = 0; y < h; y++) {
+        for(x = 0; x < w; x++) {
+            if(mask[x] == 0) continue;
+            if(opa > LV_OPA_MAX) {
+                if(mask[x] == LV_OPA_COVER) buf[x] = map[x];
+                else buf[x] = lv_color_mix(map[x], buf[x], mask[x]);
+            }
+            else {
+                lv_opa_t opa_tmp = mask[x] >= LV_OPA_MAX ? opa : ((opa * mask[x]) >> 8);
+                buf[x] = lv_color_mix(map[x], buf[x], opa_tmp);
+            }
+        }
+        buf += buf_w;
+        mask += w;
+        map += map_w;
+    }
+}
+
+static void rand_fill(uint8_t * p, uint32_t size)
+{
+    uint32_t i;
+    for(i = 0; i < size; i++) p[i] = (uint8_t)rand_next();
+}
+
+/*Runs of 0x00 and 0xFF with anti-aliased edges, like the masks of rounded rectangles*/
+static void rand_mask(lv_opa_t * mask, uint32_t size)
+{
+    uint32_t i;
+    lv_opa_t run = LV_OPA_TRANSP;
+    for(i = 0; i < size; i++) {
+        uint32_t r = rand_next() % 16;
+        if(r == 0) run = LV_OPA_TRANSP;
+        else if(r == 1) run = LV_OPA_COVER;
+        mask[i] = r < 5 ? (lv_opa_t)rand_next() : run;
+    }
+}
+
+static uint32_t rand_next(void)
+{
+    /*xorshift32*/
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return rand_state;
+}
+#endif
+
+#endif
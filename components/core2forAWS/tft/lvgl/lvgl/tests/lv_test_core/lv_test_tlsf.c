@@ -0,0 +1,367 @@
+/**
+ * @file lv_test_tlsf.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../../lvgl.h"
+#include "../lv_test_assert.h"
+#include "lv_test_tlsf.h"
+
+#if LV_BUILD_TEST
+#include <string.h>
+#include <time.h>
+#include "../../src/lv_misc/lv_tlsf.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define POOL_SIZE       (16U * 1024U)
+#define STRESS_SLOTS    64
+#define STRESS_OPS      20000
+#define STRESS_SIZE_MAX 512
+#define BENCH_OPS       200000
+#define BENCH_SIZE_MAX  256
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct {
+    uint8_t * p;
+    uint32_t size;
+    uint8_t seed;
+} slot_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void alloc_and_join(void);
+static void realloc_in_place(void);
+static void out_of_memory(void);
+static void stress(void);
+#if LV_MEM_CUSTOM == 0
+static void bench(void);
+static long bench_run(bool use_tlsf, uint32_t slot_cnt, uint32_t * fail_cnt);
+#endif
+static void slot_fill(slot_t * slot);
+static bool slot_check(const slot_t * slot, uint32_t size);
+static uint32_t rand_size(uint32_t max);
+static uint32_t rand_next(void);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static lv_tlsf_t tlsf;
+static uint64_t pool[POOL_SIZE / sizeof(uint64_t)];
+static slot_t slots[STRESS_SLOTS];
+static uint32_t rand_state = 0x2545F491;
+
+#if LV_MEM_CUSTOM == 0
+static uint64_t bench_pool[LV_MEM_SIZE / sizeof(uint64_t)];
+#endif
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_test_tlsf(void)
+{
+    lv_test_print("");
+    lv_test_print("====================");
+    lv_test_print("Start lv_tlsf tests");
+    lv_test_print("====================");
+
+    alloc_and_join();
+    realloc_in_place();
+    out_of_memory();
+    stress();
+#if LV_MEM_CUSTOM == 0
+    bench();
+#endif
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void alloc_and_join(void)
+{
+    lv_test_print("");
+    lv_test_print("Allocate and join the free blocks:");
+    lv_test_print("----------------------------------");
+
+    lv_mem_monitor_t mon_init;
+    lv_mem_monitor_t mon;
+
+    _lv_tlsf_init(&tlsf, pool, sizeof(pool));
+    _lv_tlsf_monitor(&tlsf, &mon_init);
+    lv_test_assert_int_eq(1, mon_init.free_cnt, "One free block after init");
+    lv_test_assert_int_eq(mon_init.free_size, mon_init.free_biggest_size, "The free block is the biggest one");
+
+    uint8_t * a = _lv_tlsf_alloc(&tlsf, 10);
+    uint8_t * b = _lv_tlsf_alloc(&tlsf, 100);
+    uint8_t * c = _lv_tlsf_alloc(&tlsf, 1000);
+    lv_test_assert_true(a != NULL && b != NULL && c != NULL, "Allocated");
+    lv_test_assert_int_eq(0, (lv_uintptr_t)a % sizeof(void *), "Aligned");
+    lv_test_assert_int_eq(0, (lv_uintptr_t)b % sizeof(void *), "Aligned");
+    lv_test_assert_true(_lv_tlsf_get_size(a) >= 10 && _lv_tlsf_get_size(b) >= 100 && _lv_tlsf_get_size(c) >= 1000,
+                        "Sizes at least the requested ones");
+
+    _lv_tlsf_free(&tlsf, b);
+    _lv_tlsf_monitor(&tlsf, &mon);
+    lv_test_assert_int_eq(2, mon.free_cnt, "A hole and the end");
+    lv_test_assert_int_eq(2, mon.used_cnt, "Two used blocks");
+
+    _lv_tlsf_free(&tlsf, a);
+    _lv_tlsf_monitor(&tlsf, &mon);
+    lv_test_assert_int_eq(2, mon.free_cnt, "The hole is joined with the free block before it");
+
+    _lv_tlsf_free(&tlsf, c);
+    _lv_tlsf_monitor(&tlsf, &mon);
+    lv_test_assert_int_eq(1, mon.free_cnt, "Everything is joined again");
+    lv_test_assert_int_eq(mon_init.free_biggest_size, mon.free_biggest_size, "The whole pool is free");
+    lv_test_assert_int_eq(LV_RES_OK, _lv_tlsf_check(&tlsf), "Consistent");
+}
+
+static void realloc_in_place(void)
+{
+    lv_test_print("");
+    lv_test_print("Reallocate in place:");
+    lv_test_print("--------------------");
+
+    _lv_tlsf_init(&tlsf, pool, sizeof(pool));
+
+    slot_t a = {.size = 100, .seed = 1};
+    slot_t b = {.size = 200, .seed = 2};
+    a.p = _lv_tlsf_alloc(&tlsf, a.size);
+    b.p = _lv_tlsf_alloc(&tlsf, b.size);
+    slot_fill(&a);
+    slot_fill(&b);
+
+    /*`b` is followed by the free end of the pool*/
+    uint8_t * p = _lv_tlsf_realloc(&tlsf, b.p, 2000);
+    lv_test_assert_ptr_eq(b.p, p, "Grown in place into the next free block");
+    lv_test_assert_true(slot_check(&b, b.size), "Content kept");
+
+    p = _lv_tlsf_realloc(&tlsf, b.p, 50);
+    lv_test_assert_ptr_eq(b.p, p, "Shrunk in place");
+    lv_test_assert_true(slot_check(&b, 50), "Content kept");
+    b.size = 50;
+
+    /*`a` is followed by the used `b`*/
+    p = _lv_tlsf_realloc(&tlsf, a.p, 300);
+    lv_test_assert_true(p != NULL && p != a.p, "Moved, the next block is used");
+    a.p = p;
+    lv_test_assert_true(slot_check(&a, a.size), "Content kept");
+    lv_test_assert_int_eq(LV_RES_OK, _lv_tlsf_check(&tlsf), "Consistent");
+
+    _lv_tlsf_free(&tlsf, a.p);
+    _lv_tlsf_free(&tlsf, b.p);
+
+    lv_mem_monitor_t mon;
+    _lv_tlsf_monitor(&tlsf, &mon);
+    lv_test_assert_int_eq(1, mon.free_cnt, "Everything is joined again");
+}
+
+static void out_of_memory(void)
+{
+    lv_test_print("");
+    lv_test_print("Out of memory:");
+    lv_test_print("--------------");
+
+    lv_mem_monitor_t mon;
+    uint32_t i;
+
+    _lv_tlsf_init(&tlsf, pool, sizeof(pool));
+    _lv_tlsf_monitor(&tlsf, &mon);
+
+    lv_test_assert_ptr_eq(NULL, _lv_tlsf_alloc(&tlsf, mon.free_biggest_size + 1), "Larger than the pool");
+    lv_test_assert_ptr_eq(NULL, _lv_tlsf_alloc(&tlsf, 0), "0 byte");
+
+    /*Fill the pool with 512 byte blocks*/
+    for(i = 0; i < STRESS_SLOTS; i++) {
+        slots[i].p = _lv_tlsf_alloc(&tlsf, 512);
+        if(slots[i].p == NULL) break;
+    }
+    lv_test_assert_true(i > 0 && i < STRESS_SLOTS, "Allocated until the pool is full");
+    lv_test_assert_int_eq(LV_RES_OK, _lv_tlsf_check(&tlsf), "Consistent when full");
+
+    while(i > 0) {
+        i--;
+        _lv_tlsf_free(&tlsf, slots[i].p);
+        slots[i].p = NULL;
+    }
+
+    lv_mem_monitor_t mon_after;
+    _lv_tlsf_monitor(&tlsf, &mon_after);
+    lv_test_assert_int_eq(mon.free_biggest_size, mon_after.free_biggest_size, "The whole pool is free again");
+}
+
+static void stress(void)
+{
+    lv_test_print("");
+    lv_test_print("Random allocations, reallocations and frees:");
+    lv_test_print("--------------------------------------------");
+
+    uint32_t i;
+    uint32_t bad_content = 0;
+    uint32_t bad_check = 0;
+
+    _lv_tlsf_init(&tlsf, pool, sizeof(pool));
+    _lv_memset_00(slots, sizeof(slots));
+
+    for(i = 0; i < STRESS_OPS; i++) {
+        slot_t * slot = &slots[rand_next() % STRESS_SLOTS];
+        uint32_t op = rand_next() % 4;
+
+        if(slot->p == NULL) {
+            slot->size = rand_size(STRESS_SIZE_MAX);
+            slot->seed = (uint8_t)rand_next();
+            slot->p = _lv_tlsf_alloc(&tlsf, slot->size);
+            if(slot->p) slot_fill(slot);
+        }
+        else if(op == 0) {
+            uint32_t new_size = rand_size(STRESS_SIZE_MAX);
+            uint8_t * p = _lv_tlsf_realloc(&tlsf, slot->p, new_size);
+            if(p) {
+                slot->p = p;
+                if(!slot_check(slot, LV_MATH_MIN(slot->size, new_size))) bad_content++;
+                slot->size = new_size;
+                slot_fill(slot);
+            }
+        }
+        else {
+            if(!slot_check(slot, slot->size)) bad_content++;
+            _lv_tlsf_free(&tlsf, slot->p);
+            slot->p = NULL;
+        }
+
+        if((i & 0xFF) == 0 && _lv_tlsf_check(&tlsf) != LV_RES_OK) bad_check++;
+    }
+
+    lv_mem_monitor_t mon;
+    _lv_tlsf_monitor(&tlsf, &mon);
+    lv_test_print("   %d used, %d free blocks, biggest free: %d of %d bytes", mon.used_cnt, mon.free_cnt,
+                  mon.free_biggest_size, mon.free_size);
+
+    lv_test_assert_int_eq(0, bad_content, "Blocks overwritten");
+    lv_test_assert_int_eq(0, bad_check, "Inconsistent pool");
+
+    for(i = 0; i < STRESS_SLOTS; i++) {
+        if(slots[i].p) _lv_tlsf_free(&tlsf, slots[i].p);
+        slots[i].p = NULL;
+    }
+
+    _lv_tlsf_monitor(&tlsf, &mon);
+    lv_test_assert_int_eq(1, mon.free_cnt, "One free block at the end");
+    lv_test_assert_int_eq(0, mon.used_cnt, "No used blocks at the end");
+    lv_test_assert_int_eq(LV_RES_OK, _lv_tlsf_check(&tlsf), "Consistent at the end");
+    lv_test_assert_int_eq(LV_RES_OK, lv_mem_test(), "lv_mem is consistent");
+}
+
+#if LV_MEM_CUSTOM == 0
+static void bench(void)
+{
+    /*Keep a quarter of the heap used on average*/
+    uint32_t slot_cnt = LV_MATH_MIN(LV_MEM_SIZE / 512, STRESS_SLOTS);
+    uint32_t fail_mem;
+    uint32_t fail_tlsf;
+
+    lv_test_print("");
+    lv_test_print("Time of %d random operations on %d blocks (lv_mem_alloc -> lv_tlsf):", BENCH_OPS, slot_cnt);
+    lv_test_print("---------------------------------------------------------------------");
+
+    long t_mem = bench_run(false, slot_cnt, &fail_mem);
+    long t_tlsf = bench_run(true, slot_cnt, &fail_tlsf);
+
+    lv_test_print("   %s:  %6ld us (%d failed) -> %6ld us (%d failed)", LV_MEM_TLSF ? "tlsf" : "first fit",
+                  t_mem, fail_mem, t_tlsf, fail_tlsf);
+
+    lv_test_assert_int_eq(LV_RES_OK, lv_mem_test(), "lv_mem is consistent after the benchmark");
+}
+
+/**
+ * Allocate, reallocate and free text sized blocks like a label which is updated often
+ * @param use_tlsf true: use a TLSF pool of `LV_MEM_SIZE`; false: use `lv_mem_alloc`
+ * @param slot_cnt number of blocks to use at most
+ * @param fail_cnt the number of failed allocations will be stored here
+ * @return the time of the run in microseconds
+ */
+static long bench_run(bool use_tlsf, uint32_t slot_cnt, uint32_t * fail_cnt)
+{
+    uint32_t i;
+    *fail_cnt = 0;
+    rand_state = 0x2545F491;
+    _lv_memset_00(slots, sizeof(slots));
+    if(use_tlsf) _lv_tlsf_init(&tlsf, bench_pool, sizeof(bench_pool));
+
+    clock_t t = clock();
+    for(i = 0; i < BENCH_OPS; i++) {
+        slot_t * slot = &slots[rand_next() % slot_cnt];
+        uint32_t size = rand_size(BENCH_SIZE_MAX);
+
+        if(slot->p == NULL) {
+            slot->p = use_tlsf ? _lv_tlsf_alloc(&tlsf, size) : lv_mem_alloc(size);
+            if(slot->p == NULL) (*fail_cnt)++;
+        }
+        else if(rand_next() & 1) {
+            uint8_t * p = use_tlsf ? _lv_tlsf_realloc(&tlsf, slot->p, size) : lv_mem_realloc(slot->p, size);
+            if(p) slot->p = p;
+            else (*fail_cnt)++;
+        }
+        else {
+            if(use_tlsf) _lv_tlsf_free(&tlsf, slot->p);
+            else lv_mem_free(slot->p);
+            slot->p = NULL;
+        }
+    }
+    t = clock() - t;
+
+    for(i = 0; i < slot_cnt; i++) {
+        if(slots[i].p == NULL) continue;
+        if(use_tlsf) _lv_tlsf_free(&tlsf, slots[i].p);
+        else lv_mem_free(slots[i].p);
+        slots[i].p = NULL;
+    }
+
+    return (long)(t * 1000000 / CLOCKS_PER_SEC);
+}
+#endif
+
+static void slot_fill(slot_t * slot)
+{
+    uint32_t i;
+    for(i = 0; i < slot->size; i++) slot->p[i] = (uint8_t)(slot->seed + i);
+}
+
+static bool slot_check(const slot_t * slot, uint32_t size)
+{
+    uint32_t i;
+    for(i = 0; i < size; i++) {
+        if(slot->p[i] != (uint8_t)(slot->seed + i)) return false;
+    }
+    return true;
+}
+
+/*Mostly short texts, sometimes a long one*/
+static uint32_t rand_size(uint32_t max)
+{
+    if(rand_next() % 8 == 0) return 1 + rand_next() % max;
+    return 1 + rand_next() % (max / 8);
+}
+
+static uint32_t rand_next(void)
+{
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 17;
+    rand_state ^= rand_state << 5;
+    return rand_state;
+}
+
+#endif
@@ -112,6 +112,10 @@ ATCA_STATUS atcab_sign(uint16_t key_id, const uint8_t *msg, uint8_t *signature)
     uint8_t nonce_target = NONCE_MODE_TARGET_TEMPKEY;
     uint8_t sign_source = SIGN_MODE_SOURCE_TEMPKEY;
 
+    // Hold the device from the nonce to the sign, a command from another task
+    // in between could replace the message being signed
+    (void)atcab_wakeup();
+
     do
     {
         // Make sure RNG has updated its seed
@@ -140,6 +144,8 @@ ATCA_STATUS atcab_sign(uint16_t key_id, const uint8_t *msg, uint8_t *signature)
     }
     while (0);
 
+    (void)atcab_idle();
+
     return status;
 }
 
@@ -16,6 +16,8 @@
 #include <stdio.h>
 #include <string.h>
 #include <driver/i2c.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "hal/atca_hal.h"
 #include "esp_err.h"
 #include "esp_log.h"
@@ -36,6 +38,14 @@
 
 I2CDevice_t i2c_device_bus = NULL;
 
+/*
+ * Held from wake to idle (or sleep), so only one task talks to the chip at a time.
+ * The I2C bus itself is only held for each transfer, other devices on the bus can
+ * use it while the chip is executing a command. Recursive, so a caller can wrap a
+ * command sequence in atcab_wakeup()/atcab_idle() to keep it to itself.
+ */
+static SemaphoreHandle_t device_mutex = NULL;
+
 static const char *TAG = "HAL_I2C";
 
 void hal_i2c_change_baud(ATCAIface iface, uint32_t speed) {
@@ -46,11 +56,20 @@ ATCA_STATUS hal_i2c_init(void *hal, ATCAIfaceCfg *cfg)
 {
     esp_err_t rc;
     int bus = cfg->atcai2c.bus;
+
+    if (device_mutex == NULL) {
+        device_mutex = xSemaphoreCreateRecursiveMutex();
+        if (device_mutex == NULL) {
+            return ATCA_ALLOC_FAILURE;
+        }
+    }
+
     i2c_device_bus = i2c_malloc_device(bus, SDA_PIN, SCL_PIN, cfg->atcai2c.baud, cfg->atcai2c.slave_address >> 1);
 
     if (i2c_device_bus == NULL) {
         return ATCA_COMM_FAIL;
     } else {
+        i2c_device_set_priority(i2c_device_bus, I2C_PRIORITY_LOW);
         return ATCA_SUCCESS;
     }
 }
@@ -62,21 +81,10 @@ ATCA_STATUS hal_i2c_post_init(ATCAIface iface)
 
 ATCA_STATUS hal_i2c_send(ATCAIface iface, uint8_t *txdata, int txlength)
 {
-    ATCAIfaceCfg *cfg = iface->mIfaceCFG;
     esp_err_t rc;
 
-    txdata[0] = 0x03;              //Word Address value, Command Token as per datasheet of ATECC508A
-    txlength++;
-
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    (void)i2c_master_start(cmd);
-    (void)i2c_master_write_byte(cmd, cfg->atcai2c.slave_address | I2C_MASTER_WRITE, ACK_CHECK_EN);
-    (void)i2c_master_write(cmd, txdata, txlength, ACK_CHECK_EN);
-    (void)i2c_master_stop(cmd);
-
-    rc = i2c_master_cmd_begin(cfg->atcai2c.bus, cmd, 10);
-
-    (void)i2c_cmd_link_delete(cmd);
+    // the Command word address goes out as the register, queued behind the faster devices
+    rc = i2c_write_bytes(i2c_device_bus, 0x03, &txdata[1], txlength);
 
     if (ESP_OK != rc) {
         return ATCA_COMM_FAIL;
@@ -98,12 +106,15 @@ ATCA_STATUS hal_i2c_receive(ATCAIface iface, uint8_t *rxdata, uint16_t *rxlength
     (void)i2c_master_write_byte(cmd, cfg->atcai2c.slave_address | I2C_MASTER_READ, ACK_CHECK_EN);
     (void)i2c_master_read_byte(cmd, rxdata, ACK_VAL);
 
+    // the count byte and the rest are one transfer, keep the bus until the stop
+    i2c_apply_bus(i2c_device_bus);
     rc = i2c_master_cmd_begin(cfg->atcai2c.bus, cmd, 10);
 
     (void)i2c_cmd_link_delete(cmd);
 
     if (ESP_OK != rc)
     {
+        i2c_free_bus(i2c_device_bus);
         return ATCA_COMM_FAIL;
     }
 
@@ -128,6 +139,7 @@ ATCA_STATUS hal_i2c_receive(ATCAIface iface, uint8_t *rxdata, uint16_t *rxlength
         rc = i2c_master_cmd_begin(cfg->atcai2c.bus, cmd, 10);
         (void)i2c_cmd_link_delete(cmd);
     }
+    i2c_free_bus(i2c_device_bus);
 
 //    ESP_LOG_BUFFER_HEX(TAG, rxdata, *rxlength);
 
@@ -154,6 +166,8 @@ ATCA_STATUS hal_i2c_wake(ATCAIface iface)
     uint16_t rxlen;
     uint8_t data[4] = { 0 };
     const uint8_t expected[4] = { 0x04, 0x11, 0x33, 0x43 };
+
+    xSemaphoreTakeRecursive(device_mutex, portMAX_DELAY);
     i2c_apply_bus(i2c_device_bus);
 //    if (bdrt != 100000) {
 //        hal_i2c_change_baud(iface, 100000);
@@ -173,6 +187,8 @@ ATCA_STATUS hal_i2c_wake(ATCAIface iface)
     rxlen = 4;
 
     hal_i2c_receive(iface, data, &rxlen);
+    i2c_free_bus(i2c_device_bus);
+
     if (memcmp(data, expected, 4) == 0)
     {
         return ATCA_SUCCESS;
@@ -190,9 +206,11 @@ ATCA_STATUS hal_i2c_idle(ATCAIface iface)
     (void)i2c_master_write_byte(cmd, cfg->atcai2c.slave_address | I2C_MASTER_WRITE, ACK_CHECK_EN);
     (void)i2c_master_write(cmd, &idle_data, 1, ACK_CHECK_DIS);
     (void)i2c_master_stop(cmd);
+    i2c_apply_bus(i2c_device_bus);
     (void)i2c_master_cmd_begin(cfg->atcai2c.bus, cmd, 10);
-    (void)i2c_cmd_link_delete(cmd);
     i2c_free_bus(i2c_device_bus);
+    (void)i2c_cmd_link_delete(cmd);
+    xSemaphoreGiveRecursive(device_mutex);
     return ATCA_SUCCESS;
 }
 
@@ -207,8 +225,12 @@ ATCA_STATUS hal_i2c_sleep(ATCAIface iface)
     (void)i2c_master_write_byte(cmd, cfg->atcai2c.slave_address | I2C_MASTER_WRITE, ACK_CHECK_EN);
     (void)i2c_master_write(cmd, &sleep_data, 1, ACK_CHECK_DIS);
     (void)i2c_master_stop(cmd);
+    i2c_apply_bus(i2c_device_bus);
     (void)i2c_master_cmd_begin(cfg->atcai2c.bus, cmd, 10);
+    i2c_free_bus(i2c_device_bus);
     (void)i2c_cmd_link_delete(cmd);
+    // not taken when sleep is not preceded by a wake, the give then fails harmlessly
+    xSemaphoreGiveRecursive(device_mutex);
 
     return ATCA_SUCCESS;
 }
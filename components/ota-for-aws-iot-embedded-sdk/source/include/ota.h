@@ -298,7 +298,8 @@ typedef struct OtaAgentContext
     uint8_t * pClientTokenFromJob;                         /*!< The clientToken field from the latest update job. */
     uint32_t timestampFromJob;                             /*!< Timestamp received from the latest job document. */
     OtaImageState_t imageState;                            /*!< The current application image state. */
-    uint32_t numOfBlocksToReceive;                         /*!< Number of data blocks to receive per data request. */
+    uint32_t numOfBlocksToReceive;                         /*!< Number of data blocks to receive per data request, or in flight when requests are windowed. */
+    uint32_t requestBlockCursor;                           /*!< First block covered by the next windowed data request. */
     OtaAgentStatistics_t statistics;                       /*!< The OTA agent statistics block. */
     uint32_t requestMomentum;                              /*!< The number of requests sent before a response was received. */
     OtaInterfaces_t * pOtaInterface;                       /*!< Collection of all interfaces used by the agent. */
@@ -56,6 +56,18 @@ bool OTA_CBOR_Decode_GetStreamResponseMessage( const uint8_t * pMessageBuffer,
                                                uint8_t ** pPayload,
                                                size_t * pPayloadSize );
 
+/**
+ * @brief Decode a Get Stream response message from AWS IoT OTA, leaving the
+ * payload in the message buffer.
+ */
+bool OTA_CBOR_Decode_GetStreamResponseMessageInPlace( const uint8_t * pMessageBuffer,
+                                                      size_t messageSize,
+                                                      int32_t * pFileId,
+                                                      int32_t * pBlockId,
+                                                      int32_t * pBlockSize,
+                                                      const uint8_t ** ppPayload,
+                                                      size_t * pPayloadSize );
+
 /**
  * @brief Create an encoded Get Stream Request message for the AWS IoT OTA
  * service. The service allows block count or block bitmap to be requested,
@@ -152,6 +152,43 @@
     #define otaconfigMAX_NUM_BLOCKS_REQUEST    1U
 #endif
 
+/**
+ * @brief The number of data block requests kept in flight.
+ *
+ * @note With the default of 1 the agent waits for all blocks of a request to
+ * arrive before sending the next one, so every request costs a full round
+ * trip. A larger window pipelines the download over MQTT: each request covers
+ * the next otaconfigMAX_NUM_BLOCKS_REQUEST blocks of the receive bitmap, and a
+ * new request is sent as soon as one request's worth of blocks has arrived.
+ * When the request timer expires only the blocks still missing from the
+ * bitmap are requested again. Requests start on a bitmap byte, so
+ * otaconfigMAX_NUM_BLOCKS_REQUEST must be a multiple of 8 when the window is
+ * larger than 1. Size otaconfigMAX_NUM_OTA_DATA_BUFFERS for the extra blocks
+ * that may be queued; blocks dropped for lack of a buffer are re-requested.
+ *
+ * <b>Possible values:</b> Any unsigned 32 integer value greater than 0. <br>
+ * <b>Default value:</b> '1'
+ */
+#ifndef otaconfigBLOCK_REQUEST_WINDOW
+    #define otaconfigBLOCK_REQUEST_WINDOW    1U
+#endif
+
+/**
+ * @brief The maximum number of data blocks fetched with one HTTP range request.
+ *
+ * @note Over HTTP the agent requests the next run of missing blocks as a
+ * single byte range, and the HTTP interface hands the response body to the
+ * agent one block at a time. Larger ranges spend fewer round trips on request
+ * headers; a range that is lost costs a full request timeout before the
+ * missing blocks are requested again.
+ *
+ * <b>Possible values:</b> Any unsigned 32 integer value greater than 0. <br>
+ * <b>Default value:</b> '32'
+ */
+#ifndef otaconfigHTTP_MAX_RANGE_BLOCKS
+    #define otaconfigHTTP_MAX_RANGE_BLOCKS    32U
+#endif
+
 /**
  * @brief The maximum number of requests allowed to send without a response
  * before we abort.
@@ -100,6 +100,10 @@ typedef OtaHttpStatus_t ( * OtaHttpInit_t ) ( char * pUrl );
  * @brief Request file block over Http.
  *
  * This function requests file block over Http from the rangeStart and rangeEnd.
+ * The range may span several blocks. The response body must be passed to the
+ * agent in order, as one OtaAgentEventReceivedFileBlock event per
+ * OTA_FILE_BLOCK_SIZE bytes (the last block of the file may be shorter).
+ * A new request replaces any range that is still being delivered.
  *
  * @param[in] rangeStart  Starting index of the file data to be requested.
  *
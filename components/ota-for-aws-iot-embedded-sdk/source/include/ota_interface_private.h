@@ -75,7 +75,7 @@ typedef struct
                                     int32_t * pBlockId,
                                     int32_t * pBlockSize,
                                     uint8_t ** pPayload,
-                                    size_t * pPayloadSize );       /*!< Decode a cbor encoded fileblock. */
+                                    size_t * pPayloadSize );       /*!< Decode a cbor encoded fileblock. *pPayload may be pointed into pMessageBuffer. */
     OtaErr_t ( * cleanup )( const OtaAgentContext_t * pAgentCtx ); /*!< Cleanup related to OTA data plane. */
 } OtaDataInterface_t;
 
@@ -76,14 +76,16 @@ OtaErr_t requestFileBlock_Mqtt( OtaAgentContext_t * pAgentCtx );
  * @brief Decode a cbor encoded fileblock.
  *
  * This function is used for decoding a file block received over MQTT & encoded in cbor.
+ * The payload is normally not copied: *pPayload is pointed at the payload inside
+ * pMessageBuffer. Only messages that need TinyCBOR are copied into *pPayload.
  *
  * @param[in] pMessageBuffer The message to be decoded.
  * @param[in] messageSize     The size of the message in bytes.
  * @param[out] pFileId        The server file ID.
  * @param[out] pBlockId       The file block ID.
  * @param[out] pBlockSize     The file block size.
- * @param[out] pPayload     The payload.
- * @param[out] pPayloadSize   The payload size.
+ * @param[in,out] pPayload    Buffer for the payload as in, the payload as out.
+ * @param[in,out] pPayloadSize Size of the buffer as in, the payload size as out.
  *
  * @return The OTA PAL layer error code combined with the MCU specific error code. See OTA Agent
  * error codes information in ota.h.
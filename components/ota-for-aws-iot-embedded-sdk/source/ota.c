@@ -316,7 +316,8 @@ static bool validateDataBlock( const OtaFileContext_t * pFileContext,
  * @param[in] pFileContext Information of file to be streamed.
  * @param[in] pRawMsg Raw job document.
  * @param[in] messageSize Length of document.
- * @param[in] pPayload Data stored in the document.
+ * @param[out] pDecodeBuffer Buffer used for decoding, to be freed if it was allocated.
+ * @param[out] pPayload Data stored in the document, in pDecodeBuffer or in pRawMsg.
  * @param[out] pBlockSize Block size of incoming data block.
  * @param[out] pBlockIndex Block index of incoming data block.
  * @return IngestResult_t IngestResultAccepted_Continue if successful, other error for failure.
@@ -324,6 +325,7 @@ static bool validateDataBlock( const OtaFileContext_t * pFileContext,
 static IngestResult_t decodeAndStoreDataBlock( OtaFileContext_t * pFileContext,
                                                const uint8_t * pRawMsg,
                                                uint32_t messageSize,
+                                               uint8_t ** pDecodeBuffer,
                                                uint8_t ** pPayload,
                                                uint32_t * pBlockSize,
                                                uint32_t * pBlockIndex );
@@ -479,6 +481,7 @@ static OtaErr_t inSelfTestHandler( const OtaEventData_t * pEventData );      /*!
 static OtaErr_t initFileHandler( const OtaEventData_t * pEventData );        /*!< Initialize and handle file transfer. */
 static OtaErr_t processDataHandler( const OtaEventData_t * pEventData );     /*!< Process incoming data blocks. */
 static OtaErr_t requestDataHandler( const OtaEventData_t * pEventData );     /*!< Request for data blocks. */
+static OtaErr_t retryDataHandler( const OtaEventData_t * pEventData );       /*!< Request the missing data blocks again after a timeout. */
 static OtaErr_t shutdownHandler( const OtaEventData_t * pEventData );        /*!< Shutdown OTA and cleanup. */
 static OtaErr_t closeFileHandler( const OtaEventData_t * pEventData );       /*!< Close file opened for download. */
 static OtaErr_t userAbortHandler( const OtaEventData_t * pEventData );       /*!< Handle user interrupt to abort task. */
@@ -503,6 +506,7 @@ static OtaAgentContext_t otaAgent =
     0,                    /* timestampFromJob */
     OtaImageStateUnknown, /* imageState */
     1,                    /* numOfBlocksToReceive */
+    0,                    /* requestBlockCursor */
     { 0 },                /* statistics */
     0,                    /* requestMomentum */
     NULL,                 /* pOtaInterface */
@@ -524,9 +528,9 @@ static OtaStateTableEntry_t otaTransitionTable[] =
     { OtaAgentStateCreatingFile,        OtaAgentEventCreateFile,          initFileHandler,        OtaAgentStateRequestingFileBlock },
     { OtaAgentStateCreatingFile,        OtaAgentEventRequestTimer,        initFileHandler,        OtaAgentStateRequestingFileBlock },
     { OtaAgentStateRequestingFileBlock, OtaAgentEventRequestFileBlock,    requestDataHandler,     OtaAgentStateWaitingForFileBlock },
-    { OtaAgentStateRequestingFileBlock, OtaAgentEventRequestTimer,        requestDataHandler,     OtaAgentStateWaitingForFileBlock },
+    { OtaAgentStateRequestingFileBlock, OtaAgentEventRequestTimer,        retryDataHandler,       OtaAgentStateWaitingForFileBlock },
     { OtaAgentStateWaitingForFileBlock, OtaAgentEventReceivedFileBlock,   processDataHandler,     OtaAgentStateWaitingForFileBlock },
-    { OtaAgentStateWaitingForFileBlock, OtaAgentEventRequestTimer,        requestDataHandler,     OtaAgentStateWaitingForFileBlock },
+    { OtaAgentStateWaitingForFileBlock, OtaAgentEventRequestTimer,        retryDataHandler,       OtaAgentStateWaitingForFileBlock },
     { OtaAgentStateWaitingForFileBlock, OtaAgentEventRequestFileBlock,    requestDataHandler,     OtaAgentStateWaitingForFileBlock },
     { OtaAgentStateWaitingForFileBlock, OtaAgentEventRequestJobDocument,  requestJobHandler,      OtaAgentStateWaitingForJob       },
     { OtaAgentStateWaitingForFileBlock, OtaAgentEventReceivedJobDocument, jobNotificationHandler, OtaAgentStateRequestingJob       },
@@ -1066,6 +1070,12 @@ static OtaErr_t initFileHandler( const OtaEventData_t * pEventData )
         /* Reset the request momentum. */
         otaAgent.requestMomentum = 0;
 
+        /* Nothing has been requested for this file yet. */
+        otaAgent.requestBlockCursor = 0;
+        #if ( otaconfigBLOCK_REQUEST_WINDOW > 1U )
+            otaAgent.numOfBlocksToReceive = 0;
+        #endif
+
         /* Reset the OTA statistics. */
         ( void ) memset( &otaAgent.statistics, 0, sizeof( otaAgent.statistics ) );
 
@@ -1086,6 +1096,11 @@ static OtaErr_t requestDataHandler( const OtaEventData_t * pEventData )
     OtaOsStatus_t osErr = OtaOsSuccess;
     OtaEventMsg_t eventMsg = { 0 };
 
+    #if ( otaconfigBLOCK_REQUEST_WINDOW > 1U )
+        uint32_t requests = 0;
+        uint32_t inFlight = otaAgent.numOfBlocksToReceive;
+    #endif
+
     ( void ) pEventData;
 
     if( otaAgent.fileContext.blocksRemaining > 0U )
@@ -1101,6 +1116,19 @@ static OtaErr_t requestDataHandler( const OtaEventData_t * pEventData )
             /* Request data blocks. */
             err = otaDataInterface.requestFileBlock( &otaAgent );
 
+            #if ( otaconfigBLOCK_REQUEST_WINDOW > 1U )
+                /* Top up the window. A request that adds no blocks means the rest
+                 * of the file is already received or in flight. */
+                for( requests = 1U; ( err == OtaErrNone ) &&
+                     ( requests < otaconfigBLOCK_REQUEST_WINDOW ) &&
+                     ( otaAgent.numOfBlocksToReceive > inFlight ) &&
+                     ( otaAgent.numOfBlocksToReceive <= OTA_WINDOW_REFILL_LEVEL ); requests++ )
+                {
+                    inFlight = otaAgent.numOfBlocksToReceive;
+                    err = otaDataInterface.requestFileBlock( &otaAgent );
+                }
+            #endif
+
             /* Each request increases the momentum until a response is received. Too much momentum is
              * interpreted as a failure to communicate and will cause us to abort the OTA. */
             otaAgent.requestMomentum++;
@@ -1140,6 +1168,20 @@ static OtaErr_t requestDataHandler( const OtaEventData_t * pEventData )
     return err;
 }
 
+static OtaErr_t retryDataHandler( const OtaEventData_t * pEventData )
+{
+    /* Nothing arrived within the request timeout, so whatever is still in
+     * flight is presumed lost. Restart the request window from the beginning
+     * of the file; only blocks missing from the bitmap are requested again. */
+    otaAgent.requestBlockCursor = 0;
+
+    #if ( otaconfigBLOCK_REQUEST_WINDOW > 1U )
+        otaAgent.numOfBlocksToReceive = 0;
+    #endif
+
+    return requestDataHandler( pEventData );
+}
+
 static void dataHandlerCleanup( void )
 {
     OtaEventMsg_t eventMsg = { 0 };
@@ -1254,11 +1296,27 @@ static OtaErr_t processDataHandler( const OtaEventData_t * pEventData )
             err = otaControlInterface.updateJobStatus( &otaAgent, JobStatusInProgress, JobReasonReceiving, 0 );
         }
 
-        if( otaAgent.numOfBlocksToReceive > 1U )
-        {
-            otaAgent.numOfBlocksToReceive--;
-        }
-        else
+        #if ( otaconfigBLOCK_REQUEST_WINDOW > 1U )
+            /* Any block, even a duplicate, is a response to an outstanding request. */
+            otaAgent.requestMomentum = 0;
+
+            if( otaAgent.numOfBlocksToReceive > 0U )
+            {
+                otaAgent.numOfBlocksToReceive--;
+            }
+
+            /* Request the next span as soon as it fits in the window, instead of
+             * waiting for every outstanding block. Once nothing is in flight, the
+             * request also picks up blocks that were lost along the way. */
+            if( ( otaAgent.numOfBlocksToReceive == OTA_WINDOW_REFILL_LEVEL ) ||
+                ( otaAgent.numOfBlocksToReceive == 0U ) )
+        #else
+            if( otaAgent.numOfBlocksToReceive > 1U )
+            {
+                otaAgent.numOfBlocksToReceive--;
+            }
+            else
+        #endif
         {
             /* Start the request timer. */
             ( void ) otaAgent.pOtaInterface->os.timer.start( OtaRequestTimer, "OtaRequestTimer", otaconfigFILE_REQUEST_WAIT_MS, otaTimerCallback );
@@ -2546,6 +2604,7 @@ static IngestResult_t processDataBlock( OtaFileContext_t * pFileContext,
 static IngestResult_t decodeAndStoreDataBlock( OtaFileContext_t * pFileContext,
                                                const uint8_t * pRawMsg,
                                                uint32_t messageSize,
+                                               uint8_t ** pDecodeBuffer,
                                                uint8_t ** pPayload,
                                                uint32_t * pBlockSize,
                                                uint32_t * pBlockIndex )
@@ -2566,18 +2625,21 @@ static IngestResult_t decodeAndStoreDataBlock( OtaFileContext_t * pFileContext,
 
         if( otaAgent.fileContext.decodeMemMaxSize != 0U )
         {
-            *pPayload = otaAgent.fileContext.pDecodeMem;
+            *pDecodeBuffer = otaAgent.fileContext.pDecodeMem;
             payloadSize = otaAgent.fileContext.decodeMemMaxSize;
         }
         else
         {
-            *pPayload = otaAgent.pOtaInterface->os.mem.malloc( 1UL << otaconfigLOG2_FILE_BLOCK_SIZE );
+            *pDecodeBuffer = otaAgent.pOtaInterface->os.mem.malloc( 1UL << otaconfigLOG2_FILE_BLOCK_SIZE );
 
-            if( *pPayload != NULL )
+            if( *pDecodeBuffer != NULL )
             {
                 payloadSize = ( 1UL << otaconfigLOG2_FILE_BLOCK_SIZE );
             }
         }
+
+        /* The decoder may point the payload into pRawMsg instead of filling the buffer. */
+        *pPayload = *pDecodeBuffer;
     }
     else
     {
@@ -2696,6 +2758,7 @@ static IngestResult_t ingestDataBlock( OtaFileContext_t * pFileContext,
     IngestResult_t eIngestResult = IngestResultUninitialized;
     uint32_t uBlockSize = 0;
     uint32_t uBlockIndex = 0;
+    uint8_t * pDecodeBuffer = NULL;
     uint8_t * pPayload = NULL;
 
     /* Assume the file context and result pointers are not NULL. This function
@@ -2706,7 +2769,7 @@ static IngestResult_t ingestDataBlock( OtaFileContext_t * pFileContext,
 
     /* Decode the received data block. */
     /* If we have a block bitmap available then process the message. */
-    eIngestResult = decodeAndStoreDataBlock( pFileContext, pRawMsg, messageSize, &pPayload, &uBlockSize, &uBlockIndex );
+    eIngestResult = decodeAndStoreDataBlock( pFileContext, pRawMsg, messageSize, &pDecodeBuffer, &pPayload, &uBlockSize, &uBlockIndex );
 
     /* Validate the data block and process it to store the information.*/
     if( eIngestResult == IngestResultUninitialized )
@@ -2722,9 +2785,9 @@ static IngestResult_t ingestDataBlock( OtaFileContext_t * pFileContext,
 
     /* Free the payload if it's dynamically allocated by us. */
     if( ( otaAgent.fileContext.decodeMemMaxSize == 0u ) &&
-        ( pPayload != NULL ) )
+        ( pDecodeBuffer != NULL ) )
     {
-        otaAgent.pOtaInterface->os.mem.free( pPayload );
+        otaAgent.pOtaInterface->os.mem.free( pDecodeBuffer );
     }
 
     return eIngestResult;
@@ -27,6 +27,7 @@
 
 #include "ota_base64_private.h"
 #include <assert.h>
+#include <stdbool.h>
 
 /**
  * @brief Number to represent both line feed and carriage return symbols in the
@@ -401,6 +402,47 @@ static Base64Status_t decodeBase64IndexBuffer( uint32_t * pBase64IndexBuffer,
     return returnVal;
 }
 
+/**
+ * @brief         Decode four Base64 digits into three octets with one table
+ *                lookup per symbol.
+ *
+ * @param[in]     pEncodedData Pointer to four Ascii symbols.
+ * @param[out]    pDest Pointer to room for three octets. Nothing is written
+ *                unless all four symbols are Base64 digits.
+ *
+ * @return        true if the four symbols were Base64 digits and were decoded,
+ *                false if any of them needs the validating path.
+ */
+static bool decodeBase64Quad( const uint8_t * pEncodedData,
+                              uint8_t * pDest )
+{
+    bool decoded = false;
+    uint32_t index0 = pBase64SymbolToIndexMap[ pEncodedData[ 0 ] ];
+    uint32_t index1 = pBase64SymbolToIndexMap[ pEncodedData[ 1 ] ];
+    uint32_t index2 = pBase64SymbolToIndexMap[ pEncodedData[ 2 ] ];
+    uint32_t index3 = pBase64SymbolToIndexMap[ pEncodedData[ 3 ] ];
+    uint32_t base64IndexBuffer;
+
+    assert( pEncodedData != NULL );
+    assert( pDest != NULL );
+
+    /* All formatting and invalid symbols map to 64 or above, so a single test
+     * of bit 6 tells whether the four symbols are all Base64 digits. */
+    if( ( ( index0 | index1 | index2 | index3 ) & ~VALID_BASE64_SYMBOL_INDEX_RANGE_MAX ) == 0U )
+    {
+        base64IndexBuffer = ( index0 << ( 3 * SEXTET_SIZE ) ) |
+                            ( index1 << ( 2 * SEXTET_SIZE ) ) |
+                            ( index2 << SEXTET_SIZE ) |
+                            index3;
+        pDest[ 0 ] = ( uint8_t ) ( base64IndexBuffer >> SIZE_OF_TWO_OCTETS ) & 0xFFU;
+        pDest[ 1 ] = ( uint8_t ) ( base64IndexBuffer >> SIZE_OF_ONE_OCTET ) & 0xFFU;
+        pDest[ 2 ] = ( uint8_t ) base64IndexBuffer & 0xFFU;
+        decoded = true;
+    }
+
+    return decoded;
+}
+
 /**
  * @brief Decode Base64 encoded data.
  *
@@ -445,35 +487,51 @@ Base64Status_t base64Decode( uint8_t * pDest,
     while( ( returnVal == Base64Success ) &&
            ( pCurrBase64Symbol < ( pEncodedData + encodedLen ) ) )
     {
-        uint8_t base64Index = 0;
-        /* Read in the next Ascii character that represents the current Base64 symbol. */
-        uint8_t base64AsciiSymbol = *pCurrBase64Symbol++;
-        /* Get the Base64 index that represents the Base64 symbol. */
-        base64Index = pBase64SymbolToIndexMap[ base64AsciiSymbol ];
-
-        /* Validate the input and update counters for padding and whitespace. */
-        returnVal = preprocessBase64Index( base64Index,
-                                           &numPadding,
-                                           &numWhitespace );
-
-        if( returnVal != Base64Success )
+        /* Between groups, and before any padding or whitespace, four Base64 digits
+         * in a row are decoded at once. Everything else, including the end of the
+         * data, goes through the validating path one symbol at a time. */
+        if( ( numDataInBuffer == 0U ) &&
+            ( numPadding == 0 ) &&
+            ( numWhitespace == 0 ) &&
+            ( ( size_t ) ( ( pEncodedData + encodedLen ) - pCurrBase64Symbol ) >= MAX_NUM_BASE64_DATA ) &&
+            ( destLen >= ( outputLen + 3U ) ) &&
+            ( decodeBase64Quad( pCurrBase64Symbol, &pDest[ outputLen ] ) == true ) )
         {
-            break;
+            pCurrBase64Symbol += MAX_NUM_BASE64_DATA;
+            outputLen += 3U;
         }
+        else
+        {
+            uint8_t base64Index = 0;
+            /* Read in the next Ascii character that represents the current Base64 symbol. */
+            uint8_t base64AsciiSymbol = *pCurrBase64Symbol++;
+            /* Get the Base64 index that represents the Base64 symbol. */
+            base64Index = pBase64SymbolToIndexMap[ base64AsciiSymbol ];
+
+            /* Validate the input and update counters for padding and whitespace. */
+            returnVal = preprocessBase64Index( base64Index,
+                                               &numPadding,
+                                               &numWhitespace );
+
+            if( returnVal != Base64Success )
+            {
+                break;
+            }
 
-        /* Add the current Base64 index to a buffer. */
-        updateBase64DecodingBuffer( base64Index,
-                                    &base64IndexBuffer,
-                                    &numDataInBuffer );
+            /* Add the current Base64 index to a buffer. */
+            updateBase64DecodingBuffer( base64Index,
+                                        &base64IndexBuffer,
+                                        &numDataInBuffer );
 
-        /* Decode the buffer when it's full and store the result. */
-        if( numDataInBuffer == MAX_NUM_BASE64_DATA )
-        {
-            returnVal = decodeBase64IndexBuffer( &base64IndexBuffer,
-                                                 &numDataInBuffer,
-                                                 pDest,
-                                                 destLen,
-                                                 &outputLen );
+            /* Decode the buffer when it's full and store the result. */
+            if( numDataInBuffer == MAX_NUM_BASE64_DATA )
+            {
+                returnVal = decodeBase64IndexBuffer( &base64IndexBuffer,
+                                                     &numDataInBuffer,
+                                                     pDest,
+                                                     destLen,
+                                                     &outputLen );
+            }
         }
     }
 
@@ -215,6 +215,246 @@ bool OTA_CBOR_Decode_GetStreamResponseMessage( const uint8_t * pMessageBuffer,
     return CborNoError == cborResult;
 }
 
+/**
+ * @brief Read the head of a CBOR data item.
+ *
+ * Only the forms found in a Get Stream response are accepted: definite
+ * lengths and values that fit in 32 bits.
+ *
+ * @param[in,out] ppCursor Position of the item, moved past its head.
+ * @param[in] pEnd End of the message.
+ * @param[out] pMajorType Major type of the item.
+ * @param[out] pArgument Value, length or count carried by the head.
+ *
+ * @return TRUE when a head was read, otherwise FALSE.
+ */
+static bool readItemHead( const uint8_t ** ppCursor,
+                          const uint8_t * pEnd,
+                          uint8_t * pMajorType,
+                          uint32_t * pArgument )
+{
+    const uint8_t * pCursor = *ppCursor;
+    bool result = false;
+    uint8_t additionalInfo = 0;
+    uint32_t argumentSize = 0;
+    uint32_t argument = 0;
+    uint32_t i = 0;
+
+    if( pCursor < pEnd )
+    {
+        *pMajorType = ( uint8_t ) ( *pCursor >> 5 );
+        additionalInfo = ( uint8_t ) ( *pCursor & 0x1fU );
+        pCursor++;
+
+        if( additionalInfo < 24U )
+        {
+            argument = additionalInfo;
+            result = true;
+        }
+        else if( additionalInfo <= 26U )
+        {
+            /* 24, 25 and 26 are followed by a 1, 2 or 4 byte big endian argument. */
+            argumentSize = 1UL << ( additionalInfo - 24U );
+
+            if( ( size_t ) ( pEnd - pCursor ) >= argumentSize )
+            {
+                for( i = 0; i < argumentSize; i++ )
+                {
+                    argument = ( argument << 8 ) | pCursor[ i ];
+                }
+
+                pCursor += argumentSize;
+                result = true;
+            }
+        }
+        else
+        {
+            /* 64 bit arguments and indefinite lengths are left to TinyCBOR. */
+        }
+    }
+
+    if( result == true )
+    {
+        *ppCursor = pCursor;
+        *pArgument = argument;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Read a CBOR integer that fits in an int32_t.
+ *
+ * @param[in] majorType Major type of the item.
+ * @param[in] argument Argument of the item.
+ * @param[out] pValue The integer.
+ *
+ * @return TRUE when the item is such an integer, otherwise FALSE.
+ */
+static bool readInt32( uint8_t majorType,
+                       uint32_t argument,
+                       int32_t * pValue )
+{
+    bool result = false;
+
+    if( argument <= ( uint32_t ) INT32_MAX )
+    {
+        if( majorType == 0U )
+        {
+            *pValue = ( int32_t ) argument;
+            result = true;
+        }
+        else if( majorType == 1U )
+        {
+            /* Negative integers encode -1 - value. */
+            *pValue = -1 - ( int32_t ) argument;
+            result = true;
+        }
+        else
+        {
+            /* Not an integer. */
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Decode a Get Stream response message from AWS IoT OTA without
+ * copying the payload.
+ *
+ * The message is walked once instead of once per key. The payload is left
+ * where it is, so it is only valid as long as the message buffer is.
+ *
+ * Messages using encodings the service does not produce (indefinite lengths,
+ * nested items, tags, 64 bit values) are rejected, use
+ * OTA_CBOR_Decode_GetStreamResponseMessage() for those.
+ *
+ * @param[in] pMessageBuffer message to decode.
+ * @param[in] messageSize size of the message to decode.
+ * @param[out] pFileId Decoded file id value.
+ * @param[out] pBlockId Decoded block id value.
+ * @param[out] pBlockSize Decoded block size value.
+ * @param[out] ppPayload Start of the payload inside pMessageBuffer.
+ * @param[out] pPayloadSize Size of the payload.
+ *
+ * @return TRUE when success, otherwise FALSE.
+ */
+bool OTA_CBOR_Decode_GetStreamResponseMessageInPlace( const uint8_t * pMessageBuffer,
+                                                      size_t messageSize,
+                                                      int32_t * pFileId,
+                                                      int32_t * pBlockId,
+                                                      int32_t * pBlockSize,
+                                                      const uint8_t ** ppPayload,
+                                                      size_t * pPayloadSize )
+{
+    const uint8_t * pCursor = pMessageBuffer;
+    const uint8_t * pEnd = NULL;
+    const uint8_t * pKey = NULL;
+    const uint8_t * pPayload = NULL;
+    bool result = false;
+    bool foundFileId = false;
+    bool foundBlockId = false;
+    bool foundBlockSize = false;
+    uint8_t majorType = 0;
+    uint8_t keyMajorType = 0;
+    uint32_t argument = 0;
+    uint32_t keyLength = 0;
+    uint32_t numEntries = 0;
+    int32_t value = 0;
+
+    if( ( pFileId != NULL ) &&
+        ( pBlockId != NULL ) &&
+        ( pBlockSize != NULL ) &&
+        ( ppPayload != NULL ) &&
+        ( pPayloadSize != NULL ) &&
+        ( pMessageBuffer != NULL ) )
+    {
+        pEnd = pMessageBuffer + messageSize;
+
+        /* The outer element must be a map. */
+        result = readItemHead( &pCursor, pEnd, &majorType, &numEntries ) &&
+                 ( majorType == 5U );
+    }
+
+    while( ( result == true ) && ( numEntries > 0U ) )
+    {
+        numEntries--;
+
+        /* Every key is a short text string. */
+        result = readItemHead( &pCursor, pEnd, &keyMajorType, &keyLength ) &&
+                 ( keyMajorType == 3U ) &&
+                 ( keyLength <= ( size_t ) ( pEnd - pCursor ) );
+
+        if( result == true )
+        {
+            pKey = pCursor;
+            pCursor += keyLength;
+            result = readItemHead( &pCursor, pEnd, &majorType, &argument );
+        }
+
+        /* Like cbor_value_map_find_value(), the first occurrence of a key wins. */
+        if( ( result == true ) && ( keyLength == 1U ) )
+        {
+            if( ( pKey[ 0 ] == ( uint8_t ) OTA_CBOR_FILEID_KEY[ 0 ] ) && ( foundFileId == false ) )
+            {
+                result = readInt32( majorType, argument, &value );
+                *pFileId = value;
+                foundFileId = true;
+            }
+            else if( ( pKey[ 0 ] == ( uint8_t ) OTA_CBOR_BLOCKID_KEY[ 0 ] ) && ( foundBlockId == false ) )
+            {
+                result = readInt32( majorType, argument, &value );
+                *pBlockId = value;
+                foundBlockId = true;
+            }
+            else if( ( pKey[ 0 ] == ( uint8_t ) OTA_CBOR_BLOCKSIZE_KEY[ 0 ] ) && ( foundBlockSize == false ) )
+            {
+                result = readInt32( majorType, argument, &value );
+                *pBlockSize = value;
+                foundBlockSize = true;
+            }
+            else if( ( pKey[ 0 ] == ( uint8_t ) OTA_CBOR_BLOCKPAYLOAD_KEY[ 0 ] ) && ( pPayload == NULL ) )
+            {
+                result = ( majorType == 2U );
+                pPayload = pCursor;
+                *pPayloadSize = argument;
+            }
+            else
+            {
+                /* Not a field of the response. */
+            }
+        }
+
+        /* Step over the value. Strings carry their length, integers and
+         * simple values have nothing after the head. */
+        if( result == true )
+        {
+            if( ( majorType == 2U ) || ( majorType == 3U ) )
+            {
+                result = ( argument <= ( size_t ) ( pEnd - pCursor ) );
+                pCursor += ( result == true ) ? argument : 0U;
+            }
+            else
+            {
+                result = ( majorType <= 1U ) || ( majorType == 7U );
+            }
+        }
+    }
+
+    if( result == true )
+    {
+        result = foundFileId && foundBlockId && foundBlockSize && ( pPayload != NULL );
+    }
+
+    if( result == true )
+    {
+        *ppPayload = pPayload;
+    }
+
+    return result;
+}
+
 /**
  * @brief Create an encoded Get Stream Request message for the AWS IoT OTA
  * service. The service allows block count or block bitmap to be requested,
@@ -41,6 +41,69 @@
  */
 static uint32_t currBlock;
 
+/**
+ * @brief Blocks of the current range request that have not arrived yet.
+ */
+static uint32_t rangeBlocksLeft;
+
+/**
+ * @brief Blocks that arrived since the range was requested or last checked
+ * by a retry.
+ */
+static uint32_t rangeProgress;
+
+/**
+ * @brief Find the next run of missing blocks to request as one range.
+ *
+ * The search starts at the request cursor and wraps around to the beginning
+ * of the file, so blocks lost along the way are picked up once the end of
+ * the file has been requested.
+ *
+ * @param[in] pAgentCtx The OTA agent context.
+ * @param[in] numBlocks Number of blocks in the file.
+ * @param[out] pStartBlock First block of the run.
+ *
+ * @return Number of blocks in the run, 0 if no block is missing.
+ */
+static uint32_t nextMissingRange( const OtaAgentContext_t * pAgentCtx,
+                                  uint32_t numBlocks,
+                                  uint32_t * pStartBlock );
+
+static uint32_t nextMissingRange( const OtaAgentContext_t * pAgentCtx,
+                                  uint32_t numBlocks,
+                                  uint32_t * pStartBlock )
+{
+    const uint8_t * pBitmap = pAgentCtx->fileContext.pRxBlockBitmap;
+    uint32_t block = pAgentCtx->requestBlockCursor;
+    uint32_t count = 0;
+    uint32_t i = 0;
+
+    /* A set bit marks a block that has not been received yet. */
+    for( i = 0; ( i < numBlocks ) && ( count == 0U ); i++ )
+    {
+        if( block >= numBlocks )
+        {
+            block = 0;
+        }
+
+        while( ( block < numBlocks ) && ( count < otaconfigHTTP_MAX_RANGE_BLOCKS ) &&
+               ( ( pBitmap[ block >> LOG2_BITS_PER_BYTE ] & ( 1U << ( block % BITS_PER_BYTE ) ) ) != 0U ) )
+        {
+            if( count == 0U )
+            {
+                *pStartBlock = block;
+            }
+
+            count++;
+            block++;
+        }
+
+        block++;
+    }
+
+    return count;
+}
+
 /*
  * Init file transfer by initializing the http module with the pre-signed url.
  */
@@ -59,6 +122,11 @@ OtaErr_t initFileTransfer_Http( OtaAgentContext_t * pAgentCtx )
     /* Get pre-signed URL from pAgentCtx. */
     pURL = ( char * ) fileContext->pUpdateUrlPath;
 
+    /* Nothing has been requested from the new URL yet. */
+    currBlock = 0;
+    rangeBlocksLeft = 0;
+    rangeProgress = 0;
+
     /* Connect to the HTTP server and initialize download information. */
     httpStatus = pAgentCtx->pOtaInterface->http.init( pURL );
 
@@ -73,16 +141,21 @@ OtaErr_t initFileTransfer_Http( OtaAgentContext_t * pAgentCtx )
 }
 
 /*
- * Check for next available OTA job from the job service.
+ * Request the next run of missing blocks as a single range.
  */
 OtaErr_t requestDataBlock_Http( OtaAgentContext_t * pAgentCtx )
 {
+    OtaErr_t err = OtaErrNone;
     OtaHttpStatus_t httpStatus = OtaHttpSuccess;
 
     /* Values for the "Range" field in HTTP header. */
     uint32_t rangeStart = 0;
     uint32_t rangeEnd = 0;
 
+    uint32_t numBlocks = 0;
+    uint32_t startBlock = 0;
+    uint32_t count = 0;
+
     OtaFileContext_t * fileContext = NULL;
 
     assert( pAgentCtx != NULL && pAgentCtx->pOtaInterface != NULL );
@@ -90,29 +163,66 @@ OtaErr_t requestDataBlock_Http( OtaAgentContext_t * pAgentCtx )
 
     fileContext = &( pAgentCtx->fileContext );
 
-    /* Calculate ranges. */
-    rangeStart = currBlock * OTA_FILE_BLOCK_SIZE;
+    numBlocks = ( fileContext->fileSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE;
+
+    /* The agent resets the cursor when the request timer expires. A range that
+     * kept delivering blocks since then is slow, not lost, so let it finish
+     * instead of asking for the same blocks again. */
+    if( ( rangeBlocksLeft > 0U ) && ( pAgentCtx->requestBlockCursor == 0U ) && ( rangeProgress > 0U ) )
+    {
+        rangeProgress = 0;
+        pAgentCtx->requestBlockCursor = currBlock + rangeBlocksLeft;
+        pAgentCtx->numOfBlocksToReceive = rangeBlocksLeft;
+    }
 
-    if( fileContext->blocksRemaining == 1U )
+    if( ( rangeBlocksLeft > 0U ) && ( pAgentCtx->requestBlockCursor != 0U ) )
     {
-        rangeEnd = fileContext->fileSize - 1U;
+        /* The current range is still streaming in. */
+        LogDebug( ( "Range still in flight: Blocks left=%u", rangeBlocksLeft ) );
     }
     else
     {
-        rangeEnd = rangeStart + OTA_FILE_BLOCK_SIZE - 1U;
+        count = nextMissingRange( pAgentCtx, numBlocks, &startBlock );
     }
 
-    /* Request file data over HTTP using the rangeStart and rangeEnd. */
-    httpStatus = pAgentCtx->pOtaInterface->http.request( rangeStart, rangeEnd );
-
-    if( httpStatus != OtaHttpSuccess )
+    if( count > 0U )
     {
-        LogError( ( "Error occured while requesting data block:"
-                    "OtaHttpStatus_t=%s"
-                    , OTA_HTTP_strerror( httpStatus ) ) );
+        /* Calculate ranges. */
+        rangeStart = startBlock * OTA_FILE_BLOCK_SIZE;
+
+        if( ( startBlock + count ) == numBlocks )
+        {
+            rangeEnd = fileContext->fileSize - 1U;
+        }
+        else
+        {
+            rangeEnd = ( ( startBlock + count ) * OTA_FILE_BLOCK_SIZE ) - 1U;
+        }
+
+        /* The response body is delivered in order, one block per event. */
+        currBlock = startBlock;
+        rangeBlocksLeft = count;
+        rangeProgress = 0;
+        pAgentCtx->requestBlockCursor = startBlock + count;
+        pAgentCtx->numOfBlocksToReceive = count;
+
+        /* Request file data over HTTP using the rangeStart and rangeEnd. */
+        httpStatus = pAgentCtx->pOtaInterface->http.request( rangeStart, rangeEnd );
+
+        if( httpStatus != OtaHttpSuccess )
+        {
+            LogError( ( "Error occured while requesting data block:"
+                        "OtaHttpStatus_t=%s"
+                        , OTA_HTTP_strerror( httpStatus ) ) );
+
+            /* Nothing of this range is coming, start over on the next request. */
+            rangeBlocksLeft = 0;
+            pAgentCtx->requestBlockCursor = 0;
+            err = OtaErrRequestFileBlockFailed;
+        }
     }
 
-    return ( httpStatus == OtaHttpSuccess ) ? OtaErrNone : OtaErrRequestFileBlockFailed;
+    return err;
 }
 
 /*
@@ -144,13 +254,21 @@ OtaErr_t decodeFileBlock_Http( const uint8_t * pMessageBuffer,
         *pBlockId = ( int32_t ) currBlock;
         *pBlockSize = ( int32_t ) messageSize;
 
-        /* The data received over HTTP does not require any decoding. */
-        ( void ) memcpy( *pPayload, pMessageBuffer, messageSize );
+        /* The data received over HTTP does not require any decoding, the block
+         * is written straight from the message buffer. */
+        *pPayload = ( uint8_t * ) pMessageBuffer;
 
         *pPayloadSize = messageSize;
 
         /* Current block is processed, set the file block to next. */
         currBlock++;
+
+        if( rangeBlocksLeft > 0U )
+        {
+            rangeBlocksLeft--;
+        }
+
+        rangeProgress++;
     }
 
     return err;
@@ -168,6 +286,8 @@ OtaErr_t cleanupData_Http( const OtaAgentContext_t * pAgentCtx )
 
     /* Reset currBlock. */
     currBlock = 0;
+    rangeBlocksLeft = 0;
+    rangeProgress = 0;
 
     return ( httpStatus == OtaHttpSuccess ) ? OtaErrNone : OtaErrCleanupDataFailed;
 }
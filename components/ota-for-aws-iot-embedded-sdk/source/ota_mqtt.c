@@ -253,6 +253,29 @@ static size_t stringBuilderUInt32Hex( char * pBuffer,
                                       size_t bufferSizeBytes,
                                       uint32_t value );
 
+#if ( otaconfigBLOCK_REQUEST_WINDOW > 1U )
+
+/**
+ * @brief Select the blocks covered by the next windowed data request.
+ *
+ * Starting at the request cursor, spans of otaconfigMAX_NUM_BLOCKS_REQUEST
+ * blocks that have all been received are skipped. Once every earlier request
+ * has been answered the cursor wraps to the start of the file, so blocks lost
+ * in transit are requested again.
+ *
+ * @param[in,out] pAgentCtx Agent context holding the receive bitmap and the request cursor.
+ * @param[in] numBlocks Number of blocks in the file.
+ * @param[out] pBlockOffset First block of the selected span.
+ * @param[out] pBitmapLen Number of bitmap bytes covering the selected span.
+ * @return uint32_t Number of missing blocks in the span, 0 if there is nothing left to request.
+ */
+static uint32_t nextWindowSpan( OtaAgentContext_t * pAgentCtx,
+                                uint32_t numBlocks,
+                                uint32_t * pBlockOffset,
+                                uint32_t * pBitmapLen );
+
+#endif /* if ( otaconfigBLOCK_REQUEST_WINDOW > 1U ) */
+
 static size_t stringBuilder( char * pBuffer,
                              size_t bufferSizeBytes,
                              const char * strings[] )
@@ -1028,6 +1051,53 @@ OtaErr_t initFileTransfer_Mqtt( OtaAgentContext_t * pAgentCtx )
     return result;
 }
 
+#if ( otaconfigBLOCK_REQUEST_WINDOW > 1U )
+
+static uint32_t nextWindowSpan( OtaAgentContext_t * pAgentCtx,
+                                uint32_t numBlocks,
+                                uint32_t * pBlockOffset,
+                                uint32_t * pBitmapLen )
+{
+    const uint8_t * pBitmap = pAgentCtx->fileContext.pRxBlockBitmap;
+    uint32_t bitmapLen = ( numBlocks + ( BITS_PER_BYTE - 1U ) ) >> LOG2_BITS_PER_BYTE;
+    uint32_t spanLen = otaconfigMAX_NUM_BLOCKS_REQUEST >> LOG2_BITS_PER_BYTE;
+    uint32_t byteIndex = 0;
+    uint32_t missing = 0;
+    uint32_t i = 0;
+    uint8_t bits = 0;
+
+    if( ( pAgentCtx->requestBlockCursor >= numBlocks ) && ( pAgentCtx->numOfBlocksToReceive == 0U ) )
+    {
+        /* Every request has been answered but blocks are still missing. */
+        pAgentCtx->requestBlockCursor = 0;
+    }
+
+    byteIndex = pAgentCtx->requestBlockCursor >> LOG2_BITS_PER_BYTE;
+
+    while( ( missing == 0U ) && ( byteIndex < bitmapLen ) )
+    {
+        *pBlockOffset = byteIndex << LOG2_BITS_PER_BYTE;
+        *pBitmapLen = ( ( bitmapLen - byteIndex ) < spanLen ) ? ( bitmapLen - byteIndex ) : spanLen;
+
+        /* A set bit marks a block that has not been received yet. */
+        for( i = 0; i < *pBitmapLen; i++ )
+        {
+            for( bits = pBitmap[ byteIndex + i ]; bits != 0U; bits &= ( uint8_t ) ( bits - 1U ) )
+            {
+                missing++;
+            }
+        }
+
+        byteIndex += *pBitmapLen;
+    }
+
+    pAgentCtx->requestBlockCursor = byteIndex << LOG2_BITS_PER_BYTE;
+
+    return missing;
+}
+
+#endif /* if ( otaconfigBLOCK_REQUEST_WINDOW > 1U ) */
+
 /*
  * Request file block by publishing to the get stream topic.
  */
@@ -1039,6 +1109,8 @@ OtaErr_t requestFileBlock_Mqtt( OtaAgentContext_t * pAgentCtx )
     uint32_t blockSize = OTA_FILE_BLOCK_SIZE;
     uint32_t numBlocks = 0;
     uint32_t bitmapLen = 0;
+    uint32_t blockOffset = 0;
+    uint32_t numBlocksRequested = otaconfigMAX_NUM_BLOCKS_REQUEST;
     uint32_t msgSizeToPublish = 0;
     uint32_t topicLen = 0;
     bool cborEncodeRet = false;
@@ -1068,22 +1140,38 @@ OtaErr_t requestFileBlock_Mqtt( OtaAgentContext_t * pAgentCtx )
     pTopicParts[ 1 ] = ( const char * ) pAgentCtx->pThingName;
     pTopicParts[ 3 ] = ( const char * ) pFileContext->pStreamName;
 
-    /* Reset number of blocks requested. */
-    pAgentCtx->numOfBlocksToReceive = otaconfigMAX_NUM_BLOCKS_REQUEST;
-
     numBlocks = ( pFileContext->fileSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) >> otaconfigLOG2_FILE_BLOCK_SIZE;
-    bitmapLen = ( numBlocks + ( BITS_PER_BYTE - 1U ) ) >> LOG2_BITS_PER_BYTE;
-
-    cborEncodeRet = OTA_CBOR_Encode_GetStreamRequestMessage( ( uint8_t * ) pMsg,
-                                                             sizeof( pMsg ),
-                                                             &msgSizeFromStream,
-                                                             OTA_CLIENT_TOKEN,
-                                                             ( int32_t ) pFileContext->serverFileID,
-                                                             ( int32_t ) blockSize,
-                                                             0,
-                                                             pFileContext->pRxBlockBitmap,
-                                                             bitmapLen,
-                                                             ( int32_t ) otaconfigMAX_NUM_BLOCKS_REQUEST );
+
+    #if ( otaconfigBLOCK_REQUEST_WINDOW > 1U )
+        /* Request only the missing blocks of the next span, the blocks before it are
+         * already in flight. */
+        numBlocksRequested = nextWindowSpan( pAgentCtx, numBlocks, &blockOffset, &bitmapLen );
+    #else
+        /* Reset number of blocks requested. */
+        pAgentCtx->numOfBlocksToReceive = otaconfigMAX_NUM_BLOCKS_REQUEST;
+
+        bitmapLen = ( numBlocks + ( BITS_PER_BYTE - 1U ) ) >> LOG2_BITS_PER_BYTE;
+    #endif
+
+    if( numBlocksRequested == 0U )
+    {
+        /* The rest of the file is received or in flight, wait for the outstanding blocks. */
+        LogDebug( ( "No blocks left to request: Blocks in flight=%u", pAgentCtx->numOfBlocksToReceive ) );
+        result = OtaErrNone;
+    }
+    else
+    {
+        cborEncodeRet = OTA_CBOR_Encode_GetStreamRequestMessage( ( uint8_t * ) pMsg,
+                                                                 sizeof( pMsg ),
+                                                                 &msgSizeFromStream,
+                                                                 OTA_CLIENT_TOKEN,
+                                                                 ( int32_t ) pFileContext->serverFileID,
+                                                                 ( int32_t ) blockSize,
+                                                                 ( int32_t ) blockOffset,
+                                                                 &pFileContext->pRxBlockBitmap[ blockOffset >> LOG2_BITS_PER_BYTE ],
+                                                                 bitmapLen,
+                                                                 ( int32_t ) numBlocksRequested );
+    }
 
     if( cborEncodeRet == true )
     {
@@ -1111,6 +1199,10 @@ OtaErr_t requestFileBlock_Mqtt( OtaAgentContext_t * pAgentCtx )
                        "topic=%s",
                        pTopicBuffer ) );
             result = OtaErrNone;
+
+            #if ( otaconfigBLOCK_REQUEST_WINDOW > 1U )
+                pAgentCtx->numOfBlocksToReceive += numBlocksRequested;
+            #endif
         }
         else
         {
@@ -1120,12 +1212,16 @@ OtaErr_t requestFileBlock_Mqtt( OtaAgentContext_t * pAgentCtx )
                         OTA_MQTT_strerror( mqttStatus ) ) );
         }
     }
-    else
+    else if( numBlocksRequested != 0U )
     {
         result = OtaErrFailedToEncodeCbor;
         LogError( ( "Failed to CBOR encode stream request message: "
                     "OTA_CBOR_Encode_GetStreamRequestMessage returned error." ) );
     }
+    else
+    {
+        /* Nothing was requested. */
+    }
 
     return result;
 }
@@ -1143,15 +1239,41 @@ OtaErr_t decodeFileBlock_Mqtt( const uint8_t * pMessageBuffer,
 {
     OtaErr_t result = OtaErrFailedToDecodeCbor;
     bool cborDecodeRet = false;
-
-    /* Decode the CBOR content. */
-    cborDecodeRet = OTA_CBOR_Decode_GetStreamResponseMessage( pMessageBuffer,
-                                                              messageSize,
-                                                              pFileId,
-                                                              pBlockId,   /* CBOR requires pointer to int and our block indices never exceed 31 bits. */
-                                                              pBlockSize, /* CBOR requires pointer to int and our block sizes never exceed 31 bits. */
-                                                              pPayload,   /* This payload gets malloc'd by OTA_CBOR_Decode_GetStreamResponseMessage(). We must free it. */
-                                                              pPayloadSize );
+    const uint8_t * pBlockData = NULL;
+    size_t blockDataSize = 0;
+
+    /* The stream service always sends a flat map with definite lengths, which
+     * is decoded in a single pass and leaves the payload in the message buffer.
+     * The message buffer stays valid until the agent has written the block. */
+    cborDecodeRet = OTA_CBOR_Decode_GetStreamResponseMessageInPlace( pMessageBuffer,
+                                                                     messageSize,
+                                                                     pFileId,
+                                                                     pBlockId,
+                                                                     pBlockSize,
+                                                                     &pBlockData,
+                                                                     &blockDataSize );
+
+    if( ( cborDecodeRet == true ) &&
+        ( pPayload != NULL ) &&
+        ( pPayloadSize != NULL ) &&
+        ( blockDataSize <= *pPayloadSize ) )
+    {
+        /* The payload is only read by the agent, the cast is needed because the
+         * PAL write function takes a non-const buffer. */
+        *pPayload = ( uint8_t * ) pBlockData;
+        *pPayloadSize = blockDataSize;
+    }
+    else
+    {
+        /* Anything else goes through TinyCBOR, which copies the payload. */
+        cborDecodeRet = OTA_CBOR_Decode_GetStreamResponseMessage( pMessageBuffer,
+                                                                  messageSize,
+                                                                  pFileId,
+                                                                  pBlockId,   /* CBOR requires pointer to int and our block indices never exceed 31 bits. */
+                                                                  pBlockSize, /* CBOR requires pointer to int and our block sizes never exceed 31 bits. */
+                                                                  pPayload,   /* This payload gets malloc'd by OTA_CBOR_Decode_GetStreamResponseMessage(). We must free it. */
+                                                                  pPayloadSize );
+    }
 
     if( cborDecodeRet == true )
     {
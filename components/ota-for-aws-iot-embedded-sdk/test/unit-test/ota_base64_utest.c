@@ -25,7 +25,9 @@
  * @brief Unit tests for functions in ota_base64.c
  */
 
+#include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include "unity.h"
 
 /* For accessing OTA private functions and error codes. */
@@ -150,6 +152,77 @@ void tearDown( void )
 {
 }
 
+/* Size of the decoded data used for the long data and benchmark tests, a signature
+ * sized chunk repeated a few times. */
+#define BASE64_LONG_DATA_DECODED_LEN                                  1500U
+
+/* Room for the encoded long data with a line break after every symbol. */
+#define BASE64_LONG_DATA_ENCODED_BUFFER_SIZE                          ( ( ( BASE64_LONG_DATA_DECODED_LEN + 2U ) / 3U ) * 4U * 3U )
+
+/* Number of times the long data is decoded when timing the decoder. */
+#define BASE64_BENCHMARK_ITERATIONS                                   2000U
+
+/**
+ * @brief Base64 encode data, adding lineBreak after every lineLength symbols.
+ *
+ * @return Length of the encoded data.
+ */
+static size_t encodeTestData( const uint8_t * pData,
+                              size_t dataLen,
+                              char * pEncoded,
+                              size_t lineLength,
+                              const char * lineBreak )
+{
+    static const char symbols[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char quad[ 4 ];
+    size_t encodedLen = 0;
+    size_t numSymbols = 0;
+    size_t i = 0;
+    size_t j = 0;
+
+    for( i = 0; i < dataLen; i += 3U )
+    {
+        uint32_t triple = ( uint32_t ) pData[ i ] << 16;
+
+        triple |= ( i + 1U < dataLen ) ? ( ( uint32_t ) pData[ i + 1U ] << 8 ) : 0U;
+        triple |= ( i + 2U < dataLen ) ? pData[ i + 2U ] : 0U;
+
+        quad[ 0 ] = symbols[ ( triple >> 18 ) & 0x3FU ];
+        quad[ 1 ] = symbols[ ( triple >> 12 ) & 0x3FU ];
+        quad[ 2 ] = ( i + 1U < dataLen ) ? symbols[ ( triple >> 6 ) & 0x3FU ] : '=';
+        quad[ 3 ] = ( i + 2U < dataLen ) ? symbols[ triple & 0x3FU ] : '=';
+
+        for( j = 0; j < 4U; j++ )
+        {
+            pEncoded[ encodedLen++ ] = quad[ j ];
+
+            if( ( lineLength != 0U ) && ( ++numSymbols % lineLength == 0U ) )
+            {
+                memcpy( &pEncoded[ encodedLen ], lineBreak, strlen( lineBreak ) );
+                encodedLen += strlen( lineBreak );
+            }
+        }
+    }
+
+    return encodedLen;
+}
+
+/**
+ * @brief Fill a buffer with data that uses every symbol of the Base64 alphabet.
+ */
+static void fillTestData( uint8_t * pData,
+                          size_t dataLen )
+{
+    uint32_t state = 0x12345678U;
+    size_t i = 0;
+
+    for( i = 0; i < dataLen; i++ )
+    {
+        state = ( state * 1103515245U ) + 12345U;
+        pData[ i ] = ( uint8_t ) ( state >> 16 );
+    }
+}
+
 /* ========================================================================== */
 
 /**
@@ -655,4 +728,107 @@ void test_OTA_base64Decode_InvalidPaddingPlacement( void )
     TEST_ASSERT_EQUAL_INT( Base64InvalidSymbolOrdering, result );
 }
 
+/**
+ * @brief Test that base64Decode decodes long data the same way whether it is
+ *        one unbroken line or broken into lines at any position.
+ */
+void test_OTA_base64Decode_ValidLongDataWithLineBreaks( void )
+{
+    static uint8_t pData[ BASE64_LONG_DATA_DECODED_LEN ];
+    static uint8_t pDecodedResultBuffer[ BASE64_LONG_DATA_DECODED_LEN ];
+    static char pEncoded[ BASE64_LONG_DATA_ENCODED_BUFFER_SIZE ];
+    const size_t lineLengths[] = { 0, 1, 3, 5, 64, 76 };
+    size_t encodedLen = 0;
+    size_t resultLen = 0;
+    size_t dataLen = 0;
+    size_t i = 0;
+    int result = 0;
+
+    fillTestData( pData, sizeof( pData ) );
+
+    /* Cover all three lengths of the last group. */
+    for( dataLen = sizeof( pData ) - 2U; dataLen <= sizeof( pData ); dataLen++ )
+    {
+        for( i = 0; i < sizeof( lineLengths ) / sizeof( lineLengths[ 0 ] ); i++ )
+        {
+            encodedLen = encodeTestData( pData, dataLen, pEncoded, lineLengths[ i ], "\r\n" );
+            resultLen = 0;
+            memset( pDecodedResultBuffer, 0, sizeof( pDecodedResultBuffer ) );
+
+            result = base64Decode( pDecodedResultBuffer,
+                                   sizeof( pDecodedResultBuffer ),
+                                   &resultLen,
+                                   ( const uint8_t * ) pEncoded,
+                                   encodedLen );
+
+            TEST_ASSERT_EQUAL_INT( Base64Success, result );
+            TEST_ASSERT_EQUAL_INT( dataLen, resultLen );
+            TEST_ASSERT_EQUAL_MEMORY( pData, pDecodedResultBuffer, dataLen );
+        }
+    }
+
+    /* An invalid symbol is still reported after many valid groups. */
+    encodedLen = encodeTestData( pData, sizeof( pData ), pEncoded, 0, "" );
+    pEncoded[ encodedLen - 9U ] = '*';
+    result = base64Decode( pDecodedResultBuffer,
+                           sizeof( pDecodedResultBuffer ),
+                           &resultLen,
+                           ( const uint8_t * ) pEncoded,
+                           encodedLen );
+    TEST_ASSERT_EQUAL_INT( Base64InvalidSymbol, result );
+
+    /* So is running out of room part way through. */
+    encodedLen = encodeTestData( pData, sizeof( pData ), pEncoded, 0, "" );
+    result = base64Decode( pDecodedResultBuffer,
+                           sizeof( pDecodedResultBuffer ) - 1U,
+                           &resultLen,
+                           ( const uint8_t * ) pEncoded,
+                           encodedLen );
+    TEST_ASSERT_EQUAL_INT( Base64InvalidBufferSize, result );
+}
+
+/**
+ * @brief Time base64Decode over unbroken data, which is decoded four symbols at
+ *        a time, and over the same data with a line break after every symbol,
+ *        which takes the validating path for every symbol.
+ */
+void test_OTA_base64Decode_Benchmark( void )
+{
+    static uint8_t pData[ BASE64_LONG_DATA_DECODED_LEN ];
+    static uint8_t pDecodedResultBuffer[ BASE64_LONG_DATA_DECODED_LEN ];
+    static char pEncoded[ BASE64_LONG_DATA_ENCODED_BUFFER_SIZE ];
+    const size_t lineLengths[] = { 0, 1 };
+    size_t encodedLen = 0;
+    size_t resultLen = 0;
+    size_t i = 0;
+    uint32_t iteration = 0;
+    clock_t start;
+    int result = 0;
+
+    fillTestData( pData, sizeof( pData ) );
+
+    for( i = 0; i < sizeof( lineLengths ) / sizeof( lineLengths[ 0 ] ); i++ )
+    {
+        encodedLen = encodeTestData( pData, sizeof( pData ), pEncoded, lineLengths[ i ], "\n" );
+        start = clock();
+
+        for( iteration = 0; iteration < BASE64_BENCHMARK_ITERATIONS; iteration++ )
+        {
+            result = base64Decode( pDecodedResultBuffer,
+                                   sizeof( pDecodedResultBuffer ),
+                                   &resultLen,
+                                   ( const uint8_t * ) pEncoded,
+                                   encodedLen );
+            TEST_ASSERT_EQUAL_INT( Base64Success, result );
+        }
+
+        printf( "base64Decode, %s: %u x %u bytes in %.1f ms\n",
+                ( lineLengths[ i ] == 0U ) ? "unbroken" : "broken after every symbol",
+                ( unsigned ) BASE64_BENCHMARK_ITERATIONS,
+                ( unsigned ) encodedLen,
+                ( double ) ( clock() - start ) * 1000.0 / CLOCKS_PER_SEC );
+        TEST_ASSERT_EQUAL_MEMORY( pData, pDecodedResultBuffer, sizeof( pData ) );
+    }
+}
+
 /* ========================================================================== */
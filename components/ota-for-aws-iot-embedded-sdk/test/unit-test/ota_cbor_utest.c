@@ -21,8 +21,11 @@
  */
 
 /* Standard includes. */
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
+#include <time.h>
 
 /* CBOR and OTA includes. */
 #include "ota.h"
@@ -39,6 +42,7 @@
 #define CBOR_TEST_MESSAGE_BUFFER_SIZE    ( OTA_FILE_BLOCK_SIZE * 2 )
 #define CBOR_TEST_BITMAP_VALUE           0xAAAAAAAA
 #define CBOR_TEST_BLOCKIDENTITY_VALUE    0
+#define CBOR_TEST_STREAM_NUM_BLOCKS      256
 
 /* ========================================================================== */
 
@@ -385,3 +389,230 @@ void test_OTA_CborDecodeStreamResponse_InvalidMap()
         &payloadSize );
     TEST_ASSERT_FALSE( result );
 }
+
+/**
+ * @brief Test OTA_CBOR_Decode_GetStreamResponseMessageInPlace() decodes a message
+ * correctly and leaves the payload in the message buffer.
+ *
+ */
+void test_OTA_CborDecodeStreamResponseInPlace()
+{
+    uint8_t blockPayload[ OTA_FILE_BLOCK_SIZE ] = { 0 };
+    uint8_t cborWork[ CBOR_TEST_MESSAGE_BUFFER_SIZE ] = { 0 };
+    size_t encodedSize = 0;
+    int32_t fileId = -1;
+    int32_t blockIndex = -1;
+    int32_t blockSize = -1;
+    const uint8_t * pDecodedPayload = NULL;
+    size_t payloadSize = 0;
+    bool result = false;
+    int i = 0;
+
+    for( i = 0; i < ( int ) sizeof( blockPayload ); i++ )
+    {
+        blockPayload[ i ] = i % UINT8_MAX;
+    }
+
+    result = createOtaStreamingMessage(
+        cborWork,
+        sizeof( cborWork ),
+        CBOR_TEST_BLOCKIDENTITY_VALUE,
+        blockPayload,
+        sizeof( blockPayload ),
+        &encodedSize,
+        true );
+    TEST_ASSERT_EQUAL( CborNoError, result );
+
+    result = OTA_CBOR_Decode_GetStreamResponseMessageInPlace(
+        cborWork,
+        encodedSize,
+        &fileId,
+        &blockIndex,
+        &blockSize,
+        &pDecodedPayload,
+        &payloadSize );
+
+    TEST_ASSERT_TRUE( result );
+    TEST_ASSERT_EQUAL( CBOR_TEST_FILEIDENTITY_VALUE, fileId );
+    TEST_ASSERT_EQUAL( CBOR_TEST_BLOCKIDENTITY_VALUE, blockIndex );
+    TEST_ASSERT_EQUAL( OTA_FILE_BLOCK_SIZE, blockSize );
+    TEST_ASSERT_EQUAL( OTA_FILE_BLOCK_SIZE, payloadSize );
+
+    /* The payload is the tail of the message, it is not copied. */
+    TEST_ASSERT_EQUAL_PTR( &cborWork[ encodedSize - OTA_FILE_BLOCK_SIZE ], pDecodedPayload );
+    TEST_ASSERT_EQUAL_MEMORY( blockPayload, pDecodedPayload, OTA_FILE_BLOCK_SIZE );
+}
+
+/**
+ * @brief Test OTA_CBOR_Decode_GetStreamResponseMessageInPlace() rejects invalid
+ * messages, and messages encoded in ways only TinyCBOR handles.
+ *
+ */
+void test_OTA_CborDecodeStreamResponseInPlace_Invalid()
+{
+    uint8_t blockPayload[ OTA_FILE_BLOCK_SIZE ] = { 0 };
+    uint8_t cborWork[ CBOR_TEST_MESSAGE_BUFFER_SIZE ] = { 0 };
+    uint8_t decodedPayload[ OTA_FILE_BLOCK_SIZE ] = { 0 };
+    uint8_t * pCopiedPayload = decodedPayload;
+    size_t encodedSize = 0;
+    int32_t fileId = -1;
+    int32_t blockIndex = -1;
+    int32_t blockSize = -1;
+    const uint8_t * pDecodedPayload = NULL;
+    size_t payloadSize = 0;
+    CborEncoder cborEncoder, cborMapEncoder;
+    bool result = false;
+
+    /* The file id is a string. */
+    result = createOtaStreamingMessage(
+        cborWork,
+        sizeof( cborWork ),
+        CBOR_TEST_BLOCKIDENTITY_VALUE,
+        blockPayload,
+        sizeof( blockPayload ),
+        &encodedSize,
+        false );
+    TEST_ASSERT_EQUAL( CborNoError, result );
+
+    result = OTA_CBOR_Decode_GetStreamResponseMessageInPlace(
+        cborWork, encodedSize, &fileId, &blockIndex, &blockSize, &pDecodedPayload, &payloadSize );
+    TEST_ASSERT_FALSE( result );
+
+    /* The message is cut short inside the payload. */
+    result = createOtaStreamingMessage(
+        cborWork,
+        sizeof( cborWork ),
+        CBOR_TEST_BLOCKIDENTITY_VALUE,
+        blockPayload,
+        sizeof( blockPayload ),
+        &encodedSize,
+        true );
+    TEST_ASSERT_EQUAL( CborNoError, result );
+
+    result = OTA_CBOR_Decode_GetStreamResponseMessageInPlace(
+        cborWork, encodedSize - 1U, &fileId, &blockIndex, &blockSize, &pDecodedPayload, &payloadSize );
+    TEST_ASSERT_FALSE( result );
+
+    /* NULL parameters. */
+    result = OTA_CBOR_Decode_GetStreamResponseMessageInPlace(
+        NULL, encodedSize, &fileId, &blockIndex, &blockSize, &pDecodedPayload, &payloadSize );
+    TEST_ASSERT_FALSE( result );
+    result = OTA_CBOR_Decode_GetStreamResponseMessageInPlace(
+        cborWork, encodedSize, &fileId, &blockIndex, &blockSize, NULL, &payloadSize );
+    TEST_ASSERT_FALSE( result );
+    result = OTA_CBOR_Decode_GetStreamResponseMessageInPlace(
+        cborWork, encodedSize, &fileId, &blockIndex, &blockSize, &pDecodedPayload, NULL );
+    TEST_ASSERT_FALSE( result );
+
+    /* An array instead of a map. */
+    result = createCborArray( cborWork,
+                              sizeof( cborWork ),
+                              &encodedSize );
+    TEST_ASSERT_EQUAL( CborNoError, result );
+
+    result = OTA_CBOR_Decode_GetStreamResponseMessageInPlace(
+        cborWork, encodedSize, &fileId, &blockIndex, &blockSize, &pDecodedPayload, &payloadSize );
+    TEST_ASSERT_FALSE( result );
+
+    /* A map of indefinite length is valid CBOR, but is left to TinyCBOR. */
+    cbor_encoder_init( &cborEncoder, cborWork, sizeof( cborWork ), 0 );
+    TEST_ASSERT_EQUAL( CborNoError, cbor_encoder_create_map( &cborEncoder, &cborMapEncoder, CborIndefiniteLength ) );
+    TEST_ASSERT_EQUAL( CborNoError, cbor_encode_text_stringz( &cborMapEncoder, OTA_CBOR_FILEID_KEY ) );
+    TEST_ASSERT_EQUAL( CborNoError, cbor_encode_int( &cborMapEncoder, CBOR_TEST_FILEIDENTITY_VALUE ) );
+    TEST_ASSERT_EQUAL( CborNoError, cbor_encode_text_stringz( &cborMapEncoder, OTA_CBOR_BLOCKID_KEY ) );
+    TEST_ASSERT_EQUAL( CborNoError, cbor_encode_int( &cborMapEncoder, 1 ) );
+    TEST_ASSERT_EQUAL( CborNoError, cbor_encode_text_stringz( &cborMapEncoder, OTA_CBOR_BLOCKSIZE_KEY ) );
+    TEST_ASSERT_EQUAL( CborNoError, cbor_encode_int( &cborMapEncoder, sizeof( blockPayload ) ) );
+    TEST_ASSERT_EQUAL( CborNoError, cbor_encode_text_stringz( &cborMapEncoder, OTA_CBOR_BLOCKPAYLOAD_KEY ) );
+    TEST_ASSERT_EQUAL( CborNoError, cbor_encode_byte_string( &cborMapEncoder, blockPayload, sizeof( blockPayload ) ) );
+    TEST_ASSERT_EQUAL( CborNoError, cbor_encoder_close_container( &cborEncoder, &cborMapEncoder ) );
+    encodedSize = cbor_encoder_get_buffer_size( &cborEncoder, cborWork );
+
+    result = OTA_CBOR_Decode_GetStreamResponseMessageInPlace(
+        cborWork, encodedSize, &fileId, &blockIndex, &blockSize, &pDecodedPayload, &payloadSize );
+    TEST_ASSERT_FALSE( result );
+
+    payloadSize = sizeof( decodedPayload );
+    result = OTA_CBOR_Decode_GetStreamResponseMessage(
+        cborWork, encodedSize, &fileId, &blockIndex, &blockSize, &pCopiedPayload, &payloadSize );
+    TEST_ASSERT_TRUE( result );
+    TEST_ASSERT_EQUAL( 1, blockIndex );
+}
+
+/**
+ * @brief Decode a synthetic stream of blocks with both decoders, check that they
+ * agree and report how long each one took.
+ *
+ */
+void test_OTA_CborDecodeStreamResponse_Benchmark()
+{
+    static uint8_t stream[ CBOR_TEST_STREAM_NUM_BLOCKS ][ OTA_FILE_BLOCK_SIZE + 32 ];
+    static size_t messageSize[ CBOR_TEST_STREAM_NUM_BLOCKS ];
+    uint8_t blockPayload[ OTA_FILE_BLOCK_SIZE ] = { 0 };
+    uint8_t decodedPayload[ OTA_FILE_BLOCK_SIZE ] = { 0 };
+    uint8_t * pCopiedPayload = decodedPayload;
+    const uint8_t * pDecodedPayload = NULL;
+    int32_t fileId = -1;
+    int32_t blockIndex = -1;
+    int32_t blockSize = -1;
+    size_t payloadSize = 0;
+    uint32_t checksum[ 2 ] = { 0 };
+    clock_t elapsed[ 2 ] = { 0 };
+    clock_t start;
+    bool result = false;
+    int block = 0;
+    int i = 0;
+
+    for( block = 0; block < CBOR_TEST_STREAM_NUM_BLOCKS; block++ )
+    {
+        for( i = 0; i < ( int ) sizeof( blockPayload ); i++ )
+        {
+            blockPayload[ i ] = ( uint8_t ) ( i + block );
+        }
+
+        result = createOtaStreamingMessage(
+            stream[ block ],
+            sizeof( stream[ block ] ),
+            block,
+            blockPayload,
+            sizeof( blockPayload ),
+            &messageSize[ block ],
+            true );
+        TEST_ASSERT_EQUAL( CborNoError, result );
+    }
+
+    /* TinyCBOR, copying the payload out. */
+    start = clock();
+
+    for( block = 0; block < CBOR_TEST_STREAM_NUM_BLOCKS; block++ )
+    {
+        payloadSize = sizeof( decodedPayload );
+        result = OTA_CBOR_Decode_GetStreamResponseMessage(
+            stream[ block ], messageSize[ block ], &fileId, &blockIndex, &blockSize, &pCopiedPayload, &payloadSize );
+        TEST_ASSERT_TRUE( result );
+        TEST_ASSERT_EQUAL( block, blockIndex );
+        checksum[ 0 ] += pCopiedPayload[ 0 ] + pCopiedPayload[ payloadSize - 1U ];
+    }
+
+    elapsed[ 0 ] = clock() - start;
+
+    /* In place. */
+    start = clock();
+
+    for( block = 0; block < CBOR_TEST_STREAM_NUM_BLOCKS; block++ )
+    {
+        result = OTA_CBOR_Decode_GetStreamResponseMessageInPlace(
+            stream[ block ], messageSize[ block ], &fileId, &blockIndex, &blockSize, &pDecodedPayload, &payloadSize );
+        TEST_ASSERT_TRUE( result );
+        TEST_ASSERT_EQUAL( block, blockIndex );
+        checksum[ 1 ] += pDecodedPayload[ 0 ] + pDecodedPayload[ payloadSize - 1U ];
+    }
+
+    elapsed[ 1 ] = clock() - start;
+
+    TEST_ASSERT_EQUAL( checksum[ 0 ], checksum[ 1 ] );
+    printf( "GetStream response, %d blocks: TinyCBOR %.3f ms, in place %.3f ms\n",
+            CBOR_TEST_STREAM_NUM_BLOCKS,
+            ( double ) elapsed[ 0 ] * 1000.0 / CLOCKS_PER_SEC,
+            ( double ) elapsed[ 1 ] * 1000.0 / CLOCKS_PER_SEC );
+}
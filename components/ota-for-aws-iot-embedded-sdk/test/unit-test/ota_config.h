@@ -38,7 +38,9 @@
 #define otaconfigMAX_NUM_REQUEST_MOMENTUM       3
 
 /* Use larger number of blocks per mqtt request to increase branch coverage. */
-#define otaconfigMAX_NUM_BLOCKS_REQUEST         4
+#ifndef otaconfigMAX_NUM_BLOCKS_REQUEST
+    #define otaconfigMAX_NUM_BLOCKS_REQUEST     4
+#endif
 
 #define LOG_LEVEL_ERROR                         0
 #define LOG_LEVEL_WARN                          1
@@ -0,0 +1,879 @@
+/*
+ * AWS IoT Over-the-air Update v3.0.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file ota_http_utest.c
+ * @brief End to end tests for the HTTP range download.
+ *
+ * The OTA agent runs in its own thread on top of ota_os_posix.c and downloads
+ * the file from an HTTP/1.1 server on the loopback interface. The HTTP
+ * interface keeps one connection open and streams each range response to the
+ * agent one block at a time, like the device port does.
+ */
+
+/* Standard includes. */
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* 3rdparty includes. */
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "unity.h"
+
+/* OTA includes. */
+#include "ota_appversion32.h"
+#include "ota.h"
+#include "ota_private.h"
+#include "ota_os_posix.h"
+
+/* test includes. */
+#include "utest_helpers.h"
+
+/* File served by the HTTP server, the last block is a partial one. */
+#define OTA_TEST_FILE_NUM_BLOCKS        100U
+#define OTA_TEST_FILE_SIZE              ( ( OTA_TEST_FILE_NUM_BLOCKS * OTA_FILE_BLOCK_SIZE ) - 1000U )
+#define OTA_TEST_NUM_RANGES             ( ( OTA_TEST_FILE_NUM_BLOCKS + otaconfigHTTP_MAX_RANGE_BLOCKS - 1U ) / otaconfigHTTP_MAX_RANGE_BLOCKS )
+#define JOB_DOC_HTTP_FORMAT             "{\"clientToken\":\"0:testclient\",\"timestamp\":1602795143,\"execution\":{\"jobId\":\"AFR_OTA-testjob21\",\"status\":\"QUEUED\",\"queuedAt\":1602795128,\"lastUpdatedAt\":1602795128,\"versionNumber\":1,\"executionNumber\":1,\"jobDocument\":{\"afr_ota\":{\"protocols\":[\"HTTP\"],\"files\":[{\"filepath\":\"/test/demo\",\"filesize\":%u,\"fileid\":0,\"certfile\":\"test.crt\",\"update_data_url\":\"http://127.0.0.1:%u/ota.bin\",\"auth_scheme\":\"aws.s3.presigned\",\"sig-sha256-ecdsa\":\"MEQCIF2QDvww1G/kpRGZ8FYvQrok1bSZvXjXefRk7sqNcyPTAiB4dvGt8fozIY5NC0vUDJ2MY42ZERYEcrbwA4n6q7vrBg==\"}] }}}}"
+
+/* OTA application buffer size. */
+#define OTA_UPDATE_FILE_PATH_SIZE       100
+#define OTA_CERT_FILE_PATH_SIZE         100
+#define OTA_STREAM_NAME_SIZE            50
+#define OTA_DECODE_MEMORY_SIZE          OTA_FILE_BLOCK_SIZE
+#define OTA_FILE_BITMAP_SIZE            50
+#define OTA_UPDATE_URL_SIZE             100
+#define OTA_AUTH_SCHEME_SIZE            50
+#define OTA_APP_BUFFER_SIZE       \
+    ( OTA_UPDATE_FILE_PATH_SIZE + \
+      OTA_CERT_FILE_PATH_SIZE +   \
+      OTA_STREAM_NAME_SIZE +      \
+      OTA_DECODE_MEMORY_SIZE +    \
+      OTA_FILE_BITMAP_SIZE +      \
+      OTA_UPDATE_URL_SIZE +       \
+      OTA_AUTH_SCHEME_SIZE )
+
+/* Event buffers shared by the job document and the data blocks. There are
+ * fewer than the posix event queue holds, so the agent always finds room for
+ * the events it sends to itself. */
+#define OTA_TEST_NUM_EVENT_BUFFERS      6U
+
+/* Give up on a download after this long. */
+#define OTA_TEST_DOWNLOAD_TIMEOUT_MS    20000U
+
+/* Longest request or response header accepted. */
+#define OTA_TEST_HTTP_HEADER_SIZE       512U
+
+/* Firmware version. */
+const AppVersion32_t appFirmwareVersion =
+{
+    .u.x.major = 1,
+    .u.x.minor = 0,
+    .u.x.build = 1,
+};
+
+/* OTA code signing signature algorithm. */
+const char OTA_JsonFileSignatureKey[ OTA_FILE_SIG_KEY_STR_MAX_LENGTH ] = "sig-sha256-ecdsa";
+
+/* OTA client name. */
+static const char * pOtaDefaultClientId = "ota_http_utest";
+
+/* OTA interface. */
+static OtaInterfaces_t otaInterfaces;
+
+/* OTA application buffer. */
+static OtaAppBuffer_t pOtaAppBuffer;
+static uint8_t pUserBuffer[ OTA_APP_BUFFER_SIZE ];
+
+/* Image served by the HTTP server and the copy written by the agent. */
+static uint8_t pOtaSourceFile[ OTA_TEST_FILE_SIZE ];
+static uint8_t pOtaFileBuffer[ OTA_TEST_FILE_SIZE ];
+
+/* Pool of event buffers, released by the agent through OtaJobEventProcessed. */
+static OtaEventData_t eventBuffers[ OTA_TEST_NUM_EVENT_BUFFERS ];
+static bool eventBufferUsed[ OTA_TEST_NUM_EVENT_BUFFERS ];
+static pthread_mutex_t eventBufferLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* HTTP server state. */
+static int serverSocket = -1;
+static uint16_t serverPort;
+static uint32_t serverConnections;
+static uint32_t serverRequests;
+static uint32_t serverBytesSent;
+static uint32_t serverDropAfterBytes;
+
+/* HTTP interface state. The client thread serves one range at a time; a new
+ * request replaces the range it is working on. */
+static int clientSocket = -1;
+static uint16_t clientPort;
+static char clientPath[ OTA_UPDATE_URL_SIZE ];
+static uint32_t clientRangeStart;
+static uint32_t clientRangeEnd;
+static uint32_t clientGeneration;
+static uint32_t clientServedGeneration;
+static bool clientStop;
+static bool clientRunning;
+static pthread_t clientThread;
+static pthread_mutex_t clientLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t clientSignal = PTHREAD_COND_INITIALIZER;
+
+/* Download result reported through the application callback. */
+static volatile bool downloadDone;
+static volatile bool downloadFailed;
+
+/* ========================================================================== */
+/* ====================== Unit test helper functions ======================== */
+/* ========================================================================== */
+
+static uint64_t nowUs( void )
+{
+    struct timespec ts;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( ( uint64_t ) ts.tv_sec * 1000000U ) + ( ( uint64_t ) ts.tv_nsec / 1000U );
+}
+
+static OtaEventData_t * eventBufferGet( void )
+{
+    OtaEventData_t * pBuffer = NULL;
+    uint32_t idx = 0;
+
+    pthread_mutex_lock( &eventBufferLock );
+
+    for( idx = 0; idx < OTA_TEST_NUM_EVENT_BUFFERS; idx++ )
+    {
+        if( !eventBufferUsed[ idx ] )
+        {
+            eventBufferUsed[ idx ] = true;
+            pBuffer = &eventBuffers[ idx ];
+            break;
+        }
+    }
+
+    pthread_mutex_unlock( &eventBufferLock );
+
+    return pBuffer;
+}
+
+static void eventBufferFree( const OtaEventData_t * pBuffer )
+{
+    pthread_mutex_lock( &eventBufferLock );
+
+    if( ( pBuffer >= eventBuffers ) && ( pBuffer < eventBuffers + OTA_TEST_NUM_EVENT_BUFFERS ) )
+    {
+        eventBufferUsed[ pBuffer - eventBuffers ] = false;
+    }
+
+    pthread_mutex_unlock( &eventBufferLock );
+}
+
+/* Read a request or response header up to the empty line, return its length
+ * or 0 if the connection closed first. */
+static size_t readHeader( int fd,
+                          char * pHeader )
+{
+    size_t len = 0;
+
+    while( ( len < ( OTA_TEST_HTTP_HEADER_SIZE - 1U ) ) && ( recv( fd, &pHeader[ len ], 1, 0 ) == 1 ) )
+    {
+        len++;
+        pHeader[ len ] = '\0';
+
+        if( ( len >= 4U ) && ( strcmp( &pHeader[ len - 4U ], "\r\n\r\n" ) == 0 ) )
+        {
+            return len;
+        }
+    }
+
+    return 0;
+}
+
+static bool sendAll( int fd,
+                     const void * pData,
+                     size_t len )
+{
+    const uint8_t * pBytes = pData;
+    ssize_t sent = 0;
+
+    while( len > 0U )
+    {
+        sent = send( fd, pBytes, len, MSG_NOSIGNAL );
+
+        if( sent <= 0 )
+        {
+            return false;
+        }
+
+        pBytes += sent;
+        len -= ( size_t ) sent;
+    }
+
+    return true;
+}
+
+/* Answer range requests on one connection until the client closes it. */
+static void serverHandleConnection( int fd )
+{
+    char pHeader[ OTA_TEST_HTTP_HEADER_SIZE ];
+    const char * pRange = NULL;
+    unsigned int start = 0;
+    unsigned int end = 0;
+    uint32_t len = 0;
+
+    while( readHeader( fd, pHeader ) > 0U )
+    {
+        TEST_ASSERT_EQUAL( 0, strncmp( pHeader, "GET /ota.bin HTTP/1.1\r\n", 23 ) );
+        pRange = strstr( pHeader, "\r\nRange: bytes=" );
+        TEST_ASSERT_NOT_NULL( pRange );
+        TEST_ASSERT_EQUAL( 2, sscanf( pRange, "\r\nRange: bytes=%u-%u", &start, &end ) );
+        TEST_ASSERT_TRUE( ( start <= end ) && ( end < OTA_TEST_FILE_SIZE ) );
+
+        /* Ranges start on a block and span whole blocks, except at the end of the file. */
+        TEST_ASSERT_EQUAL( 0, start % OTA_FILE_BLOCK_SIZE );
+        TEST_ASSERT_TRUE( ( ( ( end + 1U ) % OTA_FILE_BLOCK_SIZE ) == 0U ) || ( end == ( OTA_TEST_FILE_SIZE - 1U ) ) );
+        TEST_ASSERT_LESS_OR_EQUAL( otaconfigHTTP_MAX_RANGE_BLOCKS * OTA_FILE_BLOCK_SIZE, end - start + 1U );
+
+        serverRequests++;
+        len = end - start + 1U;
+        ( void ) snprintf( pHeader, sizeof( pHeader ),
+                           "HTTP/1.1 206 Partial Content\r\n"
+                           "Content-Range: bytes %u-%u/%u\r\n"
+                           "Content-Length: %u\r\n"
+                           "\r\n",
+                           start, end, OTA_TEST_FILE_SIZE, len );
+
+        if( !sendAll( fd, pHeader, strlen( pHeader ) ) )
+        {
+            break;
+        }
+
+        /* Lose the connection part way through a response, once. */
+        if( ( serverDropAfterBytes > 0U ) && ( serverDropAfterBytes < len ) )
+        {
+            ( void ) sendAll( fd, &pOtaSourceFile[ start ], serverDropAfterBytes );
+            serverBytesSent += serverDropAfterBytes;
+            serverDropAfterBytes = 0;
+            break;
+        }
+
+        if( !sendAll( fd, &pOtaSourceFile[ start ], len ) )
+        {
+            break;
+        }
+
+        serverBytesSent += len;
+    }
+
+    ( void ) close( fd );
+}
+
+static void * serverTask( void * pArgs )
+{
+    int fd = -1;
+
+    ( void ) pArgs;
+
+    while( ( fd = accept( serverSocket, NULL, NULL ) ) >= 0 )
+    {
+        serverConnections++;
+        serverHandleConnection( fd );
+    }
+
+    return NULL;
+}
+
+static void serverStart( pthread_t * pThread )
+{
+    struct sockaddr_in addr = { 0 };
+    socklen_t addrLen = sizeof( addr );
+
+    serverSocket = socket( AF_INET, SOCK_STREAM, 0 );
+    TEST_ASSERT_TRUE( serverSocket >= 0 );
+
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    addr.sin_port = 0;
+    TEST_ASSERT_EQUAL( 0, bind( serverSocket, ( struct sockaddr * ) &addr, sizeof( addr ) ) );
+    TEST_ASSERT_EQUAL( 0, listen( serverSocket, 1 ) );
+    TEST_ASSERT_EQUAL( 0, getsockname( serverSocket, ( struct sockaddr * ) &addr, &addrLen ) );
+    serverPort = ntohs( addr.sin_port );
+
+    TEST_ASSERT_EQUAL( 0, pthread_create( pThread, NULL, serverTask, NULL ) );
+}
+
+static void serverStop( pthread_t thread )
+{
+    ( void ) shutdown( serverSocket, SHUT_RDWR );
+    ( void ) close( serverSocket );
+    pthread_join( thread, NULL );
+}
+
+static bool clientConnect( void )
+{
+    struct sockaddr_in addr = { 0 };
+
+    clientSocket = socket( AF_INET, SOCK_STREAM, 0 );
+
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    addr.sin_port = htons( clientPort );
+
+    if( ( clientSocket >= 0 ) && ( connect( clientSocket, ( struct sockaddr * ) &addr, sizeof( addr ) ) != 0 ) )
+    {
+        ( void ) close( clientSocket );
+        clientSocket = -1;
+    }
+
+    return clientSocket >= 0;
+}
+
+static void clientDisconnect( void )
+{
+    if( clientSocket >= 0 )
+    {
+        ( void ) close( clientSocket );
+        clientSocket = -1;
+    }
+}
+
+/* Wait for a free event buffer. Returns NULL if the range was replaced in the
+ * meantime. */
+static OtaEventData_t * clientBufferGet( uint32_t generation )
+{
+    OtaEventData_t * pBuffer = NULL;
+
+    while( ( pBuffer = eventBufferGet() ) == NULL )
+    {
+        if( clientGeneration != generation )
+        {
+            return NULL;
+        }
+
+        /* The agent still holds every buffer, let it catch up. */
+        usleep( 100 );
+    }
+
+    return pBuffer;
+}
+
+/* Fetch one range and pass it to the agent block by block. Returns false if
+ * the connection can not be used for the next request. */
+static bool clientFetchRange( uint32_t rangeStart,
+                              uint32_t rangeEnd,
+                              uint32_t generation )
+{
+    char pHeader[ OTA_TEST_HTTP_HEADER_SIZE ];
+    OtaEventMsg_t otaEvent = { 0 };
+    OtaEventData_t * pBuffer = NULL;
+    const char * pLength = NULL;
+    unsigned int contentLength = 0;
+    uint32_t blockLen = 0;
+    ssize_t received = 0;
+
+    ( void ) snprintf( pHeader, sizeof( pHeader ),
+                       "GET %s HTTP/1.1\r\n"
+                       "Host: 127.0.0.1:%u\r\n"
+                       "Range: bytes=%u-%u\r\n"
+                       "\r\n",
+                       clientPath, clientPort, rangeStart, rangeEnd );
+
+    if( !sendAll( clientSocket, pHeader, strlen( pHeader ) ) || ( readHeader( clientSocket, pHeader ) == 0U ) )
+    {
+        return false;
+    }
+
+    TEST_ASSERT_EQUAL( 0, strncmp( pHeader, "HTTP/1.1 206 ", 13 ) );
+    pLength = strstr( pHeader, "\r\nContent-Length: " );
+    TEST_ASSERT_NOT_NULL( pLength );
+    TEST_ASSERT_EQUAL( 1, sscanf( pLength, "\r\nContent-Length: %u", &contentLength ) );
+    TEST_ASSERT_EQUAL( rangeEnd - rangeStart + 1U, contentLength );
+
+    while( contentLength > 0U )
+    {
+        pBuffer = clientBufferGet( generation );
+
+        if( pBuffer == NULL )
+        {
+            /* The rest of this response is not wanted anymore. */
+            return false;
+        }
+
+        /* Read the body straight into the event buffer. */
+        blockLen = ( contentLength < OTA_FILE_BLOCK_SIZE ) ? contentLength : OTA_FILE_BLOCK_SIZE;
+        pBuffer->dataLength = 0;
+
+        while( pBuffer->dataLength < blockLen )
+        {
+            received = recv( clientSocket, &pBuffer->data[ pBuffer->dataLength ], blockLen - pBuffer->dataLength, 0 );
+
+            if( received <= 0 )
+            {
+                eventBufferFree( pBuffer );
+
+                return false;
+            }
+
+            pBuffer->dataLength += ( uint32_t ) received;
+        }
+
+        contentLength -= blockLen;
+
+        pthread_mutex_lock( &clientLock );
+
+        if( clientGeneration != generation )
+        {
+            pthread_mutex_unlock( &clientLock );
+            eventBufferFree( pBuffer );
+
+            return false;
+        }
+
+        otaEvent.eventId = OtaAgentEventReceivedFileBlock;
+        otaEvent.pEventData = pBuffer;
+
+        if( !OTA_SignalEvent( &otaEvent ) )
+        {
+            eventBufferFree( pBuffer );
+        }
+
+        pthread_mutex_unlock( &clientLock );
+    }
+
+    return true;
+}
+
+static void * clientTask( void * pArgs )
+{
+    uint32_t rangeStart = 0;
+    uint32_t rangeEnd = 0;
+    uint32_t generation = 0;
+
+    ( void ) pArgs;
+
+    pthread_mutex_lock( &clientLock );
+
+    while( !clientStop )
+    {
+        if( clientServedGeneration == clientGeneration )
+        {
+            pthread_cond_wait( &clientSignal, &clientLock );
+            continue;
+        }
+
+        rangeStart = clientRangeStart;
+        rangeEnd = clientRangeEnd;
+        generation = clientGeneration;
+        clientServedGeneration = generation;
+        pthread_mutex_unlock( &clientLock );
+
+        if( ( ( clientSocket >= 0 ) || clientConnect() ) &&
+            !clientFetchRange( rangeStart, rangeEnd, generation ) )
+        {
+            /* The request timer of the agent asks for the missing blocks again. */
+            clientDisconnect();
+        }
+
+        pthread_mutex_lock( &clientLock );
+    }
+
+    pthread_mutex_unlock( &clientLock );
+
+    return NULL;
+}
+
+static OtaHttpStatus_t posixHttpInit( char * pUrl )
+{
+    unsigned int port = 0;
+
+    if( sscanf( pUrl, "http://127.0.0.1:%u%99s", &port, clientPath ) != 2 )
+    {
+        return OtaHttpInitFailed;
+    }
+
+    clientPort = ( uint16_t ) port;
+    clientGeneration = 0;
+    clientServedGeneration = 0;
+    clientStop = false;
+    clientRunning = ( pthread_create( &clientThread, NULL, clientTask, NULL ) == 0 );
+
+    return clientRunning ? OtaHttpSuccess : OtaHttpInitFailed;
+}
+
+static OtaHttpStatus_t posixHttpRequest( uint32_t rangeStart,
+                                         uint32_t rangeEnd )
+{
+    pthread_mutex_lock( &clientLock );
+    clientRangeStart = rangeStart;
+    clientRangeEnd = rangeEnd;
+    clientGeneration++;
+    pthread_cond_signal( &clientSignal );
+    pthread_mutex_unlock( &clientLock );
+
+    return OtaHttpSuccess;
+}
+
+static OtaHttpStatus_t posixHttpDeinit()
+{
+    /* The agent cleans up when the file is closed and again on shutdown. */
+    if( !clientRunning )
+    {
+        return OtaHttpSuccess;
+    }
+
+    pthread_mutex_lock( &clientLock );
+    clientStop = true;
+    clientGeneration++;
+    pthread_cond_signal( &clientSignal );
+    pthread_mutex_unlock( &clientLock );
+
+    /* Unblock a receive that waits for the server. */
+    if( clientSocket >= 0 )
+    {
+        ( void ) shutdown( clientSocket, SHUT_RDWR );
+    }
+
+    pthread_join( clientThread, NULL );
+    clientDisconnect();
+    clientRunning = false;
+
+    return OtaHttpSuccess;
+}
+
+static void * agentTask( void * pArgs )
+{
+    OTA_EventProcessingTask( pArgs );
+
+    return NULL;
+}
+
+static OtaMqttStatus_t stubMqttSubscribe( const char * unused_1,
+                                          uint16_t unused_2,
+                                          uint8_t unused_3 )
+{
+    ( void ) unused_1;
+    ( void ) unused_2;
+    ( void ) unused_3;
+
+    return OtaMqttSuccess;
+}
+
+static OtaMqttStatus_t stubMqttUnsubscribe( const char * unused_1,
+                                            uint16_t unused_2,
+                                            uint8_t unused_3 )
+{
+    ( void ) unused_1;
+    ( void ) unused_2;
+    ( void ) unused_3;
+
+    return OtaMqttSuccess;
+}
+
+static OtaMqttStatus_t stubMqttPublish( const char * const unused_1,
+                                        uint16_t unused_2,
+                                        const char * unused_3,
+                                        uint32_t unused_4,
+                                        uint8_t unused_5 )
+{
+    ( void ) unused_1;
+    ( void ) unused_2;
+    ( void ) unused_3;
+    ( void ) unused_4;
+    ( void ) unused_5;
+
+    return OtaMqttSuccess;
+}
+
+OtaPalStatus_t mockPalAbort( OtaFileContext_t * const pFileContext )
+{
+    ( void ) pFileContext;
+
+    return OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
+}
+
+OtaPalStatus_t mockPalCreateFileForRx( OtaFileContext_t * const pFileContext )
+{
+    pFileContext->pFile = ( FILE * ) pOtaFileBuffer;
+
+    return OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
+}
+
+OtaPalStatus_t mockPalCloseFile( OtaFileContext_t * const pFileContext )
+{
+    ( void ) pFileContext;
+
+    return OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
+}
+
+int16_t mockPalWriteBlock( OtaFileContext_t * const pFileContext,
+                           uint32_t offset,
+                           uint8_t * const pData,
+                           uint32_t blockSize )
+{
+    ( void ) pFileContext;
+
+    if( ( offset + blockSize ) > OTA_TEST_FILE_SIZE )
+    {
+        return -1;
+    }
+
+    memcpy( pOtaFileBuffer + offset, pData, blockSize );
+
+    return ( int16_t ) blockSize;
+}
+
+OtaPalStatus_t mockPalActivate( OtaFileContext_t * const pFileContext )
+{
+    ( void ) pFileContext;
+
+    return OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
+}
+
+OtaPalStatus_t mockPalResetDevice( OtaFileContext_t * const pFileContext )
+{
+    ( void ) pFileContext;
+
+    return OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
+}
+
+OtaPalStatus_t mockPalSetPlatformImageState( OtaFileContext_t * const pFileContext,
+                                             OtaImageState_t eState )
+{
+    ( void ) pFileContext;
+    ( void ) eState;
+
+    return OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
+}
+
+OtaPalImageState_t mockPalGetPlatformImageState( OtaFileContext_t * const pFileContext )
+{
+    ( void ) pFileContext;
+
+    return OtaPalImageStateValid;
+}
+
+static void mockAppCallback( OtaJobEvent_t event,
+                             const void * pData )
+{
+    switch( event )
+    {
+        case OtaJobEventProcessed:
+            eventBufferFree( ( const OtaEventData_t * ) pData );
+            break;
+
+        case OtaJobEventActivate:
+            downloadDone = true;
+            break;
+
+        case OtaJobEventFail:
+            downloadFailed = true;
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void otaInterfaceDefault()
+{
+    otaInterfaces.os.event.init = Posix_OtaInitEvent;
+    otaInterfaces.os.event.send = Posix_OtaSendEvent;
+    otaInterfaces.os.event.recv = Posix_OtaReceiveEvent;
+    otaInterfaces.os.event.deinit = Posix_OtaDeinitEvent;
+
+    otaInterfaces.os.timer.start = Posix_OtaStartTimer;
+    otaInterfaces.os.timer.stop = Posix_OtaStopTimer;
+    otaInterfaces.os.timer.delete = Posix_OtaDeleteTimer;
+
+    otaInterfaces.os.mem.malloc = STDC_Malloc;
+    otaInterfaces.os.mem.free = STDC_Free;
+
+    otaInterfaces.mqtt.subscribe = stubMqttSubscribe;
+    otaInterfaces.mqtt.publish = stubMqttPublish;
+    otaInterfaces.mqtt.unsubscribe = stubMqttUnsubscribe;
+
+    otaInterfaces.http.init = posixHttpInit;
+    otaInterfaces.http.deinit = posixHttpDeinit;
+    otaInterfaces.http.request = posixHttpRequest;
+
+    otaInterfaces.pal.abort = mockPalAbort;
+    otaInterfaces.pal.createFile = mockPalCreateFileForRx;
+    otaInterfaces.pal.closeFile = mockPalCloseFile;
+    otaInterfaces.pal.writeBlock = mockPalWriteBlock;
+    otaInterfaces.pal.activate = mockPalActivate;
+    otaInterfaces.pal.reset = mockPalResetDevice;
+    otaInterfaces.pal.setPlatformImageState = mockPalSetPlatformImageState;
+    otaInterfaces.pal.getPlatformImageState = mockPalGetPlatformImageState;
+}
+
+static void otaAppBufferDefault()
+{
+    pOtaAppBuffer.pUpdateFilePath = pUserBuffer;
+    pOtaAppBuffer.updateFilePathsize = OTA_UPDATE_FILE_PATH_SIZE;
+    pOtaAppBuffer.pCertFilePath = pOtaAppBuffer.pUpdateFilePath + pOtaAppBuffer.updateFilePathsize;
+    pOtaAppBuffer.certFilePathSize = OTA_CERT_FILE_PATH_SIZE;
+    pOtaAppBuffer.pStreamName = pOtaAppBuffer.pCertFilePath + pOtaAppBuffer.certFilePathSize;
+    pOtaAppBuffer.streamNameSize = OTA_STREAM_NAME_SIZE;
+    pOtaAppBuffer.pDecodeMemory = pOtaAppBuffer.pStreamName + pOtaAppBuffer.streamNameSize;
+    pOtaAppBuffer.decodeMemorySize = OTA_DECODE_MEMORY_SIZE;
+    pOtaAppBuffer.pFileBitmap = pOtaAppBuffer.pDecodeMemory + pOtaAppBuffer.decodeMemorySize;
+    pOtaAppBuffer.fileBitmapSize = OTA_FILE_BITMAP_SIZE;
+    pOtaAppBuffer.pUrl = pOtaAppBuffer.pFileBitmap + pOtaAppBuffer.fileBitmapSize;
+    pOtaAppBuffer.urlSize = OTA_UPDATE_URL_SIZE;
+    pOtaAppBuffer.pAuthScheme = pOtaAppBuffer.pUrl + pOtaAppBuffer.urlSize;
+    pOtaAppBuffer.authSchemeSize = OTA_AUTH_SCHEME_SIZE;
+}
+
+/* Run one complete download from the HTTP server and return how long it took
+ * in milliseconds, from job document to activation. */
+static uint32_t otaDownload( void )
+{
+    pthread_t agentThread;
+    pthread_t serverThread;
+    OtaEventMsg_t otaEvent = { 0 };
+    OtaEventData_t * pJobDoc = NULL;
+    uint64_t startUs = 0;
+    uint64_t elapsedUs = 0;
+
+    serverStart( &serverThread );
+
+    TEST_ASSERT_EQUAL( OtaErrNone, OTA_Init( &pOtaAppBuffer,
+                                             &otaInterfaces,
+                                             ( const uint8_t * ) pOtaDefaultClientId,
+                                             mockAppCallback ) );
+    TEST_ASSERT_EQUAL( 0, pthread_create( &agentThread, NULL, agentTask, NULL ) );
+
+    otaEvent.eventId = OtaAgentEventStart;
+    TEST_ASSERT_TRUE( OTA_SignalEvent( &otaEvent ) );
+
+    /* The job document only comes in as the answer to the job request. */
+    while( OTA_GetState() != OtaAgentStateWaitingForJob )
+    {
+        usleep( 1000 );
+    }
+
+    /* Hand over the job document as if it was received on the job topic. */
+    pJobDoc = eventBufferGet();
+    TEST_ASSERT_NOT_NULL( pJobDoc );
+    pJobDoc->dataLength = ( uint32_t ) snprintf( ( char * ) pJobDoc->data, sizeof( pJobDoc->data ),
+                                                 JOB_DOC_HTTP_FORMAT, OTA_TEST_FILE_SIZE, serverPort );
+    otaEvent.eventId = OtaAgentEventReceivedJobDocument;
+    otaEvent.pEventData = pJobDoc;
+    startUs = nowUs();
+    TEST_ASSERT_TRUE( OTA_SignalEvent( &otaEvent ) );
+
+    while( !downloadDone && !downloadFailed &&
+           ( ( nowUs() - startUs ) < ( OTA_TEST_DOWNLOAD_TIMEOUT_MS * 1000U ) ) )
+    {
+        usleep( 1000 );
+    }
+
+    elapsedUs = nowUs() - startUs;
+
+    /* Shutting down closes the connection, which ends the server thread. */
+    ( void ) OTA_Shutdown( 0, 1 );
+    pthread_join( agentThread, NULL );
+    serverStop( serverThread );
+
+    TEST_ASSERT_FALSE( downloadFailed );
+    TEST_ASSERT_TRUE_MESSAGE( downloadDone, "Download did not complete in time." );
+    TEST_ASSERT_EQUAL_UINT8_ARRAY( pOtaSourceFile, pOtaFileBuffer, OTA_TEST_FILE_SIZE );
+
+    return ( uint32_t ) ( elapsedUs / 1000U );
+}
+
+/* ========================================================================== */
+/* ================ Unit test setup and tear down functions ================= */
+/* ========================================================================== */
+
+void setUp()
+{
+    uint32_t idx = 0;
+
+    for( idx = 0; idx < OTA_TEST_FILE_SIZE; idx++ )
+    {
+        pOtaSourceFile[ idx ] = ( uint8_t ) ( ( idx * 31U ) + ( idx / OTA_FILE_BLOCK_SIZE ) );
+    }
+
+    memset( pOtaFileBuffer, 0, sizeof( pOtaFileBuffer ) );
+    memset( eventBufferUsed, 0, sizeof( eventBufferUsed ) );
+    serverConnections = 0;
+    serverRequests = 0;
+    serverBytesSent = 0;
+    serverDropAfterBytes = 0;
+    downloadDone = false;
+    downloadFailed = false;
+
+    otaInterfaceDefault();
+    otaAppBufferDefault();
+}
+
+void tearDown()
+{
+    TEST_ASSERT_EQUAL( OtaAgentStateStopped, OTA_GetState() );
+}
+
+/* ========================================================================== */
+/* =============================== Unit tests =============================== */
+/* ========================================================================== */
+
+/**
+ * @brief Download the file over a single connection, with one range request
+ * for every otaconfigHTTP_MAX_RANGE_BLOCKS blocks.
+ */
+void test_OTA_HttpRangeDownloadKeepsConnection()
+{
+    uint32_t elapsedMs = otaDownload();
+
+    printf( "HTTP: %u bytes in %u ms, %u requests on %u connections\n",
+            OTA_TEST_FILE_SIZE, elapsedMs, serverRequests, serverConnections );
+
+    TEST_ASSERT_EQUAL( 1, serverConnections );
+    TEST_ASSERT_EQUAL( OTA_TEST_NUM_RANGES, serverRequests );
+    TEST_ASSERT_EQUAL( OTA_TEST_FILE_SIZE, serverBytesSent );
+}
+
+/**
+ * @brief Lose the connection in the middle of a range and check that the
+ * request timeout reconnects and asks for the missing blocks only.
+ */
+void test_OTA_HttpRangeDownloadResumesAfterDroppedConnection()
+{
+    /* Cut the first response a little over five blocks in. */
+    serverDropAfterBytes = ( 5U * OTA_FILE_BLOCK_SIZE ) + 100U;
+
+    ( void ) otaDownload();
+
+    /* The ranges after the cut start at the first missing block. */
+    TEST_ASSERT_EQUAL( 2, serverConnections );
+    TEST_ASSERT_EQUAL( 1U + ( ( OTA_TEST_FILE_NUM_BLOCKS - 5U + otaconfigHTTP_MAX_RANGE_BLOCKS - 1U ) / otaconfigHTTP_MAX_RANGE_BLOCKS ),
+                       serverRequests );
+
+    /* Only the partial block is sent twice. */
+    TEST_ASSERT_EQUAL( OTA_TEST_FILE_SIZE + 100U, serverBytesSent );
+}
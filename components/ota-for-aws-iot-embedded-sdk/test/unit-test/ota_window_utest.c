@@ -0,0 +1,681 @@
+/*
+ * AWS IoT Over-the-air Update v3.0.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file ota_window_utest.c
+ * @brief End to end tests for the windowed MQTT block download.
+ *
+ * The OTA agent runs in its own thread on top of ota_os_posix.c, and a fake
+ * stream server answers every GetStream request with the requested blocks
+ * after a configurable round trip time.
+ */
+
+/* Standard includes. */
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* 3rdparty includes. */
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "unity.h"
+#include "cbor.h"
+
+/* OTA includes. */
+#include "ota_appversion32.h"
+#include "ota.h"
+#include "ota_private.h"
+#include "ota_cbor_private.h"
+#include "ota_os_posix.h"
+
+/* test includes. */
+#include "utest_helpers.h"
+
+#if ( otaconfigBLOCK_REQUEST_WINDOW <= 1U )
+    #error "ota_window_utest must be built with otaconfigBLOCK_REQUEST_WINDOW larger than 1."
+#endif
+
+/* File served by the fake stream server. */
+#define OTA_TEST_FILE_NUM_BLOCKS        64U
+#define OTA_TEST_FILE_SIZE              ( OTA_TEST_FILE_NUM_BLOCKS * OTA_FILE_BLOCK_SIZE )
+#define OTA_TEST_FILE_SIZE_STR          "262144"
+#define JOB_DOC_WINDOW                  "{\"clientToken\":\"0:testclient\",\"timestamp\":1602795143,\"execution\":{\"jobId\":\"AFR_OTA-testjob20\",\"status\":\"QUEUED\",\"queuedAt\":1602795128,\"lastUpdatedAt\":1602795128,\"versionNumber\":1,\"executionNumber\":1,\"jobDocument\":{\"afr_ota\":{\"protocols\":[\"MQTT\"],\"streamname\":\"AFR_OTA-XYZ\",\"files\":[{\"filepath\":\"/test/demo\",\"filesize\":" OTA_TEST_FILE_SIZE_STR ",\"fileid\":0,\"certfile\":\"test.crt\",\"sig-sha256-ecdsa\":\"MEQCIF2QDvww1G/kpRGZ8FYvQrok1bSZvXjXefRk7sqNcyPTAiB4dvGt8fozIY5NC0vUDJ2MY42ZERYEcrbwA4n6q7vrBg==\"}] }}}}"
+
+/* OTA application buffer size. */
+#define OTA_UPDATE_FILE_PATH_SIZE       100
+#define OTA_CERT_FILE_PATH_SIZE         100
+#define OTA_STREAM_NAME_SIZE            50
+#define OTA_DECODE_MEMORY_SIZE          OTA_FILE_BLOCK_SIZE
+#define OTA_FILE_BITMAP_SIZE            50
+#define OTA_UPDATE_URL_SIZE             100
+#define OTA_AUTH_SCHEME_SIZE            50
+#define OTA_APP_BUFFER_SIZE       \
+    ( OTA_UPDATE_FILE_PATH_SIZE + \
+      OTA_CERT_FILE_PATH_SIZE +   \
+      OTA_STREAM_NAME_SIZE +      \
+      OTA_DECODE_MEMORY_SIZE +    \
+      OTA_FILE_BITMAP_SIZE +      \
+      OTA_UPDATE_URL_SIZE +       \
+      OTA_AUTH_SCHEME_SIZE )
+
+/* Event buffers shared by the job document and the data blocks. There are
+ * fewer than the posix event queue holds, so the agent always finds room for
+ * the events it sends to itself. */
+#define OTA_TEST_NUM_EVENT_BUFFERS      6U
+
+/* Give up on a download after this long. */
+#define OTA_TEST_DOWNLOAD_TIMEOUT_MS    20000U
+
+/* Firmware version. */
+const AppVersion32_t appFirmwareVersion =
+{
+    .u.x.major = 1,
+    .u.x.minor = 0,
+    .u.x.build = 1,
+};
+
+/* OTA code signing signature algorithm. */
+const char OTA_JsonFileSignatureKey[ OTA_FILE_SIG_KEY_STR_MAX_LENGTH ] = "sig-sha256-ecdsa";
+
+/* OTA client name. */
+static const char * pOtaDefaultClientId = "ota_window_utest";
+
+/* OTA interface. */
+static OtaInterfaces_t otaInterfaces;
+
+/* OTA application buffer. */
+static OtaAppBuffer_t pOtaAppBuffer;
+static uint8_t pUserBuffer[ OTA_APP_BUFFER_SIZE ];
+
+/* Image served by the fake stream server and the copy written by the agent. */
+static uint8_t pOtaSourceFile[ OTA_TEST_FILE_SIZE ];
+static uint8_t pOtaFileBuffer[ OTA_TEST_FILE_SIZE ];
+
+/* Pool of event buffers, released by the agent through OtaJobEventProcessed. */
+static OtaEventData_t eventBuffers[ OTA_TEST_NUM_EVENT_BUFFERS ];
+static bool eventBufferUsed[ OTA_TEST_NUM_EVENT_BUFFERS ];
+static pthread_mutex_t eventBufferLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Fake stream server state. A single round trip time applies to every block
+ * so the responses are due in the order they were requested. */
+typedef struct
+{
+    uint32_t blockIndex;
+    uint64_t dueUs;
+} ServerResponse_t;
+
+static ServerResponse_t serverQueue[ OTA_TEST_FILE_NUM_BLOCKS * 4U ];
+static uint32_t serverQueueHead;
+static uint32_t serverQueueTail;
+static uint32_t serverRttMs;
+static uint32_t serverDropInterval;
+static bool serverDropped[ OTA_TEST_FILE_NUM_BLOCKS ];
+static uint32_t serverRequests;
+static uint32_t serverBlocksSent;
+static uint32_t serverBlocksDropped;
+static bool serverStop;
+static pthread_mutex_t serverLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t serverSignal = PTHREAD_COND_INITIALIZER;
+
+/* Download result reported through the application callback. */
+static volatile bool downloadDone;
+static volatile bool downloadFailed;
+
+/* ========================================================================== */
+/* ====================== Unit test helper functions ======================== */
+/* ========================================================================== */
+
+static uint64_t nowUs( void )
+{
+    struct timespec ts;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( ( uint64_t ) ts.tv_sec * 1000000U ) + ( ( uint64_t ) ts.tv_nsec / 1000U );
+}
+
+static OtaEventData_t * eventBufferGet( void )
+{
+    OtaEventData_t * pBuffer = NULL;
+    uint32_t idx = 0;
+
+    pthread_mutex_lock( &eventBufferLock );
+
+    for( idx = 0; idx < OTA_TEST_NUM_EVENT_BUFFERS; idx++ )
+    {
+        if( !eventBufferUsed[ idx ] )
+        {
+            eventBufferUsed[ idx ] = true;
+            pBuffer = &eventBuffers[ idx ];
+            break;
+        }
+    }
+
+    pthread_mutex_unlock( &eventBufferLock );
+
+    return pBuffer;
+}
+
+static void eventBufferFree( const OtaEventData_t * pBuffer )
+{
+    pthread_mutex_lock( &eventBufferLock );
+
+    if( ( pBuffer >= eventBuffers ) && ( pBuffer < eventBuffers + OTA_TEST_NUM_EVENT_BUFFERS ) )
+    {
+        eventBufferUsed[ pBuffer - eventBuffers ] = false;
+    }
+
+    pthread_mutex_unlock( &eventBufferLock );
+}
+
+/* Queue a response for every block marked in the bitmap of a GetStream request. */
+static void serverHandleRequest( const uint8_t * pMsg,
+                                 size_t msgSize )
+{
+    CborParser parser;
+    CborValue map;
+    CborValue value;
+    uint8_t bitmap[ OTA_MAX_BLOCK_BITMAP_SIZE ] = { 0 };
+    size_t bitmapLen = sizeof( bitmap );
+    int offset = 0;
+    int numBlocks = 0;
+    uint32_t bit = 0;
+    uint32_t blockIndex = 0;
+    uint64_t dueUs = nowUs() + ( ( uint64_t ) serverRttMs * 1000U );
+
+    TEST_ASSERT_EQUAL( CborNoError, cbor_parser_init( pMsg, msgSize, 0, &parser, &map ) );
+    TEST_ASSERT_EQUAL( CborNoError, cbor_value_map_find_value( &map, OTA_CBOR_BLOCKOFFSET_KEY, &value ) );
+    TEST_ASSERT_EQUAL( CborNoError, cbor_value_get_int( &value, &offset ) );
+    TEST_ASSERT_EQUAL( CborNoError, cbor_value_map_find_value( &map, OTA_CBOR_NUMBEROFBLOCKS_KEY, &value ) );
+    TEST_ASSERT_EQUAL( CborNoError, cbor_value_get_int( &value, &numBlocks ) );
+    TEST_ASSERT_EQUAL( CborNoError, cbor_value_map_find_value( &map, OTA_CBOR_BLOCKBITMAP_KEY, &value ) );
+    TEST_ASSERT_EQUAL( CborNoError, cbor_value_copy_byte_string( &value, bitmap, &bitmapLen, NULL ) );
+
+    /* Each request covers at most one span of the window. */
+    TEST_ASSERT_LESS_OR_EQUAL( otaconfigMAX_NUM_BLOCKS_REQUEST, numBlocks );
+    TEST_ASSERT_EQUAL( 0, offset % BITS_PER_BYTE );
+
+    pthread_mutex_lock( &serverLock );
+
+    serverRequests++;
+
+    for( bit = 0; ( bit < ( bitmapLen * BITS_PER_BYTE ) ) && ( numBlocks > 0 ); bit++ )
+    {
+        blockIndex = ( uint32_t ) offset + bit;
+
+        if( ( ( bitmap[ bit / BITS_PER_BYTE ] & ( 1U << ( bit % BITS_PER_BYTE ) ) ) == 0U ) ||
+            ( blockIndex >= OTA_TEST_FILE_NUM_BLOCKS ) )
+        {
+            continue;
+        }
+
+        numBlocks--;
+
+        /* Lose every n-th block the first time it is sent. */
+        if( ( serverDropInterval > 0U ) &&
+            ( ( blockIndex % serverDropInterval ) == ( serverDropInterval - 1U ) ) &&
+            !serverDropped[ blockIndex ] )
+        {
+            serverDropped[ blockIndex ] = true;
+            serverBlocksDropped++;
+            continue;
+        }
+
+        TEST_ASSERT_LESS_THAN( sizeof( serverQueue ) / sizeof( serverQueue[ 0 ] ), serverQueueTail );
+        serverQueue[ serverQueueTail ].blockIndex = blockIndex;
+        serverQueue[ serverQueueTail ].dueUs = dueUs;
+        serverQueueTail++;
+    }
+
+    pthread_cond_signal( &serverSignal );
+    pthread_mutex_unlock( &serverLock );
+}
+
+/* Deliver the queued blocks to the agent once their round trip time has passed. */
+static void * serverTask( void * pArgs )
+{
+    uint8_t pStreamingMessage[ OTA_FILE_BLOCK_SIZE * 2 ] = { 0 };
+    size_t streamingMessageSize = 0;
+    OtaEventMsg_t otaEvent = { 0 };
+    OtaEventData_t * pBuffer = NULL;
+    ServerResponse_t response;
+    uint64_t now = 0;
+
+    ( void ) pArgs;
+
+    pthread_mutex_lock( &serverLock );
+
+    while( !serverStop )
+    {
+        now = nowUs();
+
+        if( serverQueueHead == serverQueueTail )
+        {
+            pthread_cond_wait( &serverSignal, &serverLock );
+        }
+        else if( serverQueue[ serverQueueHead ].dueUs > now )
+        {
+            pthread_mutex_unlock( &serverLock );
+            usleep( ( useconds_t ) ( serverQueue[ serverQueueHead ].dueUs - now ) );
+            pthread_mutex_lock( &serverLock );
+        }
+        else if( ( pBuffer = eventBufferGet() ) == NULL )
+        {
+            /* The agent still holds every buffer, let it catch up. */
+            pthread_mutex_unlock( &serverLock );
+            usleep( 100 );
+            pthread_mutex_lock( &serverLock );
+        }
+        else
+        {
+            response = serverQueue[ serverQueueHead++ ];
+            serverBlocksSent++;
+            pthread_mutex_unlock( &serverLock );
+
+            createOtaStreamingMessage( pStreamingMessage,
+                                       sizeof( pStreamingMessage ),
+                                       ( int ) response.blockIndex,
+                                       &pOtaSourceFile[ response.blockIndex * OTA_FILE_BLOCK_SIZE ],
+                                       OTA_FILE_BLOCK_SIZE,
+                                       &streamingMessageSize,
+                                       true );
+
+            memcpy( pBuffer->data, pStreamingMessage, streamingMessageSize );
+            pBuffer->dataLength = streamingMessageSize;
+            otaEvent.eventId = OtaAgentEventReceivedFileBlock;
+            otaEvent.pEventData = pBuffer;
+
+            if( !OTA_SignalEvent( &otaEvent ) )
+            {
+                eventBufferFree( pBuffer );
+            }
+
+            pthread_mutex_lock( &serverLock );
+        }
+    }
+
+    pthread_mutex_unlock( &serverLock );
+
+    return NULL;
+}
+
+static void * agentTask( void * pArgs )
+{
+    OTA_EventProcessingTask( pArgs );
+
+    return NULL;
+}
+
+static OtaMqttStatus_t stubMqttSubscribe( const char * unused_1,
+                                          uint16_t unused_2,
+                                          uint8_t unused_3 )
+{
+    ( void ) unused_1;
+    ( void ) unused_2;
+    ( void ) unused_3;
+
+    return OtaMqttSuccess;
+}
+
+static OtaMqttStatus_t stubMqttUnsubscribe( const char * unused_1,
+                                            uint16_t unused_2,
+                                            uint8_t unused_3 )
+{
+    ( void ) unused_1;
+    ( void ) unused_2;
+    ( void ) unused_3;
+
+    return OtaMqttSuccess;
+}
+
+/* Forward GetStream requests to the fake stream server, drop job updates. */
+static OtaMqttStatus_t mockMqttPublishToServer( const char * const pTopic,
+                                                uint16_t topicLen,
+                                                const char * pMsg,
+                                                uint32_t msgSize,
+                                                uint8_t unused )
+{
+    ( void ) topicLen;
+    ( void ) unused;
+
+    if( ( strstr( pTopic, "/streams/" ) != NULL ) && ( strstr( pTopic, "/get/cbor" ) != NULL ) )
+    {
+        serverHandleRequest( ( const uint8_t * ) pMsg, msgSize );
+    }
+
+    return OtaMqttSuccess;
+}
+
+static OtaHttpStatus_t stubHttpInit( char * url )
+{
+    ( void ) url;
+
+    return OtaHttpSuccess;
+}
+
+static OtaHttpStatus_t stubHttpRequest( uint32_t rangeStart,
+                                        uint32_t rangeEnd )
+{
+    ( void ) rangeEnd;
+    ( void ) rangeStart;
+
+    return OtaHttpSuccess;
+}
+
+static OtaHttpStatus_t stubHttpDeinit()
+{
+    return OtaHttpSuccess;
+}
+
+OtaPalStatus_t mockPalAbort( OtaFileContext_t * const pFileContext )
+{
+    ( void ) pFileContext;
+
+    return OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
+}
+
+OtaPalStatus_t mockPalCreateFileForRx( OtaFileContext_t * const pFileContext )
+{
+    pFileContext->pFile = ( FILE * ) pOtaFileBuffer;
+
+    return OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
+}
+
+OtaPalStatus_t mockPalCloseFile( OtaFileContext_t * const pFileContext )
+{
+    ( void ) pFileContext;
+
+    return OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
+}
+
+int16_t mockPalWriteBlock( OtaFileContext_t * const pFileContext,
+                           uint32_t offset,
+                           uint8_t * const pData,
+                           uint32_t blockSize )
+{
+    ( void ) pFileContext;
+
+    if( ( offset + blockSize ) > OTA_TEST_FILE_SIZE )
+    {
+        return -1;
+    }
+
+    memcpy( pOtaFileBuffer + offset, pData, blockSize );
+
+    return ( int16_t ) blockSize;
+}
+
+OtaPalStatus_t mockPalActivate( OtaFileContext_t * const pFileContext )
+{
+    ( void ) pFileContext;
+
+    return OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
+}
+
+OtaPalStatus_t mockPalResetDevice( OtaFileContext_t * const pFileContext )
+{
+    ( void ) pFileContext;
+
+    return OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
+}
+
+OtaPalStatus_t mockPalSetPlatformImageState( OtaFileContext_t * const pFileContext,
+                                             OtaImageState_t eState )
+{
+    ( void ) pFileContext;
+    ( void ) eState;
+
+    return OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
+}
+
+OtaPalImageState_t mockPalGetPlatformImageState( OtaFileContext_t * const pFileContext )
+{
+    ( void ) pFileContext;
+
+    return OtaPalImageStateValid;
+}
+
+static void mockAppCallback( OtaJobEvent_t event,
+                             const void * pData )
+{
+    switch( event )
+    {
+        case OtaJobEventProcessed:
+            eventBufferFree( ( const OtaEventData_t * ) pData );
+            break;
+
+        case OtaJobEventActivate:
+            downloadDone = true;
+            break;
+
+        case OtaJobEventFail:
+            downloadFailed = true;
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void otaInterfaceDefault()
+{
+    otaInterfaces.os.event.init = Posix_OtaInitEvent;
+    otaInterfaces.os.event.send = Posix_OtaSendEvent;
+    otaInterfaces.os.event.recv = Posix_OtaReceiveEvent;
+    otaInterfaces.os.event.deinit = Posix_OtaDeinitEvent;
+
+    otaInterfaces.os.timer.start = Posix_OtaStartTimer;
+    otaInterfaces.os.timer.stop = Posix_OtaStopTimer;
+    otaInterfaces.os.timer.delete = Posix_OtaDeleteTimer;
+
+    otaInterfaces.os.mem.malloc = STDC_Malloc;
+    otaInterfaces.os.mem.free = STDC_Free;
+
+    otaInterfaces.mqtt.subscribe = stubMqttSubscribe;
+    otaInterfaces.mqtt.publish = mockMqttPublishToServer;
+    otaInterfaces.mqtt.unsubscribe = stubMqttUnsubscribe;
+
+    otaInterfaces.http.init = stubHttpInit;
+    otaInterfaces.http.deinit = stubHttpDeinit;
+    otaInterfaces.http.request = stubHttpRequest;
+
+    otaInterfaces.pal.abort = mockPalAbort;
+    otaInterfaces.pal.createFile = mockPalCreateFileForRx;
+    otaInterfaces.pal.closeFile = mockPalCloseFile;
+    otaInterfaces.pal.writeBlock = mockPalWriteBlock;
+    otaInterfaces.pal.activate = mockPalActivate;
+    otaInterfaces.pal.reset = mockPalResetDevice;
+    otaInterfaces.pal.setPlatformImageState = mockPalSetPlatformImageState;
+    otaInterfaces.pal.getPlatformImageState = mockPalGetPlatformImageState;
+}
+
+static void otaAppBufferDefault()
+{
+    pOtaAppBuffer.pUpdateFilePath = pUserBuffer;
+    pOtaAppBuffer.updateFilePathsize = OTA_UPDATE_FILE_PATH_SIZE;
+    pOtaAppBuffer.pCertFilePath = pOtaAppBuffer.pUpdateFilePath + pOtaAppBuffer.updateFilePathsize;
+    pOtaAppBuffer.certFilePathSize = OTA_CERT_FILE_PATH_SIZE;
+    pOtaAppBuffer.pStreamName = pOtaAppBuffer.pCertFilePath + pOtaAppBuffer.certFilePathSize;
+    pOtaAppBuffer.streamNameSize = OTA_STREAM_NAME_SIZE;
+    pOtaAppBuffer.pDecodeMemory = pOtaAppBuffer.pStreamName + pOtaAppBuffer.streamNameSize;
+    pOtaAppBuffer.decodeMemorySize = OTA_DECODE_MEMORY_SIZE;
+    pOtaAppBuffer.pFileBitmap = pOtaAppBuffer.pDecodeMemory + pOtaAppBuffer.decodeMemorySize;
+    pOtaAppBuffer.fileBitmapSize = OTA_FILE_BITMAP_SIZE;
+    pOtaAppBuffer.pUrl = pOtaAppBuffer.pFileBitmap + pOtaAppBuffer.fileBitmapSize;
+    pOtaAppBuffer.urlSize = OTA_UPDATE_URL_SIZE;
+    pOtaAppBuffer.pAuthScheme = pOtaAppBuffer.pUrl + pOtaAppBuffer.urlSize;
+    pOtaAppBuffer.authSchemeSize = OTA_AUTH_SCHEME_SIZE;
+}
+
+/* Run one complete download against the fake stream server and return how
+ * long it took in milliseconds, from job document to activation. */
+static uint32_t otaDownload( uint32_t rttMs,
+                             uint32_t dropInterval )
+{
+    pthread_t agentThread;
+    pthread_t serverThread;
+    OtaEventMsg_t otaEvent = { 0 };
+    OtaEventData_t * pJobDoc = NULL;
+    uint64_t startUs = 0;
+    uint64_t elapsedUs = 0;
+
+    serverRttMs = rttMs;
+    serverDropInterval = dropInterval;
+
+    TEST_ASSERT_EQUAL( OtaErrNone, OTA_Init( &pOtaAppBuffer,
+                                             &otaInterfaces,
+                                             ( const uint8_t * ) pOtaDefaultClientId,
+                                             mockAppCallback ) );
+    TEST_ASSERT_EQUAL( 0, pthread_create( &agentThread, NULL, agentTask, NULL ) );
+    TEST_ASSERT_EQUAL( 0, pthread_create( &serverThread, NULL, serverTask, NULL ) );
+
+    otaEvent.eventId = OtaAgentEventStart;
+    TEST_ASSERT_TRUE( OTA_SignalEvent( &otaEvent ) );
+
+    /* The job document only comes in as the answer to the job request. */
+    while( OTA_GetState() != OtaAgentStateWaitingForJob )
+    {
+        usleep( 1000 );
+    }
+
+    /* Hand over the job document as if it was received on the job topic. */
+    pJobDoc = eventBufferGet();
+    TEST_ASSERT_NOT_NULL( pJobDoc );
+    memcpy( pJobDoc->data, JOB_DOC_WINDOW, strlen( JOB_DOC_WINDOW ) );
+    pJobDoc->dataLength = strlen( JOB_DOC_WINDOW );
+    otaEvent.eventId = OtaAgentEventReceivedJobDocument;
+    otaEvent.pEventData = pJobDoc;
+    startUs = nowUs();
+    TEST_ASSERT_TRUE( OTA_SignalEvent( &otaEvent ) );
+
+    while( !downloadDone && !downloadFailed &&
+           ( ( nowUs() - startUs ) < ( OTA_TEST_DOWNLOAD_TIMEOUT_MS * 1000U ) ) )
+    {
+        usleep( 1000 );
+    }
+
+    elapsedUs = nowUs() - startUs;
+
+    pthread_mutex_lock( &serverLock );
+    serverStop = true;
+    pthread_cond_signal( &serverSignal );
+    pthread_mutex_unlock( &serverLock );
+    pthread_join( serverThread, NULL );
+
+    ( void ) OTA_Shutdown( 0, 1 );
+    pthread_join( agentThread, NULL );
+
+    TEST_ASSERT_FALSE( downloadFailed );
+    TEST_ASSERT_TRUE_MESSAGE( downloadDone, "Download did not complete in time." );
+    TEST_ASSERT_EQUAL_UINT8_ARRAY( pOtaSourceFile, pOtaFileBuffer, OTA_TEST_FILE_SIZE );
+
+    return ( uint32_t ) ( elapsedUs / 1000U );
+}
+
+/* ========================================================================== */
+/* ================ Unit test setup and tear down functions ================= */
+/* ========================================================================== */
+
+void setUp()
+{
+    uint32_t idx = 0;
+
+    for( idx = 0; idx < OTA_TEST_FILE_SIZE; idx++ )
+    {
+        pOtaSourceFile[ idx ] = ( uint8_t ) ( ( idx * 31U ) + ( idx / OTA_FILE_BLOCK_SIZE ) );
+    }
+
+    memset( pOtaFileBuffer, 0, sizeof( pOtaFileBuffer ) );
+    memset( eventBufferUsed, 0, sizeof( eventBufferUsed ) );
+    memset( serverDropped, 0, sizeof( serverDropped ) );
+    serverQueueHead = 0;
+    serverQueueTail = 0;
+    serverRequests = 0;
+    serverBlocksSent = 0;
+    serverBlocksDropped = 0;
+    serverStop = false;
+    downloadDone = false;
+    downloadFailed = false;
+
+    otaInterfaceDefault();
+    otaAppBufferDefault();
+}
+
+void tearDown()
+{
+    TEST_ASSERT_EQUAL( OtaAgentStateStopped, OTA_GetState() );
+}
+
+/* ========================================================================== */
+/* =============================== Unit tests =============================== */
+/* ========================================================================== */
+
+/**
+ * @brief Download the file over links of increasing round trip time and
+ * check that the window hides most of it.
+ *
+ * With one request outstanding at a time every span of
+ * otaconfigMAX_NUM_BLOCKS_REQUEST blocks costs a full round trip, so the
+ * download can not finish faster than the stop-and-wait bound below.
+ */
+void test_OTA_WindowedDownloadThroughput()
+{
+    static const uint32_t rttMs[] = { 20, 50, 100 };
+    uint32_t stopAndWaitMs = 0;
+    uint32_t elapsedMs = 0;
+    uint32_t idx = 0;
+
+    for( idx = 0; idx < ( sizeof( rttMs ) / sizeof( rttMs[ 0 ] ) ); idx++ )
+    {
+        if( idx > 0U )
+        {
+            setUp();
+        }
+
+        elapsedMs = otaDownload( rttMs[ idx ], 0 );
+        stopAndWaitMs = ( OTA_TEST_FILE_NUM_BLOCKS / otaconfigMAX_NUM_BLOCKS_REQUEST ) * rttMs[ idx ];
+
+        printf( "RTT %3u ms: %u blocks in %u ms (%u KB/s), %u requests, stop-and-wait bound %u ms\n",
+                rttMs[ idx ], OTA_TEST_FILE_NUM_BLOCKS, elapsedMs,
+                ( OTA_TEST_FILE_SIZE / 1024U ) * 1000U / ( elapsedMs + 1U ),
+                serverRequests, stopAndWaitMs );
+
+        /* Every block is sent exactly once on a lossless link. */
+        TEST_ASSERT_EQUAL( OTA_TEST_FILE_NUM_BLOCKS, serverBlocksSent );
+        TEST_ASSERT_LESS_THAN( stopAndWaitMs, elapsedMs );
+    }
+}
+
+/**
+ * @brief Lose some blocks on their first transmission and check that the
+ * request timeout asks again for those blocks only.
+ */
+void test_OTA_WindowedDownloadRetransmitsMissingBlocks()
+{
+    ( void ) otaDownload( 10, 10 );
+
+    TEST_ASSERT_EQUAL( OTA_TEST_FILE_NUM_BLOCKS / 10U, serverBlocksDropped );
+    TEST_ASSERT_EQUAL( OTA_TEST_FILE_NUM_BLOCKS, serverBlocksSent );
+}
@@ -269,6 +269,85 @@ esp_err_t sdmmc_io_get_cis_data(sdmmc_card_t* card, uint8_t* out_buffer, size_t
 esp_err_t sdmmc_io_print_cis_info(uint8_t* buffer, size_t buffer_size, FILE* fp);
 
 
+/**
+ * State of a sequential sector writer
+ *
+ * Filled in by sdmmc_seq_writer_begin. Data passed to sdmmc_seq_writer_write
+ * is staged in a DMA-capable buffer and written to consecutive sectors using
+ * multi-block write commands, one command per full buffer. Members should not
+ * be modified by the application.
+ */
+typedef struct {
+    sdmmc_card_t* card;     /*!< card being written */
+    size_t next_sector;     /*!< sector the staged data will be written to */
+    size_t end_sector;      /*!< one past the last sector of the region */
+    uint8_t* buf;           /*!< DMA-capable staging buffer */
+    size_t buf_size;        /*!< size of the staging buffer, in bytes */
+    size_t buf_fill;        /*!< number of bytes currently staged */
+    uint64_t bytes_written; /*!< bytes accepted by sdmmc_seq_writer_write */
+    int64_t busy_us;        /*!< time spent inside write commands */
+    uint32_t write_cmds;    /*!< number of write commands issued */
+} sdmmc_seq_writer_t;
+
+/**
+ * Start writing sequentially to a range of sectors
+ *
+ * @note Buffer size should be a multiple of the card's erase/allocation
+ *       unit (e.g. 16 or 32 kB) for best throughput.
+ *
+ * @param writer  writer state to initialize
+ * @param card  pointer to card information structure previously initialized
+ *              using sdmmc_card_init
+ * @param start_sector  first sector of the region
+ * @param sector_count  number of sectors in the region
+ * @param buffer_sectors  number of sectors written by each write command
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_ARG if buffer_sectors is zero
+ *      - ESP_ERR_INVALID_SIZE if the region is outside of the card
+ *      - ESP_ERR_NO_MEM if the staging buffer can not be allocated
+ */
+esp_err_t sdmmc_seq_writer_begin(sdmmc_seq_writer_t* writer, sdmmc_card_t* card,
+        size_t start_sector, size_t sector_count, size_t buffer_sectors);
+
+/**
+ * Append data to the region
+ *
+ * Data is copied into the staging buffer; a write command is issued each time
+ * the buffer becomes full. Whole buffers of DMA-capable, word-aligned source
+ * data are written directly without copying when nothing is staged.
+ *
+ * @param writer  writer state initialized by sdmmc_seq_writer_begin
+ * @param src  data to write
+ * @param size  number of bytes to write
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_SIZE if the data does not fit into the region
+ *      - One of the error codes from SDMMC host controller
+ */
+esp_err_t sdmmc_seq_writer_write(sdmmc_seq_writer_t* writer, const void* src, size_t size);
+
+/**
+ * Write out staged data and release the staging buffer
+ *
+ * A trailing partial sector is padded with zeros.
+ *
+ * @param writer  writer state initialized by sdmmc_seq_writer_begin
+ * @return
+ *      - ESP_OK on success
+ *      - One of the error codes from SDMMC host controller
+ */
+esp_err_t sdmmc_seq_writer_end(sdmmc_seq_writer_t* writer);
+
+/**
+ * Get sustained write throughput of a sequential writer
+ *
+ * @param writer  writer state
+ * @return throughput in kB/s, measured over the time spent in write commands;
+ *         0 if nothing was written yet
+ */
+uint32_t sdmmc_seq_writer_get_kbps(const sdmmc_seq_writer_t* writer);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,124 @@
+// Copyright 2015-2018 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sdmmc_common.h"
+#include "esp_timer.h"
+
+static const char* TAG = "sdmmc_seqwrite";
+
+static esp_err_t seq_write_sectors(sdmmc_seq_writer_t* writer, const void* src, size_t sector_count)
+{
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = sdmmc_write_sectors(writer->card, src, writer->next_sector, sector_count);
+    writer->busy_us += esp_timer_get_time() - start;
+    writer->write_cmds++;
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "%s: error 0x%x writing sectors %d+%d",
+                __func__, err, writer->next_sector, sector_count);
+        return err;
+    }
+    writer->next_sector += sector_count;
+    return ESP_OK;
+}
+
+esp_err_t sdmmc_seq_writer_begin(sdmmc_seq_writer_t* writer, sdmmc_card_t* card,
+        size_t start_sector, size_t sector_count, size_t buffer_sectors)
+{
+    if (buffer_sectors == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (start_sector + sector_count > card->csd.capacity) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    size_t sector_size = card->csd.sector_size;
+    // heap_caps_malloc returns word-aligned memory, which is what both
+    // the SDMMC and the SPI DMA engines require
+    uint8_t* buf = heap_caps_malloc(buffer_sectors * sector_size, MALLOC_CAP_DMA);
+    if (buf == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    *writer = (sdmmc_seq_writer_t) {
+        .card = card,
+        .next_sector = start_sector,
+        .end_sector = start_sector + sector_count,
+        .buf = buf,
+        .buf_size = buffer_sectors * sector_size,
+    };
+    return ESP_OK;
+}
+
+esp_err_t sdmmc_seq_writer_write(sdmmc_seq_writer_t* writer, const void* src, size_t size)
+{
+    size_t sector_size = writer->card->csd.sector_size;
+    size_t staged_sectors = (writer->buf_fill + size + sector_size - 1) / sector_size;
+    if (writer->next_sector + staged_sectors > writer->end_sector) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    const uint8_t* cur = (const uint8_t*) src;
+    while (size > 0) {
+        if (writer->buf_fill == 0 && size >= writer->buf_size &&
+                esp_ptr_dma_capable(cur) && ((intptr_t) cur & 3) == 0) {
+            // Nothing staged and the caller's buffer is usable by DMA:
+            // write as many whole buffers as possible straight from it
+            size_t chunk = size - size % writer->buf_size;
+            esp_err_t err = seq_write_sectors(writer, cur, chunk / sector_size);
+            if (err != ESP_OK) {
+                return err;
+            }
+            cur += chunk;
+            size -= chunk;
+            writer->bytes_written += chunk;
+            continue;
+        }
+        size_t copy = MIN(size, writer->buf_size - writer->buf_fill);
+        memcpy(writer->buf + writer->buf_fill, cur, copy);
+        writer->buf_fill += copy;
+        cur += copy;
+        size -= copy;
+        writer->bytes_written += copy;
+        if (writer->buf_fill == writer->buf_size) {
+            esp_err_t err = seq_write_sectors(writer, writer->buf, writer->buf_size / sector_size);
+            if (err != ESP_OK) {
+                return err;
+            }
+            writer->buf_fill = 0;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t sdmmc_seq_writer_end(sdmmc_seq_writer_t* writer)
+{
+    esp_err_t err = ESP_OK;
+    if (writer->buf_fill > 0) {
+        size_t sector_size = writer->card->csd.sector_size;
+        size_t padded = (writer->buf_fill + sector_size - 1) / sector_size * sector_size;
+        memset(writer->buf + writer->buf_fill, 0, padded - writer->buf_fill);
+        err = seq_write_sectors(writer, writer->buf, padded / sector_size);
+        writer->buf_fill = 0;
+    }
+    free(writer->buf);
+    writer->buf = NULL;
+    ESP_LOGD(TAG, "%llu bytes in %u commands, %u kB/s",
+            writer->bytes_written, writer->write_cmds, sdmmc_seq_writer_get_kbps(writer));
+    return err;
+}
+
+uint32_t sdmmc_seq_writer_get_kbps(const sdmmc_seq_writer_t* writer)
+{
+    if (writer->busy_us == 0) {
+        return 0;
+    }
+    return (uint32_t) (writer->bytes_written * 1000000 / writer->busy_us / 1024);
+}
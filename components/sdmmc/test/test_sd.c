@@ -18,6 +18,7 @@
 #include <time.h>
 #include <sys/time.h>
 #include <unistd.h>
+#include <sys/param.h>
 #include "unity.h"
 #include "driver/gpio.h"
 #include "soc/soc_caps.h"
@@ -401,6 +402,60 @@ TEST_CASE("SDMMC read/write test (SD slot 1, in SPI mode)", "[sdspi][test_env=UT
     test_sdspi_deinit_bus(dev_config.host_id);
     sd_test_board_power_off();
 }
+
+static void do_seq_write_test(sdmmc_card_t* card, size_t start_block, size_t block_count,
+        size_t buffer_blocks, size_t write_size)
+{
+    size_t block_size = card->csd.sector_size;
+    size_t total_size = block_size * block_count;
+    uint8_t* data = heap_caps_malloc(total_size, MALLOC_CAP_DMA);
+    TEST_ASSERT_NOT_NULL(data);
+    fill_buffer(start_block, data, total_size / sizeof(uint32_t));
+
+    sdmmc_seq_writer_t writer;
+    TEST_ESP_OK(sdmmc_seq_writer_begin(&writer, card, start_block, block_count, buffer_blocks));
+    for (size_t offset = 0; offset < total_size; offset += write_size) {
+        TEST_ESP_OK(sdmmc_seq_writer_write(&writer, data + offset, MIN(write_size, total_size - offset)));
+    }
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, sdmmc_seq_writer_write(&writer, data, 1));
+    TEST_ESP_OK(sdmmc_seq_writer_end(&writer));
+    printf(" %8d |  %3d  |     %3d      |   %6d   |  %4d  |   %5.2f\n",
+            start_block, block_count, buffer_blocks, write_size, writer.write_cmds,
+            sdmmc_seq_writer_get_kbps(&writer) / 1024.0f);
+
+    memset(data, 0xbb, total_size);
+    TEST_ESP_OK(sdmmc_read_sectors(card, data, start_block, block_count));
+    check_buffer(start_block, data, total_size / sizeof(uint32_t));
+    free(data);
+}
+
+TEST_CASE("SDMMC sequential writer (SD slot 1, in SPI mode)", "[sdspi][test_env=UT_T1_SPIMODE]")
+{
+    sd_test_board_power_on();
+
+    sdspi_dev_handle_t handle;
+    sdspi_device_config_t dev_config = SDSPI_DEVICE_CONFIG_DEFAULT();
+    test_sdspi_init_bus(dev_config.host_id, GPIO_NUM_15, GPIO_NUM_2, GPIO_NUM_14, TEST_SDSPI_DMACHAN);
+    TEST_ESP_OK(sdspi_host_init());
+    TEST_ESP_OK(sdspi_host_init_device(&dev_config, &handle));
+
+    sdmmc_host_t config = SDSPI_HOST_DEFAULT();
+    config.slot = handle;
+
+    sdmmc_card_t* card = malloc(sizeof(sdmmc_card_t));
+    TEST_ASSERT_NOT_NULL(card);
+    TEST_ESP_OK(sdmmc_card_init(&config, card));
+    printf("  sector  | count | buffer(blocks) | write size | cmds  | wr_speed(MB/s)\n");
+    // small appends are staged and written one buffer at a time
+    do_seq_write_test(card, card->csd.capacity/2, 128, 32, 1000);
+    do_seq_write_test(card, card->csd.capacity/2, 128, 64, 1000);
+    // whole buffers of DMA-capable data bypass the staging buffer
+    do_seq_write_test(card, card->csd.capacity/2, 256, 32, 32 * 512);
+    TEST_ESP_OK(sdspi_host_deinit());
+    free(card);
+    test_sdspi_deinit_bus(dev_config.host_id);
+    sd_test_board_power_off();
+}
 #endif //DISABLED_FOR_TARGETS(ESP32S2, ESP32C3)
 
 #if SOC_SDMMC_HOST_SUPPORTED
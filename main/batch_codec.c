@@ -0,0 +1,92 @@
+#include <string.h>
+
+#include "batch_codec.h"
+
+static size_t put_varint(uint8_t *out, uint64_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+static uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static void put_le(uint8_t *out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static size_t encode_fixed(const struct acceldata *records, uint16_t count, uint8_t *out) {
+    uint8_t *ts_col = out;
+    uint8_t *ax_col = ts_col + count * 2;
+    uint8_t *ay_col = ax_col + count * 2;
+    uint8_t *az_col = ay_col + count * 2;
+    long long prev_ts = records[0].ts;
+
+    for (uint16_t i = 0; i < count; i++) {
+        long long delta = records[i].ts - prev_ts;
+        if (delta < 0 || delta > 0xffff) {
+            return 0;
+        }
+        prev_ts = records[i].ts;
+        put_le(ts_col + i * 2, (uint64_t)delta, 2);
+        put_le(ax_col + i * 2, (uint16_t)records[i].ax, 2);
+        put_le(ay_col + i * 2, (uint16_t)records[i].ay, 2);
+        put_le(az_col + i * 2, (uint16_t)records[i].az, 2);
+    }
+    return count * 8;
+}
+
+static size_t encode_varint(const struct acceldata *records, uint16_t count, uint8_t *out) {
+    size_t n = 0;
+    long long prev_ts = records[0].ts;
+
+    for (uint16_t i = 0; i < count; i++) {
+        n += put_varint(out + n, zigzag(records[i].ts - prev_ts));
+        prev_ts = records[i].ts;
+    }
+
+    /* axis columns - offsetof keeps one loop for the three of them */
+    const size_t axis_offset[3] = {
+        offsetof(struct acceldata, ax), offsetof(struct acceldata, ay), offsetof(struct acceldata, az)
+    };
+    for (int axis = 0; axis < 3; axis++) {
+        int32_t prev = 0;
+        for (uint16_t i = 0; i < count; i++) {
+            int16_t value = *(const int16_t *)((const uint8_t *)&records[i] + axis_offset[axis]);
+            n += put_varint(out + n, zigzag((int64_t)value - prev));
+            prev = value;
+        }
+    }
+    return n;
+}
+
+size_t batch_encode(const struct acceldata *records, uint16_t count, uint8_t acc_fs_g, uint8_t flags,
+                    uint8_t *out, size_t out_len) {
+    if (records == NULL || out == NULL || count == 0 || out_len < BATCH_MAX_ENCODED_SIZE(count)) {
+        return 0;
+    }
+
+    out[0] = BATCH_MAGIC_0;
+    out[1] = BATCH_MAGIC_1;
+    out[2] = BATCH_VERSION;
+    out[3] = flags;
+    put_le(out + 4, count, 2);
+    out[6] = acc_fs_g;
+    out[7] = 0;
+    put_le(out + 8, (uint64_t)records[0].ts, 8);
+
+    size_t body;
+    if (flags & BATCH_FLAG_VARINT) {
+        body = encode_varint(records, count, out + BATCH_HEADER_SIZE);
+    } else {
+        body = encode_fixed(records, count, out + BATCH_HEADER_SIZE);
+    }
+    return body == 0 ? 0 : BATCH_HEADER_SIZE + body;
+}
@@ -0,0 +1,230 @@
+#include <string.h>
+#include <stdlib.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/event_groups.h"
+
+#include "esp_log.h"
+#include "mbedtls/sha256.h"
+#include "core2forAWS.h"
+#include "wifi.h"
+#include "sntp_sync.h"
+#include "data_batch.h"
+#include "batch_seal.h"
+
+#define SEAL_QUEUED 2 //seals waiting for the publisher next to the pages
+
+static const char *TAG = "SEAL";
+
+extern QueueHandle_t xQueueBatchData;
+QueueHandle_t xQueueSealedData;
+
+/* the seal being filled, only touched by batch_seal_task */
+static struct {
+    uint8_t leaves[SEAL_MAX_PAGES][SEAL_DIGEST_SIZE];
+    uint8_t count;
+    uint32_t seq;
+    uint8_t prev[SEAL_DIGEST_SIZE];
+    TickType_t opened;
+} seal;
+
+static void put_le32(uint8_t *out, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+/* SHA-256(prefix || a || b), on the hardware SHA engine */
+static void seal_hash(uint8_t prefix, const uint8_t *a, size_t a_len, const uint8_t *b, size_t b_len, uint8_t *out)
+{
+    mbedtls_sha256_context ctx;
+
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts_ret(&ctx, 0);
+    mbedtls_sha256_update_ret(&ctx, &prefix, 1);
+    mbedtls_sha256_update_ret(&ctx, a, a_len);
+    if (b_len > 0) {
+        mbedtls_sha256_update_ret(&ctx, b, b_len);
+    }
+    mbedtls_sha256_finish_ret(&ctx, out);
+    mbedtls_sha256_free(&ctx);
+}
+
+/* reduces the leaves level by level in place, an odd node moves up unchanged */
+static void seal_merkle_root(uint8_t (*nodes)[SEAL_DIGEST_SIZE], int count, uint8_t *root)
+{
+    while (count > 1) {
+        int next = 0;
+        for (int i = 0; i + 1 < count; i += 2) {
+            seal_hash(0x01, nodes[i], SEAL_DIGEST_SIZE, nodes[i + 1], SEAL_DIGEST_SIZE, nodes[next++]);
+        }
+        if (count & 1) {
+            memcpy(nodes[next++], nodes[count - 1], SEAL_DIGEST_SIZE);
+        }
+        count = next;
+    }
+    memcpy(root, nodes[0], SEAL_DIGEST_SIZE);
+}
+
+static void seal_publish(uint8_t *msg)
+{
+    seal_item_t item = { .data = msg, .len = SEAL_SIZE(msg[3]), .kind = SEAL_ITEM_SEAL };
+
+    // never block the secure element task, the pages keep their place in the queue
+    if (!xQueueSend(xQueueSealedData, &item, 0)) {
+        ESP_LOGW(TAG, "Publisher is behind, dropping seal %u", msg[4] | msg[5] << 8 | msg[6] << 16 | msg[7] << 24);
+        free(msg);
+    }
+}
+
+#if CONFIG_SOFTWARE_ATECC608_SUPPORT
+static void seal_signed(ATCA_STATUS status, const uint8_t *signature, void *arg)
+{
+    uint8_t *msg = (uint8_t *)arg;
+
+    if (signature != NULL) {
+        memcpy(msg + 72, signature, 64);
+    } else {
+        ESP_LOGE(TAG, "Signing the seal failed: %02x", status);
+    }
+    seal_publish(msg);
+}
+#endif
+
+static void seal_close(void)
+{
+    uint8_t digest[SEAL_DIGEST_SIZE];
+    uint8_t *msg = calloc(1, SEAL_SIZE(seal.count));
+
+    if (msg == NULL) {
+        // the sequence still moves on, so the verifier sees the missing seal
+        ESP_LOGE(TAG, "Cannot malloc seal %u", seal.seq);
+    } else {
+        msg[0] = SEAL_MAGIC_0;
+        msg[1] = SEAL_MAGIC_1;
+        msg[2] = SEAL_VERSION;
+        msg[3] = seal.count;
+        put_le32(msg + 4, seal.seq);
+        memcpy(msg + 8, seal.prev, SEAL_DIGEST_SIZE);
+        memcpy(msg + SEAL_HEADER_SIZE, seal.leaves, seal.count * SEAL_DIGEST_SIZE);
+        seal_merkle_root(seal.leaves, seal.count, msg + 40);
+
+        // digest of bytes 0..71, everything but the signature and the leaves
+        seal_hash(msg[0], msg + 1, 71, NULL, 0, digest);
+        memcpy(seal.prev, digest, SEAL_DIGEST_SIZE);
+
+        ESP_LOGD(TAG, "Seal %u closed over %u pages", seal.seq, seal.count);
+
+#if CONFIG_SOFTWARE_ATECC608_SUPPORT
+        // signed on the secure element task, the next pages are hashed meanwhile
+        if (Atecc608_SignAsync(SEAL_KEY_SLOT, digest, seal_signed, msg, pdMS_TO_TICKS(1000)) != ATCA_SUCCESS) {
+            ESP_LOGE(TAG, "Cannot queue seal %u for signing", seal.seq);
+            seal_publish(msg);
+        }
+#else
+        ESP_LOGW(TAG, "No secure element, seal %u is unsigned", seal.seq);
+        seal_publish(msg);
+#endif
+    }
+
+    seal.seq++;
+    seal.count = 0;
+}
+
+static void seal_page(batch_page_t *page)
+{
+    if (page->len == 0) {
+        data_batch_release(page->data);
+        return;
+    }
+
+    if (seal.count == 0) {
+        seal.opened = xTaskGetTickCount();
+    }
+
+    // data_batch leaves SEAL_TRAILER_SIZE bytes after every encoded page
+    uint8_t *trailer = page->data + page->len;
+    trailer[0] = SEAL_TRAILER_MAGIC_0;
+    trailer[1] = SEAL_TRAILER_MAGIC_1;
+    trailer[2] = seal.count;
+    trailer[3] = 0;
+    put_le32(trailer + 4, seal.seq);
+    page->len += SEAL_TRAILER_SIZE;
+
+    seal_hash(0x00, page->data, page->len, NULL, 0, seal.leaves[seal.count]);
+    seal.count++;
+
+    seal_item_t item = { .data = page->data, .len = page->len, .kind = SEAL_ITEM_PAGE };
+    xQueueSend(xQueueSealedData, &item, portMAX_DELAY);
+}
+
+void batch_seal_release(const seal_item_t *item)
+{
+    if (item->kind == SEAL_ITEM_PAGE) {
+        data_batch_release(item->data);
+    } else {
+        free(item->data);
+    }
+}
+
+uint8_t *batch_seal_reclaim_page(void)
+{
+    seal_item_t item;
+
+    if (xQueueSealedData == 0) {
+        return NULL;
+    }
+
+    for (UBaseType_t n = uxQueueMessagesWaiting(xQueueSealedData); n > 0; n--) {
+        if (!xQueueReceive(xQueueSealedData, &item, 0)) {
+            break;
+        }
+        if (item.kind == SEAL_ITEM_PAGE) {
+            return item.data;
+        }
+        // seals are small and cover the pages that did get through, keep them
+        if (!xQueueSend(xQueueSealedData, &item, 0)) {
+            free(item.data);
+        }
+    }
+    return NULL;
+}
+
+void batch_seal_task(void *args)
+{
+    xEventGroupWaitBits(wifi_event_group, CONNECTED_BIT, false, true, portMAX_DELAY);
+    xEventGroupWaitBits(sntp_event_group, TIMESET_BIT, false, true, portMAX_DELAY);
+
+    xQueueSealedData = xQueueCreate(BATCH_PAGES + SEAL_QUEUED, sizeof(seal_item_t));
+
+    // created by data_batch_task once it is past the same waits
+    while (xQueueBatchData == 0) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+
+    const TickType_t max_age = pdMS_TO_TICKS(SEAL_MAX_AGE_MS);
+    batch_page_t page;
+
+    while(1){
+
+        TickType_t wait = portMAX_DELAY;
+        if (seal.count > 0) {
+            TickType_t age = xTaskGetTickCount() - seal.opened;
+            wait = age < max_age ? max_age - age : 0;
+        }
+
+        if (xQueueReceive(xQueueBatchData,&page,wait)) {
+            seal_page(&page);
+        }
+
+        if (seal.count == SEAL_MAX_PAGES ||
+            (seal.count > 0 && xTaskGetTickCount() - seal.opened >= max_age)) {
+            seal_close();
+        }
+
+    }
+
+}
@@ -9,30 +9,70 @@
 #include "wifi.h"
 #include "sntp_sync.h"
 #include "data_batch.h"
+#include "batch_codec.h"
+#include "batch_seal.h"
+#include "mpu.h"
+
+/* mpu6886 driver default full scale, MPU6886_AFS_8G */
+#define BATCH_ACC_FS_G 8
+#define BATCH_ENCODED_SIZE BATCH_MAX_ENCODED_SIZE(BUFFER_RECORDS)
+#define BATCH_PAGE_SIZE (BATCH_ENCODED_SIZE + SEAL_TRAILER_SIZE)
 
 static const char *TAG = "DAT";
 
 extern QueueHandle_t xQueueAccelData;
 QueueHandle_t xQueueBatchData;
+static QueueHandle_t xQueueBatchFree;
+
+void data_batch_release(uint8_t *data)
+{
+    xQueueSend(xQueueBatchFree,&data,portMAX_DELAY);
+}
+
+static uint8_t * data_batch_get_page(void)
+{
+    uint8_t * page;
+    if (xQueueReceive(xQueueBatchFree,&page,0)) {
+        return page;
+    }
+    // Publisher is behind - recycle the oldest queued batch rather than stall the IMU
+    batch_page_t oldest;
+    if (xQueueReceive(xQueueBatchData,&oldest,0)) {
+        ESP_LOGW(TAG, "No free page, dropping oldest batch");
+        return oldest.data;
+    }
+    uint8_t * sealed = batch_seal_reclaim_page();
+    if (sealed != NULL) {
+        ESP_LOGW(TAG, "No free page, dropping oldest sealed batch");
+        return sealed;
+    }
+    // Every page is checked out by the publisher, wait for one to come back
+    xQueueReceive(xQueueBatchFree,&page,portMAX_DELAY);
+    return page;
+}
 
 void data_batch_task(void *args) 
 {
     xEventGroupWaitBits(wifi_event_group, CONNECTED_BIT, false, true, portMAX_DELAY);
     xEventGroupWaitBits(sntp_event_group, TIMESET_BIT, false, true, portMAX_DELAY);
     
-    struct acceldata { 
-        long long ts; 
-        float ax,ay,az;   
-    } acceldata1;
+    xQueueBatchData = xQueueCreate(BATCH_PAGES,sizeof(batch_page_t)); 
+    xQueueBatchFree = xQueueCreate(BATCH_PAGES,sizeof(uint8_t *)); 
 
-    xQueueBatchData = xQueueCreate(8,BUFFER_RECORDS*sizeof(struct acceldata)); 
-
-    // Allocate a buffer
-    unsigned char * mqtt_buffer = heap_caps_malloc(BUFFER_RECORDS*sizeof(struct acceldata), MALLOC_CAP_SPIRAM);
-    if (mqtt_buffer == NULL) {
+    // Allocate the staging records and the encoded pages once
+    struct acceldata * records = heap_caps_malloc(BUFFER_RECORDS*sizeof(struct acceldata), MALLOC_CAP_SPIRAM);
+    if (records == NULL) {
         ESP_LOGE(TAG, "Cannot malloc buffer");
         return;
     }
+    for (int i = 0; i < BATCH_PAGES; i++) {
+        uint8_t * page = heap_caps_malloc(BATCH_PAGE_SIZE, MALLOC_CAP_SPIRAM);
+        if (page == NULL) {
+            ESP_LOGE(TAG, "Cannot malloc page %i", i);
+            return;
+        }
+        xQueueSend(xQueueBatchFree,&page,0);
+    }
 
     int cursor = 0;
 
@@ -40,32 +80,23 @@ void data_batch_task(void *args)
 
         if(xQueueAccelData != 0)
         {
-            if (xQueueReceive(xQueueAccelData,&acceldata1,(TickType_t)10))
+            if (xQueueReceive(xQueueAccelData,&records[cursor],(TickType_t)10))
             {
-                // Copy struct to buffer
-                for(size_t i=0; i<sizeof(struct acceldata);i++)
-                {
-                    mqtt_buffer[cursor] = ((unsigned char*)&acceldata1)[i];
-                    cursor++;
-                }
-                
-                // If buffer is full send it to another queue
-                if (cursor ==  BUFFER_RECORDS*sizeof(struct acceldata))
+                cursor++;
+
+                // If staging is full encode it into a free page and send it to another queue
+                if (cursor == BUFFER_RECORDS)
                 {
-                    
-                    ESP_LOGW(TAG, "Buffer full");
-                          
-                    xQueueSend(xQueueBatchData,&mqtt_buffer,portMAX_DELAY);
-                    
-                    cursor = 0;
+                    batch_page_t batch;
+                    batch.data = data_batch_get_page();
+                    batch.len = batch_encode(records, BUFFER_RECORDS, BATCH_ACC_FS_G, BATCH_FLAG_VARINT, 
+                        batch.data, BATCH_ENCODED_SIZE);
 
-                    ESP_LOGW(TAG, "Buffer reset");
+                    ESP_LOGD(TAG, "Batch encoded, %i records in %i bytes", BUFFER_RECORDS, batch.len);
+                    xQueueSend(xQueueBatchData,&batch,portMAX_DELAY);
+
+                    cursor = 0;
                 }
-                
-                char buffer[50];
-                sprintf(buffer, "%lli,%.4f,%.4f,%.4f", acceldata1.ts, acceldata1.ax, acceldata1.ay, acceldata1.az);
-                ESP_LOGD(TAG, "%s", buffer);
-                
             }
         }
 
@@ -0,0 +1,218 @@
+#include <string.h>
+#include "esp_log.h"
+#include "mbedtls/sha256.h"
+#include "sys/param.h"
+#include "delta_patch.h"
+
+static const char *TAG = "DELTA";
+
+enum {
+    ST_HEADER,
+    ST_OP,
+    ST_COPY_OFFSET,
+    ST_LITERAL,
+    ST_DONE,
+    ST_ERROR,
+};
+
+static uint32_t get_u32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool delta_patch_is_patch_file(const char *path) {
+    size_t len = strlen(path);
+    size_t suffix_len = strlen(DELTA_PATCH_FILE_SUFFIX);
+    return len >= suffix_len && strcmp(path + len - suffix_len, DELTA_PATCH_FILE_SUFFIX) == 0;
+}
+
+void delta_patch_begin(delta_patch_t *dp, const esp_partition_t *source, uint32_t out_limit,
+                       delta_patch_out_fn out, void *out_arg) {
+    memset(dp, 0, offsetof(delta_patch_t, buf));
+    dp->source = source;
+    dp->out_limit = out_limit;
+    dp->out = out;
+    dp->out_arg = out_arg;
+    dp->state = ST_HEADER;
+}
+
+static esp_err_t flush(delta_patch_t *dp) {
+    if (dp->buf_fill == 0) {
+        return ESP_OK;
+    }
+    esp_err_t err = dp->out(dp->out_arg, dp->out_pos - dp->buf_fill, dp->buf, dp->buf_fill);
+    dp->buf_fill = 0;
+    return err;
+}
+
+static esp_err_t emit(delta_patch_t *dp, const uint8_t *data, size_t len) {
+    while (len > 0) {
+        size_t n = MIN(len, DELTA_PATCH_BUF_SIZE - dp->buf_fill);
+        memcpy(dp->buf + dp->buf_fill, data, n);
+        dp->buf_fill += n;
+        dp->out_pos += n;
+        data += n;
+        len -= n;
+        if (dp->buf_fill == DELTA_PATCH_BUF_SIZE) {
+            esp_err_t err = flush(dp);
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+// reads straight into the output buffer, no extra copy of the source
+static esp_err_t emit_source(delta_patch_t *dp, uint32_t offset, uint32_t len) {
+    while (len > 0) {
+        size_t n = MIN(len, DELTA_PATCH_BUF_SIZE - dp->buf_fill);
+        esp_err_t err = esp_partition_read(dp->source, offset, dp->buf + dp->buf_fill, n);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to read source at 0x%x, error : %d", offset, err);
+            return err;
+        }
+        dp->buf_fill += n;
+        dp->out_pos += n;
+        offset += n;
+        len -= n;
+        if (dp->buf_fill == DELTA_PATCH_BUF_SIZE) {
+            err = flush(dp);
+            if (err != ESP_OK) {
+                return err;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+static esp_err_t check_header(delta_patch_t *dp) {
+    const uint8_t *h = dp->header;
+    if (h[0] != DELTA_PATCH_MAGIC_0 || h[1] != DELTA_PATCH_MAGIC_1 || h[2] != DELTA_PATCH_MAGIC_2 ||
+        h[3] != DELTA_PATCH_VERSION) {
+        ESP_LOGE(TAG, "Not a delta patch");
+        return ESP_ERR_INVALID_VERSION;
+    }
+    dp->source_size = get_u32(h + 4);
+    dp->target_size = get_u32(h + 8);
+    if (dp->source_size > dp->source->size || dp->target_size > dp->out_limit) {
+        ESP_LOGE(TAG, "Patch sizes %u -> %u do not fit", dp->source_size, dp->target_size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // the ops are meaningless against any other image, so make sure we run the one it was made for
+    mbedtls_sha256_context sha;
+    uint8_t digest[32];
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts_ret(&sha, 0);
+    for (uint32_t pos = 0; pos < dp->source_size; pos += DELTA_PATCH_BUF_SIZE) {
+        size_t n = MIN(DELTA_PATCH_BUF_SIZE, dp->source_size - pos);
+        esp_err_t err = esp_partition_read(dp->source, pos, dp->buf, n);
+        if (err != ESP_OK) {
+            mbedtls_sha256_free(&sha);
+            return err;
+        }
+        mbedtls_sha256_update_ret(&sha, dp->buf, n);
+    }
+    mbedtls_sha256_finish_ret(&sha, digest);
+    mbedtls_sha256_free(&sha);
+    if (memcmp(digest, h + 12, sizeof(digest)) != 0) {
+        ESP_LOGE(TAG, "Patch was made for a different source image");
+        return ESP_ERR_INVALID_STATE;
+    }
+    ESP_LOGI(TAG, "Applying patch %u -> %u bytes", dp->source_size, dp->target_size);
+    return ESP_OK;
+}
+
+// returns true once the varint is complete
+static bool varint_step(delta_patch_t *dp, uint8_t byte, esp_err_t *err) {
+    if (dp->varint_shift > 28) {
+        *err = ESP_ERR_INVALID_SIZE;
+        return false;
+    }
+    dp->varint |= (uint32_t)(byte & 0x7f) << dp->varint_shift;
+    dp->varint_shift += 7;
+    return byte < 0x80;
+}
+
+static void next_op(delta_patch_t *dp) {
+    dp->varint = 0;
+    dp->varint_shift = 0;
+    dp->state = dp->out_pos == dp->target_size ? ST_DONE : ST_OP;
+}
+
+esp_err_t delta_patch_feed(delta_patch_t *dp, const uint8_t *data, size_t len) {
+    esp_err_t err = ESP_OK;
+    while (len > 0 && err == ESP_OK) {
+        size_t used = 1;
+        switch (dp->state) {
+        case ST_HEADER:
+            used = MIN(len, DELTA_PATCH_HEADER_SIZE - dp->patch_pos);
+            memcpy(dp->header + dp->patch_pos, data, used);
+            if (dp->patch_pos + used == DELTA_PATCH_HEADER_SIZE) {
+                err = check_header(dp);
+                next_op(dp);
+            }
+            break;
+        case ST_OP:
+            if (varint_step(dp, *data, &err)) {
+                dp->op_len = dp->varint >> 1;
+                if (dp->op_len == 0 || dp->op_len > dp->target_size - dp->out_pos) {
+                    ESP_LOGE(TAG, "Op of %u bytes at target offset %u", dp->op_len, dp->out_pos);
+                    err = ESP_ERR_INVALID_SIZE;
+                }
+                dp->state = (dp->varint & 1) ? ST_COPY_OFFSET : ST_LITERAL;
+                dp->varint = 0;
+                dp->varint_shift = 0;
+            }
+            break;
+        case ST_COPY_OFFSET:
+            if (varint_step(dp, *data, &err)) {
+                // zig-zag, wraps like the signed delta it encodes
+                uint32_t src = dp->src_pos + ((dp->varint >> 1) ^ -(dp->varint & 1));
+                if (src > dp->source_size || dp->op_len > dp->source_size - src) {
+                    ESP_LOGE(TAG, "Copy of %u bytes from %u is outside the source", dp->op_len, src);
+                    err = ESP_ERR_INVALID_SIZE;
+                    break;
+                }
+                err = emit_source(dp, src, dp->op_len);
+                dp->src_pos = src + dp->op_len;
+                next_op(dp);
+            }
+            break;
+        case ST_LITERAL:
+            used = MIN(len, dp->op_len);
+            err = emit(dp, data, used);
+            dp->op_len -= used;
+            if (dp->op_len == 0) {
+                next_op(dp);
+            }
+            break;
+        case ST_DONE:
+            ESP_LOGE(TAG, "Trailing data after the target image");
+            err = ESP_ERR_INVALID_SIZE;
+            break;
+        default:
+            err = ESP_FAIL;
+            break;
+        }
+        dp->patch_pos += used;
+        data += used;
+        len -= used;
+    }
+    if (err != ESP_OK) {
+        dp->state = ST_ERROR;
+    }
+    return err;
+}
+
+esp_err_t delta_patch_finish(delta_patch_t *dp) {
+    if (dp->state != ST_DONE) {
+        ESP_LOGE(TAG, "Patch ended after %u of %u target bytes", dp->out_pos, dp->target_size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    esp_err_t err = flush(dp);
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "%u byte patch rebuilt %u byte image", dp->patch_pos, dp->out_pos);
+    }
+    return err;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "mpu.h"
+
+/*
+ * Columnar accelerometer batch, little-endian:
+ *
+ *   0  'A' 'B'          magic
+ *   2  u8               version
+ *   3  u8               flags (BATCH_FLAG_*)
+ *   4  u16              record count
+ *   6  u8               accelerometer full scale in G (LSB = fs / 32768)
+ *   7  u8               reserved
+ *   8  i64              timestamp of the first record (ms)
+ *  16  ts column        delta to the previous timestamp
+ *      ax, ay, az       one column per axis
+ *
+ * Fixed layout: u16 timestamp deltas, raw i16 axis values.
+ * BATCH_FLAG_VARINT: every column is zig-zag LEB128 of the delta to the
+ * previous value of the same column (first delta against t0 / 0).
+ */
+#define BATCH_MAGIC_0 'A'
+#define BATCH_MAGIC_1 'B'
+#define BATCH_VERSION 1
+#define BATCH_FLAG_VARINT 0x01
+#define BATCH_HEADER_SIZE 16
+
+/* worst case - 10 byte timestamp varint and three 3 byte axis varints per record */
+#define BATCH_MAX_ENCODED_SIZE(count) (BATCH_HEADER_SIZE + (size_t)(count) * 19)
+
+/* returns the encoded length, 0 if out_len is too small or a fixed-layout delta overflows */
+size_t batch_encode(const struct acceldata *records, uint16_t count, uint8_t acc_fs_g, uint8_t flags,
+                    uint8_t *out, size_t out_len);
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Tamper-evident telemetry. batch_seal_task takes the encoded pages of
+ * data_batch_task, appends a trailer and forwards them to the publisher right
+ * away. Every SEAL_MAX_PAGES pages (or SEAL_MAX_AGE_MS) the SHA-256 of the
+ * pages become the leaves of a Merkle tree and only its root is signed, by the
+ * device key in the ATECC608 (slot SEAL_KEY_SLOT), in a seal item that follows
+ * the pages. Each seal chains the digest of the previous one, so dropped or
+ * replayed seals show up as well.
+ *
+ * Page trailer, appended to the batch_codec page:
+ *
+ *   0  'S' 'L'          magic
+ *   2  u8               leaf index in the seal
+ *   3  u8               reserved
+ *   4  u32              seal sequence number
+ *
+ * Seal, little-endian:
+ *
+ *   0  'S' 'E'          magic
+ *   2  u8               version
+ *   3  u8               leaf count
+ *   4  u32              sequence number, 0 after boot
+ *   8  u8[32]           digest of the previous seal, zero for sequence 0
+ *  40  u8[32]           Merkle root
+ *  72  u8[64]           ECDSA P-256 signature (R, S) of the digest
+ * 136  u8[32]           leaves, one per page
+ *
+ * digest = SHA-256 of bytes 0..71. leaf = SHA-256(0x00 || page with trailer),
+ * node = SHA-256(0x01 || left || right), an odd node moves up unchanged. A page
+ * is proven by its leaf and the log2(count) siblings on its path to the root,
+ * all of which follow from the leaves of its seal (see utilities/batch_seal.py).
+ */
+#define SEAL_MAGIC_0 'S'
+#define SEAL_MAGIC_1 'E'
+#define SEAL_VERSION 1
+#define SEAL_HEADER_SIZE 136
+#define SEAL_DIGEST_SIZE 32
+#define SEAL_SIZE(count) (SEAL_HEADER_SIZE + (size_t)(count) * SEAL_DIGEST_SIZE)
+
+#define SEAL_TRAILER_MAGIC_0 'S'
+#define SEAL_TRAILER_MAGIC_1 'L'
+#define SEAL_TRAILER_SIZE 8
+
+#define SEAL_MAX_PAGES 16 //pages per signature, 64 s of records at 4 s per page
+#define SEAL_MAX_AGE_MS (SEAL_MAX_PAGES * 4000)
+#define SEAL_KEY_SLOT 0 //device key, the same one the MQTT TLS connection uses
+
+#define SEAL_ITEM_PAGE 0
+#define SEAL_ITEM_SEAL 1
+
+/* item of xQueueSealedData - hand it back with batch_seal_release() once published */
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    uint8_t kind; //SEAL_ITEM_*
+} seal_item_t;
+
+void batch_seal_task(void *args);
+void batch_seal_release(const seal_item_t *item);
+
+/* oldest page still waiting for the publisher, NULL if none - for data_batch to recycle */
+uint8_t *batch_seal_reclaim_page(void);
@@ -1,3 +1,17 @@
-#define BUFFER_RECORDS 50*4*2 //50 Hz, 4 seconds ~ 5 KB. Each message is 24 bytes 
+#include <stdint.h>
+#include <stddef.h>
 
-void data_batch_task(void *args);
\ No newline at end of file
+#define BUFFER_RECORDS 500*4 //500 Hz, 4 seconds. Encoded with batch_codec, ~5 bytes per record
+#define BATCH_PAGES 4 //encoded pages in flight between data_batch_task and the publisher
+
+/*
+ * item of xQueueBatchData - hand the page back with data_batch_release() once published.
+ * Pages have room for a SEAL_TRAILER_SIZE trailer after len, see batch_seal.h.
+ */
+typedef struct {
+    uint8_t *data;
+    size_t len;
+} batch_page_t;
+
+void data_batch_task(void *args);
+void data_batch_release(uint8_t *data);
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "esp_partition.h"
+
+/*
+ * Binary delta against the running firmware, produced by utilities/delta_patch.py.
+ * Little-endian:
+ *
+ *   0  'E' 'D' 'P'      magic
+ *   3  u8               version
+ *   4  u32              source image size
+ *   8  u32              target image size
+ *  12  u8[32]           SHA-256 of the source image
+ *  44  ops              until target size bytes have been produced
+ *
+ * Every op starts with the LEB128 varint (len << 1 | copy):
+ *   copy     zig-zag varint source offset, relative to the end of the previous
+ *            copy - then len bytes are copied from the running partition
+ *   literal  len bytes follow in the patch
+ *
+ * Jobs whose file path ends in DELTA_PATCH_FILE_SUFFIX are applied by ota_pal.c.
+ */
+#define DELTA_PATCH_MAGIC_0 'E'
+#define DELTA_PATCH_MAGIC_1 'D'
+#define DELTA_PATCH_MAGIC_2 'P'
+#define DELTA_PATCH_VERSION 1
+#define DELTA_PATCH_HEADER_SIZE 44
+#define DELTA_PATCH_FILE_SUFFIX ".dpatch"
+#define DELTA_PATCH_BUF_SIZE 4096 //one flash sector of output per write
+
+/* called with consecutive chunks of the reconstructed image */
+typedef esp_err_t (*delta_patch_out_fn)(void *arg, uint32_t offset, const uint8_t *data, size_t len);
+
+typedef struct {
+    const esp_partition_t *source;
+    uint32_t out_limit;         // largest target image the caller has room for
+    delta_patch_out_fn out;
+    void *out_arg;
+
+    uint8_t state;
+    uint8_t header[DELTA_PATCH_HEADER_SIZE];
+    uint32_t source_size;
+    uint32_t target_size;
+    uint32_t patch_pos;         // patch bytes consumed
+    uint32_t src_pos;           // end of the previous copy
+    uint32_t out_pos;           // target bytes produced, flushed or not
+    uint32_t op_len;            // bytes left in the current literal
+    uint32_t varint;
+    uint8_t varint_shift;
+
+    uint32_t buf_fill;
+    uint8_t buf[DELTA_PATCH_BUF_SIZE];
+} delta_patch_t;
+
+bool delta_patch_is_patch_file(const char *path);
+
+void delta_patch_begin(delta_patch_t *dp, const esp_partition_t *source, uint32_t out_limit,
+                       delta_patch_out_fn out, void *out_arg);
+/* patch bytes must be fed in order; the source image is checked once the header is in */
+esp_err_t delta_patch_feed(delta_patch_t *dp, const uint8_t *data, size_t len);
+/* flushes the last output, fails unless the whole target image was produced */
+esp_err_t delta_patch_finish(delta_patch_t *dp);
@@ -1 +1,17 @@
-void mic_task(void *args);
\ No newline at end of file
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define MIC_SAMPLE_RATE 16000 //16 bit mono
+#define MIC_BUFF_SIZE 64*1000 //2 seconds of audio per buffer
+#define MIC_POOL_BUFFERS 8 //capture buffers allocated once in PSRAM, shared by mic_task and the consumer
+
+/* item of xQueueMicData - hand the buffer back with mic_buffer_release() when done */
+typedef struct {
+    int8_t *data;
+    size_t len;
+} mic_buffer_t;
+
+void mic_task(void *args);
+void mic_buffer_release(int8_t *data);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "esp_partition.h"
+#include "esp_spi_flash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Model flatbuffers in the "model" data partition, two slots of half the partition
+ * each. A slot is its header sector followed by the flatbuffer:
+ *
+ *   0  u32              MODEL_STORE_MAGIC, zeroed to retire a slot
+ *   4  u32              version, one more than the slot it replaced
+ *   8  u32              flatbuffer length
+ *  12  u8[32]           SHA-256 of the flatbuffer
+ *
+ * The header is written last, so a slot only becomes valid once the whole model
+ * is in flash. The valid slot with the highest version is used; without one,
+ * the model compiled into the app is.
+ *
+ * OTA files with fileType otaconfigMODEL_FILE_TYPE_ID are written here by ota_pal.c.
+ */
+#define MODEL_STORE_SUBTYPE 0x40
+#define MODEL_STORE_MAGIC 0x4c444f4d // "MODL"
+#define MODEL_STORE_DATA_OFFSET SPI_FLASH_SEC_SIZE
+
+/* the newest valid slot becomes the pending model, picked up by the first take */
+esp_err_t model_store_init(void);
+
+/*
+ * Inference side. Returns a newly committed model, or NULL. Until
+ * model_store_finish_switch() both the new and the old model stay mapped; a
+ * rejected model is retired in flash and the old one stays in use.
+ */
+const uint8_t *model_store_take_pending(uint32_t *version);
+void model_store_finish_switch(bool accepted);
+
+/* OTA side. The flatbuffer is written to *offset in *partition between begin and commit. */
+esp_err_t model_store_begin(uint32_t len, const esp_partition_t **partition, uint32_t *offset);
+esp_err_t model_store_commit(uint32_t len);
+void model_store_abort(void);
+
+#ifdef __cplusplus
+}
+#endif
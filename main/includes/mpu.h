@@ -1 +1,15 @@
-void mpu_task(void *args);
\ No newline at end of file
+#pragma once
+
+#include <stdint.h>
+
+/* IMU sample clock and FIFO watermark - 500 Hz drained every 50 ms */
+#define MPU_SAMPLE_RATE_HZ 500
+#define MPU_FIFO_WATERMARK 25
+
+/* Raw accelerometer record - scale with MPU6886_GetAccRes() */
+struct acceldata { 
+    long long ts; 
+    int16_t ax,ay,az;   
+};
+
+void mpu_task(void *args);
@@ -106,7 +106,26 @@
  * based on how many data blocks response is expected for each data requests.
  * @note This must be set larger than zero.
  */
-#define otaconfigMAX_NUM_BLOCKS_REQUEST         1U
+#define otaconfigMAX_NUM_BLOCKS_REQUEST         8U
+
+/**
+ * @brief The number of data block requests kept in flight.
+ *
+ * Two requests of 8 blocks keep up to 64 KB on the way, so the download is no
+ * longer paced by one MQTT round trip per request. Only blocks still missing
+ * from the receive bitmap are requested again after a timeout.
+ * @note otaconfigMAX_NUM_BLOCKS_REQUEST must be a multiple of 8 when this is
+ * larger than 1.
+ */
+#define otaconfigBLOCK_REQUEST_WINDOW           2U
+
+/**
+ * @brief The maximum number of data blocks fetched with one HTTP range request.
+ *
+ * 32 blocks of 4 KB are one 128 KB range on the kept-alive connection; the body
+ * is handed to the agent block by block, waiting for free data buffers.
+ */
+#define otaconfigHTTP_MAX_RANGE_BLOCKS          32U
 
 /**
  * @brief The maximum number of requests allowed to send without a response before
@@ -123,7 +142,7 @@
  * This configurations parameter sets the maximum number of static data buffers used by
  * the OTA agent for job and file data blocks received.
  */
-#define otaconfigMAX_NUM_OTA_DATA_BUFFERS       otaconfigMAX_NUM_BLOCKS_REQUEST + 1
+#define otaconfigMAX_NUM_OTA_DATA_BUFFERS       ( ( otaconfigMAX_NUM_BLOCKS_REQUEST * otaconfigBLOCK_REQUEST_WINDOW ) + 1U )
 
 /**
  * @brief How frequently the device will report its OTA progress to the cloud.
@@ -144,6 +163,15 @@
  */
 #define otaconfigAllowDowngrade                 0U
 
+/**
+ * @brief The file type ID of model updates.
+ *
+ * Files created with this fileType in the OTA job are model flatbuffers. They are
+ * written to the model partition and switched to without a reboot, see model_store.h.
+ * Firmware keeps configOTA_FIRMWARE_UPDATE_FILE_TYPE_ID (0).
+ */
+#define otaconfigMODEL_FILE_TYPE_ID             1U
+
 /**
  * @brief The protocol selected for OTA control operations.
  *
@@ -169,7 +197,7 @@
  * @note To enable data over HTTP, you must remove `AWSIOT_NETWORK_TYPE_BLE` from
  * `configENABLED_NETWORKS` in `aws_iot_network_config.h`
  */
-#define configENABLED_DATA_PROTOCOLS            ( OTA_DATA_OVER_MQTT )
+#define configENABLED_DATA_PROTOCOLS            ( OTA_DATA_OVER_MQTT | OTA_DATA_OVER_HTTP )
 
 /**
  * @brief The preferred protocol selected for OTA data operations.
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "esp_err.h"
+#include "ff.h"
+#include "sdmmc_cmd.h"
+
+/* FATFS drive the card is registered as by Core2ForAWS_SDcard_Mount - it is the only FAT volume */
+#define SD_SEQFILE_DRIVE "0:"
+#define SD_SEQFILE_BUF_SECTORS 32 //16 KB per multi-block write, one FAT cluster
+
+/*
+ * A file whose clusters are reserved up front as one contiguous run, then filled
+ * with raw multi-block writes that bypass FATFS. The FAT and directory entry are
+ * only touched on open and close, never while streaming.
+ *
+ * Every call talks to the card - the caller holds the SPI bus (spi_bus_acquire) around it.
+ */
+typedef struct {
+    FIL fil;
+    sdmmc_seq_writer_t writer;
+    uint32_t capacity;  // bytes reserved on open
+    uint32_t size;      // bytes written so far
+} sd_seqfile_t;
+
+esp_err_t sd_seqfile_open(sd_seqfile_t *sf, sdmmc_card_t *card, const char *name, uint32_t capacity);
+esp_err_t sd_seqfile_write(sd_seqfile_t *sf, const void *data, size_t len);
+esp_err_t sd_seqfile_close(sd_seqfile_t *sf);
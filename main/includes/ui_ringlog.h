@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "lvgl/lvgl.h"
+
+/*
+ * A read-only text area that keeps the last max_len characters of a log.
+ * The text lives in a window of a buffer twice that size which the text
+ * area's label shows in place (lv_label_set_text_static): dropping old lines
+ * only moves the start of the window, and the window is slid back to the
+ * front once per max_len appended characters. Every add is one label
+ * refresh, however much it trims. Call with xGuiSemaphore held.
+ */
+typedef struct {
+    lv_obj_t *textarea;
+    char *buf;          // 2 * max_len + 1 bytes
+    size_t max_len;
+    size_t start;       // first shown character
+    size_t end;         // terminating NUL
+} ui_ringlog_t;
+
+lv_obj_t *ui_ringlog_create(ui_ringlog_t *log, lv_obj_t *parent, size_t max_len);
+void ui_ringlog_add(ui_ringlog_t *log, const char *text, size_t len);
+void ui_ringlog_set(ui_ringlog_t *log, const char *text);
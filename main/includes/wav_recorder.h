@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "sdmmc_cmd.h"
+#include "sd_seqfile.h"
+
+/* most PCM handed to the card per SPI bus hold - one multi-block write at most */
+#define WAV_CHUNK_SIZE (SD_SEQFILE_BUF_SECTORS * 512)
+#define WAV_HEADER_SIZE 44
+#define WAV_ROTATE_SECONDS 600 //start a new file every 10 minutes
+
+typedef struct {
+    sdmmc_card_t *card;
+    const char *dir;
+    uint32_t sample_rate;
+    uint16_t bits_per_sample;
+    uint16_t channels;
+    uint32_t max_data_bytes;    // rotate once a file holds this much PCM
+    sd_seqfile_t file;          // preallocated for a full rotation, streamed with raw sector writes
+    bool open;
+    char path[24];              // YYMMDD/hhmmss.WAV under dir
+    uint32_t data_bytes;        // PCM bytes accepted into the current file
+} wav_recorder_t;
+
+esp_err_t wav_recorder_init(wav_recorder_t *rec, sdmmc_card_t *card, const char *dir, uint32_t sample_rate, 
+                            uint16_t bits_per_sample, uint16_t channels, uint32_t rotate_seconds);
+esp_err_t wav_recorder_write(wav_recorder_t *rec, const uint8_t *pcm, size_t len);
+esp_err_t wav_recorder_close(wav_recorder_t *rec);
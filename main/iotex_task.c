@@ -16,7 +16,6 @@
 #include "wifi.h"
 
 #include "atecc608.h"
-#include "i2c_device.h"
 #include "iotex_emb.h"
 #include "abi_pack.h"
 #include "signer.h"
@@ -32,13 +31,25 @@ static const char *TAG = "IOTEX";
 #define IOTEX_CONTRACT "io1jjwlujpk7wztptwdjvun268ccsadsd7dtl2alq"
 #define IOTEX_EMB_MAX_ACB_LEN 1024
 
+static void print_public_key(ATCA_STATUS status, const uint8_t *public_key, void *arg)
+{
+    printf("atca_status_ret: %i \r\n", status);
+    if (public_key == NULL) {
+        return;
+    }
+    printf("atcab_read_pubkey 2: \r\n");
+    for (int i = 0; i < 64; i++) {
+        printf("%02X", public_key[i]);
+    } 
+    printf("\n");
+}
+
 void iotex_task(void *args) 
 {
     xEventGroupWaitBits(wifi_event_group, CONNECTED_BIT, false, true, portMAX_DELAY);
     
     ATCA_STATUS atca_status_ret;
     uint8_t signature[64];
-    uint8_t public_key[64];
     // message to sign  - 'hello from AWS EduKit' -> 0x68656c6c6f2066726f6d20415753204564754b6974
     uint8_t msg[32] = { 
         0x7d, 0x38, 0xde, 0x03, 0xdd, 0x4e, 0x59, 0xdf, 
@@ -47,11 +58,10 @@ void iotex_task(void *args)
         0xe1, 0xbd, 0x49, 0xbf, 0xe6, 0x75, 0xd5, 0x31 
     };
 
-    // Sign the message using private key in slot No. 2
+    // Sign the message using private key in slot No. 2, through the secure
+    // element task so the I2C bus stays free while the chip computes
 
-    i2c_take_port(ATECC608_I2C_PORT, portMAX_DELAY);
-    atca_status_ret =  atcab_sign(2, msg, signature);
-    i2c_free_port(ATECC608_I2C_PORT);
+    atca_status_ret = Atecc608_Sign(2, msg, signature);
     printf("atca_status_ret: %i \r\n", atca_status_ret);
     printf("signature 2: \r\n");
     for (int i = 0; i < 64; i++) {
@@ -61,15 +71,10 @@ void iotex_task(void *args)
 
     // Calculate the public key based on private key in slot No. 2
 
-    i2c_take_port(ATECC608_I2C_PORT, portMAX_DELAY);
-    atca_status_ret = atcab_get_pubkey(2, public_key);
-    i2c_free_port(ATECC608_I2C_PORT);
-    printf("atca_status_ret: %i \r\n", atca_status_ret);
-    printf("atcab_read_pubkey 2: \r\n");
-    for (int i = 0; i < 64; i++) {
-        printf("%02X", public_key[i]);
-    } 
-    printf("\n");
+    atca_status_ret = Atecc608_GetPubkeyAsync(2, print_public_key, NULL, portMAX_DELAY);
+    if (atca_status_ret != ATCA_SUCCESS) {
+        printf("atca_status_ret: %i \r\n", atca_status_ret);
+    }
  
 
     while(1){
@@ -10,12 +10,30 @@
 #include "sntp_sync.h"
 #include "microphone.h"
 
-#define MIC_QUEUE_DEPTH 10
-#define MIC_BUFF_SIZE 1024*1000
-
 static const char *TAG = "MIC";
 
 QueueHandle_t xQueueMicData;
+static QueueHandle_t xQueueMicFree;
+
+void mic_buffer_release(int8_t *data) {
+    xQueueSend(xQueueMicFree,&data,portMAX_DELAY);
+}
+
+static int8_t * mic_buffer_get(void) {
+    int8_t * data;
+    if (xQueueReceive(xQueueMicFree,&data,0)) {
+        return data;
+    }
+    // Consumer is behind - overwrite the oldest capture rather than stall the I2S DMA
+    mic_buffer_t oldest;
+    if (xQueueReceive(xQueueMicData,&oldest,0)) {
+        ESP_LOGW(TAG, "No free buffer, dropping oldest capture");
+        return oldest.data;
+    }
+    // Every buffer is held by the consumer, wait for one to come back
+    xQueueReceive(xQueueMicFree,&data,portMAX_DELAY);
+    return data;
+}
 
 void mic_task(void *args) {
 
@@ -23,20 +41,33 @@ void mic_task(void *args) {
     xEventGroupWaitBits(sntp_event_group, TIMESET_BIT, false, true, portMAX_DELAY);
 
     Microphone_Init();
+    i2s_set_clk(I2S_NUM_0, MIC_SAMPLE_RATE, I2S_BITS_PER_SAMPLE_16BIT, I2S_CHANNEL_MONO);
     
-    xQueueMicData = xQueueCreate(MIC_QUEUE_DEPTH,sizeof(char *)); 
-    size_t bytesread;
+    xQueueMicData = xQueueCreate(MIC_POOL_BUFFERS,sizeof(mic_buffer_t)); 
+    xQueueMicFree = xQueueCreate(MIC_POOL_BUFFERS,sizeof(int8_t *)); 
+
+    // allocate the whole pool in PSRAM up front, nothing is allocated on the capture path
+    for (int i = 0; i < MIC_POOL_BUFFERS; i++) {
+        int8_t * data = heap_caps_malloc(MIC_BUFF_SIZE, MALLOC_CAP_SPIRAM);
+        if (data == NULL) {
+            ESP_LOGE(TAG, "Cannot malloc buffer %i", i);
+            break;
+        }
+        xQueueSend(xQueueMicFree,&data,0);
+    }
+
+    mic_buffer_t capture;
 
     while(1){
-        // allocate memory in PSRAM and return its pointer
-        int8_t * i2s_readraw_buff = heap_caps_malloc(MIC_BUFF_SIZE, MALLOC_CAP_SPIRAM);
+        // take a buffer from the pool
+        capture.data = mic_buffer_get();
         // dump mic data in the buffer
-        i2s_read(I2S_NUM_0, (char*)i2s_readraw_buff, 
-            MIC_BUFF_SIZE, &bytesread, pdMS_TO_TICKS(100));
-        // send the pointer to a queue
-        xQueueSend(xQueueMicData,&i2s_readraw_buff,portMAX_DELAY);
+        i2s_read(I2S_NUM_0, (char*)capture.data, 
+            MIC_BUFF_SIZE, &capture.len, pdMS_TO_TICKS(100));
+        // send the buffer to a queue, ownership moves to the consumer
+        xQueueSend(xQueueMicData,&capture,portMAX_DELAY);
         // 
-        ESP_LOGI(TAG, "bytesread: %i", bytesread);
+        ESP_LOGI(TAG, "bytesread: %i", capture.len);
 
     }
 
@@ -0,0 +1,210 @@
+#include <string.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "mbedtls/sha256.h"
+#include "sys/param.h"
+#include "model_store.h"
+
+static const char *TAG = "MODEL";
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t len;
+    uint8_t sha256[32];
+} slot_header_t;
+
+typedef struct {
+    int slot;   // -1 for the built-in model
+    const uint8_t *data;
+    spi_flash_mmap_handle_t handle;
+} mapping_t;
+
+static const esp_partition_t *partition;
+static uint32_t slot_size;
+static uint32_t last_version;
+
+// owned by the inference task
+static mapping_t active = { .slot = -1 };
+static mapping_t next = { .slot = -1 };
+
+// shared with the OTA task
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static int pending_slot = -1;
+static int writing_slot = -1;
+static bool switching;
+
+static esp_err_t hash_slot(int slot, uint32_t len, uint8_t *digest) {
+    uint8_t buf[512];
+    mbedtls_sha256_context sha;
+    esp_err_t err = ESP_OK;
+
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts_ret(&sha, 0);
+    for (uint32_t pos = 0; pos < len && err == ESP_OK; pos += sizeof(buf)) {
+        size_t n = MIN(sizeof(buf), len - pos);
+        err = esp_partition_read(partition, slot * slot_size + MODEL_STORE_DATA_OFFSET + pos, buf, n);
+        mbedtls_sha256_update_ret(&sha, buf, n);
+    }
+    mbedtls_sha256_finish_ret(&sha, digest);
+    mbedtls_sha256_free(&sha);
+    return err;
+}
+
+static bool read_slot(int slot, slot_header_t *header) {
+    uint8_t digest[32];
+    if (esp_partition_read(partition, slot * slot_size, header, sizeof(*header)) != ESP_OK ||
+        header->magic != MODEL_STORE_MAGIC || header->len == 0 ||
+        header->len > slot_size - MODEL_STORE_DATA_OFFSET) {
+        return false;
+    }
+    if (hash_slot(slot, header->len, digest) != ESP_OK || memcmp(digest, header->sha256, sizeof(digest)) != 0) {
+        ESP_LOGW(TAG, "Slot %d (v%u) does not match its hash", slot, header->version);
+        return false;
+    }
+    return true;
+}
+
+esp_err_t model_store_init(void) {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, MODEL_STORE_SUBTYPE, NULL);
+    if (partition == NULL) {
+        ESP_LOGW(TAG, "No model partition, using the built-in model");
+        return ESP_ERR_NOT_FOUND;
+    }
+    slot_size = (partition->size / 2) & ~(SPI_FLASH_SEC_SIZE - 1);
+
+    slot_header_t header;
+    for (int slot = 0; slot < 2; slot++) {
+        if (read_slot(slot, &header) && header.version > last_version) {
+            last_version = header.version;
+            pending_slot = slot;
+        }
+    }
+    if (pending_slot >= 0) {
+        ESP_LOGI(TAG, "Model v%u in slot %d", last_version, pending_slot);
+    }
+    return ESP_OK;
+}
+
+const uint8_t *model_store_take_pending(uint32_t *version) {
+    portENTER_CRITICAL(&lock);
+    int slot = pending_slot;
+    pending_slot = -1;
+    switching = slot >= 0;
+    portEXIT_CRITICAL(&lock);
+    if (slot < 0) {
+        return NULL;
+    }
+
+    slot_header_t header;
+    esp_err_t err = esp_partition_read(partition, slot * slot_size, &header, sizeof(header));
+    if (err == ESP_OK) {
+        err = esp_partition_mmap(partition, slot * slot_size + MODEL_STORE_DATA_OFFSET, header.len,
+                                 SPI_FLASH_MMAP_DATA, (const void **)&next.data, &next.handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Cannot map slot %d, error : %d", slot, err);
+        portENTER_CRITICAL(&lock);
+        switching = false;
+        portEXIT_CRITICAL(&lock);
+        return NULL;
+    }
+    next.slot = slot;
+    if (version != NULL) {
+        *version = header.version;
+    }
+    return next.data;
+}
+
+void model_store_finish_switch(bool accepted) {
+    if (next.slot < 0) {
+        return;
+    }
+    if (accepted) {
+        if (active.slot >= 0) {
+            spi_flash_munmap(active.handle);
+        }
+        active = next;
+        ESP_LOGI(TAG, "Switched to slot %d", active.slot);
+    } else {
+        // clearing bits needs no erase, the slot is skipped from now on
+        uint32_t retired = 0;
+        esp_partition_write(partition, next.slot * slot_size, &retired, sizeof(retired));
+        spi_flash_munmap(next.handle);
+        ESP_LOGW(TAG, "Model in slot %d rejected", next.slot);
+    }
+    next = (mapping_t) { .slot = -1 };
+    portENTER_CRITICAL(&lock);
+    switching = false;
+    portEXIT_CRITICAL(&lock);
+}
+
+esp_err_t model_store_begin(uint32_t len, const esp_partition_t **out_partition, uint32_t *offset) {
+    if (partition == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (len == 0 || len > slot_size - MODEL_STORE_DATA_OFFSET) {
+        ESP_LOGE(TAG, "Model of %u bytes does not fit a %u byte slot", len, slot_size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    portENTER_CRITICAL(&lock);
+    // both slots are mapped while the inference task switches, that takes a moment
+    bool busy = switching || writing_slot >= 0;
+    int slot = active.slot == 0 ? 1 : 0;
+    if (!busy) {
+        if (pending_slot == slot) {
+            pending_slot = -1;
+        }
+        writing_slot = slot;
+    }
+    portEXIT_CRITICAL(&lock);
+    if (busy) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // the header sector goes first, so the slot is invalid until commit
+    esp_err_t err = esp_partition_erase_range(partition, slot * slot_size, slot_size);
+    if (err != ESP_OK) {
+        model_store_abort();
+        return err;
+    }
+    *out_partition = partition;
+    *offset = slot * slot_size + MODEL_STORE_DATA_OFFSET;
+    return ESP_OK;
+}
+
+esp_err_t model_store_commit(uint32_t len) {
+    int slot = writing_slot;
+    slot_header_t header = {
+        .magic = MODEL_STORE_MAGIC,
+        .version = last_version + 1,
+        .len = len,
+    };
+    esp_err_t err = ESP_ERR_INVALID_STATE;
+    if (slot >= 0) {
+        err = hash_slot(slot, len, header.sha256);
+    }
+    if (err == ESP_OK) {
+        err = esp_partition_write(partition, slot * slot_size, &header, sizeof(header));
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to commit slot %d, error : %d", slot, err);
+        model_store_abort();
+        return err;
+    }
+    last_version = header.version;
+
+    portENTER_CRITICAL(&lock);
+    pending_slot = slot;
+    writing_slot = -1;
+    portEXIT_CRITICAL(&lock);
+    ESP_LOGI(TAG, "Model v%u (%u bytes) committed to slot %d", header.version, len, slot);
+    return ESP_OK;
+}
+
+void model_store_abort(void) {
+    portENTER_CRITICAL(&lock);
+    writing_slot = -1;
+    portEXIT_CRITICAL(&lock);
+}
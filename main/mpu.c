@@ -1,4 +1,3 @@
-
 #include <time.h>
 #include <string.h>
 #include <sys/time.h>
@@ -12,22 +11,24 @@
 
 #include "wifi.h"
 #include "sntp_sync.h"
+#include "mpu.h"
 
 #include "mpu6886.h"
 
-static const char *TAG = "MPU";
+/* MPU6886 INT is not wired to an ESP32 GPIO here, sleep one watermark period instead */
+#define MPU_INT_PIN MPU6886_FIFO_NO_INT_PIN
+#define MPU_QUEUE_DEPTH (MPU_FIFO_WATERMARK * 4)
 
-struct acceldata { 
-    long long ts; 
-    float ax,ay,az;   
-} acceldata1;
+static const char *TAG = "MPU";
 
 QueueHandle_t xQueueAccelData;
 
-static int64_t time_get_time() {
+static mpu6886_fifo_frame_t fifo_frames[MPU6886_FIFO_MAX_FRAMES];
+
+static int64_t time_get_time_us() {
 	struct timeval tv;
 	gettimeofday(&tv, NULL);
-	return (tv.tv_sec * 1000LL + (tv.tv_usec / 1000LL));
+	return (tv.tv_sec * 1000000LL + tv.tv_usec);
 }
 
 void mpu_task(void *args) {
@@ -35,25 +36,41 @@ void mpu_task(void *args) {
     xEventGroupWaitBits(wifi_event_group, CONNECTED_BIT, false, true, portMAX_DELAY);
     xEventGroupWaitBits(sntp_event_group, TIMESET_BIT, false, true, portMAX_DELAY);
 
-    xQueueAccelData = xQueueCreate(60,sizeof(struct acceldata)); 
+    xQueueAccelData = xQueueCreate(MPU_QUEUE_DEPTH,sizeof(struct acceldata)); 
 
     int sensor_status = MPU6886_Init();
-
     printf("MPU6886_Init status: %i \r\n", sensor_status);
-    
+
+    sensor_status = MPU6886_FifoInit(MPU_SAMPLE_RATE_HZ, MPU_FIFO_WATERMARK, MPU_INT_PIN);
+    printf("MPU6886_FifoInit status: %i \r\n", sensor_status);
+
+    // timestamps are reconstructed from the sample clock, anchored at the FIFO reset
+    int64_t anchor_us = time_get_time_us();
+    uint32_t period_us = MPU6886_FifoGetPeriodUs();
+    struct acceldata acceldata1;
+
     while(1){
         
-        // wait 20ms
-        vTaskDelay(pdMS_TO_TICKS(20));
-        // get timestamp & accel data
-        acceldata1.ts = time_get_time(); 
-        MPU6886_GetAccelData(&acceldata1.ax, &acceldata1.ay, &acceldata1.az);
-        // send collected data to a queue
-        xQueueSend(xQueueAccelData,&acceldata1,portMAX_DELAY);
-
-        char buffer[50];
-        sprintf(buffer, "%lli,%.4f,%.4f,%.4f", acceldata1.ts, acceldata1.ax, acceldata1.ay, acceldata1.az);
-        ESP_LOGD(TAG, "%s", buffer);
+        MPU6886_FifoWait(pdMS_TO_TICKS(1000));
+
+        uint64_t first_sample = MPU6886_FifoGetSampleCount();
+        int count = MPU6886_FifoRead(fifo_frames, MPU6886_FIFO_MAX_FRAMES);
+        if (count < 0) {
+            ESP_LOGW(TAG, "FIFO overflow, samples dropped");
+            anchor_us = time_get_time_us();
+            continue;
+        }
+
+        for (int i = 0; i < count; i++) {
+            acceldata1.ts = (anchor_us + (int64_t)(first_sample + i + 1) * period_us) / 1000LL;
+            acceldata1.ax = fifo_frames[i].ax;
+            acceldata1.ay = fifo_frames[i].ay;
+            acceldata1.az = fifo_frames[i].az;
+            // send collected data to a queue
+            xQueueSend(xQueueAccelData,&acceldata1,portMAX_DELAY);
+        }
+
+        ESP_LOGD(TAG, "%i frames, last %lli,%i,%i,%i", count, acceldata1.ts, acceldata1.ax, acceldata1.ay, acceldata1.az);
 
     }
 
@@ -50,10 +50,17 @@
 #include "mbedtls/asn1.h"
 #include "mbedtls/bignum.h"
 #include "mbedtls/base64.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/x509_crt.h"
 #include "freertos/task.h"
+#include "core2forAWS.h"
+#include "delta_patch.h"
+#include "model_store.h"
 
 #define OTA_HALF_SECOND_DELAY    pdMS_TO_TICKS( 500UL )
 #define ECDSA_INTEGER_LEN        32
+#define SHA256_DIGEST_LEN        32
+#define HASH_READBACK_CHUNK      512 /* Stack buffer for consuming blocks back from flash */
 
 /* Check configuration for memory constraints provided SPIRAM is not enabled */
 #if !CONFIG_SPIRAM_SUPPORT
@@ -75,6 +82,11 @@ typedef struct
     esp_ota_handle_t update_handle;
     uint32_t data_write_len;
     bool valid_image;
+    mbedtls_sha256_context sha256_ctx; /* Running hash of the image, fed as blocks are written */
+    uint32_t consumed_len;             /* File bytes [0, consumed_len) are hashed or patched */
+    uint32_t stage_base;               /* Partition offset the received file is written at */
+    delta_patch_t * delta;             /* Set while receiving a delta patch */
+    bool model;                        /* Receiving a model for the model partition */
 } esp_ota_context_t;
 
 typedef struct
@@ -87,21 +99,14 @@ typedef struct
 static esp_ota_context_t ota_ctx;
 static const char * TAG = "ota_pal";
 
-//static const char codeSigningCertificatePEM[] = otapalconfigCODE_SIGNING_CERTIFICATE;
-//static const char codeSigningCertificatePEM[] = "test";
+/* Code signing certificate, embedded from certs/ota-signer-cert.pem. Every image is
+ * checked against it, the certfile named in the job document is not used. */
+extern const uint8_t ota_signer_cert_pem_start[] asm( "_binary_ota_signer_cert_pem_start" );
+extern const uint8_t ota_signer_cert_pem_end[] asm( "_binary_ota_signer_cert_pem_end" );
 
 /* Specify the OTA signature algorithm we support on this platform. */
 const char OTA_JsonFileSignatureKey[ OTA_FILE_SIG_KEY_STR_MAX_LENGTH ] = "sig-sha256-ecdsa";
-/*
-static CK_RV prvGetCertificateHandle( CK_FUNCTION_LIST_PTR pxFunctionList,
-                                      CK_SESSION_HANDLE xSession,
-                                      const char * pcLabelName,
-                                      CK_OBJECT_HANDLE_PTR pxCertHandle );
-
-static CK_RV prvGetCertificate( const char * pcLabelName,
-                                uint8_t ** ppucData,
-                                uint32_t * pulDataSize );
-*/
+
 static OtaPalMainStatus_t asn1_to_raw_ecdsa( uint8_t * signature,
                                              uint16_t sig_len,
                                              uint8_t * out_signature )
@@ -162,6 +167,8 @@ static void _esp_ota_ctx_clear( esp_ota_context_t * ota_ctx )
 {
     if( ota_ctx != NULL )
     {
+        mbedtls_sha256_free( &ota_ctx->sha256_ctx );
+        free( ota_ctx->delta );
         memset( ota_ctx, 0, sizeof( esp_ota_context_t ) );
     }
 }
@@ -179,9 +186,100 @@ static void _esp_ota_ctx_close( OtaFileContext_t * pFileContext )
     }
 
     /*memset(&ota_ctx, 0, sizeof(esp_ota_context_t)); */
+    mbedtls_sha256_free( &ota_ctx.sha256_ctx );
+    free( ota_ctx.delta );
+    ota_ctx.delta = NULL;
     ota_ctx.cur_ota = 0;
 }
 
+/* Rebuilt image from the delta applier. It goes to the start of the partition and
+ * is hashed here, so the signature covers the image that will boot, not the patch. */
+static esp_err_t _esp_ota_delta_out( void * arg,
+                                     uint32_t offset,
+                                     const uint8_t * data,
+                                     size_t len )
+{
+    ( void ) arg;
+
+    esp_err_t ret = esp_ota_write_with_offset( ota_ctx.update_handle, data, len, offset );
+
+    if( ret != ESP_OK )
+    {
+        LogError( ( "Couldn't flash rebuilt image at the offset %d", offset ) );
+        return ret;
+    }
+
+    mbedtls_sha256_update_ret( &ota_ctx.sha256_ctx, data, len );
+    ota_ctx.data_write_len = offset + len;
+
+    return ESP_OK;
+}
+
+/* Received file bytes, in order: image data is hashed, patch data is applied. */
+static esp_err_t _esp_ota_consume( const uint8_t * data,
+                                   uint32_t len )
+{
+    if( ota_ctx.delta != NULL )
+    {
+        esp_err_t ret = delta_patch_feed( ota_ctx.delta, data, len );
+
+        if( ret != ESP_OK )
+        {
+            return ret;
+        }
+    }
+    else
+    {
+        mbedtls_sha256_update_ret( &ota_ctx.sha256_ctx, data, len );
+    }
+
+    ota_ctx.consumed_len += len;
+
+    return ESP_OK;
+}
+
+/* Bring the hash (or the patch applier) up to the first block that has not been written yet.
+ *
+ * Blocks normally arrive in order and are consumed straight from the receive buffer
+ * in otaPal_WriteBlock. A block that arrives ahead of a missing one is only written;
+ * once the gap is filled, it is read back from flash and consumed here. With
+ * check_bitmap false, everything written up to the file size is consumed. */
+static esp_err_t _esp_ota_consume_written( const OtaFileContext_t * pFileContext,
+                                           bool check_bitmap )
+{
+    uint8_t buf[ HASH_READBACK_CHUNK ];
+
+    while( ota_ctx.consumed_len < pFileContext->fileSize )
+    {
+        uint32_t block = ota_ctx.consumed_len / OTA_FILE_BLOCK_SIZE;
+        uint32_t block_end = MIN( ( block + 1 ) * OTA_FILE_BLOCK_SIZE, pFileContext->fileSize );
+        uint32_t len = MIN( sizeof( buf ), block_end - ota_ctx.consumed_len );
+
+        /* A set bit marks a block that has not been received yet. */
+        if( check_bitmap && ( ( pFileContext->pRxBlockBitmap[ block / 8 ] & ( 1U << ( block % 8 ) ) ) != 0 ) )
+        {
+            break;
+        }
+
+        esp_err_t ret = esp_partition_read( ota_ctx.update_partition, ota_ctx.stage_base + ota_ctx.consumed_len, buf, len );
+
+        if( ret != ESP_OK )
+        {
+            LogError( ( "Failed to read back offset %d (%d)", ota_ctx.consumed_len, ret ) );
+            return ret;
+        }
+
+        ret = _esp_ota_consume( buf, len );
+
+        if( ret != ESP_OK )
+        {
+            return ret;
+        }
+    }
+
+    return ESP_OK;
+}
+
 /* Abort receiving the specified OTA update by closing the file. */
 OtaPalStatus_t otaPal_Abort( OtaFileContext_t * const pFileContext )
 {
@@ -189,6 +287,11 @@ OtaPalStatus_t otaPal_Abort( OtaFileContext_t * const pFileContext )
 
     if( _esp_ota_ctx_validate( pFileContext ) )
     {
+        if( ota_ctx.model )
+        {
+            model_store_abort();
+        }
+
         _esp_ota_ctx_close( pFileContext );
         ota_ret = OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
     }
@@ -200,6 +303,37 @@ OtaPalStatus_t otaPal_Abort( OtaFileContext_t * const pFileContext )
     return ota_ret;
 }
 
+/* Model files go to the inactive slot of the model partition instead of an app
+ * partition. They are hashed and signature checked like firmware, but committed
+ * on close and picked up by the inference task without a reboot. */
+static OtaPalStatus_t _esp_ota_create_model_file( OtaFileContext_t * const pFileContext )
+{
+    esp_err_t err = model_store_begin( pFileContext->fileSize, &ota_ctx.update_partition, &ota_ctx.stage_base );
+
+    if( err != ESP_OK )
+    {
+        LogError( ( "Cannot store a %d byte model (%d)", pFileContext->fileSize, err ) );
+        return OTA_PAL_COMBINE_ERR( OtaPalRxFileCreateFailed, 0 );
+    }
+
+    ota_ctx.cur_ota = pFileContext;
+    ota_ctx.update_handle = 0;
+    ota_ctx.model = true;
+
+    pFileContext->pFile = ( uint8_t * ) &ota_ctx;
+    ota_ctx.data_write_len = 0;
+    ota_ctx.valid_image = false;
+
+    mbedtls_sha256_init( &ota_ctx.sha256_ctx );
+    mbedtls_sha256_starts_ret( &ota_ctx.sha256_ctx, 0 );
+    ota_ctx.consumed_len = 0;
+    ota_ctx.delta = NULL;
+
+    LogInfo( ( "Writing model to partition %s at offset 0x%x", ota_ctx.update_partition->label, ota_ctx.stage_base ) );
+
+    return OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
+}
+
 /* Attempt to create a new receive file for the file chunks as they come in. */
 OtaPalStatus_t otaPal_CreateFileForRx( OtaFileContext_t * const pFileContext )
 {
@@ -208,6 +342,11 @@ OtaPalStatus_t otaPal_CreateFileForRx( OtaFileContext_t * const pFileContext )
         return OTA_PAL_COMBINE_ERR( OtaPalRxFileCreateFailed, 0 );
     }
 
+    if( pFileContext->fileType == otaconfigMODEL_FILE_TYPE_ID )
+    {
+        return _esp_ota_create_model_file( pFileContext );
+    }
+
     const esp_partition_t * update_partition = esp_ota_get_next_update_partition( NULL );
 
     if( update_partition == NULL )
@@ -231,260 +370,152 @@ OtaPalStatus_t otaPal_CreateFileForRx( OtaFileContext_t * const pFileContext )
     ota_ctx.cur_ota = pFileContext;
     ota_ctx.update_partition = update_partition;
     ota_ctx.update_handle = update_handle;
+    ota_ctx.model = false;
 
     pFileContext->pFile = ( uint8_t * ) &ota_ctx;
     ota_ctx.data_write_len = 0;
     ota_ctx.valid_image = false;
 
-    LogInfo( ( "esp_ota_begin succeeded" ) );
-
-    return OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
-}
-
-#if 0
-static CK_RV prvGetCertificateHandle( CK_FUNCTION_LIST_PTR pxFunctionList,
-                                      CK_SESSION_HANDLE xSession,
-                                      const char * pcLabelName,
-                                      CK_OBJECT_HANDLE_PTR pxCertHandle )
-{
-    CK_ATTRIBUTE xTemplate;
-    CK_RV xResult = CKR_OK;
-    CK_ULONG ulCount = 0;
-    CK_BBOOL xFindInit = CK_FALSE;
+    mbedtls_sha256_init( &ota_ctx.sha256_ctx );
+    mbedtls_sha256_starts_ret( &ota_ctx.sha256_ctx, 0 );
+    ota_ctx.consumed_len = 0;
+    ota_ctx.stage_base = 0;
+    ota_ctx.delta = NULL;
 
-    /* Get the certificate handle. */
-    if( 0 == xResult )
+    if( delta_patch_is_patch_file( ( const char * ) pFileContext->pFilePath ) )
     {
-        xTemplate.type = CKA_LABEL;
-        xTemplate.ulValueLen = strlen( pcLabelName ) + 1;
-        xTemplate.pValue = ( char * ) pcLabelName;
-        xResult = pxFunctionList->C_FindObjectsInit( xSession, &xTemplate, 1 );
-    }
+        /* The patch is staged at the end of the partition while the image is rebuilt
+         * from the start, so both have to fit with the signature block in between. */
+        ota_ctx.stage_base = ( update_partition->size - MIN( pFileContext->fileSize, update_partition->size ) ) & ~( SPI_FLASH_SEC_SIZE - 1 );
+        ota_ctx.delta = malloc( sizeof( delta_patch_t ) );
 
-    if( 0 == xResult )
-    {
-        xFindInit = CK_TRUE;
-        xResult = pxFunctionList->C_FindObjects( xSession,
-                                                 ( CK_OBJECT_HANDLE_PTR ) pxCertHandle,
-                                                 1,
-                                                 &ulCount );
-    }
+        if( ( ota_ctx.stage_base <= ECDSA_SIG_SIZE ) || ( ota_ctx.delta == NULL ) )
+        {
+            LogError( ( "Cannot stage a %d byte patch", pFileContext->fileSize ) );
+            esp_ota_end( update_handle );
+            _esp_ota_ctx_clear( &ota_ctx );
+            pFileContext->pFile = NULL;
+            return OTA_PAL_COMBINE_ERR( OtaPalRxFileCreateFailed, 0 );
+        }
 
-    if( CK_TRUE == xFindInit )
-    {
-        xResult = pxFunctionList->C_FindObjectsFinal( xSession );
+        delta_patch_begin( ota_ctx.delta, esp_ota_get_running_partition(),
+                           ota_ctx.stage_base - ECDSA_SIG_SIZE, _esp_ota_delta_out, NULL );
+        LogInfo( ( "Receiving delta patch, staged at offset 0x%x", ota_ctx.stage_base ) );
     }
 
-    return xResult;
+    LogInfo( ( "esp_ota_begin succeeded" ) );
+
+    return OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
 }
 
-/* Note that this function mallocs a buffer for the certificate to reside in,
- * and it is the responsibility of the caller to free the buffer. */
-static CK_RV prvGetCertificate( const char * pcLabelName,
-                                uint8_t ** ppucData,
-                                uint32_t * pulDataSize )
-{
-    /* Find the certificate */
-    CK_OBJECT_HANDLE xHandle = 0;
-    CK_RV xResult;
-    CK_FUNCTION_LIST_PTR xFunctionList;
-    CK_SLOT_ID xSlotId;
-    CK_ULONG xCount = 1;
-    CK_SESSION_HANDLE xSession;
-    CK_ATTRIBUTE xTemplate = { 0 };
-    uint8_t * pucCert = NULL;
-    CK_BBOOL xSessionOpen = CK_FALSE;
 
-    xResult = C_GetFunctionList( &xFunctionList );
 
-    if( CKR_OK == xResult )
-    {
-        xResult = xFunctionList->C_Initialize( NULL );
-    }
+#if CONFIG_SOFTWARE_ATECC608_SUPPORT
 
-    if( ( CKR_OK == xResult ) || ( CKR_CRYPTOKI_ALREADY_INITIALIZED == xResult ) )
-    {
-        xResult = xFunctionList->C_GetSlotList( CK_TRUE, &xSlotId, &xCount );
-    }
+/* Verify on the ATECC608, which takes the raw r|s signature and an X|Y public key. */
+static ATCA_STATUS _esp_ota_verify_atecc( const uint8_t * digest,
+                                          const Sig_t * sig,
+                                          mbedtls_pk_context * signer_key,
+                                          bool * verified )
+{
+    uint8_t raw_sig[ 2 * ECDSA_INTEGER_LEN ];
+    uint8_t pub_key[ 1 + 2 * ECDSA_INTEGER_LEN ];
+    size_t pub_key_len = 0;
+    mbedtls_ecp_keypair * ec = mbedtls_pk_ec( *signer_key );
 
-    if( CKR_OK == xResult )
+    if( ( mbedtls_pk_get_type( signer_key ) != MBEDTLS_PK_ECKEY ) ||
+        ( ec->grp.id != MBEDTLS_ECP_DP_SECP256R1 ) ||
+        ( mbedtls_ecp_point_write_binary( &ec->grp, &ec->Q, MBEDTLS_ECP_PF_UNCOMPRESSED,
+                                          &pub_key_len, pub_key, sizeof( pub_key ) ) != 0 ) )
     {
-        xResult = xFunctionList->C_OpenSession( xSlotId, CKF_SERIAL_SESSION, NULL, NULL, &xSession );
+        return ATCA_BAD_PARAM;
     }
 
-    if( CKR_OK == xResult )
+    if( asn1_to_raw_ecdsa( ( uint8_t * ) sig->data, sig->size, raw_sig ) != OtaPalSuccess )
     {
-        xSessionOpen = CK_TRUE;
-        xResult = prvGetCertificateHandle( xFunctionList, xSession, pcLabelName, &xHandle );
+        /* Malformed signature, no point asking the software path either */
+        *verified = false;
+        return ATCA_SUCCESS;
     }
 
-    if( ( xHandle != 0 ) && ( xResult == CKR_OK ) ) /* 0 is an invalid handle */
-    {
-        /* Get the length of the certificate */
-        xTemplate.type = CKA_VALUE;
-        xTemplate.pValue = NULL;
-        xResult = xFunctionList->C_GetAttributeValue( xSession, xHandle, &xTemplate, xCount );
-
-        if( xResult == CKR_OK )
-        {
-            pucCert = pvPortMalloc( xTemplate.ulValueLen );
-        }
+    /* Skip the 0x04 uncompressed point marker */
+    return atcab_verify_extern( digest, raw_sig, pub_key + 1, verified );
+}
 
-        if( ( xResult == CKR_OK ) && ( pucCert == NULL ) )
-        {
-            xResult = CKR_HOST_MEMORY;
-        }
+#endif /* CONFIG_SOFTWARE_ATECC608_SUPPORT */
 
-        if( xResult == CKR_OK )
-        {
-            xTemplate.pValue = pucCert;
-            xResult = xFunctionList->C_GetAttributeValue( xSession, xHandle, &xTemplate, xCount );
+/* Verify the signature of the specified file.
+ *
+ * The image was hashed while it was written, so all that is left here is to hash
+ * any blocks that arrived out of order and check one ECDSA signature: on the
+ * ATECC608 when it is enabled, otherwise with mbedTLS. For a delta patch, the
+ * remaining ops are applied first and the signature is checked on the rebuilt image. */
+OtaPalStatus_t otaPal_CheckFileSignature( OtaFileContext_t * const pFileContext )
+{
+    OtaPalMainStatus_t mainErr = OtaPalSignatureCheckFailed;
+    uint8_t digest[ SHA256_DIGEST_LEN ];
+    mbedtls_x509_crt signer;
+    TickType_t start = xTaskGetTickCount();
+    uint32_t readback_len = pFileContext->fileSize - MIN( ota_ctx.consumed_len, pFileContext->fileSize );
 
-            if( xResult == CKR_OK )
-            {
-                *ppucData = pucCert;
-                *pulDataSize = xTemplate.ulValueLen;
-            }
-            else
-            {
-                vPortFree( pucCert );
-            }
-        }
-    }
-    else /* Certificate was not found. */
+    if( _esp_ota_consume_written( pFileContext, false ) != ESP_OK )
     {
-        *ppucData = NULL;
-        *pulDataSize = 0;
+        return OTA_PAL_COMBINE_ERR( OtaPalSignatureCheckFailed, 0 );
     }
 
-    if( xSessionOpen == CK_TRUE )
+    if( ( ota_ctx.delta != NULL ) && ( delta_patch_finish( ota_ctx.delta ) != ESP_OK ) )
     {
-        ( void ) xFunctionList->C_CloseSession( xSession );
+        return OTA_PAL_COMBINE_ERR( OtaPalSignatureCheckFailed, 0 );
     }
 
-    return xResult;
-}
+    mbedtls_sha256_finish_ret( &ota_ctx.sha256_ctx, digest );
 
-uint8_t * otaPal_ReadAndAssumeCertificate( const uint8_t * const pucCertName,
-                                           uint32_t * const ulSignerCertSize )
-{
-    uint8_t * pucCertData;
-    uint32_t ulCertSize;
-    uint8_t * pucSignerCert = NULL;
-    CK_RV xResult;
+    mbedtls_x509_crt_init( &signer );
 
-    xResult = prvGetCertificate( ( const char * ) pucCertName, &pucSignerCert, ulSignerCertSize );
-
-    if( ( xResult == CKR_OK ) && ( pucSignerCert != NULL ) )
+    if( mbedtls_x509_crt_parse( &signer, ota_signer_cert_pem_start,
+                                ota_signer_cert_pem_end - ota_signer_cert_pem_start ) != 0 )
     {
-        LogInfo( ( "Using cert with label: %s OK", ( const char * ) pucCertName ) );
+        LogError( ( "Failed to parse the code signing certificate" ) );
+        mbedtls_x509_crt_free( &signer );
+        return OTA_PAL_COMBINE_ERR( OtaPalBadSignerCert, 0 );
     }
-    else
-    {
-        LogInfo( ( "No such certificate file: %s. Using certificate in ota_demo_config.h.",
-                   ( const char * ) pucCertName ) );
 
-        /* Allocate memory for the signer certificate plus a terminating zero so we can copy it and return to the caller. */
-        ulCertSize = sizeof( codeSigningCertificatePEM );
-        pucSignerCert = pvPortMalloc( ulCertSize );            /*lint !e9029 !e9079 !e838 malloc proto requires void*. */
-        pucCertData = ( uint8_t * ) codeSigningCertificatePEM; /*lint !e9005 we don't modify the cert but it could be set by PKCS11 so it's not const. */
+    bool verified = false;
+    bool checked = false;
+
+    #if CONFIG_SOFTWARE_ATECC608_SUPPORT
+        ATCA_STATUS atca_status = _esp_ota_verify_atecc( digest, pFileContext->pSignature, &signer.pk, &verified );
 
-        if( pucSignerCert != NULL )
+        if( atca_status == ATCA_SUCCESS )
         {
-            memcpy( pucSignerCert, pucCertData, ulCertSize );
-            *ulSignerCertSize = ulCertSize;
+            checked = true;
         }
         else
         {
-            LogError( ( "No memory for certificate in otaPal_ReadAndAssumeCertificate!" ) );
+            LogWarn( ( "ATECC608 verify failed (0x%x), using mbedTLS", atca_status ) );
         }
-    }
-
-    return pucSignerCert;
-}
-
-#endif
-
-
-/* Verify the signature of the specified file. */
-OtaPalStatus_t otaPal_CheckFileSignature( OtaFileContext_t * const pFileContext )
-{
-    
-    OtaPalStatus_t result;
-    #if 0
-    uint32_t ulSignerCertSize;
-    void * pvSigVerifyContext;
-    uint8_t * pucSignerCert = 0;
-    static spi_flash_mmap_memory_t ota_data_map;
-    uint32_t mmu_free_pages_count, len, flash_offset = 0;
-
-    /* Verify an ECDSA-SHA256 signature. */
-    
-    if( CRYPTO_SignatureVerificationStart( &pvSigVerifyContext, cryptoASYMMETRIC_ALGORITHM_ECDSA,
-                                           cryptoHASH_ALGORITHM_SHA256 ) == pdFALSE )
-    {
-        LogError( ( "Signature verification start failed" ) );
-        return OTA_PAL_COMBINE_ERR( OtaPalSignatureCheckFailed, 0 );
-    }
-   
-
-    pucSignerCert = otaPal_ReadAndAssumeCertificate( ( const uint8_t * const ) pFileContext->pCertFilepath, &ulSignerCertSize );
+    #endif
 
-    if( pucSignerCert == NULL )
+    if( !checked )
     {
-        LogError( ( "Cert read failed" ) );
-        return OTA_PAL_COMBINE_ERR( OtaPalBadSignerCert, 0 );
+        verified = mbedtls_pk_verify( &signer.pk, MBEDTLS_MD_SHA256, digest, sizeof( digest ),
+                                      pFileContext->pSignature->data, pFileContext->pSignature->size ) == 0;
     }
 
-    mmu_free_pages_count = spi_flash_mmap_get_free_pages( SPI_FLASH_MMAP_DATA );
-    len = ota_ctx.data_write_len;
-
-    while( len > 0 )
-    {
-        /* Data we could map in case we are not aligned to PAGE boundary is one page size lesser.
-         * 0x0000FFFF is mmap aligned mask for 64K boundary */
-        uint32_t mmu_page_offset = ( ( flash_offset & 0x0000FFFF ) != 0 ) ? 1 : 0;
-        /* Read the image that fits in the free MMU pages */
-        uint32_t partial_image_len = MIN( len, ( ( mmu_free_pages_count - mmu_page_offset ) * SPI_FLASH_MMU_PAGE_SIZE ) );
-        const void * buf = NULL;
-
-        esp_err_t ret = esp_partition_mmap( ota_ctx.update_partition, flash_offset, partial_image_len,
-                                            SPI_FLASH_MMAP_DATA, &buf, &ota_data_map );
-
-        if( ret != ESP_OK )
-        {
-            LogError( ( "Partition mmap failed %d", ret ) );
-            result = OTA_PAL_COMBINE_ERR( OtaPalSignatureCheckFailed, 0 );
-            goto end;
-        }
-
-        CRYPTO_SignatureVerificationUpdate( pvSigVerifyContext, buf, partial_image_len );
-        spi_flash_munmap( ota_data_map );
-        flash_offset += partial_image_len;
-        len -= partial_image_len;
-    }
+    mbedtls_x509_crt_free( &signer );
 
-    if( CRYPTO_SignatureVerificationFinal( pvSigVerifyContext, ( char * ) pucSignerCert, ulSignerCertSize,
-                                           pFileContext->pSignature->data, pFileContext->pSignature->size ) == pdFALSE )
+    if( verified )
     {
-        LogError( ( "Signature verification failed" ) );
-        result = OTA_PAL_COMBINE_ERR( OtaPalSignatureCheckFailed, 0 );
+        mainErr = OtaPalSuccess;
+        LogInfo( ( "Signature verified in %d ms, %d bytes read back for hashing",
+                   ( xTaskGetTickCount() - start ) * portTICK_PERIOD_MS, readback_len ) );
     }
     else
     {
-        result = OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
+        LogError( ( "Signature verification failed" ) );
     }
 
-end:
-
-    /* Free the signer certificate that we now own after prvReadAndAssumeCertificate(). */
-    if( pucSignerCert != NULL )
-    {
-        vPortFree( pucSignerCert );
-    }
-    #endif 
-    result = OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
-    return result;
+    return OTA_PAL_COMBINE_ERR( mainErr, 0 );
 }
 
 
@@ -501,10 +532,16 @@ OtaPalStatus_t otaPal_CloseFile( OtaFileContext_t * const pFileContext )
     if( pFileContext->pSignature == NULL )
     {
         LogError( ( "Image Signature not found" ) );
+
+        if( ota_ctx.model )
+        {
+            model_store_abort();
+        }
+
         _esp_ota_ctx_clear( &ota_ctx );
         mainErr = OtaPalSignatureCheckFailed;
     }
-    else if( ota_ctx.data_write_len == 0 )
+    else if( ( ota_ctx.delta == NULL ) && !ota_ctx.model && ( ota_ctx.data_write_len == 0 ) )
     {
         LogError( ( "No data written to partition" ) );
         mainErr = OtaPalSignatureCheckFailed;
@@ -514,7 +551,21 @@ OtaPalStatus_t otaPal_CloseFile( OtaFileContext_t * const pFileContext )
         /* Verify the file signature, close the file and return the signature verification result. */
         mainErr = OTA_PAL_MAIN_ERR( otaPal_CheckFileSignature( pFileContext ) );
 
-        if( mainErr != OtaPalSuccess )
+        if( ota_ctx.model )
+        {
+            if( mainErr == OtaPalSuccess )
+            {
+                mainErr = ( model_store_commit( ota_ctx.data_write_len ) == ESP_OK ) ? OtaPalSuccess : OtaPalFileClose;
+            }
+            else
+            {
+                model_store_abort();
+            }
+
+            /* Nothing to activate, the inference task switches over on its own */
+            _esp_ota_ctx_clear( &ota_ctx );
+        }
+        else if( mainErr != OtaPalSuccess )
         {
             esp_partition_erase_range( ota_ctx.update_partition, 0, ota_ctx.update_partition->size );
         }
@@ -602,7 +653,16 @@ int16_t otaPal_WriteBlock( OtaFileContext_t * const pFileContext,
 {
     if( _esp_ota_ctx_validate( pFileContext ) )
     {
-        esp_err_t ret = esp_ota_write_with_offset( ota_ctx.update_handle, pacData, iBlockSize, iOffset );
+        esp_err_t ret;
+
+        if( ota_ctx.model )
+        {
+            ret = esp_partition_write( ota_ctx.update_partition, ota_ctx.stage_base + iOffset, pacData, iBlockSize );
+        }
+        else
+        {
+            ret = esp_ota_write_with_offset( ota_ctx.update_handle, pacData, iBlockSize, ota_ctx.stage_base + iOffset );
+        }
 
         if( ret != ESP_OK )
         {
@@ -610,7 +670,24 @@ int16_t otaPal_WriteBlock( OtaFileContext_t * const pFileContext,
             return -1;
         }
 
-        ota_ctx.data_write_len += iBlockSize;
+        if( ota_ctx.delta == NULL )
+        {
+            ota_ctx.data_write_len += iBlockSize;
+        }
+
+        if( iOffset == ota_ctx.consumed_len )
+        {
+            if( _esp_ota_consume( pacData, iBlockSize ) != ESP_OK )
+            {
+                /* Patch for another source image, or corrupt: no point in downloading the rest */
+                LogError( ( "Delta patch rejected at offset %d", iOffset ) );
+                return -1;
+            }
+
+            /* Catch up on blocks that arrived ahead of this one. A failure here is
+             * not fatal, consuming resumes from flash on close and fails there. */
+            ( void ) _esp_ota_consume_written( pFileContext, true );
+        }
     }
     else
     {
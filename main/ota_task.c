@@ -2,14 +2,17 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/param.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
 
 #include "esp_log.h"
+#include "esp_attr.h"
 #include "esp_http_client.h"
 #include "esp_https_ota.h"
+#include "esp_crt_bundle.h"
 #include "ota_task.h"
 #include "wifi.h"
 #include "ui.h"
@@ -63,6 +66,21 @@ extern const uint8_t aws_root_ca_pem_start[] asm("_binary_aws_root_ca_pem_start"
  */
 #define otaexampleMAX_STREAM_NAME_SIZE                   ( 128U )
 
+/**
+ * @brief The maximum size of the pre-signed URL of HTTP downloads.
+ */
+#define otaexampleMAX_URL_SIZE                           ( 1600U )
+
+/**
+ * @brief The maximum size of the authentication scheme of HTTP downloads.
+ */
+#define otaexampleMAX_AUTH_SCHEME_SIZE                   ( 32U )
+
+/**
+ * @brief Network timeout of the HTTP download connection.
+ */
+#define otaexampleHTTP_TIMEOUT_MS                        ( 10000 )
+
 /**
  * @brief The common prefix for all OTA topics.
  *
@@ -155,13 +173,43 @@ static uint8_t pucDecodeMem[ otaconfigFILE_BLOCK_SIZE ];
  */
 static uint8_t pucBitmap[ OTA_MAX_BLOCK_BITMAP_SIZE ];
 
+/**
+ * @brief Pre-signed URL buffer.
+ */
+static uint8_t pucUrlBuf[ otaexampleMAX_URL_SIZE ];
+
+/**
+ * @brief Authentication scheme buffer.
+ */
+static uint8_t pucAuthSchemeBuf[ otaexampleMAX_AUTH_SCHEME_SIZE ];
+
+/**
+ * @brief HTTP download state. The connection belongs to the download task; the
+ * agent only posts ranges, a new range replaces the one being downloaded.
+ */
+static SemaphoreHandle_t xHttpMutex;
+static TaskHandle_t xHttpTask;
+static esp_http_client_handle_t xHttpClient;
+static const char * pcHttpUrl;
+static bool xHttpUrlChanged;
+static uint32_t ulHttpRangeStart;
+static uint32_t ulHttpRangeEnd;
+static volatile uint32_t ulHttpGeneration;
+static uint32_t ulHttpServedGeneration;
+
+/**
+ * @brief Block being filled from the range response.
+ */
+static OtaEventData_t * pxHttpBlock;
+static uint32_t ulHttpBlockGeneration;
+
 
 static SemaphoreHandle_t xBufferSemaphore;
 
 /**
- * @brief Event buffer.
+ * @brief Event buffer. One per block of the request window, kept in PSRAM.
  */
-static OtaEventData_t pxEventBuffer[ otaconfigMAX_NUM_OTA_DATA_BUFFERS ];
+EXT_RAM_ATTR static OtaEventData_t pxEventBuffer[ otaconfigMAX_NUM_OTA_DATA_BUFFERS ];
 
 static bool matchEndWildcardsSpecialCases( const char * pTopicFilter,
                                            uint16_t topicFilterLength,
@@ -569,6 +617,234 @@ static OtaMqttStatus_t prvMqttUnSubscribe( const char * pcTopicFilter,
 
 
 
+/* Hand the filled block to the agent, unless its range has been replaced. */
+static void prvHttpSendBlock( void )
+{
+    OtaEventMsg_t xEventMsg = { 0 };
+
+    xSemaphoreTake( xHttpMutex, portMAX_DELAY );
+
+    if( ulHttpBlockGeneration == ulHttpGeneration )
+    {
+        xEventMsg.eventId = OtaAgentEventReceivedFileBlock;
+        xEventMsg.pEventData = pxHttpBlock;
+
+        if( OTA_SignalEvent( &xEventMsg ) == false )
+        {
+            prvOtaEventBufferFree( pxHttpBlock );
+        }
+    }
+    else
+    {
+        prvOtaEventBufferFree( pxHttpBlock );
+    }
+
+    xSemaphoreGive( xHttpMutex );
+    pxHttpBlock = NULL;
+}
+
+static esp_err_t prvHttpEventHandler( esp_http_client_event_t * pxEvent )
+{
+    const uint8_t * pucData = pxEvent->data;
+    int lLen = pxEvent->data_len;
+    uint32_t ulCopy;
+
+    /* Only a partial content response carries file data. */
+    if( pxEvent->event_id != HTTP_EVENT_ON_DATA || esp_http_client_get_status_code( pxEvent->client ) != 206 )
+    {
+        return ESP_OK;
+    }
+
+    /* A replaced range is read to its end to keep the connection, but not used. */
+    while( lLen > 0 && ulHttpBlockGeneration == ulHttpGeneration )
+    {
+        if( pxHttpBlock == NULL )
+        {
+            /* Wait for the agent to free a buffer rather than dropping the block. */
+            while( ( pxHttpBlock = prvOtaEventBufferGet() ) == NULL && ulHttpBlockGeneration == ulHttpGeneration )
+            {
+                vTaskDelay( 1 );
+            }
+
+            if( pxHttpBlock == NULL )
+            {
+                break;
+            }
+
+            pxHttpBlock->dataLength = 0;
+        }
+
+        ulCopy = MIN( ( uint32_t ) lLen, otaconfigFILE_BLOCK_SIZE - pxHttpBlock->dataLength );
+        memcpy( &pxHttpBlock->data[ pxHttpBlock->dataLength ], pucData, ulCopy );
+        pxHttpBlock->dataLength += ulCopy;
+        pucData += ulCopy;
+        lLen -= ulCopy;
+
+        if( pxHttpBlock->dataLength == otaconfigFILE_BLOCK_SIZE )
+        {
+            prvHttpSendBlock();
+        }
+    }
+
+    return ESP_OK;
+}
+
+static void prvHttpFetchRange( uint32_t ulStart, uint32_t ulEnd, uint32_t ulGeneration )
+{
+    char pcRange[ 32 ];
+    esp_err_t xErr;
+    int lStatus;
+
+    snprintf( pcRange, sizeof( pcRange ), "bytes=%u-%u", ulStart, ulEnd );
+    esp_http_client_set_header( xHttpClient, "Range", pcRange );
+
+    pxHttpBlock = NULL;
+    ulHttpBlockGeneration = ulGeneration;
+
+    /* Reuses the connection of the previous range while the server keeps it open. */
+    xErr = esp_http_client_perform( xHttpClient );
+    lStatus = esp_http_client_get_status_code( xHttpClient );
+
+    if( pxHttpBlock != NULL )
+    {
+        /* Only the last block of the file is shorter, a cut response is dropped. */
+        if( xErr == ESP_OK && lStatus == 206 )
+        {
+            prvHttpSendBlock();
+        }
+        else
+        {
+            prvOtaEventBufferFree( pxHttpBlock );
+            pxHttpBlock = NULL;
+        }
+    }
+
+    /* The request timer of the agent asks for the missing blocks again. */
+    if( xErr != ESP_OK )
+    {
+        ESP_LOGW( TAG, "Range %s failed : %s", pcRange, esp_err_to_name( xErr ) );
+        esp_http_client_close( xHttpClient );
+    }
+    else if( lStatus != 206 )
+    {
+        ESP_LOGE( TAG, "Range %s answered with status %d", pcRange, lStatus );
+    }
+}
+
+static void prvHttpDownloadTask( void * pvParam )
+{
+    const char * pcUrl;
+    bool xUrlChanged;
+    bool xPending;
+    uint32_t ulStart, ulEnd, ulGeneration;
+
+    for( ; ; )
+    {
+        xSemaphoreTake( xHttpMutex, portMAX_DELAY );
+        pcUrl = pcHttpUrl;
+        xUrlChanged = xHttpUrlChanged;
+        xHttpUrlChanged = false;
+        ulStart = ulHttpRangeStart;
+        ulEnd = ulHttpRangeEnd;
+        ulGeneration = ulHttpGeneration;
+        xPending = ( ulGeneration != ulHttpServedGeneration );
+        ulHttpServedGeneration = ulGeneration;
+        xSemaphoreGive( xHttpMutex );
+
+        if( xUrlChanged && xHttpClient != NULL )
+        {
+            esp_http_client_cleanup( xHttpClient );
+            xHttpClient = NULL;
+        }
+
+        if( xPending && pcUrl != NULL )
+        {
+            if( xHttpClient == NULL )
+            {
+                esp_http_client_config_t xConfig = {
+                    .url = pcUrl,
+                    .crt_bundle_attach = esp_crt_bundle_attach,
+                    .timeout_ms = otaexampleHTTP_TIMEOUT_MS,
+                    .buffer_size = 2048,
+                    .event_handler = prvHttpEventHandler,
+                };
+                xHttpClient = esp_http_client_init( &xConfig );
+            }
+
+            if( xHttpClient != NULL )
+            {
+                prvHttpFetchRange( ulStart, ulEnd, ulGeneration );
+            }
+
+            continue;
+        }
+
+        ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+    }
+}
+
+static OtaHttpStatus_t prvHttpInit( char * pcUrl )
+{
+    OtaHttpStatus_t xStatus = OtaHttpSuccess;
+
+    if( xHttpMutex == NULL )
+    {
+        xHttpMutex = xSemaphoreCreateMutex();
+    }
+
+    if( xHttpTask == NULL )
+    {
+        if( xTaskCreatePinnedToCore( &prvHttpDownloadTask, "ota_http_task", 4096 * 2, NULL, 1, &xHttpTask, 1 ) != pdPASS )
+        {
+            LogError( ( "Failed to create the HTTP download task." ) );
+            xStatus = OtaHttpInitFailed;
+        }
+    }
+
+    if( xStatus == OtaHttpSuccess )
+    {
+        xSemaphoreTake( xHttpMutex, portMAX_DELAY );
+        pcHttpUrl = pcUrl;
+        xHttpUrlChanged = true;
+        ulHttpGeneration++;
+        ulHttpServedGeneration = ulHttpGeneration;
+        xSemaphoreGive( xHttpMutex );
+    }
+
+    return xStatus;
+}
+
+static OtaHttpStatus_t prvHttpRequest( uint32_t ulRangeStart,
+                                       uint32_t ulRangeEnd )
+{
+    xSemaphoreTake( xHttpMutex, portMAX_DELAY );
+    ulHttpRangeStart = ulRangeStart;
+    ulHttpRangeEnd = ulRangeEnd;
+    ulHttpGeneration++;
+    xSemaphoreGive( xHttpMutex );
+
+    xTaskNotifyGive( xHttpTask );
+
+    return OtaHttpSuccess;
+}
+
+static OtaHttpStatus_t prvHttpDeinit( void )
+{
+    if( xHttpTask != NULL )
+    {
+        /* Ends the range in flight, the task drops the connection when it next wakes. */
+        xSemaphoreTake( xHttpMutex, portMAX_DELAY );
+        pcHttpUrl = NULL;
+        xHttpUrlChanged = true;
+        ulHttpGeneration++;
+        xSemaphoreGive( xHttpMutex );
+
+        xTaskNotifyGive( xHttpTask );
+    }
+
+    return OtaHttpSuccess;
+}
+
 static void prvSetOtaInterfaces( OtaInterfaces_t * pxOtaInterfaces )
 {
     /* Initialize OTA library OS Interface. */
@@ -585,6 +861,10 @@ static void prvSetOtaInterfaces( OtaInterfaces_t * pxOtaInterfaces )
     pxOtaInterfaces->mqtt.subscribe = prvMqttSubscribe;
     pxOtaInterfaces->mqtt.publish = prvMqttPublish;
     pxOtaInterfaces->mqtt.unsubscribe = prvMqttUnSubscribe;
+    /* Initialize the OTA library HTTP Interface.*/
+    pxOtaInterfaces->http.init = prvHttpInit;
+    pxOtaInterfaces->http.request = prvHttpRequest;
+    pxOtaInterfaces->http.deinit = prvHttpDeinit;
     /* Initialize the OTA library PAL Interface.*/
     pxOtaInterfaces->pal.getPlatformImageState = otaPal_GetPlatformImageState;
     pxOtaInterfaces->pal.setPlatformImageState = otaPal_SetPlatformImageState;
@@ -658,6 +938,13 @@ static void prvOtaAppCallback( OtaJobEvent_t xEvent, const void * pData )
 
             break;
 
+        case OtaJobEventUpdateComplete:
+            LogInfo( ( "Received OtaJobEventUpdateComplete callback from OTA Agent." ) );
+
+            /* Model updates are committed to the model partition by the PAL and the
+             * inference task switches to them on its own, so no reboot is needed. */
+            break;
+
         case OtaJobEventSelfTestFailed:
             LogDebug( ( "Received OtaJobEventSelfTestFailed callback from OTA Agent." ) );
 
@@ -720,6 +1007,10 @@ void ota_task(void *args) {
         .decodeMemorySize   = otaconfigFILE_BLOCK_SIZE,
         .pFileBitmap        = pucBitmap,
         .fileBitmapSize     = OTA_MAX_BLOCK_BITMAP_SIZE,
+        .pUrl               = pucUrlBuf,
+        .urlSize            = otaexampleMAX_URL_SIZE,
+        .pAuthScheme        = pucAuthSchemeBuf,
+        .authSchemeSize     = otaexampleMAX_AUTH_SCHEME_SIZE,
     };
 
      /*************************** Init OTA Library. ***************************/
@@ -31,29 +31,81 @@
 
 static const char *TAG = "Respond";
 
+// fast enough to read as instant, slow enough to show a repeated detection
+#define RESPOND_FADE_MS 150
+
+#if CONFIG_SOFTWARE_SPEAKER_SUPPORT
+// 40ms earcons, short so the capture gap they make stays under a model window
+#define EARCON_SAMPLES (SPEAKER_SAMPLE_RATE / 25)
+#define EARCON_FADE_SAMPLES (SPEAKER_SAMPLE_RATE / 500)
+#define EARCON_AMPLITUDE 8000
+
+static int16_t earcon_yes[EARCON_SAMPLES];
+static int16_t earcon_no[EARCON_SAMPLES];
+
+// Triangle wave with a short fade in and out so it doesn't click
+static void earcon_fill(int16_t *pcm, uint32_t freq){
+    uint32_t period = SPEAKER_SAMPLE_RATE;
+    for (int i = 0; i < EARCON_SAMPLES; i++){
+        uint32_t phase = (uint32_t)i * freq % period;
+        int32_t level = phase < period / 2 ? phase : period - phase;
+        int32_t sample = level * 4 * EARCON_AMPLITUDE / period - EARCON_AMPLITUDE;
+
+        int edge = i < EARCON_SAMPLES - i ? i : EARCON_SAMPLES - i;
+        if (edge < EARCON_FADE_SAMPLES){
+            sample = sample * edge / EARCON_FADE_SAMPLES;
+        }
+        pcm[i] = sample;
+    }
+}
+
+static void earcon_play(char *response, const char *yes, const char *no){
+    static bool ready = false;
+    if (!ready){
+        earcon_fill(earcon_yes, 1320);
+        earcon_fill(earcon_no, 440);
+        ready = true;
+    }
+
+    // played by the capture task between two reads, it powers the amplifier
+    int voice = -1;
+    if (response == yes){
+        voice = Speaker_Play(earcon_yes, EARCON_SAMPLES, SPEAKER_GAIN_UNITY);
+    } else if (response == no){
+        voice = Speaker_Play(earcon_no, EARCON_SAMPLES, SPEAKER_GAIN_UNITY);
+    } else {
+        return;
+    }
+
+    if (voice < 0){
+        ESP_LOGW(TAG, "Earcon dropped");
+    }
+}
+#endif
+
 void respond(char *response){
 
     const char* yes = "y";
     const char* no = "n";
     const char* unknown = "u";
 
-    Core2ForAWS_Sk6812_Clear();
-    Core2ForAWS_Sk6812_Show();
+    // posted to the LED task, the inference loop never waits for the LEDs
+    bool posted;
     if (response == yes){
-        Core2ForAWS_Sk6812_SetSideColor(SK6812_SIDE_LEFT, 0x00ff00);
-        Core2ForAWS_Sk6812_SetSideColor(SK6812_SIDE_RIGHT, 0x000000);
-        Core2ForAWS_Sk6812_Show();
+        posted = Core2ForAWS_Sk6812_Fade(0x00ff00, 0x000000, RESPOND_FADE_MS);
     } else if (response == no){
-        Core2ForAWS_Sk6812_SetSideColor(SK6812_SIDE_LEFT, 0x000000);
-        Core2ForAWS_Sk6812_SetSideColor(SK6812_SIDE_RIGHT, 0xff0000);
-        Core2ForAWS_Sk6812_Show();
+        posted = Core2ForAWS_Sk6812_Fade(0x000000, 0xff0000, RESPOND_FADE_MS);
     } else if (response == unknown){
-        Core2ForAWS_Sk6812_SetSideColor(SK6812_SIDE_LEFT, 0xffffff);
-        Core2ForAWS_Sk6812_SetSideColor(SK6812_SIDE_RIGHT, 0xffffff);
-        Core2ForAWS_Sk6812_Show();
+        posted = Core2ForAWS_Sk6812_Fade(0xffffff, 0xffffff, RESPOND_FADE_MS);
     } else {        
-        Core2ForAWS_Sk6812_SetSideColor(SK6812_SIDE_LEFT, 0x000000);
-        Core2ForAWS_Sk6812_SetSideColor(SK6812_SIDE_RIGHT, 0x000000);
-        Core2ForAWS_Sk6812_Show();
+        posted = Core2ForAWS_Sk6812_Fade(0x000000, 0x000000, RESPOND_FADE_MS);
+    }
+
+    if (!posted) {
+        ESP_LOGW(TAG, "LED effect dropped");
     }
-}
\ No newline at end of file
+
+#if CONFIG_SOFTWARE_SPEAKER_SUPPORT
+    earcon_play(response, yes, no);
+#endif
+}
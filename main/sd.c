@@ -8,23 +8,19 @@
 #include "freertos/event_groups.h"
 #include "esp_log.h"
 #include "core2forAWS.h"
+#include "i2c_device.h"
 #include "wifi.h"
 #include "ui.h"
 #include "sntp_sync.h"
 #include "sdmmc_cmd.h"
+#include "mic.h"
+#include "wav_recorder.h"
 #define MOUNT_POINT "/sdcard"
-#define FILENAME_LENGTH 31
-#define MIC_BUFF_SIZE 1024*1000
+#define BUS_STATS_PERIOD_MS 60000 //how often the SPI and I2C bus occupancy is logged
 static const char *TAG = "SD";
 
 extern QueueHandle_t xQueueMicData;
 
-int64_t time_get_time() {
-	struct timeval tv;
-	gettimeofday(&tv, NULL);
-	return (tv.tv_sec * 1000LL + (tv.tv_usec / 1000LL));
-}
-
 void sd_task(void *args) 
 {
     xEventGroupWaitBits(wifi_event_group, CONNECTED_BIT, false, true, portMAX_DELAY);
@@ -33,59 +29,53 @@ void sd_task(void *args)
     sdmmc_card_t * card;
     esp_err_t ret;
 
-    time_t now;
-    struct tm timeinfo;
-    time(&now);
-
-    // file name => /sdcard/YY-MM-DDTHH_MM_SSZ.csv
-    char strftime_buf[FILENAME_LENGTH]; 
+    // file names are local time based
     setenv("TZ", "UTC", 1);
     tzset();
-    localtime_r(&now, &timeinfo);
-    strftime(strftime_buf, sizeof(strftime_buf), 
-        MOUNT_POINT"/%y-%m-%dT%H_%M_%SZ.wav", &timeinfo);
     
+    spi_bus_acquire(SPI_BUS_CLIENT_SDCARD, SPI_BUS_SDCARD_DEADLINE_MS);
+    spi_poll();
     ret = Core2ForAWS_SDcard_Mount(MOUNT_POINT, &card);
+    spi_bus_release(SPI_BUS_CLIENT_SDCARD);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize the sd card");
-        return;
+        vTaskDelete(NULL);
     } 
 
     ESP_LOGI(TAG, "Success to initialize the sd card");
     sdmmc_card_print_info(stdout, card);
+
+    wav_recorder_t recorder;
+    ret = wav_recorder_init(&recorder, card, MOUNT_POINT, MIC_SAMPLE_RATE, 16, 1, WAV_ROTATE_SECONDS);
+    if (ret != ESP_OK) {
+        vTaskDelete(NULL);
+    }
     
-    // buffer pointer
-    int8_t * i2s_readraw_buffPtr;
+    // capture buffer borrowed from the mic pool
+    mic_buffer_t capture;
+    TickType_t stats_at = xTaskGetTickCount();
     while(1){
 
         if(xQueueMicData != 0)
         {
-            if (xQueueReceive(xQueueMicData,&i2s_readraw_buffPtr,(TickType_t)10))
+            if (xQueueReceive(xQueueMicData,&capture,(TickType_t)10))
             {
-                
-                // the sd card and the screen share the SPI bus - take the mutex
-                xSemaphoreTake(spi_mutex, portMAX_DELAY);
-                spi_poll();
-                // open the file
-                ESP_LOGE(TAG, "Opening file %s", strftime_buf);
-                FILE* f = fopen(strftime_buf, "w+");
-                if (f == NULL) {
-                    ESP_LOGE(TAG, "Failed to open file for writing, error : %d", errno);
-                    xSemaphoreGive(spi_mutex);
-                } else {
-                    ESP_LOGE(TAG, "Succeeded to open file for writing");
-                    // write the contents of the buffer
-                    fwrite(i2s_readraw_buffPtr, 1, MIC_BUFF_SIZE, f);
-                    // close the file
-                    fclose(f);
-                    // CRITICAL - free the buffer 
-                    free(i2s_readraw_buffPtr);
-                    // give the mutex back
-                    xSemaphoreGive(spi_mutex);
+                // streamed into the preallocated file one multi-block write at a time,
+                // the SPI bus is released between chunks so the display keeps refreshing
+                if (wav_recorder_write(&recorder, (uint8_t *)capture.data, capture.len) != ESP_OK) {
+                    ESP_LOGE(TAG, "Failed to record %i bytes", capture.len);
                 }
+                // CRITICAL - return the buffer to the pool on every path
+                mic_buffer_release(capture.data);
             }
         }
 
+        if (xTaskGetTickCount() - stats_at >= pdMS_TO_TICKS(BUS_STATS_PERIOD_MS)) {
+            spi_bus_log_stats();
+            i2c_log_stats(I2C_NUM_1);
+            stats_at = xTaskGetTickCount();
+        }
+
     }
 
 }
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "sd_seqfile.h"
+
+static const char *TAG = "SEQFILE";
+
+// first sector of a cluster, same as clst2sect() inside FATFS
+static size_t cluster_sector(const FATFS *fs, DWORD clst) {
+    return fs->database + (size_t)fs->csize * (clst - 2);
+}
+
+static FRESULT reserve_contiguous(FIL *fil, uint32_t capacity) {
+#if FF_USE_EXPAND
+    return f_expand(fil, capacity, 1);
+#else
+    // no f_expand in this FATFS build - grow the file and check that the
+    // clusters FATFS handed out follow each other
+    FRESULT res = f_lseek(fil, capacity);
+    if (res != FR_OK) {
+        return res;
+    }
+    if (f_tell(fil) != capacity) {
+        return FR_DENIED; // volume full
+    }
+    uint32_t cluster_bytes = (uint32_t)fil->obj.fs->csize * FF_MIN_SS;
+    for (uint32_t i = 1; i * cluster_bytes < capacity; i++) {
+        // FATFS keeps the cluster holding byte (ofs - 1), step one byte past the boundary
+        res = f_lseek(fil, i * cluster_bytes + 1);
+        if (res != FR_OK) {
+            return res;
+        }
+        if (fil->clust != fil->obj.sclust + i) {
+            return FR_DENIED; // fragmented free space
+        }
+    }
+    return FR_OK;
+#endif
+}
+
+esp_err_t sd_seqfile_open(sd_seqfile_t *sf, sdmmc_card_t *card, const char *name, uint32_t capacity) {
+    char path[32];
+    snprintf(path, sizeof(path), SD_SEQFILE_DRIVE "/%s", name);
+    memset(sf, 0, sizeof(*sf));
+
+    FRESULT res = f_open(&sf->fil, path, FA_WRITE | FA_CREATE_ALWAYS);
+    if (res != FR_OK) {
+        ESP_LOGE(TAG, "Failed to create %s, error : %d", path, res);
+        return ESP_FAIL;
+    }
+    res = reserve_contiguous(&sf->fil, capacity);
+    if (res == FR_OK) {
+        // FAT chain and directory entry go out now, nothing is left to update while streaming
+        res = f_sync(&sf->fil);
+    }
+    if (res != FR_OK) {
+        ESP_LOGE(TAG, "Cannot reserve %u contiguous bytes for %s, error : %d", capacity, path, res);
+        f_close(&sf->fil);
+        f_unlink(path);
+        return ESP_ERR_NO_MEM;
+    }
+
+    FATFS *fs = sf->fil.obj.fs;
+    size_t cluster_sectors = fs->csize;
+    size_t sectors = (capacity + FF_MIN_SS - 1) / FF_MIN_SS;
+    // round up to whole clusters, the tail of the last one belongs to the file too
+    sectors = (sectors + cluster_sectors - 1) / cluster_sectors * cluster_sectors;
+    esp_err_t err = sdmmc_seq_writer_begin(&sf->writer, card, cluster_sector(fs, sf->fil.obj.sclust),
+                                           sectors, SD_SEQFILE_BUF_SECTORS);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Cannot start writer for %s, error : %d", path, err);
+        f_close(&sf->fil);
+        f_unlink(path);
+        return err;
+    }
+    sf->capacity = capacity;
+    ESP_LOGD(TAG, "%s reserved at sector %u, %u bytes", path, sf->writer.next_sector, capacity);
+    return ESP_OK;
+}
+
+esp_err_t sd_seqfile_write(sd_seqfile_t *sf, const void *data, size_t len) {
+    if (len > sf->capacity - sf->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    esp_err_t err = sdmmc_seq_writer_write(&sf->writer, data, len);
+    if (err == ESP_OK) {
+        sf->size += len;
+    }
+    return err;
+}
+
+esp_err_t sd_seqfile_close(sd_seqfile_t *sf) {
+    esp_err_t err = sdmmc_seq_writer_end(&sf->writer);
+    ESP_LOGI(TAG, "%u bytes written at %u kB/s", sf->size, sdmmc_seq_writer_get_kbps(&sf->writer));
+
+    // hand the unused reservation back to the volume
+    FRESULT res = f_lseek(&sf->fil, sf->size);
+    if (res == FR_OK) {
+        res = f_truncate(&sf->fil);
+    }
+    if (res != FR_OK) {
+        ESP_LOGE(TAG, "Failed to trim file, error : %d", res);
+        err = ESP_FAIL;
+    }
+    f_close(&sf->fil);
+    return err;
+}
@@ -35,6 +35,9 @@ limitations under the License.
 
 extern "C" {
   #include "ui.h"
+#if CONFIG_SOFTWARE_SPEAKER_SUPPORT
+  #include "speaker.h"
+#endif
 }
 
 using namespace std;
@@ -43,6 +46,11 @@ static const char* TAG = "TF_LITE_AUDIO_PROVIDER";
 /* ringbuffer to hold the incoming audio data */
 ringbuf_t* g_audio_capture_buffer;
 volatile int32_t g_latest_audio_timestamp = 0;
+/* samples written to the ring buffer, the timestamp is derived from it so it
+ * doesn't drift by the rounding of each read */
+static int64_t g_captured_samples = 0;
+/* time the microphone was off while the speaker had the I2S port */
+static volatile int32_t g_capture_gap_ms = 0;
 /* model requires 20ms new data from g_audio_capture_buffer and 10ms old data
  * each time , storing old data in the histrory buffer , {
  * history_samples_to_keep = 10 * 16 } */
@@ -62,6 +70,8 @@ int16_t g_history_buffer[history_samples_to_keep];
 
 const int32_t kAudioCaptureBufferSize = 80000;
 const int32_t i2s_bytes_to_read = 3200;
+/* longest playback between two reads, the capture gap is filled with silence */
+const uint32_t kPlaybackSliceMs = 200;
 
 #define I2S_LRCK_PIN 0
 #define I2S_DATA_IN_PIN 34
@@ -110,11 +120,56 @@ static void i2s_init(void) {
   
 }
 
+static int WriteCaptured(const uint8_t* data, int len) {
+  int bytes_written = rb_write(g_audio_capture_buffer, data, len, pdMS_TO_TICKS(10));
+  if (bytes_written > 0) {
+    /* update the timestamp (in ms) to let the model know that new data has
+     * arrived */
+    g_captured_samples += bytes_written / 2;
+    g_latest_audio_timestamp =
+        (int32_t)((g_captured_samples * 1000) / kAudioSampleFrequency);
+  }
+  return bytes_written;
+}
+
+#if CONFIG_SOFTWARE_SPEAKER_SUPPORT
+/* Silence for the time the microphone was off, so the samples stay in step
+ * with the time and the model doesn't hear the earcon */
+static void FillCaptureGap(uint32_t gap_ms, uint8_t* buffer) {
+  int32_t bytes = gap_ms * (kAudioSampleFrequency / 1000) * 2;
+  memset(buffer, 0, i2s_bytes_to_read);
+  while (bytes > 0) {
+    int32_t len = bytes < i2s_bytes_to_read ? bytes : i2s_bytes_to_read;
+    if (WriteCaptured(buffer, len) <= 0) {
+      ESP_LOGW(TAG, "Capture gap not filled: %d bytes", bytes);
+      break;
+    }
+    bytes -= len;
+  }
+  g_capture_gap_ms += gap_ms;
+}
+#endif
+
 static void CaptureSamples(void* arg) {
   size_t bytes_read;
   uint8_t i2s_read_buffer[i2s_bytes_to_read] = {};
+#if CONFIG_SOFTWARE_SPEAKER_SUPPORT
+  /* this task owns I2S_NUM_0 from now on and plays the speaker's slices */
+  Speaker_SetScheduled(true);
+#endif
   i2s_init();
   while (1) {
+#if CONFIG_SOFTWARE_SPEAKER_SUPPORT
+    /* the speaker shares the port: it plays between two reads, for one
+     * slice at most so the capture gap stays short */
+    if (Speaker_Pending()) {
+      i2s_driver_uninstall(I2S_NUM_0);
+      uint32_t gap_ms = Speaker_PlaySlice(kPlaybackSliceMs);
+      i2s_init();
+      FillCaptureGap(gap_ms, i2s_read_buffer);
+    }
+#endif
+
     /* read 100ms data at once from i2s */
     i2s_read(I2S_NUM_0, (void*)i2s_read_buffer, i2s_bytes_to_read,
              &bytes_read, pdMS_TO_TICKS(3000));
@@ -127,14 +182,9 @@ static void CaptureSamples(void* arg) {
         ESP_LOGW(TAG, "Partial I2S read");
       }
       /* write bytes read by i2s into ring buffer */
-      int bytes_written = rb_write(g_audio_capture_buffer,
-                                   (uint8_t*)i2s_read_buffer, bytes_read, pdMS_TO_TICKS(10));
+      int bytes_written = WriteCaptured((uint8_t*)i2s_read_buffer, bytes_read);
 
       //ESP_LOGE(TAG, "rb leftover %d bytes", g_audio_capture_buffer->size - g_audio_capture_buffer->fill_cnt);
-      /* update the timestamp (in ms) to let the model know that new data has
-       * arrived */
-      g_latest_audio_timestamp +=
-          ((1000 * (bytes_written / 2)) / kAudioSampleFrequency);
       if (bytes_written <= 0) {
         ESP_LOGE(TAG, "Could Not Write in Ring Buffer: %d ", bytes_written);
       } else if (bytes_written < bytes_read) {
@@ -204,3 +254,5 @@ TfLiteStatus GetAudioSamples(tflite::ErrorReporter* error_reporter,
 }
 
 int32_t LatestAudioTimestamp() { return g_latest_audio_timestamp; }
+
+int32_t CaptureGapMs() { return g_capture_gap_ms; }
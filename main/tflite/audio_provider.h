@@ -43,4 +43,9 @@ TfLiteStatus GetAudioSamples(tflite::ErrorReporter* error_reporter,
 // your own platform-specific implementation.
 int32_t LatestAudioTimestamp();
 
+// Returns the total time in milliseconds the microphone was off while the
+// speaker played. The gaps are in the samples as silence and counted in
+// LatestAudioTimestamp().
+int32_t CaptureGapMs();
+
 #endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_MICRO_SPEECH_AUDIO_PROVIDER_H_
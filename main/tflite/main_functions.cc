@@ -15,10 +15,13 @@ limitations under the License.
 
 #include "main_functions.h"
 
+#include <new>
+
 #include "audio_provider.h"
 #include "command_responder.h"
 #include "feature_provider.h"
 #include "model.h"
+#include "model_store.h"
 #include "recognize_commands.h"
 #include "tensorflow/lite/micro/micro_error_reporter.h"
 #include "tensorflow/lite/micro/micro_interpreter.h"
@@ -29,7 +32,9 @@ limitations under the License.
 // Globals, used for compatibility with Arduino-style sketches.
 namespace {
 tflite::ErrorReporter* error_reporter = nullptr;
+tflite::MicroOpResolver* op_resolver = nullptr;
 const tflite::Model* model = nullptr;
+const unsigned char* model_data = nullptr;
 tflite::MicroInterpreter* interpreter = nullptr;
 TfLiteTensor* model_input = nullptr;
 FeatureProvider* feature_provider = nullptr;
@@ -43,28 +48,89 @@ constexpr int kTensorArenaSize = 10 * 1024;
 uint8_t tensor_arena[kTensorArenaSize];
 int8_t feature_buffer[kFeatureElementCount];
 int8_t* model_input_buffer = nullptr;
-}  // namespace
 
-// The name of this function is important for Arduino compatibility.
-void setup() {
-  tflite::InitializeTarget();
+// The interpreter is rebuilt in place when a new model is swapped in.
+alignas(tflite::MicroInterpreter) uint8_t
+    interpreter_buffer[sizeof(tflite::MicroInterpreter)];
+}  // namespace
 
-  // Set up logging. Google style is to avoid globals or statics because of
-  // lifetime uncertainty, but since this has a trivial destructor it's okay.
-  // NOLINTNEXTLINE(runtime-global-variables)
-  static tflite::MicroErrorReporter micro_error_reporter;
-  error_reporter = &micro_error_reporter;
+// Builds the interpreter for a model flatbuffer, replacing the current one. On
+// failure there is no interpreter and the caller loads another model.
+static bool LoadModel(const unsigned char* data) {
+  if (interpreter != nullptr) {
+    interpreter->~MicroInterpreter();
+    interpreter = nullptr;
+  }
 
   // Map the model into a usable data structure. This doesn't involve any
   // copying or parsing, it's a very lightweight operation.
-  model = tflite::GetModel(g_model);
+  model = tflite::GetModel(data);
   if (model->version() != TFLITE_SCHEMA_VERSION) {
     TF_LITE_REPORT_ERROR(error_reporter,
                          "Model provided is schema version %d not equal "
                          "to supported version %d.",
                          model->version(), TFLITE_SCHEMA_VERSION);
+    return false;
+  }
+
+  // Build an interpreter to run the model with.
+  interpreter = new (interpreter_buffer) tflite::MicroInterpreter(
+      model, *op_resolver, tensor_arena, kTensorArenaSize, error_reporter);
+
+  // Allocate memory from the tensor_arena for the model's tensors.
+  TfLiteStatus allocate_status = interpreter->AllocateTensors();
+  if (allocate_status != kTfLiteOk) {
+    TF_LITE_REPORT_ERROR(error_reporter, "AllocateTensors() failed");
+    interpreter->~MicroInterpreter();
+    interpreter = nullptr;
+    return false;
+  }
+
+  // Get information about the memory area to use for the model's input.
+  model_input = interpreter->input(0);
+  if ((model_input->dims->size != 2) || (model_input->dims->data[0] != 1) ||
+      (model_input->dims->data[1] !=
+       (kFeatureSliceCount * kFeatureSliceSize)) ||
+      (model_input->type != kTfLiteInt8)) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Bad input tensor parameters in model");
+    interpreter->~MicroInterpreter();
+    interpreter = nullptr;
+    return false;
+  }
+  model_input_buffer = model_input->data.int8;
+  model_data = data;
+  return true;
+}
+
+// Picks up a model committed to the model partition (at boot or by OTA) and
+// switches to it between two inferences. If it cannot be loaded, it is retired
+// and the model that was running before is loaded again.
+static void SwitchToPendingModel() {
+  uint32_t version = 0;
+  const unsigned char* pending = model_store_take_pending(&version);
+  if (pending == nullptr) {
     return;
   }
+  if (LoadModel(pending)) {
+    model_store_finish_switch(true);
+    TF_LITE_REPORT_ERROR(error_reporter, "Running model v%d from flash",
+                         version);
+    return;
+  }
+  model_store_finish_switch(false);
+  LoadModel(model_data != nullptr ? model_data : g_model);
+}
+
+// The name of this function is important for Arduino compatibility.
+void setup() {
+  tflite::InitializeTarget();
+
+  // Set up logging. Google style is to avoid globals or statics because of
+  // lifetime uncertainty, but since this has a trivial destructor it's okay.
+  // NOLINTNEXTLINE(runtime-global-variables)
+  static tflite::MicroErrorReporter micro_error_reporter;
+  error_reporter = &micro_error_reporter;
 
   // Pull in only the operation implementations we need.
   // This relies on a complete list of all the ops needed by this graph.
@@ -87,30 +153,14 @@ void setup() {
   if (micro_op_resolver.AddReshape() != kTfLiteOk) {
     return;
   }
+  op_resolver = &micro_op_resolver;
 
-  // Build an interpreter to run the model with.
-  static tflite::MicroInterpreter static_interpreter(
-      model, micro_op_resolver, tensor_arena, kTensorArenaSize, error_reporter);
-  interpreter = &static_interpreter;
-
-  // Allocate memory from the tensor_arena for the model's tensors.
-  TfLiteStatus allocate_status = interpreter->AllocateTensors();
-  if (allocate_status != kTfLiteOk) {
-    TF_LITE_REPORT_ERROR(error_reporter, "AllocateTensors() failed");
-    return;
-  }
-
-  // Get information about the memory area to use for the model's input.
-  model_input = interpreter->input(0);
-  if ((model_input->dims->size != 2) || (model_input->dims->data[0] != 1) ||
-      (model_input->dims->data[1] !=
-       (kFeatureSliceCount * kFeatureSliceSize)) ||
-      (model_input->type != kTfLiteInt8)) {
-    TF_LITE_REPORT_ERROR(error_reporter,
-                         "Bad input tensor parameters in model");
+  // A model in the model partition wins over the one built into the app.
+  model_store_init();
+  SwitchToPendingModel();
+  if (interpreter == nullptr && !LoadModel(g_model)) {
     return;
   }
-  model_input_buffer = model_input->data.int8;
 
   // Prepare to access the audio spectrograms from a microphone or other source
   // that will provide the inputs to the neural network.
@@ -127,6 +177,11 @@ void setup() {
 
 // The name of this function is important for Arduino compatibility.
 void loop() {
+  SwitchToPendingModel();
+  if (interpreter == nullptr) {
+    return;
+  }
+
   // Fetch the spectrogram for the current time.
   const int32_t current_time = LatestAudioTimestamp();
   int how_many_new_slices = 0;
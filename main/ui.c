@@ -35,39 +35,28 @@
 
 #include "core2forAWS.h"
 #include "ui.h"
+#include "ui_ringlog.h"
 
 #define MAX_TEXTAREA_LENGTH 1024
 
-static lv_obj_t *out_txtarea;
+static ui_ringlog_t out_log;
 static lv_obj_t *wifi_label;
 
 static char *TAG = "UI";
 
-static void ui_textarea_prune(size_t new_text_length){
-    const char * current_text = lv_textarea_get_text(out_txtarea);
-    size_t current_text_len = strlen(current_text);
-    if(current_text_len + new_text_length >= MAX_TEXTAREA_LENGTH){
-        for(int i = 0; i < new_text_length; i++){
-            lv_textarea_set_cursor_pos(out_txtarea, 0);
-            lv_textarea_del_char_forward(out_txtarea);
-        }
-        lv_textarea_set_cursor_pos(out_txtarea, LV_TEXTAREA_CURSOR_LAST);
-    }
-}
-
 void ui_textarea_add(char *baseTxt, char *param, size_t paramLen) {
     if( baseTxt != NULL ){
         xSemaphoreTake(xGuiSemaphore, portMAX_DELAY);
         if (param != NULL && paramLen != 0){
             size_t baseTxtLen = strlen(baseTxt);
-            ui_textarea_prune(paramLen);
             size_t bufLen = baseTxtLen + paramLen;
             char buf[(int) bufLen];
-            sprintf(buf, baseTxt, param);
-            lv_textarea_add_text(out_txtarea, buf);
+            int len = sprintf(buf, baseTxt, param);
+            // the oldest lines make room, one redraw for the whole update
+            ui_ringlog_add(&out_log, buf, len);
         } 
         else{
-            lv_textarea_add_text(out_txtarea, baseTxt); 
+            ui_ringlog_add(&out_log, baseTxt, strlen(baseTxt)); 
         }
         xSemaphoreGive(xGuiSemaphore);
     } 
@@ -96,12 +85,11 @@ void ui_init() {
     lv_label_set_text(wifi_label, LV_SYMBOL_WIFI);
     lv_label_set_recolor(wifi_label, true);
     
-    out_txtarea = lv_textarea_create(lv_scr_act(), NULL);
-    lv_obj_set_size(out_txtarea, 300, 180);
-    lv_obj_align(out_txtarea, NULL, LV_ALIGN_IN_BOTTOM_MID, 0, -12);
-    lv_textarea_set_max_length(out_txtarea, MAX_TEXTAREA_LENGTH);
-    lv_textarea_set_text_sel(out_txtarea, false);
-    lv_textarea_set_cursor_hidden(out_txtarea, true);
-    lv_textarea_set_text(out_txtarea, "Starting TensorFlow keyword detection.\n");
+    lv_obj_t *out_txtarea = ui_ringlog_create(&out_log, lv_scr_act(), MAX_TEXTAREA_LENGTH);
+    if (out_txtarea != NULL) {
+        lv_obj_set_size(out_txtarea, 300, 180);
+        lv_obj_align(out_txtarea, NULL, LV_ALIGN_IN_BOTTOM_MID, 0, -12);
+        ui_ringlog_set(&out_log, "Starting TensorFlow keyword detection.\n");
+    }
     xSemaphoreGive(xGuiSemaphore);
 }
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "ui_ringlog.h"
+
+static const char *TAG = "RINGLOG";
+
+static void ringlog_show(ui_ringlog_t *log) {
+    log->buf[log->end] = '\0';
+    lv_label_set_text_static(lv_textarea_get_label(log->textarea), log->buf + log->start);
+    // scrolls the page to the newest line
+    lv_textarea_set_cursor_pos(log->textarea, LV_TEXTAREA_CURSOR_LAST);
+}
+
+lv_obj_t *ui_ringlog_create(ui_ringlog_t *log, lv_obj_t *parent, size_t max_len) {
+    memset(log, 0, sizeof(*log));
+    log->buf = malloc(2 * max_len + 1);
+    if (log->buf == NULL) {
+        ESP_LOGE(TAG, "Cannot malloc %u bytes of log", 2 * max_len + 1);
+        return NULL;
+    }
+    log->max_len = max_len;
+
+    log->textarea = lv_textarea_create(parent, NULL);
+    lv_textarea_set_text_sel(log->textarea, false);
+    lv_textarea_set_cursor_hidden(log->textarea, true);
+    ringlog_show(log);
+    return log->textarea;
+}
+
+void ui_ringlog_add(ui_ringlog_t *log, const char *text, size_t len) {
+    if (log->buf == NULL) {
+        return;
+    }
+
+    // only the tail of an oversized add would stay anyway
+    if (len > log->max_len) {
+        text += len - log->max_len;
+        len = log->max_len;
+    }
+
+    // drop whole lines from the front until the new text fits
+    size_t live = log->end - log->start;
+    if (live + len > log->max_len) {
+        size_t drop = live + len - log->max_len;
+        const char *nl = memchr(log->buf + log->start + drop - 1, '\n', live - drop + 1);
+        log->start = nl != NULL ? (size_t)(nl + 1 - log->buf) : log->start + drop;
+        live = log->end - log->start;
+    }
+
+    // slide the window back to the front, at most once per max_len added
+    if (log->end + len > 2 * log->max_len) {
+        memmove(log->buf, log->buf + log->start, live);
+        log->start = 0;
+        log->end = live;
+    }
+
+    memcpy(log->buf + log->end, text, len);
+    log->end += len;
+    ringlog_show(log);
+}
+
+void ui_ringlog_set(ui_ringlog_t *log, const char *text) {
+    if (log->buf == NULL) {
+        return;
+    }
+    log->start = 0;
+    log->end = 0;
+    ui_ringlog_add(log, text, strlen(text));
+}
@@ -0,0 +1,176 @@
+#include <time.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "core2forAWS.h"
+#include "wav_recorder.h"
+
+static const char *TAG = "WAV";
+
+static void put_le16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    put_le16(p, v & 0xffff);
+    put_le16(p + 2, v >> 16);
+}
+
+static void wav_header(const wav_recorder_t *rec, uint32_t data_bytes, uint8_t *h) {
+    uint32_t byte_rate = rec->sample_rate * rec->channels * rec->bits_per_sample / 8;
+    memcpy(h, "RIFF", 4);
+    put_le32(h + 4, 36 + data_bytes);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    put_le32(h + 16, 16);
+    put_le16(h + 20, 1); // PCM
+    put_le16(h + 22, rec->channels);
+    put_le32(h + 24, rec->sample_rate);
+    put_le32(h + 28, byte_rate);
+    put_le16(h + 32, rec->channels * rec->bits_per_sample / 8);
+    put_le16(h + 34, rec->bits_per_sample);
+    memcpy(h + 36, "data", 4);
+    put_le32(h + 40, data_bytes);
+}
+
+// the sd card and the screen share the SPI bus - hold it for one chunk only,
+// the arbiter lets a waiting display flush in between
+static void bus_take(void) {
+    spi_bus_acquire(SPI_BUS_CLIENT_SDCARD, SPI_BUS_SDCARD_DEADLINE_MS);
+    spi_poll();
+}
+
+static void bus_give(void) {
+    spi_bus_release(SPI_BUS_CLIENT_SDCARD);
+}
+
+static void abandon_file(wav_recorder_t *rec) {
+    // give up on this file, the next write starts a new one
+    bus_take();
+    sd_seqfile_close(&rec->file);
+    bus_give();
+    rec->open = false;
+}
+
+static esp_err_t open_next_file(wav_recorder_t *rec) {
+    time_t now;
+    struct tm timeinfo;
+    time(&now);
+    localtime_r(&now, &timeinfo);
+    // FATFS is built without long file names - one YYMMDD directory per day, hhmmss.WAV in it
+    strftime(rec->path, sizeof(rec->path), "%y%m%d/%H%M%S.WAV", &timeinfo);
+
+    // the whole rotation is reserved up front so streaming never touches the FAT.
+    // The header claims all of it, so a file cut short by a reset still plays -
+    // the file size on the card is the reserved size until it's trimmed on close
+    uint8_t header[WAV_HEADER_SIZE];
+    rec->data_bytes = 0;
+    wav_header(rec, rec->max_data_bytes, header);
+
+    char full_dir[48];
+    snprintf(full_dir, sizeof(full_dir), "%s/%.6s", rec->dir, rec->path);
+    bus_take();
+    esp_err_t err = ESP_OK;
+    if (mkdir(full_dir, 0775) != 0 && errno != EEXIST) {
+        ESP_LOGE(TAG, "Failed to create %s, error : %d", full_dir, errno);
+        err = ESP_FAIL;
+    }
+    if (err == ESP_OK) {
+        err = sd_seqfile_open(&rec->file, rec->card, rec->path, WAV_HEADER_SIZE + rec->max_data_bytes);
+    }
+    if (err == ESP_OK) {
+        err = sd_seqfile_write(&rec->file, header, WAV_HEADER_SIZE);
+    }
+    bus_give();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open %s for writing, error : %d", rec->path, err);
+        return ESP_FAIL;
+    }
+    rec->open = true;
+    ESP_LOGI(TAG, "Recording to %s/%s", rec->dir, rec->path);
+    return ESP_OK;
+}
+
+esp_err_t wav_recorder_init(wav_recorder_t *rec, sdmmc_card_t *card, const char *dir, uint32_t sample_rate, 
+                            uint16_t bits_per_sample, uint16_t channels, uint32_t rotate_seconds) {
+    memset(rec, 0, sizeof(*rec));
+    rec->card = card;
+    rec->dir = dir;
+    rec->sample_rate = sample_rate;
+    rec->bits_per_sample = bits_per_sample;
+    rec->channels = channels;
+    rec->max_data_bytes = rotate_seconds * sample_rate * channels * bits_per_sample / 8;
+    return ESP_OK;
+}
+
+esp_err_t wav_recorder_write(wav_recorder_t *rec, const uint8_t *pcm, size_t len) {
+    while (len > 0) {
+        if (!rec->open && open_next_file(rec) != ESP_OK) {
+            return ESP_FAIL;
+        }
+
+        size_t n = WAV_CHUNK_SIZE;
+        if (n > len) {
+            n = len;
+        }
+        if (n > rec->max_data_bytes - rec->data_bytes) {
+            n = rec->max_data_bytes - rec->data_bytes;
+        }
+        bus_take();
+        esp_err_t err = sd_seqfile_write(&rec->file, pcm, n);
+        bus_give();
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Write to %s failed, error : %d", rec->path, err);
+            abandon_file(rec);
+            return ESP_FAIL;
+        }
+        rec->data_bytes += n;
+        pcm += n;
+        len -= n;
+
+        if (rec->data_bytes == rec->max_data_bytes && wav_recorder_close(rec) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t wav_recorder_close(wav_recorder_t *rec) {
+    if (!rec->open) {
+        return ESP_OK;
+    }
+    bus_take();
+    esp_err_t err = sd_seqfile_close(&rec->file);
+    bus_give();
+    rec->open = false;
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to close %s", rec->path);
+        return err;
+    }
+    if (rec->data_bytes == rec->max_data_bytes) {
+        ESP_LOGI(TAG, "Closed %s, %u bytes of PCM", rec->path, rec->data_bytes);
+        return ESP_OK;
+    }
+
+    // closed early, the header gets the real sizes through the regular file system
+    char full_path[48];
+    snprintf(full_path, sizeof(full_path), "%s/%s", rec->dir, rec->path);
+    uint8_t header[WAV_HEADER_SIZE];
+    wav_header(rec, rec->data_bytes, header);
+    bus_take();
+    FILE *f = fopen(full_path, "r+b");
+    if (f == NULL || fwrite(header, 1, WAV_HEADER_SIZE, f) != WAV_HEADER_SIZE) {
+        ESP_LOGE(TAG, "Failed to finalize header of %s, error : %d", rec->path, errno);
+        err = ESP_FAIL;
+    }
+    if (f != NULL) {
+        fclose(f);
+    }
+    bus_give();
+
+    ESP_LOGI(TAG, "Closed %s, %u bytes of PCM", rec->path, rec->data_bytes);
+    return err;
+}
@@ -0,0 +1,71 @@
+"""Decode accelerometer batches produced by main/batch_codec.c.
+
+Usage: python batch_decoder.py <batch.bin> [--csv]
+"""
+import struct
+import sys
+
+MAGIC = b'AB'
+VERSION = 1
+FLAG_VARINT = 0x01
+HEADER = struct.Struct('<2sBBHBBq')
+
+
+def _varint(buf, pos):
+    result = 0
+    shift = 0
+    while True:
+        byte = buf[pos]
+        pos += 1
+        result |= (byte & 0x7f) << shift
+        if byte < 0x80:
+            return result, pos
+        shift += 7
+
+
+def _unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def decode(buf):
+    """Returns a list of (ts_ms, ax_g, ay_g, az_g) tuples."""
+    magic, version, flags, count, acc_fs, _, t0 = HEADER.unpack_from(buf, 0)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError('not an accelerometer batch')
+    pos = HEADER.size
+
+    if flags & FLAG_VARINT:
+        columns = []
+        for _ in range(4):
+            column = []
+            prev = 0
+            for _ in range(count):
+                delta, pos = _varint(buf, pos)
+                prev += _unzigzag(delta)
+                column.append(prev)
+            columns.append(column)
+        ts = [t0 + d for d in columns[0]]
+        ax, ay, az = columns[1:]
+    else:
+        deltas = struct.unpack_from('<%dH' % count, buf, pos)
+        ax = struct.unpack_from('<%dh' % count, buf, pos + 2 * count)
+        ay = struct.unpack_from('<%dh' % count, buf, pos + 4 * count)
+        az = struct.unpack_from('<%dh' % count, buf, pos + 6 * count)
+        ts = []
+        prev = t0
+        for d in deltas:
+            prev += d
+            ts.append(prev)
+
+    res = acc_fs / 32768.0
+    return [(ts[i], ax[i] * res, ay[i] * res, az[i] * res) for i in range(count)]
+
+
+if __name__ == '__main__':
+    with open(sys.argv[1], 'rb') as f:
+        records = decode(f.read())
+    if '--csv' in sys.argv:
+        for r in records:
+            print('%d,%.4f,%.4f,%.4f' % r)
+    else:
+        print('%d records, %d ms' % (len(records), records[-1][0] - records[0][0]))
@@ -0,0 +1,146 @@
+"""Verify sealed accelerometer batches produced by main/batch_seal.c.
+
+Pages are the published batch_codec pages with their seal trailer, seals the
+published seal items. Every page is checked against the leaves of its seal,
+the Merkle root against the leaves, the chain against the previous seal and,
+with --pubkey, the signature against the device key (64 byte X|Y hex, e.g.
+from Atecc608_GetPubkeyAsync on slot 0). Needs the ecdsa package for that.
+
+Usage: python batch_seal.py [--pubkey <hex>] [--proof] <seal.bin>... <page.bin>...
+"""
+import hashlib
+import struct
+import sys
+
+SEAL_MAGIC = b'SE'
+SEAL_VERSION = 1
+SEAL_HEADER = struct.Struct('<2sBBI32s32s64s')
+TRAILER_MAGIC = b'SL'
+TRAILER = struct.Struct('<2sBBI')
+
+
+def _sha256(*parts):
+    return hashlib.sha256(b''.join(parts)).digest()
+
+
+def leaf(page):
+    return _sha256(b'\x00', page)
+
+
+def merkle_root(leaves):
+    nodes = list(leaves)
+    while len(nodes) > 1:
+        nxt = [_sha256(b'\x01', nodes[i], nodes[i + 1]) for i in range(0, len(nodes) - 1, 2)]
+        if len(nodes) & 1:
+            nxt.append(nodes[-1])
+        nodes = nxt
+    return nodes[0]
+
+
+def proof(leaves, index):
+    """Siblings from the leaf to the root, as (is_left, digest) pairs."""
+    path = []
+    nodes = list(leaves)
+    while len(nodes) > 1:
+        sibling = index ^ 1
+        if sibling < len(nodes):
+            path.append((sibling < index, nodes[sibling]))
+        nxt = [_sha256(b'\x01', nodes[i], nodes[i + 1]) for i in range(0, len(nodes) - 1, 2)]
+        if len(nodes) & 1:
+            nxt.append(nodes[-1])
+        nodes = nxt
+        index //= 2
+    return path
+
+
+def verify_proof(page, path, root):
+    node = leaf(page)
+    for is_left, sibling in path:
+        node = _sha256(b'\x01', sibling, node) if is_left else _sha256(b'\x01', node, sibling)
+    return node == root
+
+
+def parse_seal(buf):
+    magic, version, count, seq, prev, root, sig = SEAL_HEADER.unpack_from(buf, 0)
+    if magic != SEAL_MAGIC or version != SEAL_VERSION:
+        raise ValueError('not a seal')
+    leaves = [buf[SEAL_HEADER.size + 32 * i:SEAL_HEADER.size + 32 * (i + 1)] for i in range(count)]
+    return {'seq': seq, 'prev': prev, 'root': root, 'sig': sig, 'leaves': leaves,
+            'digest': _sha256(buf[:72])}
+
+
+def parse_trailer(page):
+    magic, index, _, seq = TRAILER.unpack_from(page, len(page) - TRAILER.size)
+    if magic != TRAILER_MAGIC:
+        raise ValueError('page has no seal trailer')
+    return seq, index
+
+
+def verify(seals, pages, pubkey=None, show_proof=False):
+    ok = True
+    vk = None
+    if pubkey:
+        import ecdsa
+        vk = ecdsa.VerifyingKey.from_string(bytes.fromhex(pubkey), curve=ecdsa.NIST256p,
+                                            hashfunc=hashlib.sha256)
+
+    by_seq = {}
+    for s in sorted(seals, key=lambda s: s['seq']):
+        by_seq[s['seq']] = s
+        if merkle_root(s['leaves']) != s['root']:
+            print('seal %d: root does not match its leaves' % s['seq'])
+            ok = False
+        prev = by_seq.get(s['seq'] - 1)
+        if s['seq'] == 0 and s['prev'] != bytes(32):
+            print('seal 0: chain does not start at zero')
+            ok = False
+        elif prev is not None and s['prev'] != prev['digest']:
+            print('seal %d: chain broken after seal %d' % (s['seq'], prev['seq']))
+            ok = False
+        elif s['seq'] > 0 and prev is None:
+            print('seal %d: seal %d missing' % (s['seq'], s['seq'] - 1))
+        if vk is not None:
+            try:
+                vk.verify_digest(s['sig'], s['digest'])
+            except ecdsa.BadSignatureError:
+                print('seal %d: bad signature' % s['seq'])
+                ok = False
+
+    for name, page in pages:
+        seq, index = parse_trailer(page)
+        s = by_seq.get(seq)
+        if s is None:
+            print('%s: seal %d not available' % (name, seq))
+            ok = False
+            continue
+        path = proof(s['leaves'], index)
+        if index >= len(s['leaves']) or not verify_proof(page, path, s['root']):
+            print('%s: not covered by seal %d' % (name, seq))
+            ok = False
+            continue
+        print('%s: seal %d leaf %d ok' % (name, seq, index))
+        if show_proof:
+            for is_left, sibling in path:
+                print('  %s %s' % ('L' if is_left else 'R', sibling.hex()))
+    return ok
+
+
+if __name__ == '__main__':
+    args = sys.argv[1:]
+    pubkey = None
+    if '--pubkey' in args:
+        i = args.index('--pubkey')
+        pubkey = args[i + 1]
+        del args[i:i + 2]
+    show_proof = '--proof' in args
+    args = [a for a in args if a != '--proof']
+
+    seals, pages = [], []
+    for path in args:
+        with open(path, 'rb') as f:
+            buf = f.read()
+        if buf[:2] == SEAL_MAGIC:
+            seals.append(parse_seal(buf))
+        else:
+            pages.append((path, buf))
+    sys.exit(0 if verify(seals, pages, pubkey, show_proof) else 1)
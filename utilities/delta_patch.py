@@ -0,0 +1,167 @@
+"""Build delta OTA patches for main/delta_patch.c.
+
+The patch rebuilds new.bin from the image the device is running (old.bin, the
+exact build that was flashed). Upload it as the OTA file with a file path
+ending in .dpatch. The job signature covers the rebuilt image, not the patch:
+sign new.bin with the code signing key (--sign) and pass the printed base64
+signature as the custom code signing signature of the job.
+
+Usage: python delta_patch.py diff <old.bin> <new.bin> <out.dpatch> [--sign <key.pem>]
+       python delta_patch.py apply <old.bin> <in.dpatch> <out.bin>
+"""
+import base64
+import hashlib
+import struct
+import sys
+
+MAGIC = b'EDP'
+VERSION = 1
+HEADER = struct.Struct('<3sBII32s')
+MIN_MATCH = 16   # shorter copies cost more to encode than the literal
+INDEX_STEP = 4   # source positions indexed; unaligned matches are found by extending back
+
+
+def _varint(value):
+    out = bytearray()
+    while value >= 0x80:
+        out.append((value & 0x7f) | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+def _read_varint(buf, pos):
+    result = 0
+    shift = 0
+    while True:
+        byte = buf[pos]
+        pos += 1
+        result |= (byte & 0x7f) << shift
+        if byte < 0x80:
+            return result, pos
+        shift += 7
+
+
+def _zigzag(value):
+    return value << 1 if value >= 0 else ((-value) << 1) - 1
+
+
+def _unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def _match_len(old, s, new, t):
+    """Length of the common run of old[s:] and new[t:]."""
+    n = 0
+    step = 256
+    limit = min(len(old) - s, len(new) - t)
+    while n < limit:
+        step = min(step, limit - n)
+        if old[s + n:s + n + step] == new[t + n:t + n + step]:
+            n += step
+            step *= 2
+        elif step > 1:
+            step //= 2
+        else:
+            break
+    return n
+
+
+def diff(old, new):
+    index = {}
+    for i in range(0, len(old) - MIN_MATCH + 1, INDEX_STEP):
+        index.setdefault(old[i:i + MIN_MATCH], i)
+
+    ops = bytearray()
+    src_pos = 0      # end of the previous copy, copies are encoded relative to it
+    lit_start = 0
+    t = 0
+    while t + MIN_MATCH <= len(new):
+        # Changed bytes usually replace the same number of old ones (a moved
+        # pointer, an edited constant), so first try to carry on where we were.
+        s = src_pos + (t - lit_start)
+        n = _match_len(old, s, new, t) if s < len(old) else 0
+        if n < MIN_MATCH:
+            s = index.get(new[t:t + MIN_MATCH])
+            n = _match_len(old, s, new, t) if s is not None else 0
+        if n < MIN_MATCH:
+            t += 1
+            continue
+        while t > lit_start and s > 0 and old[s - 1] == new[t - 1]:
+            s -= 1
+            t -= 1
+            n += 1
+        if t > lit_start:
+            ops += _varint((t - lit_start) << 1) + new[lit_start:t]
+        ops += _varint((n << 1) | 1) + _varint(_zigzag(s - src_pos))
+        src_pos = s + n
+        t += n
+        lit_start = t
+    if lit_start < len(new):
+        ops += _varint((len(new) - lit_start) << 1) + new[lit_start:]
+
+    header = HEADER.pack(MAGIC, VERSION, len(old), len(new), hashlib.sha256(old).digest())
+    return header + bytes(ops)
+
+
+def apply(old, patch):
+    magic, version, old_size, new_size, old_hash = HEADER.unpack_from(patch, 0)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError('not a delta patch')
+    if old_size != len(old) or hashlib.sha256(old).digest() != old_hash:
+        raise ValueError('patch was made for a different source image')
+    out = bytearray()
+    pos = HEADER.size
+    src_pos = 0
+    while len(out) < new_size:
+        op, pos = _read_varint(patch, pos)
+        length = op >> 1
+        if op & 1:
+            delta, pos = _read_varint(patch, pos)
+            src_pos += _unzigzag(delta)
+            out += old[src_pos:src_pos + length]
+            src_pos += length
+        else:
+            out += patch[pos:pos + length]
+            pos += length
+    if pos != len(patch) or len(out) != new_size:
+        raise ValueError('corrupt patch')
+    return bytes(out)
+
+
+def sign(image, key_path):
+    import ecdsa
+    from ecdsa.util import sigencode_der
+
+    with open(key_path) as f:
+        key = ecdsa.SigningKey.from_pem(f.read())
+    return base64.b64encode(key.sign_deterministic(image, hashfunc=hashlib.sha256, sigencode=sigencode_der))
+
+
+def main(argv):
+    if len(argv) >= 5 and argv[1] == 'diff':
+        with open(argv[2], 'rb') as f:
+            old = f.read()
+        with open(argv[3], 'rb') as f:
+            new = f.read()
+        patch = diff(old, new)
+        if apply(old, patch) != new:
+            raise SystemExit('patch does not rebuild %s' % argv[3])
+        with open(argv[4], 'wb') as f:
+            f.write(patch)
+        print('%s: %d bytes, %.1f%% of the %d byte image' % (argv[4], len(patch), 100.0 * len(patch) / len(new), len(new)))
+        if len(argv) == 7 and argv[5] == '--sign':
+            print('signature: %s' % sign(new, argv[6]).decode())
+    elif len(argv) == 5 and argv[1] == 'apply':
+        with open(argv[2], 'rb') as f:
+            old = f.read()
+        with open(argv[3], 'rb') as f:
+            patch = f.read()
+        with open(argv[4], 'wb') as f:
+            f.write(apply(old, patch))
+    else:
+        raise SystemExit(__doc__)
+
+
+if __name__ == '__main__':
+    main(sys.argv)